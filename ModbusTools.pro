@@ -18,3 +18,4 @@ SUBDIRS += modbus/src/modbus.pro
 SUBDIRS += src/core
 SUBDIRS += src/client
 SUBDIRS += src/server
+SUBDIRS += src/server/bench
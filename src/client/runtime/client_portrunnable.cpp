@@ -28,6 +28,8 @@
 #include <ModbusClientPort.h>
 
 #include <client.h>
+#include <runtime/core_capture.h>
+#include <runtime/core_runtime.h>
 
 #include <project/client_port.h>
 
@@ -64,6 +66,9 @@ mbClientPortRunnable::mbClientPortRunnable(mbClientRunPort *port, const Modbus::
         m_hashRunnables.insert(d->modbusClient(), d);
     }
     setName(settings.value(mbClientPort::Strings::instance().name).toString());
+
+    mbCoreCapture *capture = mbCore::globalCore()->coreRuntime()->capture();
+    m_capture = capture ? capture->createChannel(name(), m_modbusClientPort->type(), false) : nullptr;
 }
 
 mbClientPortRunnable::~mbClientPortRunnable()
@@ -183,6 +188,8 @@ void mbClientPortRunnable::slotBytesTx(const Modbus::Char */*source*/, const uin
             m_currentMessage->setBytesTx(bytes);
         mbClient::LogTx(name(), Modbus::bytesToString(buff, size).data());
     }
+    if (m_capture)
+        m_capture->capture(mbCoreCaptureChannel::Tx, buff, size);
     m_stat.countTx++;
     m_port->setStatCountTx(m_stat.countTx);
 }
@@ -203,6 +210,8 @@ void mbClientPortRunnable::slotBytesRx(const Modbus::Char */*source*/, const uin
             m_currentMessage->setBytesRx(bytes);
         mbClient::LogRx(name(), Modbus::bytesToString(buff, size).data());
     }
+    if (m_capture)
+        m_capture->capture(mbCoreCaptureChannel::Rx, buff, size);
     m_stat.countRx++;
     m_port->setStatCountRx(m_stat.countRx);
 }
@@ -223,6 +232,8 @@ void mbClientPortRunnable::slotAsciiTx(const Modbus::Char */*source*/, const uin
             m_currentMessage->setAsciiTx(bytes);
         mbClient::LogTx(name(), Modbus::asciiToString(buff, size).data());
     }
+    if (m_capture)
+        m_capture->capture(mbCoreCaptureChannel::Tx, buff, size);
     m_stat.countTx++;
     m_port->setStatCountTx(m_stat.countTx);
 }
@@ -243,6 +254,8 @@ void mbClientPortRunnable::slotAsciiRx(const Modbus::Char */*source*/, const uin
             m_currentMessage->setAsciiRx(bytes);
         mbClient::LogRx(name(), Modbus::asciiToString(buff, size).data());
     }
+    if (m_capture)
+        m_capture->capture(mbCoreCaptureChannel::Rx, buff, size);
     m_stat.countRx++;
     m_port->setStatCountRx(m_stat.countRx);
 }
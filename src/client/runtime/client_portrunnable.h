@@ -35,6 +35,7 @@ class ModbusClientPort;
 class mbClientRunPort;
 class mbClientRunDevice;
 class mbClientDeviceRunnable;
+class mbCoreCaptureChannel;
 
 class mbClientPortRunnable : public QObject
 {
@@ -81,6 +82,7 @@ private:
     QList<mbClientRunDevice*> m_devices;
     mbClientPort::Statistic m_stat;
     mbClientRunMessagePtr m_currentMessage;
+    mbCoreCaptureChannel *m_capture;
 
 private:
     typedef QList<mbClientDeviceRunnable*> Runnables_t;
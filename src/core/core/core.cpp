@@ -26,6 +26,7 @@
 
 #include <QApplication>
 #include <QDateTime>
+#include <QTimerEvent>
 
 #include <Modbus.h>
 
@@ -81,7 +82,12 @@ mbCore::Strings::Strings() :
     settings_useTimestamp   (QStringLiteral("Log.UseTimestamp"  )),
     settings_formatDateTime (QStringLiteral("Log.FormatDateTime")),
     settings_addressNotation(QStringLiteral("AddressNotation"   )),
-    settings_columns        (QStringLiteral("DataView.Columns"  ))
+    settings_columns        (QStringLiteral("DataView.Columns"  )),
+    settings_refreshRate    (QStringLiteral("DataView.RefreshRate")),
+    settings_captureEnable     (QStringLiteral("Capture.Enable"     )),
+    settings_capturePath       (QStringLiteral("Capture.Path"       )),
+    settings_captureMaxFileSize(QStringLiteral("Capture.MaxFileSize")),
+    settings_captureMaxFileTime(QStringLiteral("Capture.MaxFileTime"))
 {
 }
 
@@ -96,6 +102,11 @@ mbCore::Defaults::Defaults() :
     settings_useTimestamp   (true),
     settings_formatDateTime (QStringLiteral("dd.MM.yyyy hh:mm:ss.zzz")),
     settings_addressNotation(mb::Address::Notation_Modbus),
+    settings_refreshRate    (20),
+    settings_captureEnable     (false),
+    settings_capturePath       (QStringLiteral("capture")),
+    settings_captureMaxFileSize(100),
+    settings_captureMaxFileTime(60),
     tray                    (false),
     availableBaudRate       (mb::availableBaudRate   ()),
     availableDataBits       (mb::availableDataBits   ()),
@@ -121,16 +132,24 @@ mbCore::mbCore(const QString &application, QObject *parent) : mbCoreBase(parent)
     m_fileManager = nullptr;
     m_pluginManager = nullptr;
     m_runtime = nullptr;
+    m_builder = nullptr;
     m_ui = nullptr;
     m_project = nullptr;
+    m_app = nullptr;
+    m_logDropped = 0;
+    m_logTimerId = 0;
 
-    connect(this, &mbCore::signalLog   , this, &mbCore::logMessageThreadUnsafe);
     connect(this, &mbCore::signalOutput, this, &mbCore::outputMessageThreadUnsafe);
 
     m_settings.logFlags        = d.settings_logFlags       ;
     m_settings.useTimestamp    = d.settings_useTimestamp   ;
     m_settings.formatDateTime  = d.settings_formatDateTime ;
     m_settings.addressNotation = d.settings_addressNotation;
+    m_settings.refreshRate     = d.settings_refreshRate    ;
+    m_settings.captureEnable      = d.settings_captureEnable     ;
+    m_settings.capturePath        = d.settings_capturePath       ;
+    m_settings.captureMaxFileSize = d.settings_captureMaxFileSize;
+    m_settings.captureMaxFileTime = d.settings_captureMaxFileTime;
     m_config = new QSettings(s.settings_organization, application, this);
 }
 
@@ -295,6 +314,7 @@ int mbCore::parseArgs(int &argc, char **argv)
 int mbCore::runGui()
 {
     m_ui = createUi();
+    startLog();
     m_ui->initialize();
     loadCachedSettings();
     loadProject();
@@ -316,6 +336,7 @@ int mbCore::runGui()
 
 int mbCore::runConsole()
 {
+    startLog();
     loadCachedSettings();
     loadProject();
     int r = 1;
@@ -440,6 +461,11 @@ MBSETTINGS mbCore::cachedSettings() const
     r[s.settings_formatDateTime ] = formatDateTime();
     r[s.settings_addressNotation] = mb::toString(addressNotation());
     r[s.settings_columns        ] = columnNames();
+    r[s.settings_refreshRate    ] = refreshRate   ();
+    r[s.settings_captureEnable     ] = captureEnable     ();
+    r[s.settings_capturePath       ] = capturePath       ();
+    r[s.settings_captureMaxFileSize] = captureMaxFileSize();
+    r[s.settings_captureMaxFileTime] = captureMaxFileTime();
     return r;
 }
 
@@ -494,17 +520,82 @@ void mbCore::setCachedSettings(const MBSETTINGS &settings)
         setColumnNames(v);
     }
 
+    it = settings.find(s.settings_refreshRate);
+    if (it != end)
+    {
+        int v = it.value().toInt(&ok);
+        if (ok)
+            setRefreshRate(v);
+    }
+
+    it = settings.find(s.settings_captureEnable);
+    if (it != end)
+    {
+        bool v = it.value().toBool();
+        setCaptureEnable(v);
+    }
+
+    it = settings.find(s.settings_capturePath);
+    if (it != end)
+    {
+        QString v = it.value().toString();
+        setCapturePath(v);
+    }
+
+    it = settings.find(s.settings_captureMaxFileSize);
+    if (it != end)
+    {
+        int v = it.value().toInt(&ok);
+        if (ok)
+            setCaptureMaxFileSize(v);
+    }
+
+    it = settings.find(s.settings_captureMaxFileTime);
+    if (it != end)
+    {
+        int v = it.value().toInt(&ok);
+        if (ok)
+            setCaptureMaxFileTime(v);
+    }
+
     if (m_ui)
         m_ui->setCachedSettings(settings);
 }
 
 
+void mbCore::timerEvent(QTimerEvent *event)
+{
+    if (event->timerId() == m_logTimerId)
+        drainLog();
+    else
+        mbCoreBase::timerEvent(event);
+}
+
 void mbCore::logMessageThreadSafe(mb::LogFlag flag, const QString &source, const QString &text)
 {
     if (thread() == QThread::currentThread())
+    {
+        drainLog(); // keep order with messages of other threads
         logMessageThreadUnsafe(flag, source, text);
+    }
+    else
+        m_logRing.push(flag, source, text);
+}
+
+void mbCore::logMessageThreadSafe(mb::LogFlag flag, const QString &source, const char *text)
+{
+    if (thread() == QThread::currentThread())
+        logMessageThreadSafe(flag, source, QString::fromUtf8(text));
     else
-        Q_EMIT signalLog(flag, source, text);
+        m_logRing.push(flag, source, text);
+}
+
+void mbCore::logMessageThreadSafe(mb::LogFlag flag, const char *source, const char *text)
+{
+    if (thread() == QThread::currentThread())
+        logMessageThreadSafe(flag, QString::fromUtf8(source), QString::fromUtf8(text));
+    else
+        m_logRing.push(flag, source, text);
 }
 
 void mbCore::outputMessageThreadSafe(const QString &text)
@@ -515,17 +606,63 @@ void mbCore::outputMessageThreadSafe(const QString &text)
         Q_EMIT signalOutput(text);
 }
 
-void mbCore::logMessageThreadUnsafe(mb::LogFlag flag, const QString &source, const QString &text)
+void mbCore::startLog()
+{
+    // Messages of non-GUI threads are collected by log ring and
+    // delivered to GUI in batches with fixed rate
+    if (!m_logTimerId)
+        m_logTimerId = startTimer(mbCoreLogRing::DrainPeriod);
+}
+
+void mbCore::drainLog()
+{
+    mbCoreLogMessages batch; // local: UI may log while batch is delivered
+    m_logRing.drain(batch);
+    quint64 dropped = m_logRing.droppedCount();
+    if (dropped != m_logDropped)
+    {
+        if (m_settings.logFlags & mb::Log_Warning)
+        {
+            mbCoreLogMessage m;
+            m.timestamp = QDateTime::currentMSecsSinceEpoch();
+            m.flag = mb::Log_Warning;
+            m.source = applicationName();
+            m.text = QString("%1 log message(s) dropped (log ring overflow)").arg(dropped - m_logDropped);
+            batch.append(m);
+        }
+        m_logDropped = dropped;
+    }
+    if (batch.count())
+        logMessagesThreadUnsafe(batch);
+}
+
+void mbCore::logMessagesThreadUnsafe(const mbCoreLogMessages &messages)
 {
     if (m_ui)
-        m_ui->logMessage(flag, source, text);
+        m_ui->logMessages(messages);
     else
     {
-        QString msg = QString("%1 %2").arg(QDateTime::currentDateTime().toString(m_settings.formatDateTime), msg);
-        std::cout << msg.toStdString();
+        Q_FOREACH (const mbCoreLogMessage &m, messages)
+        {
+            QString msg = QString("%1 '%2' %3: %4\n").arg(QDateTime::fromMSecsSinceEpoch(m.timestamp).toString(m_settings.formatDateTime),
+                                                        m.source,
+                                                        mb::toString(m.flag),
+                                                        m.text);
+            std::cout << msg.toStdString();
+        }
     }
 }
 
+void mbCore::logMessageThreadUnsafe(mb::LogFlag flag, const QString &source, const QString &text)
+{
+    mbCoreLogMessage m;
+    m.timestamp = QDateTime::currentMSecsSinceEpoch();
+    m.flag = flag;
+    m.source = source;
+    m.text = text;
+    logMessagesThreadUnsafe(mbCoreLogMessages() << m);
+}
+
 void mbCore::outputMessageThreadUnsafe(const QString &text)
 {
     if (m_ui)
@@ -29,8 +29,10 @@
 
 #include <mbcore_base.h>
 #include "core_global.h"
+#include "core_logring.h"
 
 class QCoreApplication;
+class QTimerEvent;
 
 class mbCoreTask;
 class mbCoreTaskInfo;
@@ -58,6 +60,11 @@ public:
         const QString settings_formatDateTime ;
         const QString settings_addressNotation;
         const QString settings_columns        ;
+        const QString settings_refreshRate    ;
+        const QString settings_captureEnable     ;
+        const QString settings_capturePath       ;
+        const QString settings_captureMaxFileSize;
+        const QString settings_captureMaxFileTime;
         Strings();
         static const Strings &instance();
     };
@@ -68,6 +75,11 @@ public:
         const bool                settings_useTimestamp   ;
         const QString             settings_formatDateTime ;
         const mb::AddressNotation settings_addressNotation;
+        const int                 settings_refreshRate    ;
+        const bool                settings_captureEnable     ;
+        const QString             settings_capturePath       ;
+        const int                 settings_captureMaxFileSize;
+        const int                 settings_captureMaxFileTime;
         const bool                tray                    ;
         const QVariantList        availableBaudRate       ;
         const QVariantList        availableDataBits       ;
@@ -105,6 +117,10 @@ public:
     static inline void LogInfo   (const QString &source, const QString &text) { s_globalCore->logInfo   (source, text); }
     static inline void LogTx     (const QString &source, const QString &text) { s_globalCore->logTx     (source, text); }
     static inline void LogRx     (const QString &source, const QString &text) { s_globalCore->logRx     (source, text); }
+    static inline void LogTx     (const QString &source, const char    *text) { s_globalCore->logTx     (source, text); }
+    static inline void LogRx     (const QString &source, const char    *text) { s_globalCore->logRx     (source, text); }
+    static inline void LogTx     (const char    *source, const char    *text) { s_globalCore->logTx     (source, text); }
+    static inline void LogRx     (const char    *source, const char    *text) { s_globalCore->logRx     (source, text); }
     static inline void LogDebug  (const QString &source, const QString &text) { s_globalCore->logDebug  (source, text); }
     static inline void OutputMessage(const QString &text) { s_globalCore->outputMessage(text); }
 
@@ -140,6 +156,15 @@ public:
     inline mb::AddressNotation addressNotation() const { return m_settings.addressNotation; }
     void setAddressNotation(mb::AddressNotation notation);
 
+    inline bool captureEnable() const { return m_settings.captureEnable; }
+    inline void setCaptureEnable(bool enable) { m_settings.captureEnable = enable; }
+    inline QString capturePath() const { return m_settings.capturePath; }
+    inline void setCapturePath(const QString &path) { m_settings.capturePath = path; }
+    inline int captureMaxFileSize() const { return m_settings.captureMaxFileSize; }
+    inline void setCaptureMaxFileSize(int megabytes) { m_settings.captureMaxFileSize = megabytes; }
+    inline int captureMaxFileTime() const { return m_settings.captureMaxFileTime; }
+    inline void setCaptureMaxFileTime(int minutes) { m_settings.captureMaxFileTime = minutes; }
+
     inline int columnCount() const { return m_settings.columns.count(); }
     inline QList<int> columns() const { return m_settings.columns; }
     void setColumns(const QList<int> columns);
@@ -149,6 +174,8 @@ public:
     virtual int columnTypeByName(const QString &name) const;
     virtual QString columnNameByIndex(int i) const;
     int columnIndexByType(int type);
+    inline int refreshRate() const { return m_settings.refreshRate; }
+    inline void setRefreshRate(int hz) { m_settings.refreshRate = hz; }
 
     virtual MBSETTINGS cachedSettings() const;
     virtual void setCachedSettings(const MBSETTINGS &settings);
@@ -164,6 +191,13 @@ public: // log interface
     inline void logTx     (const QString &source, const QString &text) { logMessage(mb::Log_Tx     , source, text); }
     inline void logRx     (const QString &source, const QString &text) { logMessage(mb::Log_Rx     , source, text); }
     inline void logDebug  (const QString &source, const QString &text) { logMessage(mb::Log_Debug  , source, text); }
+    // Raw char overloads are meant for port threads: text is copied into log ring without QString allocation
+    inline void logMessage(mb::LogFlag flag, const QString &source, const char *text) { if (m_settings.logFlags & flag) logMessageThreadSafe(flag, source, text); }
+    inline void logMessage(mb::LogFlag flag, const char    *source, const char *text) { if (m_settings.logFlags & flag) logMessageThreadSafe(flag, source, text); }
+    inline void logTx     (const QString &source, const char *text) { logMessage(mb::Log_Tx, source, text); }
+    inline void logRx     (const QString &source, const char *text) { logMessage(mb::Log_Rx, source, text); }
+    inline void logTx     (const char    *source, const char *text) { logMessage(mb::Log_Tx, source, text); }
+    inline void logRx     (const char    *source, const char *text) { logMessage(mb::Log_Rx, source, text); }
 
 public: // output
     inline void outputMessage(const QString &text) { outputMessageThreadSafe(text); }
@@ -189,7 +223,6 @@ Q_SIGNALS:
     void columnsChanged();
 
 Q_SIGNALS:
-    void signalLog(mb::LogFlag flag, const QString &source, const QString &text);
     void signalOutput(const QString &text);
 
 public:
@@ -210,9 +243,17 @@ protected:
     virtual int runGui();
     virtual int runConsole();
 
+protected:
+    void timerEvent(QTimerEvent *event) override;
+
 private:
     void logMessageThreadSafe(mb::LogFlag flag, const QString &source, const QString &text);
+    void logMessageThreadSafe(mb::LogFlag flag, const QString &source, const char *text);
+    void logMessageThreadSafe(mb::LogFlag flag, const char *source, const char *text);
     void outputMessageThreadSafe(const QString &text);
+    void startLog();
+    void drainLog();
+    void logMessagesThreadUnsafe(const mbCoreLogMessages &messages);
 
 private Q_SLOTS:
     void logMessageThreadUnsafe(mb::LogFlag flag, const QString &source, const QString &text);
@@ -236,6 +277,9 @@ protected:
     QCoreApplication* m_app;
     QSettings* m_config;
     QSharedMemory m_shared;
+    mbCoreLogRing m_logRing;
+    quint64 m_logDropped;
+    int m_logTimerId;
 
 protected:
     MBPARAMS m_args;
@@ -247,6 +291,11 @@ protected:
         QString             formatDateTime ;
         mb::AddressNotation addressNotation;
         QList<int>          columns        ;
+        int                 refreshRate    ; // Hz, max frequency of data view updates (0 - no limit)
+        bool                captureEnable     ;
+        QString             capturePath       ;
+        int                 captureMaxFileSize; // MB
+        int                 captureMaxFileTime; // minutes
     } m_settings;
 
 private:
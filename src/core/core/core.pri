@@ -1,9 +1,11 @@
 HEADERS += \
     $$PWD/core.h \
     $$PWD/core_filemanager.h \
-    $$PWD/core_global.h
+    $$PWD/core_global.h \
+    $$PWD/core_logring.h
 
 SOURCES += \
     $$PWD/core.cpp \
     $$PWD/core_filemanager.cpp \
-    $$PWD/core_global.cpp
+    $$PWD/core_global.cpp \
+    $$PWD/core_logring.cpp
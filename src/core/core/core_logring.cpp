@@ -0,0 +1,219 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "core_logring.h"
+
+#include <cstring>
+
+#include <QDateTime>
+
+// Source ids are 16-bit and never released (records in ring refer to them),
+// so number of distinct sources is limited. Excess sources are logged with empty source
+#define LOGRING_SOURCE_MAX 4096
+
+mbCoreLogRing::mbCoreLogRing()
+{
+    m_records = new Record[Capacity]; // sequence numbers are zero-initialized
+    m_tail = 0;
+    m_stall = static_cast<quint64>(-1);
+    m_sources.append(QString()); // id 0 - empty source
+    m_sourceIds.insert(QString(), 0);
+    m_sourceIdsUtf8.insert(QByteArray(), 0);
+}
+
+mbCoreLogRing::~mbCoreLogRing()
+{
+    delete[] m_records;
+}
+
+void mbCoreLogRing::push(mb::LogFlag flag, const QString &source, const QString &text)
+{
+    write(flag, sourceId(source), text);
+}
+
+void mbCoreLogRing::push(mb::LogFlag flag, const QString &source, const char *text)
+{
+    write(flag, sourceId(source), text);
+}
+
+void mbCoreLogRing::push(mb::LogFlag flag, const char *source, const char *text)
+{
+    write(flag, sourceId(source), text);
+}
+
+void mbCoreLogRing::write(mb::LogFlag flag, quint16 source, const QString &text)
+{
+    quint64 pos;
+    Record *r = beginWrite(pos, source, flag);
+    if (!r)
+        return;
+    int size = text.size();
+    r->truncated = (size > PayloadSize);
+    if (r->truncated)
+        size = PayloadSize;
+    memcpy(r->payload, text.utf16(), static_cast<size_t>(size)*sizeof(ushort));
+    r->size = static_cast<quint16>(size);
+    endWrite(r, pos);
+}
+
+void mbCoreLogRing::write(mb::LogFlag flag, quint16 source, const char *text)
+{
+    // Tx/Rx text is ASCII, so it is widened directly into the record.
+    // Non-ASCII text is rare and goes through QString conversion
+    for (const char *c = text; *c; c++)
+    {
+        if (static_cast<uchar>(*c) & 0x80)
+        {
+            write(flag, source, QString::fromUtf8(text));
+            return;
+        }
+    }
+    quint64 pos;
+    Record *r = beginWrite(pos, source, flag);
+    if (!r)
+        return;
+    int size = 0;
+    while (text[size] && size < PayloadSize)
+    {
+        r->payload[size] = static_cast<uchar>(text[size]);
+        size++;
+    }
+    r->truncated = (text[size] != '\0');
+    r->size = static_cast<quint16>(size);
+    endWrite(r, pos);
+}
+
+int mbCoreLogRing::drain(mbCoreLogMessages &messages, int maxCount)
+{
+    quint64 head = m_head.loadAcquire();
+    if (head - m_tail > static_cast<quint64>(Capacity))
+    {
+        // producers lapped the consumer: oldest records are overwritten
+        m_dropped.fetchAndAddRelaxed(head - m_tail - Capacity);
+        m_tail = head - Capacity;
+    }
+    int c = 0;
+    while ((m_tail != head) && (c < maxCount))
+    {
+        Record *r = &m_records[m_tail & (Capacity-1)];
+        const quint64 ready = 2*m_tail+2;
+        quint64 seq = r->seq.loadAcquire();
+        if (seq < ready)
+        {
+            // Record is not completed yet. Wait for it one drain period,
+            // after that it is considered lost (producer was preempted or gave up the slot)
+            if (m_stall != m_tail)
+            {
+                m_stall = m_tail;
+                break;
+            }
+            m_dropped.fetchAndAddRelaxed(1);
+            m_tail++;
+            continue;
+        }
+        if (seq == ready)
+        {
+            mbCoreLogMessage m;
+            m.timestamp = r->timestamp;
+            m.flag = static_cast<mb::LogFlag>(r->flag);
+            quint16 source = r->source;
+            int size = qMin(static_cast<int>(r->size), static_cast<int>(PayloadSize));
+            bool truncated = r->truncated;
+            m.text = QString(reinterpret_cast<const QChar*>(r->payload), size);
+            if (r->seq.loadAcquire() == seq) // record was not overwritten while copying
+            {
+                m.source = sourceName(source);
+                if (truncated)
+                    m.text += QStringLiteral("...");
+                messages.append(m);
+                c++;
+            }
+            else
+                m_dropped.fetchAndAddRelaxed(1);
+        }
+        else // overwritten by newer record
+            m_dropped.fetchAndAddRelaxed(1);
+        m_tail++;
+    }
+    return c;
+}
+
+mbCoreLogRing::Record *mbCoreLogRing::beginWrite(quint64 &pos, quint16 source, mb::LogFlag flag)
+{
+    pos = m_head.fetchAndAddRelaxed(1);
+    Record *r = &m_records[pos & (Capacity-1)];
+    quint64 seq = r->seq.loadAcquire();
+    // Slot is still being written by producer a whole ring behind (or already holds
+    // newer record): own record is given up instead of waiting, so producer never blocks.
+    // Given up position is counted as dropped by consumer when it passes it
+    if ((seq & 1) || (seq > 2*pos) || !r->seq.testAndSetOrdered(seq, 2*pos+1))
+        return nullptr;
+    r->timestamp = QDateTime::currentMSecsSinceEpoch();
+    r->flag = static_cast<quint32>(flag);
+    r->source = source;
+    return r;
+}
+
+quint16 mbCoreLogRing::sourceId(const QString &source)
+{
+    {
+        QReadLocker _(&m_sourceLock);
+        QHash<QString, quint16>::const_iterator it = m_sourceIds.constFind(source);
+        if (it != m_sourceIds.constEnd())
+            return it.value();
+    }
+    return sourceIdInsert(source, source.toUtf8());
+}
+
+quint16 mbCoreLogRing::sourceId(const char *source)
+{
+    {
+        // raw data key avoids copy of the source string
+        QByteArray key = QByteArray::fromRawData(source, static_cast<int>(strlen(source)));
+        QReadLocker _(&m_sourceLock);
+        QHash<QByteArray, quint16>::const_iterator it = m_sourceIdsUtf8.constFind(key);
+        if (it != m_sourceIdsUtf8.constEnd())
+            return it.value();
+    }
+    return sourceIdInsert(QString::fromUtf8(source), QByteArray(source));
+}
+
+quint16 mbCoreLogRing::sourceIdInsert(const QString &source, const QByteArray &utf8)
+{
+    QWriteLocker _(&m_sourceLock);
+    QHash<QString, quint16>::const_iterator it = m_sourceIds.constFind(source);
+    if (it != m_sourceIds.constEnd())
+        return it.value();
+    if (m_sources.count() >= LOGRING_SOURCE_MAX)
+        return 0;
+    quint16 id = static_cast<quint16>(m_sources.count());
+    m_sources.append(source);
+    m_sourceIds.insert(source, id);
+    m_sourceIdsUtf8.insert(utf8, id);
+    return id;
+}
+
+QString mbCoreLogRing::sourceName(quint16 id) const
+{
+    QReadLocker _(&m_sourceLock);
+    return m_sources.value(id);
+}
@@ -0,0 +1,111 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef CORE_LOGRING_H
+#define CORE_LOGRING_H
+
+#include <QAtomicInteger>
+#include <QReadWriteLock>
+#include <QHash>
+#include <QVector>
+
+#include <mbcore.h>
+
+struct mbCoreLogMessage
+{
+    qint64 timestamp; // msecs since epoch
+    mb::LogFlag flag;
+    QString source;
+    QString text;
+};
+
+typedef QVector<mbCoreLogMessage> mbCoreLogMessages;
+
+/*
+   Bounded multi-producer/single-consumer ring of fixed-size log records.
+   Producers (port, simulation and script threads) never lock the ring and
+   never allocate memory: record slot is claimed by atomic increment of write
+   position and guarded by per-slot sequence number (seqlock). Source names are
+   interned into small ids, so record holds flag, source id, timestamp and
+   text copy limited by 'PayloadSize' characters.
+   When consumer (GUI thread) falls behind, the oldest records are overwritten
+   (drop-oldest) and counted in 'droppedCount()'.
+*/
+class MB_EXPORT mbCoreLogRing
+{
+public:
+    enum
+    {
+        CapacityBits = 11,
+        Capacity     = 1 << CapacityBits, // records
+        PayloadSize  = 1000,              // characters of text, longer text is truncated
+        DrainPeriod  = 50                 // msec, rate the consumer drains ring with
+    };
+
+public:
+    mbCoreLogRing();
+    ~mbCoreLogRing();
+
+public: // producer interface (any thread)
+    void push(mb::LogFlag flag, const QString &source, const QString &text);
+    void push(mb::LogFlag flag, const QString &source, const char *text);
+    void push(mb::LogFlag flag, const char *source, const char *text);
+
+public: // consumer interface (single thread)
+    int drain(mbCoreLogMessages &messages, int maxCount = Capacity);
+    inline quint64 droppedCount() const { return m_dropped.loadAcquire(); }
+
+private:
+    struct Record
+    {
+        QAtomicInteger<quint64> seq; // 2*pos+1 while writing, 2*pos+2 when record is ready
+        qint64 timestamp;
+        quint32 flag;
+        quint16 source;
+        quint16 size;
+        bool truncated;
+        ushort payload[PayloadSize];
+    };
+
+private:
+    void write(mb::LogFlag flag, quint16 source, const QString &text);
+    void write(mb::LogFlag flag, quint16 source, const char *text);
+    Record *beginWrite(quint64 &pos, quint16 source, mb::LogFlag flag);
+    inline void endWrite(Record *r, quint64 pos) { r->seq.storeRelease(2*pos+2); }
+    quint16 sourceId(const QString &source);
+    quint16 sourceId(const char *source);
+    quint16 sourceIdInsert(const QString &source, const QByteArray &utf8);
+    QString sourceName(quint16 id) const;
+
+private:
+    Record *m_records;
+    QAtomicInteger<quint64> m_head;
+    QAtomicInteger<quint64> m_dropped;
+    quint64 m_tail;
+    quint64 m_stall;
+    mutable QReadWriteLock m_sourceLock;
+    QHash<QString, quint16> m_sourceIds;
+    QHash<QByteArray, quint16> m_sourceIdsUtf8;
+    QVector<QString> m_sources;
+};
+
+#endif // CORE_LOGRING_H
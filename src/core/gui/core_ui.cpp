@@ -50,6 +50,7 @@
 
 #include "core_windowmanager.h"
 #include "logview/core_logview.h"
+#include "trend/core_trendview.h"
 
 #define RECENT_PROJECTS_COUNT 20
 
@@ -86,6 +87,10 @@ mbCoreUi::mbCoreUi(mbCore *core, QWidget *parent) :
     connect(core, &mbCore::projectChanged, this, &mbCoreUi::setProject);
 
     m_logView = new mbCoreLogView(this);
+    m_trendView = new mbCoreTrendView(this);
+    m_dockTrendView = nullptr;
+    m_actionViewTrendView = nullptr;
+    m_actionDataViewItemTrend = nullptr;
     m_builder = m_core->builderCore();
     m_dialogs = nullptr;
     m_windowManager = nullptr;
@@ -115,6 +120,14 @@ void mbCoreUi::initialize()
 {
     m_ui.dockLogView->setWidget(logView());
 
+    // Trend
+    m_dockTrendView = new QDockWidget("Trend", this);
+    m_dockTrendView->setObjectName(QStringLiteral("dockTrendView"));
+    m_dockTrendView->setWidget(m_trendView);
+    this->addDockWidget(Qt::BottomDockWidgetArea, m_dockTrendView);
+    this->tabifyDockWidget(m_ui.dockLogView, m_dockTrendView);
+    m_ui.dockLogView->raise();
+
     m_help = new mbCoreHelpUi(m_helpFile, this);
 
     connect(m_projectUi, &mbCoreProjectUi::portDoubleClick   , this, &mbCoreUi::menuSlotPortEdit  );
@@ -175,6 +188,9 @@ void mbCoreUi::initialize()
     // Menu View
     connect(m_ui.actionViewProject, &QAction::triggered, this, &mbCoreUi::menuSlotViewProject);
     connect(m_ui.actionViewLogView, &QAction::triggered, this, &mbCoreUi::menuSlotViewLogView);
+    m_actionViewTrendView = new QAction("Trend", this);
+    m_ui.menuView->addAction(m_actionViewTrendView);
+    connect(m_actionViewTrendView, &QAction::triggered, this, &mbCoreUi::menuSlotViewTrendView);
 
     // Menu Port
     m_ui.actionPortNew->setShortcut(QKeySequence(Qt::ALT | Qt::Key_N));
@@ -207,6 +223,11 @@ void mbCoreUi::initialize()
     connect(m_ui.actionDataViewDelete     , &QAction::triggered, this, &mbCoreUi::menuSlotDataViewDelete     );
     connect(m_ui.actionDataViewImport     , &QAction::triggered, this, &mbCoreUi::menuSlotDataViewImport     );
     connect(m_ui.actionDataViewExport     , &QAction::triggered, this, &mbCoreUi::menuSlotDataViewExport     );
+    // context menu of data view copies actions of the menu so 'Add to Trend' is available there too
+    m_actionDataViewItemTrend = new QAction("Add to Trend", this);
+    m_ui.menuDataView->insertAction(m_ui.actionDataViewImportItems, m_actionDataViewItemTrend);
+    m_ui.menuDataView->insertSeparator(m_ui.actionDataViewImportItems);
+    connect(m_actionDataViewItemTrend, &QAction::triggered, this, &mbCoreUi::menuSlotDataViewItemTrend);
 
     // Menu Tools
     connect(m_ui.actionToolsSettings   , &QAction::triggered, this, &mbCoreUi::menuSlotToolsSettings   );
@@ -304,6 +325,7 @@ MBSETTINGS mbCoreUi::cachedSettings() const
     const Strings &s = Strings::instance();
     MBSETTINGS r = m_dialogs->cachedSettings();
     mb::unite(r, m_logView->cachedSettings());
+    mb::unite(r, m_trendView->cachedSettings());
     mb::unite(r, m_help->cachedSettings());
     r[s.settings_useNameWithSettings] = useNameWithSettings();
     r[s.settings_recentProjects] = cachedSettingsRecentProjects();
@@ -349,6 +371,7 @@ void mbCoreUi::setCachedSettings(const MBSETTINGS &settings)
 
     m_dialogs->setCachedSettings(settings);
     m_logView->setCachedSettings(settings);
+    m_trendView->setCachedSettings(settings);
     m_help->setCachedSettings(settings);
 }
 
@@ -357,6 +380,11 @@ void mbCoreUi::logMessage(mb::LogFlag flag, const QString &source, const QString
     m_logView->logMessage(flag, source, text);
 }
 
+void mbCoreUi::logMessages(const mbCoreLogMessages &messages)
+{
+    m_logView->logMessages(messages);
+}
+
 void mbCoreUi::outputMessage(const QString &/*message*/)
 {
 }
@@ -537,6 +565,12 @@ void mbCoreUi::menuSlotViewLogView()
     m_ui.dockLogView->show();
 }
 
+void mbCoreUi::menuSlotViewTrendView()
+{
+    m_dockTrendView->show();
+    m_dockTrendView->raise();
+}
+
 void mbCoreUi::menuSlotPortNew()
 {
 }
@@ -713,6 +747,20 @@ void mbCoreUi::menuSlotDataViewItemDelete()
     }
 }
 
+void mbCoreUi::menuSlotDataViewItemTrend()
+{
+    mbCoreDataViewUi *ui = m_dataViewManager->activeDataViewUiCore();
+    if (ui)
+    {
+        QList<mbCoreDataViewItem*> items = ui->selectedItemsCore();
+        if (items.count())
+        {
+            m_trendView->addItems(items);
+            menuSlotViewTrendView();
+        }
+    }
+}
+
 void mbCoreUi::menuSlotDataViewImportItems()
 {
     mbCoreDataViewUi *ui = m_dataViewManager->activeDataViewUiCore();
@@ -42,6 +42,7 @@ class mbCoreDataView;
 class mbCoreDataViewUi;
 class mbCoreProjectUi;
 class mbCoreLogView;
+class mbCoreTrendView;
 class mbCoreOutputView;
 class mbCoreHelpUi;
 
@@ -99,6 +100,7 @@ public: // settings
 
 public Q_SLOTS:
     void logMessage(mb::LogFlag flag, const QString &source, const QString &text);
+    void logMessages(const mbCoreLogMessages &messages);
     virtual void outputMessage(const QString& message);
 
 protected Q_SLOTS:
@@ -131,6 +133,7 @@ protected Q_SLOTS:
     // ----------------------------
     virtual void menuSlotViewProject();
     virtual void menuSlotViewLogView();
+    virtual void menuSlotViewTrendView();
     // ----------------------------
     // ------------PORT------------
     // ----------------------------
@@ -154,6 +157,7 @@ protected Q_SLOTS:
     virtual void menuSlotDataViewItemEdit   ();
     virtual void menuSlotDataViewItemInsert ();
     virtual void menuSlotDataViewItemDelete ();
+    virtual void menuSlotDataViewItemTrend  ();
     virtual void menuSlotDataViewImportItems();
     virtual void menuSlotDataViewExportItems();
     virtual void menuSlotDataViewNew        ();
@@ -244,6 +248,7 @@ protected:
     QSystemTrayIcon* m_tray;
     QString m_helpFile;
     mbCoreLogView *m_logView;
+    mbCoreTrendView *m_trendView;
     mbCoreHelpUi *m_help;
 
 protected:
@@ -322,6 +327,10 @@ protected:
     QAction *m_actionFileRecentClear;
     // Output
     QDockWidget *m_dockOutput;
+    // Trend
+    QDockWidget *m_dockTrendView;
+    QAction *m_actionViewTrendView;
+    QAction *m_actionDataViewItemTrend;
 
     QLabel *m_lbSystemName;
     QLabel *m_lbSystemStatus;
@@ -22,6 +22,8 @@
 */
 #include "core_dataviewmodel.h"
 
+#include <QTimerEvent>
+
 #include <core.h>
 #include <project/core_project.h>
 #include <project/core_dataview.h>
@@ -30,6 +32,9 @@ mbCoreDataViewModel::mbCoreDataViewModel(mbCoreDataView *dataView, QObject *pare
     QAbstractTableModel(parent)
 {
     m_dataView = dataView;
+    m_timerId = 0;
+    m_firstVisibleRow = 0;
+    m_lastVisibleRow = -1;
     connect(m_dataView, &mbCoreDataView::itemAdded  , this, &mbCoreDataViewModel::itemAdded);
     connect(m_dataView, &mbCoreDataView::itemRemoved, this, &mbCoreDataViewModel::itemRemoving);
     connect(m_dataView, &mbCoreDataView::itemChanged, this, &mbCoreDataViewModel::itemChanged);
@@ -163,23 +168,74 @@ mbCoreDataViewItem *mbCoreDataViewModel::itemCore(const QModelIndex &index) cons
     return m_dataView->itemCore(index.row());
 }
 
+void mbCoreDataViewModel::setVisibleRows(int firstRow, int lastRow)
+{
+    m_firstVisibleRow = firstRow;
+    m_lastVisibleRow = lastRow;
+}
+
+void mbCoreDataViewModel::timerEvent(QTimerEvent *event)
+{
+    if (event->timerId() == m_timerId)
+    {
+        killTimer(m_timerId);
+        m_timerId = 0;
+        flushChanges();
+    }
+    else
+        QAbstractTableModel::timerEvent(event);
+}
+
+void mbCoreDataViewModel::flushChanges()
+{
+    // changed rows are signaled as contiguous ranges within visible rows only
+    int first = qMax(m_firstVisibleRow, 0);
+    int last = rowCount()-1;
+    if ((m_lastVisibleRow >= 0) && (m_lastVisibleRow < last))
+        last = m_lastVisibleRow;
+    int lastColumn = columnCount()-1;
+    int rangeFirst = -1;
+    for (int r = first; r <= last; r++)
+    {
+        if (m_changed.contains(m_dataView->itemCoreAt(r)))
+        {
+            if (rangeFirst < 0)
+                rangeFirst = r;
+        }
+        else if (rangeFirst >= 0)
+        {
+            Q_EMIT dataChanged(createIndex(rangeFirst, 0), createIndex(r-1, lastColumn));
+            rangeFirst = -1;
+        }
+    }
+    if (rangeFirst >= 0)
+        Q_EMIT dataChanged(createIndex(rangeFirst, 0), createIndex(last, lastColumn));
+    m_changed.clear();
+}
+
 void mbCoreDataViewModel::itemAdded(mbCoreDataViewItem * /*item*/)
 {
     beginResetModel();
     endResetModel();
 }
 
-void mbCoreDataViewModel::itemRemoving(mbCoreDataViewItem * /*item*/)
+void mbCoreDataViewModel::itemRemoving(mbCoreDataViewItem *item)
 {
     beginResetModel();
+    m_changed.remove(item);
     endResetModel();
 }
 
 void mbCoreDataViewModel::itemChanged(mbCoreDataViewItem* item)
 {
-    int i = m_dataView->itemIndex(item);
-    Q_EMIT dataChanged(createIndex(i, 0), createIndex(i, columnCount()));
-
+    m_changed.insert(item);
+    if (m_timerId)
+        return;
+    int rate = mbCore::globalCore()->refreshRate();
+    if (rate > 0)
+        m_timerId = startTimer(qMax(1000 / rate, 1));
+    else
+        flushChanges();
 }
 
 void mbCoreDataViewModel::reset()
@@ -24,6 +24,7 @@
 #define CORE_DATAVIEWMODEL_H
 
 #include <QAbstractTableModel>
+#include <QSet>
 
 #include <mbcore.h>
 
@@ -41,6 +42,9 @@ public:
     inline mbCoreDataView *dataViewCore() const { return m_dataView; }
     QModelIndex itemIndex(mbCoreDataViewItem *item) const;
     mbCoreDataViewItem *itemCore(const QModelIndex &index) const;
+    // Rows shown by the view, 'lastRow' < 0 means all rows till the end.
+    // Changes of rows out of this range are not signaled (they are read when scrolled in)
+    void setVisibleRows(int firstRow, int lastRow);
 
 public: // table model interface
     QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
@@ -50,6 +54,10 @@ public: // table model interface
     bool setData(const QModelIndex &index, const QVariant &value, int role = Qt::EditRole) override;
     Qt::ItemFlags flags(const QModelIndex &index) const override;
 
+protected:
+    void timerEvent(QTimerEvent *event) override;
+    void flushChanges();
+
 protected:
     virtual QVariant dataDisplayEdit(const QModelIndex& index, int role = Qt::DisplayRole) const;
     virtual bool setDataEdit(const QModelIndex &index, const QVariant &value, int role = Qt::EditRole);
@@ -62,6 +70,11 @@ protected Q_SLOTS:
 
 protected:
     mbCoreDataView *m_dataView;
+    // items changed since last flush, flushed at most 'mbCore::refreshRate()' times per second
+    QSet<mbCoreDataViewItem*> m_changed;
+    int m_timerId;
+    int m_firstVisibleRow;
+    int m_lastVisibleRow;
 };
 
 #endif // CORE_DATAVIEWMODEL_H
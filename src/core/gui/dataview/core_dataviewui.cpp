@@ -32,6 +32,7 @@
 #include <QFileInfo>
 #include <QDir>
 #include <QInputDialog>
+#include <QScrollBar>
 
 #include <QVBoxLayout>
 #include <QTableView>
@@ -81,8 +82,10 @@ mbCoreDataViewUi::mbCoreDataViewUi(mbCoreDataView *dataView, mbCoreDataViewModel
     header = m_view->horizontalHeader();
     header->setStretchLastSection(true);
     //header->setSectionResizeMode(QHeaderView::ResizeToContents);
+    // Rows have fixed height: content based sizing would query every row on each change
     header = m_view->verticalHeader();
-    header->setSectionResizeMode(QHeaderView::ResizeToContents);
+    header->setSectionResizeMode(QHeaderView::Fixed);
+    header->setDefaultSectionSize(m_view->fontMetrics().height()+6);
 
     QString headerStyleSheet = R"(
     QHeaderView::section {
@@ -105,6 +108,10 @@ mbCoreDataViewUi::mbCoreDataViewUi(mbCoreDataView *dataView, mbCoreDataViewModel
 
     connect(dataView, &mbCoreDataView::nameChanged, this, &mbCoreDataViewUi::nameChanged);
 
+    // range of the scroll bar is changed when view is resized or rows are added/removed
+    connect(m_view->verticalScrollBar(), &QScrollBar::valueChanged, this, &mbCoreDataViewUi::updateVisibleRows);
+    connect(m_view->verticalScrollBar(), &QScrollBar::rangeChanged, this, &mbCoreDataViewUi::updateVisibleRows);
+
     QVBoxLayout *layout = new QVBoxLayout(this);
     layout->setMargin(0);
     layout->addWidget(m_view);
@@ -177,3 +184,10 @@ void mbCoreDataViewUi::contextMenu(const QModelIndex &index)
         Q_EMIT itemContextMenu(item);
 }
 
+void mbCoreDataViewUi::updateVisibleRows()
+{
+    int firstRow = m_view->rowAt(0);
+    int lastRow = m_view->rowAt(m_view->viewport()->height()-1); // -1 when rows end above the bottom
+    m_model->setVisibleRows(qMax(firstRow, 0), lastRow);
+}
+
@@ -72,6 +72,7 @@ public Q_SLOTS:
 protected Q_SLOTS:
     void doubleClick(const QModelIndex &index);
     void contextMenu(const QModelIndex &index);
+    void updateVisibleRows();
 
 protected:
     QTableView *m_view;
@@ -128,8 +128,13 @@ void mbCoreDialogSettings::fillForm(const MBSETTINGS &m)
     m_log->setUseTimestamp  (m.value(sCore.settings_useTimestamp  ).toBool());
     m_log->setFormatDateTime(m.value(sCore.settings_formatDateTime).toString());
     m_log->setLogViewFont   (m.value(sLogView.font).toString());
+    m_log->setCaptureEnable      (m.value(sCore.settings_captureEnable     ).toBool());
+    m_log->setCapturePath        (m.value(sCore.settings_capturePath       ).toString());
+    m_log->setCaptureMaxFileSize (m.value(sCore.settings_captureMaxFileSize).toInt());
+    m_log->setCaptureMaxFileTime (m.value(sCore.settings_captureMaxFileTime).toInt());
 
     m_dataView->setColumns(m.value(sCore.settings_columns).toStringList());
+    m_dataView->setRefreshRate(m.value(sCore.settings_refreshRate).toInt());
 }
 
 void mbCoreDialogSettings::fillData(MBSETTINGS &m)
@@ -145,7 +150,12 @@ void mbCoreDialogSettings::fillData(MBSETTINGS &m)
     m[sCore.settings_useTimestamp   ] = m_log->useTimestamp();
     m[sCore.settings_formatDateTime ] = m_log->formatDateTime();
     m[sLogView.font                 ] = m_log->logViewFont();
+    m[sCore.settings_captureEnable     ] = m_log->captureEnable();
+    m[sCore.settings_capturePath       ] = m_log->capturePath();
+    m[sCore.settings_captureMaxFileSize] = m_log->captureMaxFileSize();
+    m[sCore.settings_captureMaxFileTime] = m_log->captureMaxFileTime();
 
     m[sCore.settings_columns        ] = m_dataView->getColumns();
+    m[sCore.settings_refreshRate    ] = m_dataView->refreshRate();
 
 }
@@ -13,6 +13,7 @@ mbCoreWidgetSettingsDataView::mbCoreWidgetSettingsDataView(QWidget *parent) :
 
     QStringList columns = mbCore::globalCore()->availableDataViewColumns();
     setColumns(columns);
+    setRefreshRate(mbCore::Defaults::instance().settings_refreshRate);
     connect(ui->btnEditDataViewColumns, &QPushButton::clicked, this, &mbCoreWidgetSettingsDataView::slotEditColumns);
 }
 
@@ -39,6 +40,16 @@ void mbCoreWidgetSettingsDataView::setColumns(const QStringList &columns)
         ui->lsDataViewColumns->addItem(column);
 }
 
+int mbCoreWidgetSettingsDataView::refreshRate() const
+{
+    return ui->spRefreshRate->value();
+}
+
+void mbCoreWidgetSettingsDataView::setRefreshRate(int hz)
+{
+    ui->spRefreshRate->setValue(hz);
+}
+
 void mbCoreWidgetSettingsDataView::slotEditColumns()
 {
     QStringList ls = getColumns();
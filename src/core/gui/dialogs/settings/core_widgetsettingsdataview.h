@@ -20,6 +20,8 @@ public:
 public: // properties
     QStringList getColumns() const;
     void setColumns(const QStringList &columns);
+    int refreshRate() const;
+    void setRefreshRate(int hz);
 
 private Q_SLOTS:
     void slotEditColumns();
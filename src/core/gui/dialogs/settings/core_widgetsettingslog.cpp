@@ -14,6 +14,7 @@ mbCoreWidgetSettingsLog::mbCoreWidgetSettingsLog(QWidget *parent) :
 
     setLogViewFont(mbCoreLogView::Defaults::instance().font);
     connect(ui->btnFont, &QPushButton::clicked, this, &mbCoreWidgetSettingsLog::slotFont);
+    connect(ui->btnCapturePath, &QPushButton::clicked, this, &mbCoreWidgetSettingsLog::slotCapturePath);
 
 }
 
@@ -77,6 +78,46 @@ void mbCoreWidgetSettingsLog::setLogViewFont(const QString &font)
     setLogViewFont(f);
 }
 
+bool mbCoreWidgetSettingsLog::captureEnable() const
+{
+    return ui->chbCaptureEnable->isChecked();
+}
+
+void mbCoreWidgetSettingsLog::setCaptureEnable(bool enable)
+{
+    ui->chbCaptureEnable->setChecked(enable);
+}
+
+QString mbCoreWidgetSettingsLog::capturePath() const
+{
+    return ui->lnCapturePath->text();
+}
+
+void mbCoreWidgetSettingsLog::setCapturePath(const QString &path)
+{
+    ui->lnCapturePath->setText(path);
+}
+
+int mbCoreWidgetSettingsLog::captureMaxFileSize() const
+{
+    return ui->spCaptureMaxFileSize->value();
+}
+
+void mbCoreWidgetSettingsLog::setCaptureMaxFileSize(int megabytes)
+{
+    ui->spCaptureMaxFileSize->setValue(megabytes);
+}
+
+int mbCoreWidgetSettingsLog::captureMaxFileTime() const
+{
+    return ui->spCaptureMaxFileTime->value();
+}
+
+void mbCoreWidgetSettingsLog::setCaptureMaxFileTime(int minutes)
+{
+    ui->spCaptureMaxFileTime->setValue(minutes);
+}
+
 QFont mbCoreWidgetSettingsLog::getLogViewFont() const
 {
     QFont f = ui->cmbFontFamily->currentFont();
@@ -99,3 +140,11 @@ void mbCoreWidgetSettingsLog::slotFont()
         setLogViewFont(f);
     }
 }
+
+void mbCoreWidgetSettingsLog::slotCapturePath()
+{
+    mbCoreUi *ui = mbCore::globalCore()->coreUi();
+    QString dir = ui->dialogsCore()->getExistingDirectory(ui, QStringLiteral("Capture Directory"), capturePath());
+    if (dir.count())
+        setCapturePath(dir);
+}
@@ -30,12 +30,25 @@ public: // properties
     QString logViewFont() const;
     void setLogViewFont(const QString &font);
 
+    bool captureEnable() const;
+    void setCaptureEnable(bool enable);
+
+    QString capturePath() const;
+    void setCapturePath(const QString &path);
+
+    int captureMaxFileSize() const;
+    void setCaptureMaxFileSize(int megabytes);
+
+    int captureMaxFileTime() const;
+    void setCaptureMaxFileTime(int minutes);
+
 protected:
     QFont getLogViewFont() const;
     void setLogViewFont(const QFont &f);
 
 private Q_SLOTS:
     void slotFont();
+    void slotCapturePath();
 
 private:
     Ui::mbCoreWidgetSettingsLog *ui;
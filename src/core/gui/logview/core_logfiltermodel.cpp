@@ -0,0 +1,260 @@
+#include "core_logfiltermodel.h"
+
+#include <algorithm>
+
+mbCoreLogSearch::mbCoreLogSearch(QObject *parent) :
+    QThread(parent)
+{
+    m_regex = false;
+}
+
+mbCoreLogSearch::~mbCoreLogSearch()
+{
+    cancel();
+}
+
+void mbCoreLogSearch::search(const Items &items, const QString &pattern, bool regex)
+{
+    // previous search may still be leaving 'run()'
+    wait();
+    m_items = items;
+    m_pattern = pattern;
+    m_regex = regex;
+    m_result.clear();
+    m_cancel.storeRelease(0);
+    m_done.storeRelease(0);
+    start(QThread::LowPriority);
+}
+
+void mbCoreLogSearch::cancel()
+{
+    m_cancel.storeRelease(1);
+    wait();
+}
+
+void mbCoreLogSearch::run()
+{
+    const int CheckPeriod = 256;
+    QVector<qint64> r;
+    if (m_regex)
+    {
+        QRegularExpression re(m_pattern, QRegularExpression::CaseInsensitiveOption);
+        if (re.isValid())
+        {
+            re.optimize();
+            for (int i = 0; i < m_items.count(); i++)
+            {
+                if (((i % CheckPeriod) == 0) && isCanceled())
+                    return;
+                const Item &item = m_items.at(i);
+                if (re.match(item.text).hasMatch())
+                    r.append(item.seq);
+            }
+        }
+    }
+    else
+    {
+        QStringMatcher matcher(m_pattern, Qt::CaseInsensitive);
+        for (int i = 0; i < m_items.count(); i++)
+        {
+            if (((i % CheckPeriod) == 0) && isCanceled())
+                return;
+            const Item &item = m_items.at(i);
+            if (matcher.indexIn(item.text) >= 0)
+                r.append(item.seq);
+        }
+    }
+    m_items = Items();
+    m_result.swap(r);
+    m_done.storeRelease(1);
+}
+
+mbCoreLogFilterModel::mbCoreLogFilterModel(mbCoreLogViewModel *model, QObject *parent) :
+    QAbstractTableModel(parent),
+    m_model(model)
+{
+    m_searching = false;
+    m_searchEnd = 0;
+    m_search = new mbCoreLogSearch(this);
+    connect(m_search, &QThread::finished, this, &mbCoreLogFilterModel::searchFinished);
+
+    connect(m_model, &QAbstractItemModel::rowsInserted, this, &mbCoreLogFilterModel::modelRowsInserted);
+    connect(m_model, &QAbstractItemModel::rowsRemoved , this, &mbCoreLogFilterModel::modelRowsRemoved );
+    connect(m_model, &QAbstractItemModel::dataChanged , this, &mbCoreLogFilterModel::modelDataChanged );
+    connect(m_model, &QAbstractItemModel::modelReset  , this, &mbCoreLogFilterModel::modelReset       );
+}
+
+mbCoreLogFilterModel::~mbCoreLogFilterModel()
+{
+    m_search->cancel();
+}
+
+QVariant mbCoreLogFilterModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    return m_model->headerData(section, orientation, role);
+}
+
+int mbCoreLogFilterModel::rowCount(const QModelIndex &/*index*/) const
+{
+    return m_seqs.count();
+}
+
+int mbCoreLogFilterModel::columnCount(const QModelIndex &) const
+{
+    return mbCoreLogViewModel::ColumnCount;
+}
+
+QVariant mbCoreLogFilterModel::data(const QModelIndex &index, int role) const
+{
+    int r = index.row();
+    if (r >= 0 && r < m_seqs.count())
+        return m_model->data(m_model->index(sourceRow(r), index.column()), role);
+    return QVariant();
+}
+
+void mbCoreLogFilterModel::setFilter(const Filter &filter)
+{
+    m_filter = filter;
+    m_matcher.setPattern(filter.text);
+    m_matcher.setCaseSensitivity(Qt::CaseInsensitive);
+    m_regex.setPattern(filter.regex ? filter.text : QString());
+    m_regex.setPatternOptions(QRegularExpression::CaseInsensitiveOption);
+    refilter();
+}
+
+void mbCoreLogFilterModel::modelRowsInserted(const QModelIndex &/*parent*/, int first, int last)
+{
+    // records inserted while searching are checked when search is finished
+    if (m_searching || m_filter.isEmpty())
+        return;
+    qint64 seq = m_model->firstSeq();
+    appendMatches(seq+first, seq+last+1);
+}
+
+void mbCoreLogFilterModel::modelRowsRemoved(const QModelIndex &/*parent*/, int /*first*/, int /*last*/)
+{
+    // base model removes oldest records only
+    qint64 seq = m_model->firstSeq();
+    int c = 0;
+    while (c < m_seqs.count() && m_seqs.at(c) < seq)
+        c++;
+    if (c > 0)
+    {
+        beginRemoveRows(QModelIndex(), 0, c-1);
+        m_seqs.popFront(c);
+        endRemoveRows();
+    }
+}
+
+void mbCoreLogFilterModel::modelDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight)
+{
+    if (m_seqs.count())
+        Q_EMIT dataChanged(index(0, topLeft.column()), index(m_seqs.count()-1, bottomRight.column()));
+}
+
+void mbCoreLogFilterModel::modelReset()
+{
+    refilter();
+}
+
+void mbCoreLogFilterModel::searchFinished()
+{
+    if (!m_searching || !m_search->isDone())
+        return;
+    QVector<qint64> r = m_search->result();
+    // drop records evicted while searching
+    QVector<qint64>::iterator it = std::lower_bound(r.begin(), r.end(), m_model->firstSeq());
+    r.erase(r.begin(), it);
+    beginResetModel();
+    m_seqs.assign(r);
+    m_searching = false;
+    endResetModel();
+    appendMatches(qMax(m_searchEnd, m_model->firstSeq()), m_model->lastSeq());
+    Q_EMIT searchStateChanged(false);
+}
+
+bool mbCoreLogFilterModel::matches(qint64 seq) const
+{
+    const mbCoreLogMessage &m = m_model->messageBySeq(seq);
+    if (m_filter.source.count() && (m.source != m_filter.source))
+        return false;
+    if (m_filter.categories && !(m.flag & m_filter.categories))
+        return false;
+    return matchesText(m.text);
+}
+
+bool mbCoreLogFilterModel::matchesText(const QString &text) const
+{
+    if (m_filter.text.isEmpty())
+        return true;
+    if (m_filter.regex)
+        return m_regex.isValid() && m_regex.match(text).hasMatch();
+    return m_matcher.indexIn(text) >= 0;
+}
+
+void mbCoreLogFilterModel::refilter()
+{
+    bool searching = m_searching;
+    cancelSearch();
+    // source and category are taken from incremental indexes of base model,
+    // only text is searched in background over selected records
+    if (m_filter.isEmpty())
+    {
+        // base model is shown as is, proxy stays empty
+        beginResetModel();
+        m_seqs.clear();
+        endResetModel();
+        if (searching)
+            Q_EMIT searchStateChanged(false);
+        return;
+    }
+    QVector<qint64> seqs = m_model->seqs(m_filter.source, m_filter.categories);
+    beginResetModel();
+    if (m_filter.text.isEmpty())
+    {
+        m_seqs.assign(seqs);
+        endResetModel();
+        if (searching)
+            Q_EMIT searchStateChanged(false);
+        return;
+    }
+    m_seqs.clear();
+    mbCoreLogSearch::Items items(seqs.count());
+    for (int i = 0; i < seqs.count(); i++)
+    {
+        mbCoreLogSearch::Item &item = items[i];
+        item.seq = seqs.at(i);
+        item.text = m_model->messageBySeq(item.seq).text; // implicitly shared, no copy of text
+    }
+    m_searchEnd = m_model->lastSeq();
+    m_searching = true;
+    endResetModel();
+    m_search->search(items, m_filter.text, m_filter.regex);
+    Q_EMIT searchStateChanged(true);
+}
+
+void mbCoreLogFilterModel::cancelSearch()
+{
+    if (m_searching)
+    {
+        m_search->cancel();
+        m_searching = false;
+    }
+}
+
+void mbCoreLogFilterModel::appendMatches(qint64 begin, qint64 end)
+{
+    QVector<qint64> r;
+    for (qint64 seq = begin; seq < end; seq++)
+    {
+        if (matches(seq))
+            r.append(seq);
+    }
+    if (r.isEmpty())
+        return;
+    int c = m_seqs.count();
+    beginInsertRows(QModelIndex(), c, c+r.count()-1);
+    for (int i = 0; i < r.count(); i++)
+        m_seqs.append(r.at(i));
+    endInsertRows();
+}
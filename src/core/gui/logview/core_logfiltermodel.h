@@ -0,0 +1,107 @@
+#ifndef CORE_LOGFILTERMODEL_H
+#define CORE_LOGFILTERMODEL_H
+
+#include <QThread>
+#include <QStringMatcher>
+#include <QRegularExpression>
+
+#include "core_logviewmodel.h"
+
+// Text search over snapshot of log records, runs on its own thread and can be canceled
+class mbCoreLogSearch : public QThread
+{
+public:
+    struct Item
+    {
+        qint64 seq;
+        QString text;
+    };
+    typedef QVector<Item> Items;
+
+public:
+    explicit mbCoreLogSearch(QObject *parent = nullptr);
+    ~mbCoreLogSearch();
+
+public:
+    void search(const Items &items, const QString &pattern, bool regex);
+    void cancel();
+    inline bool isCanceled() const { return m_cancel.loadAcquire() != 0; }
+    // 'finished()' of canceled or previous search can be delivered late, so result is valid only when done
+    inline bool isDone() const { return m_done.loadAcquire() != 0; }
+    inline QVector<qint64> result() const { return m_result; }
+
+protected:
+    void run() override;
+
+private:
+    Items m_items;
+    QString m_pattern;
+    bool m_regex;
+    QAtomicInt m_cancel;
+    QAtomicInt m_done;
+    QVector<qint64> m_result;
+};
+
+// Shows only records of base model which match the filter (empty filter - no records).
+// Rows are sequence numbers of the base model records so records are never copied
+class mbCoreLogFilterModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    struct Filter
+    {
+        Filter() : categories(0), regex(false) {}
+        QString source;  // empty - any source
+        int categories;  // mask of 'mb::LogFlag', 0 - any category
+        QString text;    // substring or regular expression (case insensitive), empty - any text
+        bool regex;
+        inline bool isEmpty() const { return source.isEmpty() && !categories && text.isEmpty(); }
+    };
+
+public:
+    explicit mbCoreLogFilterModel(mbCoreLogViewModel *model, QObject *parent = nullptr);
+    ~mbCoreLogFilterModel();
+
+public:
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    int rowCount(const QModelIndex &index = QModelIndex()) const override;
+    int columnCount(const QModelIndex& = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+public:
+    inline mbCoreLogViewModel *logModel() const { return m_model; }
+    inline int sourceRow(int row) const { return m_model->rowBySeq(m_seqs.at(row)); }
+    inline const Filter &filter() const { return m_filter; }
+    void setFilter(const Filter &filter);
+    inline bool isSearching() const { return m_searching; }
+
+Q_SIGNALS:
+    void searchStateChanged(bool searching);
+
+private Q_SLOTS:
+    void modelRowsInserted(const QModelIndex &parent, int first, int last);
+    void modelRowsRemoved(const QModelIndex &parent, int first, int last);
+    void modelDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight);
+    void modelReset();
+    void searchFinished();
+
+private:
+    bool matches(qint64 seq) const;
+    bool matchesText(const QString &text) const;
+    void refilter();
+    void cancelSearch();
+    void appendMatches(qint64 begin, qint64 end);
+
+private:
+    mbCoreLogViewModel *m_model;
+    mbCoreLogSearch *m_search;
+    Filter m_filter;
+    QStringMatcher m_matcher;
+    QRegularExpression m_regex;
+    mbCoreLogSeqIndex m_seqs;
+    bool m_searching;
+    qint64 m_searchEnd; // records added after snapshot of the running search are checked when it finishes
+};
+
+#endif // CORE_LOGFILTERMODEL_H
@@ -25,19 +25,28 @@
 #include <QVBoxLayout>
 #include <QHeaderView>
 #include <QTableView>
-#include <QPlainTextEdit>
+#include <QScrollBar>
 #include <QToolBar>
+#include <QComboBox>
+#include <QLineEdit>
+#include <QCheckBox>
+#include <QLabel>
 #include <QCoreApplication>
+#include <QFileInfo>
+#include <QDir>
 
 #include <core.h>
 #include <gui/core_ui.h>
 #include <gui/dialogs/core_dialogs.h>
+#include <runtime/core_capture.h>
 
-//#include "core_logviewmodel.h"
+#include "core_logviewmodel.h"
+#include "core_logfiltermodel.h"
 
 mbCoreLogView::Strings::Strings() :
     prefix(QStringLiteral("Ui.LogView.")),
-    font(prefix+QStringLiteral("font"))
+    font(prefix+QStringLiteral("font")),
+    maxCount(prefix+QStringLiteral("maxCount"))
 {
 }
 
@@ -48,7 +57,8 @@ const mbCoreLogView::Strings &mbCoreLogView::Strings::instance()
 }
 
 mbCoreLogView::Defaults::Defaults() :
-    font(QFont("Courier New", 8).toString())
+    font(QFont("Courier New", 8).toString()),
+    maxCount(100000)
 {
 }
 
@@ -66,19 +76,21 @@ mbCoreLogView::mbCoreLogView(QWidget *parent)
     m_toolBar->setIconSize(QSize(16,16));
     m_toolBar->setContentsMargins(0,0,0,0);
 
-    //m_view = new QTableView(this);
-    //m_model = new mbCoreLogViewModel(m_view);
-    //m_view->setModel(m_model);
-    //QHeaderView *header;
-    //header = m_view->horizontalHeader();
-    //header->setStretchLastSection(true);
-    //header->hide();
-    //header = m_view->verticalHeader();
-    //header->setSectionResizeMode(QHeaderView::ResizeToContents);
-    //header->hide();
-
-    m_view = new QPlainTextEdit(this);
-    m_view->setReadOnly(true);
+    m_view = new QTableView(this);
+    m_model = new mbCoreLogViewModel(m_view);
+    m_model->setMaxCount(Defaults::instance().maxCount);
+    m_filterModel = new mbCoreLogFilterModel(m_model, m_view);
+    m_view->setModel(m_model);
+    m_view->setSelectionBehavior(QAbstractItemView::SelectRows);
+    m_view->setWordWrap(false);
+    QHeaderView *header;
+    header = m_view->horizontalHeader();
+    header->setStretchLastSection(true);
+    header->hide();
+    // Rows have fixed height: content based sizing would query every row of the buffer
+    header = m_view->verticalHeader();
+    header->setSectionResizeMode(QHeaderView::Fixed);
+    header->hide();
     setFontString(Defaults::instance().font);
 
     QAction *actionClear = new QAction(m_toolBar);
@@ -93,6 +105,49 @@ mbCoreLogView::mbCoreLogView(QWidget *parent)
     connect(actionExportLog, &QAction::triggered, this, &mbCoreLogView::exportLog);
     m_toolBar->addAction(actionExportLog);
 
+    QAction *actionExportCapture = new QAction(m_toolBar);
+    actionExportCapture->setIcon(QIcon(":/core/icons/filesave.png"));
+    actionExportCapture->setText(QCoreApplication::translate("mbCoreLogView", "Export Capture to pcapng", nullptr));
+    connect(actionExportCapture, &QAction::triggered, this, &mbCoreLogView::exportCapture);
+    m_toolBar->addAction(actionExportCapture);
+
+    // filter: unfiltered log is shown by base model itself, filtered one - by proxy
+    m_toolBar->addSeparator();
+    m_cmbSource = new QComboBox(m_toolBar);
+    m_cmbSource->setSizeAdjustPolicy(QComboBox::AdjustToContents);
+    m_cmbSource->addItem(QCoreApplication::translate("mbCoreLogView", "All sources", nullptr));
+    connect(m_cmbSource, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &mbCoreLogView::applyFilter);
+    m_toolBar->addWidget(m_cmbSource);
+
+    m_cmbCategory = new QComboBox(m_toolBar);
+    m_cmbCategory->addItem(QCoreApplication::translate("mbCoreLogView", "All categories", nullptr), 0);
+    m_cmbCategory->addItem(m_model->categoryString(mb::Log_Error  ), mb::Log_Error  );
+    m_cmbCategory->addItem(m_model->categoryString(mb::Log_Warning), mb::Log_Warning);
+    m_cmbCategory->addItem(m_model->categoryString(mb::Log_Info   ), mb::Log_Info   );
+    m_cmbCategory->addItem(m_model->categoryString(mb::Log_Tx     ), mb::Log_Tx     );
+    m_cmbCategory->addItem(m_model->categoryString(mb::Log_Rx     ), mb::Log_Rx     );
+    m_cmbCategory->addItem(QStringLiteral("Tx/Rx")                 , mb::Log_Tx | mb::Log_Rx);
+    m_cmbCategory->addItem(m_model->categoryString(mb::Log_Debug  ), mb::Log_Debug  );
+    connect(m_cmbCategory, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &mbCoreLogView::applyFilter);
+    m_toolBar->addWidget(m_cmbCategory);
+
+    m_lnFilter = new QLineEdit(m_toolBar);
+    m_lnFilter->setPlaceholderText(QCoreApplication::translate("mbCoreLogView", "Search", nullptr));
+    m_lnFilter->setClearButtonEnabled(true);
+    connect(m_lnFilter, &QLineEdit::textChanged, this, &mbCoreLogView::applyFilter);
+    m_toolBar->addWidget(m_lnFilter);
+
+    m_chbRegex = new QCheckBox(QCoreApplication::translate("mbCoreLogView", "RegExp", nullptr), m_toolBar);
+    connect(m_chbRegex, &QCheckBox::toggled, this, &mbCoreLogView::applyFilter);
+    m_toolBar->addWidget(m_chbRegex);
+
+    m_lbFilter = new QLabel(m_toolBar);
+    m_lbFilter->setContentsMargins(4,0,4,0);
+    m_toolBar->addWidget(m_lbFilter);
+
+    connect(m_model, &mbCoreLogViewModel::sourcesChanged, this, &mbCoreLogView::refreshSources);
+    connect(m_filterModel, &mbCoreLogFilterModel::searchStateChanged, this, &mbCoreLogView::refreshFilterState);
+
     QVBoxLayout *layout = new QVBoxLayout(this);
     layout->setSpacing(0);
     layout->setContentsMargins(0,0,0,0);
@@ -110,7 +165,20 @@ void mbCoreLogView::setFontString(const QString &font)
 {
     QFont f = m_view->font();
     if (f.fromString(font))
+    {
         m_view->setFont(f);
+        setupColumns();
+    }
+}
+
+int mbCoreLogView::maxCount() const
+{
+    return m_model->maxCount();
+}
+
+void mbCoreLogView::setMaxCount(int maxCount)
+{
+    m_model->setMaxCount(maxCount);
 }
 
 MBSETTINGS mbCoreLogView::cachedSettings() const
@@ -118,6 +186,7 @@ MBSETTINGS mbCoreLogView::cachedSettings() const
     const Strings &s = Strings::instance();
     MBSETTINGS r;
     r[s.font] = this->fontString();
+    r[s.maxCount] = this->maxCount();
     return r;
 }
 
@@ -127,7 +196,7 @@ void mbCoreLogView::setCachedSettings(const MBSETTINGS &settings)
 
     MBSETTINGS::const_iterator it;
     MBSETTINGS::const_iterator end = settings.end();
-    //bool ok;
+    bool ok;
 
     it = settings.find(s.font);
     if (it != end)
@@ -135,12 +204,19 @@ void mbCoreLogView::setCachedSettings(const MBSETTINGS &settings)
         this->setFontString(it.value().toString());
     }
 
+    it = settings.find(s.maxCount);
+    if (it != end)
+    {
+        int v = it.value().toInt(&ok);
+        if (ok)
+            this->setMaxCount(v);
+    }
+
 }
 
 void mbCoreLogView::clear()
 {
-    //m_model->clear();
-    m_view->clear();
+    m_model->clear();
 }
 
 void mbCoreLogView::exportLog()
@@ -152,26 +228,148 @@ void mbCoreLogView::exportLog()
     QFile file(fileName);
     if (!file.open(QFile::WriteOnly))
         return;
-    file.write(m_view->toPlainText().toUtf8());
+    // exports rows which are currently shown
+    if (m_view->model() == m_filterModel)
+    {
+        for (int i = 0; i < m_filterModel->rowCount(); i++)
+        {
+            file.write(toString(m_filterModel->sourceRow(i)).toUtf8());
+            file.write("\n");
+        }
+    }
+    else
+    {
+        for (int i = 0; i < m_model->rowCount(); i++)
+        {
+            file.write(toString(i).toUtf8());
+            file.write("\n");
+        }
+    }
     file.close();
 }
 
+void mbCoreLogView::exportCapture()
+{
+    mbCoreUi *ui = mbCore::globalCore()->coreUi();
+    QString input = ui->dialogsCore()->getOpenFileName(ui, QStringLiteral("Open Capture"), mbCore::globalCore()->capturePath(), QStringLiteral("Capture files (*.mbcap);;All files (*)"));
+    if (input.isEmpty())
+        return;
+    QFileInfo fi(input);
+    QString output = ui->dialogsCore()->getSaveFileName(ui, QStringLiteral("Export Capture"), fi.dir().filePath(fi.completeBaseName()+QStringLiteral(".pcapng")), QStringLiteral("pcapng files (*.pcapng);;All files (*)"));
+    if (output.isEmpty())
+        return;
+    QString error;
+    if (mbCoreCapture::exportPcapng(input, output, &error))
+        mbCore::LogInfo(QStringLiteral("Capture"), QString("Exported '%1' to '%2'").arg(input, output));
+    else
+        mbCore::LogError(QStringLiteral("Capture"), error);
+}
+
 void mbCoreLogView::logMessage(mb::LogFlag flag, const QString &source, const QString &text)
 {
-    //m_model->logMessage(flag, source, text);
-    QString s;
-    if (m_core->useTimestamp())
+    mbCoreLogMessage m;
+    m.timestamp = QDateTime::currentMSecsSinceEpoch();
+    m.flag = flag;
+    m.source = source;
+    m.text = text;
+    logMessages(mbCoreLogMessages() << m);
+}
+
+void mbCoreLogView::logMessages(const mbCoreLogMessages &messages)
+{
+    // whole batch is inserted at once: one pair of row signals per batch
+    QScrollBar *sb = m_view->verticalScrollBar();
+    bool atBottom = (sb->value() == sb->maximum());
+    m_model->setFormatDateTime(m_core->formatDateTime());
+    m_view->setColumnHidden(mbCoreLogViewModel::Column_DateTime, !m_core->useTimestamp());
+    m_model->logMessages(messages);
+    if (atBottom)
+        m_view->scrollToBottom();
+    if (m_view->model() == m_filterModel)
+        refreshFilterState();
+}
+
+void mbCoreLogView::applyFilter()
+{
+    mbCoreLogFilterModel::Filter f;
+    if (m_cmbSource->currentIndex() > 0)
+        f.source = m_cmbSource->currentText();
+    f.categories = m_cmbCategory->currentData().toInt();
+    f.text = m_lnFilter->text();
+    f.regex = m_chbRegex->isChecked();
+    m_filterModel->setFilter(f);
+    if (f.isEmpty())
+    {
+        if (m_view->model() != m_model)
+        {
+            m_view->setModel(m_model);
+            setupColumns();
+        }
+    }
+    else
+    {
+        if (m_view->model() != m_filterModel)
+        {
+            m_view->setModel(m_filterModel);
+            setupColumns();
+        }
+    }
+    m_view->scrollToBottom();
+    refreshFilterState();
+}
+
+void mbCoreLogView::refreshSources()
+{
+    QString current = m_cmbSource->currentIndex() > 0 ? m_cmbSource->currentText() : QString();
+    QStringList sources = m_model->sources();
+    sources.removeAll(QString());
+    m_cmbSource->blockSignals(true);
+    while (m_cmbSource->count() > 1)
+        m_cmbSource->removeItem(1);
+    m_cmbSource->addItems(sources);
+    int i = current.isEmpty() ? 0 : m_cmbSource->findText(current);
+    if (i < 0)
     {
-        s = QString("%1 '%2' %3: %4").arg(QDateTime::currentDateTime().toString(m_core->formatDateTime()),
-                                          source,
-                                          mb::toString(flag),
-                                          text);
+        // selected source is gone from the log (e.g. log was cleared): keep it selected anyway
+        m_cmbSource->addItem(current);
+        i = m_cmbSource->count()-1;
     }
+    m_cmbSource->setCurrentIndex(i);
+    m_cmbSource->blockSignals(false);
+}
+
+void mbCoreLogView::refreshFilterState()
+{
+    if (m_view->model() != m_filterModel)
+        m_lbFilter->clear();
+    else if (m_filterModel->isSearching())
+        m_lbFilter->setText(QCoreApplication::translate("mbCoreLogView", "Searching...", nullptr));
     else
+        m_lbFilter->setText(QCoreApplication::translate("mbCoreLogView", "%1 of %2", nullptr).arg(m_filterModel->rowCount()).arg(m_model->rowCount()));
+}
+
+void mbCoreLogView::setupColumns()
+{
+    // switching the model of the view resets its sections
+    QFontMetrics fm(m_view->font());
+    m_view->verticalHeader()->setDefaultSectionSize(fm.height()+2);
+    m_view->setColumnWidth(mbCoreLogViewModel::Column_DateTime, fm.horizontalAdvance(QStringLiteral("00.00.0000 00:00:00.000 ")));
+    m_view->setColumnWidth(mbCoreLogViewModel::Column_Source  , fm.horizontalAdvance(QLatin1Char('W'))*16);
+    m_view->setColumnWidth(mbCoreLogViewModel::Column_Category, fm.horizontalAdvance(QLatin1Char('W'))*8);
+    m_view->setColumnHidden(mbCoreLogViewModel::Column_DateTime, !m_core->useTimestamp());
+}
+
+QString mbCoreLogView::toString(int row) const
+{
+    const mbCoreLogMessage &m = m_model->message(row);
+    if (m_core->useTimestamp())
     {
-        s = QString("'%1' %2: %3").arg(source,
-                                       mb::toString(flag),
-                                       text);
+        return QString("%1 '%2' %3: %4").arg(m_model->dateTimeString(row),
+                                             m.source,
+                                             m_model->categoryString(m.flag),
+                                             m.text);
     }
-    m_view->appendPlainText(s);
+    return QString("'%1' %2: %3").arg(m.source,
+                                      m_model->categoryString(m.flag),
+                                      m.text);
 }
@@ -25,12 +25,18 @@
 
 #include <QWidget>
 #include <mbcore.h>
+#include <core_logring.h>
 
 class QTableView;
 class QPlainTextEdit;
 class QToolBar;
+class QComboBox;
+class QLineEdit;
+class QCheckBox;
+class QLabel;
 class mbCore;
-//class mbCoreLogViewModel;
+class mbCoreLogViewModel;
+class mbCoreLogFilterModel;
 
 class mbCoreLogView : public QWidget
 {
@@ -41,6 +47,7 @@ public:
     {
         const QString prefix;
         const QString font;
+        const QString maxCount;
         Strings();
         static const Strings &instance();
     };
@@ -48,6 +55,7 @@ public:
     struct MB_EXPORT Defaults
     {
         const QString font;
+        const int maxCount;
         Defaults();
         static const Defaults &instance();
     };
@@ -58,25 +66,43 @@ public:
 public:
     QString fontString() const;
     void setFontString(const QString &font);
+    int maxCount() const;
+    void setMaxCount(int maxCount);
 
     MBSETTINGS cachedSettings() const;
     void setCachedSettings(const MBSETTINGS &settings);
 
 public:
     void logMessage(mb::LogFlag flag, const QString &source, const QString &text);
+    void logMessages(const mbCoreLogMessages &messages);
+
+private:
+    QString toString(int row) const;
+    void setupColumns();
 
 public Q_SLOTS:
     void clear();
     void exportLog();
+    void exportCapture();
+
+private Q_SLOTS:
+    void applyFilter();
+    void refreshSources();
+    void refreshFilterState();
 
 Q_SIGNALS:
 
 protected:
     mbCore *m_core;
     QToolBar *m_toolBar;
-    QPlainTextEdit *m_view;
-    //QTableView *m_view;
-    //mbCoreLogViewModel *m_model;
+    QTableView *m_view;
+    mbCoreLogViewModel *m_model;
+    mbCoreLogFilterModel *m_filterModel;
+    QComboBox *m_cmbSource;
+    QComboBox *m_cmbCategory;
+    QLineEdit *m_lnFilter;
+    QCheckBox *m_chbRegex;
+    QLabel *m_lbFilter;
 };
 
 #endif // MBCOREOUTPUT_H
@@ -1,14 +1,29 @@
 #include "core_logviewmodel.h"
 
+#include <algorithm>
+
 #include <QColor>
 #include <QDateTime>
 
+void mbCoreLogSeqIndex::popFront(int count)
+{
+    m_head += count;
+    // memory of evicted part is released in big chunks only
+    if (m_head > 1024 && m_head*2 > m_seqs.count())
+    {
+        m_seqs.remove(0, m_head);
+        m_head = 0;
+    }
+}
+
 mbCoreLogViewModel::mbCoreLogViewModel(QObject *parent) :
     QAbstractTableModel(parent)
 {
     m_ptr = 0;
     m_count = 0;
-    m_buff.resize(1000);
+    m_total = 0;
+    m_formatDateTime = QStringLiteral("hh:mm:ss.zzz");
+    m_buff.resize(100000);
 }
 
 mbCoreLogViewModel::~mbCoreLogViewModel()
@@ -51,20 +66,20 @@ QVariant mbCoreLogViewModel::data(const QModelIndex &index, int role) const
     int r = index.row();
     if (r < m_count)
     {
-        int i = getActualIndex(r);
+        const Record &rec = m_buff.at(getActualIndex(r));
         switch (role)
         {
         case Qt::DisplayRole:
             switch(c)
             {
-            case Column_DateTime: return m_buff.at(i).datetime.toString("hh:mm:ss.zzz");
-            case Column_Source  : return m_buff.at(i).source;
-            case Column_Category: return mb::toString(m_buff.at(i).category);
-            case Column_Text    : return m_buff.at(i).text;
+            case Column_DateTime: return dateTimeString(r);
+            case Column_Source  : return rec.message.source;
+            case Column_Category: return categoryString(rec.message.flag);
+            case Column_Text    : return rec.message.text;
             }
             break;
         case Qt::BackgroundRole:
-            switch (m_buff.at(i).category)
+            switch (rec.message.flag)
             {
             case mb::Log_Error  : return QColor(Qt::red);
             case mb::Log_Warning: return QColor(Qt::yellow);
@@ -75,7 +90,7 @@ QVariant mbCoreLogViewModel::data(const QModelIndex &index, int role) const
                 return QVariant();
             }
         case Qt::ForegroundRole:
-            switch (m_buff.at(i).category)
+            switch (rec.message.flag)
             {
             case mb::Log_Error  : return QColor(Qt::white);
             case mb::Log_Warning: return QColor(Qt::white);
@@ -90,38 +105,186 @@ QVariant mbCoreLogViewModel::data(const QModelIndex &index, int role) const
     return QVariant();
 }
 
+void mbCoreLogViewModel::setMaxCount(int maxCount)
+{
+    if (maxCount < 1 || maxCount == m_buff.size())
+        return;
+    beginResetModel();
+    MessageBuffer buff(maxCount);
+    int count = qMin(m_count, maxCount);
+    for (int i = 0; i < count; i++)
+        buff[i] = m_buff.at(getActualIndex(m_count - count + i));
+    m_buff.swap(buff);
+    m_count = count;
+    m_ptr = count % maxCount;
+    rebuildIndexes();
+    endResetModel();
+}
+
+void mbCoreLogViewModel::setFormatDateTime(const QString &format)
+{
+    if (m_formatDateTime == format)
+        return;
+    m_formatDateTime = format;
+    // drop cached strings, they are formatted again on demand
+    for (int i = 0; i < m_buff.size(); i++)
+        m_buff[i].datetime = QString();
+    if (m_count)
+        Q_EMIT dataChanged(index(0, Column_DateTime), index(m_count-1, Column_DateTime));
+}
+
+QString mbCoreLogViewModel::dateTimeString(int row) const
+{
+    const Record &rec = m_buff.at(getActualIndex(row));
+    if (rec.datetime.isNull())
+        rec.datetime = QDateTime::fromMSecsSinceEpoch(rec.message.timestamp).toString(m_formatDateTime);
+    return rec.datetime;
+}
+
+QString mbCoreLogViewModel::categoryString(mb::LogFlag flag) const
+{
+    QHash<int, QString>::const_iterator it = m_categories.constFind(flag);
+    if (it != m_categories.constEnd())
+        return it.value();
+    QString s = mb::toString(flag);
+    m_categories.insert(flag, s);
+    return s;
+}
+
+QStringList mbCoreLogViewModel::sources() const
+{
+    QStringList r = m_sourceIndex.keys();
+    std::sort(r.begin(), r.end());
+    return r;
+}
+
+QVector<qint64> mbCoreLogViewModel::seqs(const QString &source, int categories) const
+{
+    QVector<qint64> r;
+    if (source.count())
+    {
+        QHash<QString, mbCoreLogSeqIndex>::const_iterator it = m_sourceIndex.constFind(source);
+        if (it == m_sourceIndex.constEnd())
+            return r;
+        const mbCoreLogSeqIndex &index = it.value();
+        if (!categories)
+            return index.toVector();
+        r.reserve(index.count());
+        for (int i = 0; i < index.count(); i++)
+        {
+            qint64 seq = index.at(i);
+            if (messageBySeq(seq).flag & categories)
+                r.append(seq);
+        }
+        return r;
+    }
+    if (!categories)
+    {
+        r.resize(m_count);
+        qint64 seq = firstSeq();
+        for (int i = 0; i < m_count; i++)
+            r[i] = seq++;
+        return r;
+    }
+    // merge sorted indexes of selected categories
+    for (QHash<int, mbCoreLogSeqIndex>::const_iterator it = m_categoryIndex.constBegin(); it != m_categoryIndex.constEnd(); ++it)
+    {
+        if (!(it.key() & categories) || it.value().isEmpty())
+            continue;
+        QVector<qint64> part = it.value().toVector();
+        if (r.isEmpty())
+        {
+            r.swap(part);
+            continue;
+        }
+        QVector<qint64> merged(r.count() + part.count());
+        std::merge(r.constBegin(), r.constEnd(), part.constBegin(), part.constEnd(), merged.begin());
+        r.swap(merged);
+    }
+    return r;
+}
+
 void mbCoreLogViewModel::logMessage(mb::LogFlag flag, const QString &source, const QString &text)
+{
+    mbCoreLogMessage m;
+    m.timestamp = QDateTime::currentMSecsSinceEpoch();
+    m.flag = flag;
+    m.source = source;
+    m.text = text;
+    logMessages(mbCoreLogMessages() << m);
+}
+
+void mbCoreLogViewModel::logMessages(const mbCoreLogMessages &messages)
 {
     int sz = m_buff.size();
-    Message message;
-    message.datetime = QDateTime::currentDateTime();
-    message.category = flag;
-    message.source = source;
-    message.text = text;
-    if (m_count < sz)
+    int n = messages.count();
+    if (n == 0)
+        return;
+    const mbCoreLogMessage *src = messages.constData();
+    if (n > sz) // only the last messages fit into buffer
+    {
+        src += n - sz;
+        n = sz;
+    }
+    // evicted rows are removed from the head, new rows are appended to the tail
+    int evict = m_count + n - sz;
+    if (evict > 0)
     {
-        beginInsertRows(QModelIndex(), m_count, m_count);
-        m_buff[m_ptr] = message;
-        m_count++;
-        endInsertRows();
+        beginRemoveRows(QModelIndex(), 0, evict-1);
+        for (int i = 0; i < evict; i++)
+            indexEvict(message(i));
+        m_count -= evict;
+        endRemoveRows();
     }
-    else
+    int sources = m_sourceIndex.count();
+    beginInsertRows(QModelIndex(), m_count, m_count+n-1);
+    for (int i = 0; i < n; i++)
     {
-        beginResetModel();
-        m_buff[m_ptr] = message;
-        endResetModel();
-        //beginRemoveRows(QModelIndex(), 0, 0);
-        //endRemoveRows();
-        //beginInsertRows(QModelIndex(), m_count-1, m_count-1);
-        //endInsertRows();
+        Record &rec = m_buff[m_ptr];
+        rec.message = src[i];
+        rec.datetime = QString();
+        indexAppend(rec.message, m_total);
+        m_total++;
+        m_ptr = (m_ptr + 1) % sz;
     }
-    m_ptr = (m_ptr + 1) % sz;
+    m_count += n;
+    endInsertRows();
+    if (m_sourceIndex.count() != sources)
+        Q_EMIT sourcesChanged();
 }
 
 void mbCoreLogViewModel::clear()
 {
     beginResetModel();
     m_count = 0;
+    m_sourceIndex.clear();
+    m_categoryIndex.clear();
     endResetModel();
+    Q_EMIT sourcesChanged();
+}
+
+void mbCoreLogViewModel::indexAppend(const mbCoreLogMessage &m, qint64 seq)
+{
+    m_sourceIndex[m.source].append(seq);
+    m_categoryIndex[m.flag].append(seq);
+}
+
+void mbCoreLogViewModel::indexEvict(const mbCoreLogMessage &m)
+{
+    // evicted record is the oldest one of its source and category
+    QHash<QString, mbCoreLogSeqIndex>::iterator it = m_sourceIndex.find(m.source);
+    if (it != m_sourceIndex.end())
+        it.value().popFront();
+    QHash<int, mbCoreLogSeqIndex>::iterator itc = m_categoryIndex.find(m.flag);
+    if (itc != m_categoryIndex.end())
+        itc.value().popFront();
 }
 
+void mbCoreLogViewModel::rebuildIndexes()
+{
+    m_sourceIndex.clear();
+    m_categoryIndex.clear();
+    qint64 seq = firstSeq();
+    for (int i = 0; i < m_count; i++)
+        indexAppend(message(i), seq++);
+}
@@ -2,9 +2,36 @@
 #define XCHG_MESSAGEBUFFERMODEL_H
 
 #include <QDateTime>
+#include <QHash>
+#include <QStringList>
 #include <QAbstractTableModel>
 
 #include <mbcore.h>
+#include <core_logring.h>
+
+// Ascending sequence numbers of log records (e.g. records of one source or category).
+// Records leave the log from the front, so eviction only moves 'head' offset
+class mbCoreLogSeqIndex
+{
+public:
+    mbCoreLogSeqIndex() : m_head(0) {}
+
+public:
+    inline int count() const { return m_seqs.count() - m_head; }
+    inline bool isEmpty() const { return count() == 0; }
+    inline qint64 at(int i) const { return m_seqs.at(m_head + i); }
+    inline qint64 first() const { return m_seqs.at(m_head); }
+    inline void append(qint64 seq) { m_seqs.append(seq); }
+    inline void reserve(int size) { m_seqs.reserve(size); }
+    inline void clear() { m_seqs.clear(); m_head = 0; }
+    inline void assign(const QVector<qint64> &seqs) { m_seqs = seqs; m_head = 0; }
+    inline QVector<qint64> toVector() const { return m_seqs.mid(m_head); }
+    void popFront(int count = 1);
+
+private:
+    QVector<qint64> m_seqs;
+    int m_head;
+};
 
 class mbCoreLogViewModel : public QAbstractTableModel
 {
@@ -20,14 +47,6 @@ public:
         ColumnCount
     };
 
-    struct Message
-    {
-        QDateTime datetime;
-        mb::LogFlag category;
-        QString source;
-        QString text;
-    };
-
 public:
     explicit mbCoreLogViewModel(QObject *parent = 0);
     ~mbCoreLogViewModel();
@@ -38,18 +57,58 @@ public:
     int columnCount(const QModelIndex& = QModelIndex()) const override;
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
 
+public:
+    inline int maxCount() const { return m_buff.size(); }
+    void setMaxCount(int maxCount);
+    inline QString formatDateTime() const { return m_formatDateTime; }
+    void setFormatDateTime(const QString &format);
+    inline const mbCoreLogMessage &message(int row) const { return m_buff.at(getActualIndex(row)).message; }
+
+public: // every record gets sequence number, records of the log are [firstSeq, lastSeq)
+    inline qint64 firstSeq() const { return m_total - m_count; }
+    inline qint64 lastSeq() const { return m_total; }
+    inline int rowBySeq(qint64 seq) const { return static_cast<int>(seq - firstSeq()); }
+    inline const mbCoreLogMessage &messageBySeq(qint64 seq) const { return message(rowBySeq(seq)); }
+    QStringList sources() const;
+    // Sequence numbers of records of 'source' (empty - any source) with category
+    // within 'categories' mask (0 - any category), taken from indexes
+    QVector<qint64> seqs(const QString &source, int categories) const;
+
+Q_SIGNALS:
+    void sourcesChanged();
+
+public:
+    QString dateTimeString(int row) const;
+    QString categoryString(mb::LogFlag flag) const;
+
 public:
     void logMessage(mb::LogFlag flag, const QString &source, const QString &text);
+    void logMessages(const mbCoreLogMessages &messages);
     void clear();
 
 private:
     inline int getActualIndex(int row) const { return (m_ptr + m_buff.size() - m_count + row) % m_buff.size(); }
+    void indexAppend(const mbCoreLogMessage &m, qint64 seq);
+    void indexEvict(const mbCoreLogMessage &m);
+    void rebuildIndexes();
 
 private:
-    typedef QVector<Message> MessageBuffer;
+    // Display strings are formatted on first request of the row and cached within the record
+    struct Record
+    {
+        mbCoreLogMessage message;
+        mutable QString datetime;
+    };
+
+    typedef QVector<Record> MessageBuffer;
     MessageBuffer m_buff;
     int m_ptr;
     int m_count;
+    qint64 m_total;
+    QString m_formatDateTime;
+    QHash<QString, mbCoreLogSeqIndex> m_sourceIndex;
+    QHash<int, mbCoreLogSeqIndex> m_categoryIndex;
+    mutable QHash<int, QString> m_categories;
 };
 
 #endif // XCHG_MESSAGEBUFFERMODEL_H
@@ -0,0 +1,202 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "core_trendbuffer.h"
+
+#include <limits>
+
+#define TREND_LEVEL_SHIFT 2 // each level block is 4 times larger then block of previous level
+
+mbCoreTrendTimeline::mbCoreTrendTimeline(int capacity)
+{
+    reset(capacity);
+}
+
+qint64 mbCoreTrendTimeline::seqAt(qint64 time) const
+{
+    // timestamps are ascending
+    qint64 lo = m_firstSeq;
+    qint64 hi = m_endSeq;
+    while (lo < hi)
+    {
+        qint64 mid = lo + (hi - lo) / 2;
+        if (this->time(mid) < time)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+qint64 mbCoreTrendTimeline::append(qint64 time)
+{
+    qint64 seq = m_endSeq;
+    m_times[static_cast<int>(seq % m_times.count())] = time;
+    m_endSeq++;
+    if (m_endSeq - m_firstSeq > m_times.count())
+        m_firstSeq = m_endSeq - m_times.count();
+    return seq;
+}
+
+void mbCoreTrendTimeline::clear()
+{
+    m_firstSeq = m_endSeq;
+}
+
+void mbCoreTrendTimeline::reset(int capacity)
+{
+    m_times.fill(0, qMax(capacity, 1));
+    m_firstSeq = 0;
+    m_endSeq = 0;
+}
+
+mbCoreTrendSeries::mbCoreTrendSeries(int capacity, qint64 firstSeq)
+{
+    capacity = qMax(capacity, 1);
+    m_values.fill(std::numeric_limits<float>::quiet_NaN(), capacity);
+    for (int shift = TREND_LEVEL_SHIFT; (1 << shift) < capacity; shift += TREND_LEVEL_SHIFT)
+    {
+        Level level;
+        level.shift = shift;
+        // +2: first and last block of the buffer can be partial
+        level.blocks.resize((capacity >> shift) + 2);
+        m_levels.append(level);
+    }
+    m_startSeq = firstSeq;
+    m_firstSeq = firstSeq;
+    m_endSeq = firstSeq;
+}
+
+double mbCoreTrendSeries::value(qint64 seq) const
+{
+    if (seq < m_firstSeq || seq >= m_endSeq)
+        return std::numeric_limits<double>::quiet_NaN();
+    return m_values.at(static_cast<int>(seq % m_values.count()));
+}
+
+void mbCoreTrendSeries::append(double value)
+{
+    const float inf = std::numeric_limits<float>::infinity();
+    qint64 seq = m_endSeq;
+    float v = static_cast<float>(value);
+    bool valid = !qIsNaN(value);
+    m_values[static_cast<int>(seq % m_values.count())] = v;
+    for (int i = 0; i < m_levels.count(); i++)
+    {
+        Level &level = m_levels[i];
+        Block &b = level.blocks[static_cast<int>((seq >> level.shift) % level.blocks.count())];
+        if (((seq & ((Q_INT64_C(1) << level.shift) - 1)) == 0) || (seq == m_startSeq))
+        {
+            // first sample of the block
+            b.min = valid ? v :  inf;
+            b.max = valid ? v : -inf;
+        }
+        else if (valid)
+        {
+            if (v < b.min)
+                b.min = v;
+            if (v > b.max)
+                b.max = v;
+        }
+    }
+    m_endSeq++;
+    if (m_endSeq - m_firstSeq > m_values.count())
+        m_firstSeq = m_endSeq - m_values.count();
+}
+
+bool mbCoreTrendSeries::minMax(qint64 begin, qint64 end, double *min, double *max) const
+{
+    begin = qMax(begin, m_firstSeq);
+    end = qMin(end, m_endSeq);
+    if (begin >= end)
+        return false;
+    float mn =  std::numeric_limits<float>::infinity();
+    float mx = -std::numeric_limits<float>::infinity();
+    // [lo, hi) - part of the range which is already covered by whole blocks.
+    // Coarsest level with whole blocks inside the range covers its middle part,
+    // then every finer level extends it to the both edges by at most 3 blocks per edge
+    qint64 lo = end;
+    qint64 hi = end;
+    for (int i = m_levels.count()-1; i >= 0; i--)
+    {
+        const Level &level = m_levels.at(i);
+        const qint64 size = Q_INT64_C(1) << level.shift;
+        qint64 first = (begin + size - 1) >> level.shift;
+        if (lo == hi)
+        {
+            qint64 last = end >> level.shift;
+            if (first < last)
+            {
+                mergeBlocks(level, first, last, &mn, &mx);
+                lo = first << level.shift;
+                hi = last << level.shift;
+            }
+            continue;
+        }
+        qint64 last = lo >> level.shift;
+        if (first < last)
+        {
+            mergeBlocks(level, first, last, &mn, &mx);
+            lo = first << level.shift;
+        }
+        first = hi >> level.shift;
+        last = end >> level.shift;
+        if (first < last)
+        {
+            mergeBlocks(level, first, last, &mn, &mx);
+            hi = last << level.shift;
+        }
+    }
+    mergeValues(begin, lo, &mn, &mx);
+    mergeValues(hi, end, &mn, &mx);
+    if (mn > mx)
+        return false;
+    *min = mn;
+    *max = mx;
+    return true;
+}
+
+void mbCoreTrendSeries::mergeBlocks(const Level &level, qint64 first, qint64 end, float *min, float *max) const
+{
+    for (qint64 j = first; j < end; j++)
+    {
+        const Block &b = level.blocks.at(static_cast<int>(j % level.blocks.count()));
+        if (b.min < *min)
+            *min = b.min;
+        if (b.max > *max)
+            *max = b.max;
+    }
+}
+
+void mbCoreTrendSeries::mergeValues(qint64 first, qint64 end, float *min, float *max) const
+{
+    for (qint64 seq = first; seq < end; seq++)
+    {
+        float v = m_values.at(static_cast<int>(seq % m_values.count()));
+        if (qIsNaN(v))
+            continue;
+        if (v < *min)
+            *min = v;
+        if (v > *max)
+            *max = v;
+    }
+}
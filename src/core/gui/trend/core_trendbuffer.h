@@ -0,0 +1,100 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef CORE_TRENDBUFFER_H
+#define CORE_TRENDBUFFER_H
+
+#include <QVector>
+
+#include <mbcore.h>
+
+// Timestamps of trend samples. Every sample gets sequence number which is shared
+// by all series of the trend, buffer keeps last 'capacity' samples [firstSeq, endSeq)
+class mbCoreTrendTimeline
+{
+public:
+    explicit mbCoreTrendTimeline(int capacity = 1);
+
+public:
+    inline int capacity() const { return m_times.count(); }
+    inline qint64 firstSeq() const { return m_firstSeq; }
+    inline qint64 endSeq() const { return m_endSeq; }
+    inline bool isEmpty() const { return m_firstSeq == m_endSeq; }
+    inline qint64 time(qint64 seq) const { return m_times.at(static_cast<int>(seq % m_times.count())); }
+    // Returns sequence number of the first sample with time >= 'time' (endSeq if there is no one)
+    qint64 seqAt(qint64 time) const;
+    qint64 append(qint64 time);
+    void clear();
+    void reset(int capacity);
+
+private:
+    QVector<qint64> m_times;
+    qint64 m_firstSeq;
+    qint64 m_endSeq;
+};
+
+// Sample history of single trend value: ring of raw samples and min/max decimation pyramid.
+// Block of pyramid level 'k' keeps min/max of 4^(k+1) samples, so exact min/max of any range
+// is combined from a few blocks regardless of the range length: only whole blocks within
+// the range are taken from coarse level, edges of the range are covered by finer levels
+class mbCoreTrendSeries
+{
+public:
+    // 'firstSeq' - sequence number of the first sample which will be appended
+    mbCoreTrendSeries(int capacity, qint64 firstSeq);
+
+public:
+    inline int capacity() const { return m_values.count(); }
+    inline qint64 firstSeq() const { return m_firstSeq; }
+    inline qint64 endSeq() const { return m_endSeq; }
+    double value(qint64 seq) const;
+    // NaN value means absence of value (e.g. value can't be converted to number)
+    void append(double value);
+    // Returns false if there are no values within [begin, end)
+    bool minMax(qint64 begin, qint64 end, double *min, double *max) const;
+
+private:
+    struct Block
+    {
+        float min;
+        float max;
+    };
+
+    struct Level
+    {
+        int shift;
+        QVector<Block> blocks;
+    };
+
+    // Combines min/max of blocks [first, end) of level or of raw samples [first, end)
+    void mergeBlocks(const Level &level, qint64 first, qint64 end, float *min, float *max) const;
+    void mergeValues(qint64 first, qint64 end, float *min, float *max) const;
+
+private:
+    QVector<float> m_values;
+    QVector<Level> m_levels;
+    qint64 m_startSeq;
+    qint64 m_firstSeq;
+    qint64 m_endSeq;
+};
+
+#endif // CORE_TRENDBUFFER_H
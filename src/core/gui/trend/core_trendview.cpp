@@ -0,0 +1,645 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "core_trendview.h"
+
+#include <QVBoxLayout>
+#include <QSplitter>
+#include <QToolBar>
+#include <QAction>
+#include <QListWidget>
+#include <QPainter>
+#include <QPixmap>
+#include <QDateTime>
+#include <QMouseEvent>
+#include <QWheelEvent>
+#include <QCursor>
+#include <QCoreApplication>
+
+#include <limits>
+
+#include <project/core_device.h>
+#include <project/core_dataview.h>
+
+#define TREND_MIN_SPAN 100 // milliseconds
+
+static const QColor s_colors[] =
+{
+    QColor(  0, 114, 189),
+    QColor(217,  83,  25),
+    QColor(237, 177,  32),
+    QColor(126,  47, 142),
+    QColor(119, 172,  48),
+    QColor( 77, 190, 238),
+    QColor(162,  20,  47),
+    QColor(  0,   0,   0)
+};
+
+mbCoreTrendPlot::mbCoreTrendPlot(mbCoreTrendView *view, QWidget *parent) :
+    QWidget(parent),
+    m_view(view)
+{
+    m_span = 60000;
+    m_endTime = 0;
+    m_dragging = false;
+    m_dragX = 0;
+    m_dragEndTime = 0;
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    setMinimumSize(200, 100);
+}
+
+void mbCoreTrendPlot::setSpan(qint64 span)
+{
+    m_span = qBound<qint64>(TREND_MIN_SPAN, span, static_cast<qint64>(m_view->history())*1000);
+    update();
+}
+
+qint64 mbCoreTrendPlot::endTime() const
+{
+    const mbCoreTrendTimeline &tl = m_view->timeline();
+    if (m_view->isFollow())
+        return tl.isEmpty() ? 0 : tl.time(tl.endSeq()-1);
+    return m_endTime;
+}
+
+void mbCoreTrendPlot::setEndTime(qint64 time)
+{
+    m_endTime = time;
+    update();
+}
+
+QRect mbCoreTrendPlot::plotRect() const
+{
+    QFontMetrics fm = fontMetrics();
+    int left = fm.horizontalAdvance(QStringLiteral("-0.000000e+00")) + 6;
+    int bottom = fm.height() + 4;
+    return rect().adjusted(left, fm.height()/2, -fm.horizontalAdvance(QStringLiteral("00:00:00.000"))/2, -bottom);
+}
+
+void mbCoreTrendPlot::paintEvent(QPaintEvent * /*event*/)
+{
+    QPainter p(this);
+    p.fillRect(rect(), palette().color(QPalette::Base));
+    QRect r = plotRect();
+    int w = r.width();
+    int h = r.height();
+    if ((w <= 0) || (h <= 0))
+        return;
+    QFontMetrics fm = fontMetrics();
+    qint64 end = endTime();
+    qint64 begin = end - m_span;
+
+    // grid and time axis
+    const int GridCount = 4;
+    QColor gridColor = palette().color(QPalette::Midlight);
+    QColor textColor = palette().color(QPalette::Text);
+    for (int i = 0; i <= GridCount; i++)
+    {
+        int x = r.left() + (w-1) * i / GridCount;
+        int y = r.top() + (h-1) * i / GridCount;
+        p.setPen(gridColor);
+        p.drawLine(x, r.top(), x, r.bottom());
+        p.drawLine(r.left(), y, r.right(), y);
+        if (end > 0)
+        {
+            QString s = QDateTime::fromMSecsSinceEpoch(begin + m_span * i / GridCount).toString(QStringLiteral("hh:mm:ss.zzz"));
+            int tw = fm.horizontalAdvance(s);
+            p.setPen(textColor);
+            p.drawText(qBound(0, x - tw/2, width() - tw), r.bottom() + 2 + fm.ascent(), s);
+        }
+    }
+
+    const mbCoreTrendTimeline &tl = m_view->timeline();
+    if (tl.isEmpty() || !m_view->trendCount())
+        return;
+
+    // sequence bounds of every pixel column: column 'x' shows samples [seqs[x], seqs[x+1])
+    QVector<qint64> seqs(w+1);
+    for (int x = 0; x <= w; x++)
+        seqs[x] = tl.seqAt(begin + m_span * x / w);
+
+    double ymin =  std::numeric_limits<double>::infinity();
+    double ymax = -std::numeric_limits<double>::infinity();
+    for (int i = 0; i < m_view->trendCount(); i++)
+    {
+        double mn, mx;
+        if (m_view->trend(i)->series->minMax(seqs[0], seqs[w], &mn, &mx))
+        {
+            ymin = qMin(ymin, mn);
+            ymax = qMax(ymax, mx);
+        }
+    }
+    if (ymin > ymax)
+        return;
+    if (ymax - ymin < 1e-9)
+    {
+        ymin -= 1;
+        ymax += 1;
+    }
+    else
+    {
+        double margin = (ymax - ymin) * 0.05;
+        ymin -= margin;
+        ymax += margin;
+    }
+
+    // value axis
+    p.setPen(textColor);
+    for (int i = 0; i <= GridCount; i++)
+    {
+        int y = r.top() + (h-1) * i / GridCount;
+        QString s = QString::number(ymax - (ymax - ymin) * i / GridCount, 'g', 7);
+        p.drawText(r.left() - 3 - fm.horizontalAdvance(s), y + fm.ascent()/2, s);
+    }
+
+    p.setClipRect(r);
+    double ky = (h - 1) / (ymax - ymin);
+    double kx = static_cast<double>(w) / m_span;
+    if (seqs[w] - seqs[0] <= w)
+    {
+        // less samples than pixels: polyline through raw samples,
+        // neighbour samples outside of the plot make line reach its edges
+        for (int i = 0; i < m_view->trendCount(); i++)
+        {
+            const mbCoreTrendView::Trend *t = m_view->trend(i);
+            const mbCoreTrendSeries *series = t->series;
+            qint64 sb = qMax(seqs[0]-1, series->firstSeq());
+            qint64 se = qMin(seqs[w]+1, series->endSeq());
+            QVector<QPointF> points;
+            points.reserve(static_cast<int>(qMax<qint64>(se - sb, 0)));
+            p.setPen(t->color);
+            for (qint64 seq = sb; seq < se; seq++)
+            {
+                double v = series->value(seq);
+                if (qIsNaN(v))
+                {
+                    p.drawPolyline(points.constData(), points.count());
+                    points.clear();
+                    continue;
+                }
+                points.append(QPointF(r.left() + (tl.time(seq) - begin) * kx, r.bottom() - (v - ymin) * ky));
+            }
+            if (points.count() == 1)
+                p.drawPoint(points.first());
+            else
+                p.drawPolyline(points.constData(), points.count());
+        }
+    }
+    else
+    {
+        // vertical min/max segment per pixel column, extended to the previous one to keep line continuous
+        QVector<QLine> lines;
+        lines.reserve(w);
+        for (int i = 0; i < m_view->trendCount(); i++)
+        {
+            const mbCoreTrendView::Trend *t = m_view->trend(i);
+            const mbCoreTrendSeries *series = t->series;
+            bool prev = false;
+            double pmn = 0, pmx = 0;
+            lines.clear();
+            for (int x = 0; x < w; x++)
+            {
+                if (seqs[x] == seqs[x+1])
+                    continue; // no samples within column
+                double mn, mx;
+                if (!series->minMax(seqs[x], seqs[x+1], &mn, &mx))
+                {
+                    prev = false;
+                    continue;
+                }
+                double lo = mn, hi = mx;
+                if (prev)
+                {
+                    if (pmx < lo)
+                        lo = pmx;
+                    if (pmn > hi)
+                        hi = pmn;
+                }
+                lines.append(QLine(r.left() + x, qRound(r.bottom() - (lo - ymin) * ky),
+                                   r.left() + x, qRound(r.bottom() - (hi - ymin) * ky)));
+                pmn = mn;
+                pmx = mx;
+                prev = true;
+            }
+            p.setPen(t->color);
+            p.drawLines(lines);
+        }
+    }
+}
+
+void mbCoreTrendPlot::wheelEvent(QWheelEvent *event)
+{
+    int delta = event->angleDelta().y();
+    if (!delta)
+        return;
+    QRect r = plotRect();
+    qint64 end = endTime();
+    qint64 span = m_span;
+    if (delta > 0)
+        setSpan(span * 4 / 5);
+    else
+        setSpan(span * 5 / 4);
+    if (!m_view->isFollow() && r.width() > 0)
+    {
+        // time under cursor stays in place
+        int x = qBound(0, mapFromGlobal(QCursor::pos()).x() - r.left(), r.width());
+        qint64 anchor = end - span + span * x / r.width();
+        m_endTime = anchor + m_span * (r.width() - x) / r.width();
+    }
+    event->accept();
+}
+
+void mbCoreTrendPlot::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton)
+    {
+        m_dragging = true;
+        m_dragX = event->pos().x();
+        m_dragEndTime = endTime();
+        setCursor(Qt::ClosedHandCursor);
+    }
+}
+
+void mbCoreTrendPlot::mouseMoveEvent(QMouseEvent *event)
+{
+    if (!m_dragging)
+        return;
+    int w = plotRect().width();
+    if (w <= 0)
+        return;
+    int dx = event->pos().x() - m_dragX;
+    if (dx && m_view->isFollow())
+        m_view->setFollow(false);
+    setEndTime(m_dragEndTime - m_span * dx / w);
+}
+
+void mbCoreTrendPlot::mouseReleaseEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton)
+    {
+        m_dragging = false;
+        unsetCursor();
+    }
+}
+
+void mbCoreTrendPlot::mouseDoubleClickEvent(QMouseEvent * /*event*/)
+{
+    m_view->setFollow(true);
+}
+
+mbCoreTrendView::Strings::Strings() :
+    prefix(QStringLiteral("Ui.TrendView.")),
+    period(prefix+QStringLiteral("period")),
+    history(prefix+QStringLiteral("history"))
+{
+}
+
+const mbCoreTrendView::Strings &mbCoreTrendView::Strings::instance()
+{
+    static const Strings s;
+    return s;
+}
+
+mbCoreTrendView::Defaults::Defaults() :
+    period(10),
+    history(3600)
+{
+}
+
+const mbCoreTrendView::Defaults &mbCoreTrendView::Defaults::instance()
+{
+    static const Defaults s;
+    return s;
+}
+
+mbCoreTrendView::mbCoreTrendView(QWidget *parent)
+    : QWidget{parent}
+{
+    const Defaults &d = Defaults::instance();
+
+    m_period = d.period;
+    m_history = d.history;
+    m_follow = true;
+    m_sampled = false;
+    m_colorIndex = 0;
+    m_sampleTimer = 0;
+    m_paintTimer = 0;
+    m_clock.start();
+    m_clockBase = QDateTime::currentMSecsSinceEpoch();
+    m_timeline.reset(m_history * 1000 / m_period);
+
+    m_toolBar = new QToolBar(this);
+    m_toolBar->setIconSize(QSize(16,16));
+    m_toolBar->setContentsMargins(0,0,0,0);
+
+    m_actionFollow = new QAction(m_toolBar);
+    m_actionFollow->setText(QCoreApplication::translate("mbCoreTrendView", "Follow", nullptr));
+    m_actionFollow->setToolTip(QCoreApplication::translate("mbCoreTrendView", "Follow the last sample (double click on the plot)", nullptr));
+    m_actionFollow->setCheckable(true);
+    m_actionFollow->setChecked(m_follow);
+    connect(m_actionFollow, &QAction::toggled, this, &mbCoreTrendView::setFollow);
+    m_toolBar->addAction(m_actionFollow);
+
+    QAction *actionClear = new QAction(m_toolBar);
+    actionClear->setIcon(QIcon(":/core/icons/clear.png"));
+    actionClear->setText(QCoreApplication::translate("mbCoreTrendView", "Clear History", nullptr));
+    connect(actionClear, &QAction::triggered, this, &mbCoreTrendView::clear);
+    m_toolBar->addAction(actionClear);
+
+    QAction *actionRemove = new QAction(m_toolBar);
+    actionRemove->setIcon(QIcon(":/core/icons/remove.png"));
+    actionRemove->setText(QCoreApplication::translate("mbCoreTrendView", "Remove Selected", nullptr));
+    connect(actionRemove, &QAction::triggered, this, &mbCoreTrendView::removeSelected);
+    m_toolBar->addAction(actionRemove);
+
+    QAction *actionRemoveAll = new QAction(m_toolBar);
+    actionRemoveAll->setIcon(QIcon(":/core/icons/Trash.png"));
+    actionRemoveAll->setText(QCoreApplication::translate("mbCoreTrendView", "Remove All", nullptr));
+    connect(actionRemoveAll, &QAction::triggered, this, &mbCoreTrendView::removeAll);
+    m_toolBar->addAction(actionRemoveAll);
+
+    QSplitter *splitter = new QSplitter(Qt::Horizontal, this);
+    m_plot = new mbCoreTrendPlot(this, splitter);
+    m_legend = new QListWidget(splitter);
+    m_legend->setSelectionMode(QAbstractItemView::ExtendedSelection);
+    splitter->addWidget(m_plot);
+    splitter->addWidget(m_legend);
+    splitter->setStretchFactor(0, 1);
+    splitter->setStretchFactor(1, 0);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->setSpacing(0);
+    layout->setContentsMargins(0,0,0,0);
+    layout->addWidget(m_toolBar);
+    layout->addWidget(splitter);
+}
+
+mbCoreTrendView::~mbCoreTrendView()
+{
+    qDeleteAll(m_trends);
+}
+
+void mbCoreTrendView::setPeriod(int period)
+{
+    if ((period > 0) && (period != m_period))
+    {
+        m_period = period;
+        resetBuffers();
+        restartSampling();
+    }
+}
+
+void mbCoreTrendView::setHistory(int history)
+{
+    if ((history > 0) && (history != m_history))
+    {
+        m_history = history;
+        resetBuffers();
+        m_plot->setSpan(m_plot->span());
+    }
+}
+
+MBSETTINGS mbCoreTrendView::cachedSettings() const
+{
+    const Strings &s = Strings::instance();
+    MBSETTINGS r;
+    r[s.period ] = this->period();
+    r[s.history] = this->history();
+    return r;
+}
+
+void mbCoreTrendView::setCachedSettings(const MBSETTINGS &settings)
+{
+    const Strings &s = Strings::instance();
+
+    MBSETTINGS::const_iterator it;
+    MBSETTINGS::const_iterator end = settings.end();
+    bool ok;
+
+    it = settings.find(s.period);
+    if (it != end)
+    {
+        int v = it.value().toInt(&ok);
+        if (ok)
+            this->setPeriod(v);
+    }
+
+    it = settings.find(s.history);
+    if (it != end)
+    {
+        int v = it.value().toInt(&ok);
+        if (ok)
+            this->setHistory(v);
+    }
+}
+
+bool mbCoreTrendView::hasItem(mbCoreDataViewItem *item) const
+{
+    Q_FOREACH (const Trend *t, m_trends)
+    {
+        if (t->item == item)
+            return true;
+    }
+    return false;
+}
+
+void mbCoreTrendView::addItem(mbCoreDataViewItem *item)
+{
+    if (!item || hasItem(item))
+        return;
+    Trend *t = new Trend;
+    t->item = item;
+    // new series starts with the next sample of the shared timeline
+    t->series = new mbCoreTrendSeries(m_timeline.capacity(), m_timeline.endSeq());
+    t->color = s_colors[m_colorIndex % (sizeof(s_colors)/sizeof(s_colors[0]))];
+    m_colorIndex++;
+    QPixmap pm(12, 12);
+    pm.fill(t->color);
+    t->legend = new QListWidgetItem(QIcon(pm), itemName(item), m_legend);
+    m_trends.append(t);
+    connect(item, &QObject::destroyed, this, &mbCoreTrendView::itemDestroyed);
+    restartSampling();
+}
+
+void mbCoreTrendView::addItems(const QList<mbCoreDataViewItem *> &items)
+{
+    Q_FOREACH (mbCoreDataViewItem *item, items)
+        addItem(item);
+}
+
+void mbCoreTrendView::setFollow(bool follow)
+{
+    if (m_follow != follow)
+    {
+        // plot stays at current position when following is off
+        if (!follow)
+            m_plot->setEndTime(m_plot->endTime());
+        m_follow = follow;
+        m_actionFollow->setChecked(follow);
+        m_plot->update();
+    }
+}
+
+void mbCoreTrendView::clear()
+{
+    m_timeline.clear();
+    resetBuffers();
+}
+
+void mbCoreTrendView::removeSelected()
+{
+    for (int i = m_trends.count()-1; i >= 0; i--)
+    {
+        if (m_trends.at(i)->legend->isSelected())
+            removeTrend(i);
+    }
+    restartSampling();
+    m_plot->update();
+}
+
+void mbCoreTrendView::removeAll()
+{
+    for (int i = m_trends.count()-1; i >= 0; i--)
+        removeTrend(i);
+    m_colorIndex = 0;
+    restartSampling();
+    m_plot->update();
+}
+
+void mbCoreTrendView::timerEvent(QTimerEvent *event)
+{
+    if (event->timerId() == m_sampleTimer)
+    {
+        // all values of the tick share one timestamp of the timeline
+        m_timeline.append(m_clockBase + m_clock.elapsed());
+        Q_FOREACH (Trend *t, m_trends)
+            t->series->append(toDouble(t->item));
+        m_sampled = true;
+    }
+    else if (event->timerId() == m_paintTimer)
+    {
+        // repaint rate doesn't depend on sample rate
+        if (m_sampled && isVisible())
+        {
+            m_sampled = false;
+            m_plot->update();
+        }
+    }
+}
+
+void mbCoreTrendView::itemDestroyed(QObject *obj)
+{
+    for (int i = 0; i < m_trends.count(); i++)
+    {
+        if (m_trends.at(i)->item == obj)
+        {
+            removeTrend(i);
+            break;
+        }
+    }
+    restartSampling();
+    m_plot->update();
+}
+
+void mbCoreTrendView::removeTrend(int i)
+{
+    Trend *t = m_trends.takeAt(i);
+    disconnect(t->item, &QObject::destroyed, this, &mbCoreTrendView::itemDestroyed);
+    delete t->legend;
+    delete t->series;
+    delete t;
+}
+
+void mbCoreTrendView::resetBuffers()
+{
+    int capacity = static_cast<int>(qMin<qint64>(static_cast<qint64>(m_history) * 1000 / m_period, std::numeric_limits<int>::max()));
+    if (capacity != m_timeline.capacity())
+        m_timeline.reset(capacity);
+    Q_FOREACH (Trend *t, m_trends)
+    {
+        delete t->series;
+        t->series = new mbCoreTrendSeries(m_timeline.capacity(), m_timeline.endSeq());
+    }
+    m_plot->update();
+}
+
+void mbCoreTrendView::restartSampling()
+{
+    // timers work only while there is something to sample
+    if (m_sampleTimer)
+    {
+        killTimer(m_sampleTimer);
+        m_sampleTimer = 0;
+    }
+    if (m_paintTimer)
+    {
+        killTimer(m_paintTimer);
+        m_paintTimer = 0;
+    }
+    if (m_trends.count())
+    {
+        m_sampleTimer = startTimer(m_period, Qt::PreciseTimer);
+        m_paintTimer = startTimer(40);
+    }
+}
+
+QString mbCoreTrendView::itemName(mbCoreDataViewItem *item) const
+{
+    QString s = item->addressStr();
+    if (item->deviceCore())
+        s = item->deviceCore()->name() + QStringLiteral(": ") + s;
+    if (item->comment().count())
+        s += QStringLiteral(" (") + item->comment() + QStringLiteral(")");
+    return s;
+}
+
+double mbCoreTrendView::toDouble(const mbCoreDataViewItem *item)
+{
+    QVariant v = item->value();
+    bool ok = false;
+    double r;
+    // binary, octal and hexadecimal values are digit strings without prefix
+    switch (item->format())
+    {
+    case mb::Bin16:
+    case mb::Bin32:
+    case mb::Bin64:
+        r = static_cast<double>(v.toString().toULongLong(&ok, 2));
+        break;
+    case mb::Oct16:
+    case mb::Oct32:
+    case mb::Oct64:
+        r = static_cast<double>(v.toString().toULongLong(&ok, 8));
+        break;
+    case mb::Hex16:
+    case mb::Hex32:
+    case mb::Hex64:
+        r = static_cast<double>(v.toString().toULongLong(&ok, 16));
+        break;
+    default:
+        r = v.toDouble(&ok);
+        break;
+    }
+    if (!ok)
+        return std::numeric_limits<double>::quiet_NaN();
+    return r;
+}
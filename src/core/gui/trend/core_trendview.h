@@ -0,0 +1,166 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef CORE_TRENDVIEW_H
+#define CORE_TRENDVIEW_H
+
+#include <QWidget>
+#include <QColor>
+#include <QElapsedTimer>
+
+#include <mbcore.h>
+
+#include "core_trendbuffer.h"
+
+class QToolBar;
+class QAction;
+class QListWidget;
+class QListWidgetItem;
+class mbCoreDataViewItem;
+class mbCoreTrendView;
+
+// Plot area of the trend view. Every pixel column shows min/max of the samples which fall into it,
+// so painting cost depends on the width of the plot but not on the count of samples
+class mbCoreTrendPlot : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit mbCoreTrendPlot(mbCoreTrendView *view, QWidget *parent = nullptr);
+
+public:
+    inline qint64 span() const { return m_span; }
+    void setSpan(qint64 span);
+    qint64 endTime() const;
+    void setEndTime(qint64 time);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void wheelEvent(QWheelEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+    void mouseDoubleClickEvent(QMouseEvent *event) override;
+
+private:
+    QRect plotRect() const;
+
+private:
+    mbCoreTrendView *m_view;
+    qint64 m_span;    // visible time span, milliseconds
+    qint64 m_endTime; // right edge of the plot when view doesn't follow the last sample
+    bool m_dragging;
+    int m_dragX;
+    qint64 m_dragEndTime;
+};
+
+class mbCoreTrendView : public QWidget
+{
+    Q_OBJECT
+
+public:
+    struct MB_EXPORT Strings
+    {
+        const QString prefix;
+        const QString period;
+        const QString history;
+        Strings();
+        static const Strings &instance();
+    };
+
+    struct MB_EXPORT Defaults
+    {
+        const int period;
+        const int history;
+        Defaults();
+        static const Defaults &instance();
+    };
+
+    struct Trend
+    {
+        mbCoreDataViewItem *item;
+        mbCoreTrendSeries *series;
+        QColor color;
+        QListWidgetItem *legend;
+    };
+
+public:
+    explicit mbCoreTrendView(QWidget *parent = nullptr);
+    ~mbCoreTrendView();
+
+public:
+    inline int period() const { return m_period; }
+    void setPeriod(int period);
+    inline int history() const { return m_history; }
+    void setHistory(int history);
+
+    MBSETTINGS cachedSettings() const;
+    void setCachedSettings(const MBSETTINGS &settings);
+
+public:
+    inline const mbCoreTrendTimeline &timeline() const { return m_timeline; }
+    inline int trendCount() const { return m_trends.count(); }
+    inline const Trend *trend(int i) const { return m_trends.at(i); }
+    inline bool isFollow() const { return m_follow; }
+    bool hasItem(mbCoreDataViewItem *item) const;
+    void addItem(mbCoreDataViewItem *item);
+    void addItems(const QList<mbCoreDataViewItem*> &items);
+
+public Q_SLOTS:
+    void setFollow(bool follow);
+    void clear();
+    void removeSelected();
+    void removeAll();
+
+protected:
+    void timerEvent(QTimerEvent *event) override;
+
+private Q_SLOTS:
+    void itemDestroyed(QObject *obj);
+
+private:
+    void removeTrend(int i);
+    void resetBuffers();
+    void restartSampling();
+    QString itemName(mbCoreDataViewItem *item) const;
+    static double toDouble(const mbCoreDataViewItem *item);
+
+private:
+    QToolBar *m_toolBar;
+    QAction *m_actionFollow;
+    mbCoreTrendPlot *m_plot;
+    QListWidget *m_legend;
+    QList<Trend*> m_trends;
+    mbCoreTrendTimeline m_timeline;
+    int m_period;  // sample period, milliseconds
+    int m_history; // history length, seconds
+    bool m_follow;
+    bool m_sampled; // new samples since last repaint
+    int m_colorIndex;
+    int m_sampleTimer;
+    int m_paintTimer;
+    // monotonic clock: timestamps of the timeline must be ascending
+    QElapsedTimer m_clock;
+    qint64 m_clockBase;
+};
+
+#endif // CORE_TRENDVIEW_H
@@ -0,0 +1,7 @@
+HEADERS +=                      \
+    $$PWD/core_trendbuffer.h   \
+    $$PWD/core_trendview.h
+
+SOURCES +=                      \
+    $$PWD/core_trendbuffer.cpp \
+    $$PWD/core_trendview.cpp
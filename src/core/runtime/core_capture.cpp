@@ -0,0 +1,541 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "core_capture.h"
+
+#include <chrono>
+
+#include <QDir>
+#include <QDateTime>
+#include <QtEndian>
+
+#include <core.h>
+
+namespace {
+
+const char CaptureMagic[4] = { 'M', 'B', 'C', 'P' };
+
+inline quint64 currentUSecsSinceEpoch()
+{
+    return static_cast<quint64>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+inline int hexDigit(uint8_t c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return 0;
+}
+
+// Count of records in buffer of channel
+quint64 recordCount(const QByteArray &buffer)
+{
+    quint64 count = 0;
+    for (int i = 0; i + mbCoreCapture::HeaderSize <= buffer.size(); count++)
+        i += mbCoreCapture::HeaderSize + qFromLittleEndian<quint16>(buffer.constData()+i+14);
+    return count;
+}
+
+} // namespace
+
+mbCoreCaptureChannel::mbCoreCaptureChannel(quint16 id, const QString &name, Modbus::ProtocolType type, bool server) :
+    m_id(id),
+    m_name(name),
+    m_type(type),
+    m_server(server)
+{
+    m_buffer.reserve(mbCoreCapture::BufferSize);
+    m_dropped = 0;
+}
+
+void mbCoreCaptureChannel::capture(Direction dir, const uint8_t *buff, uint16_t size, const char *source)
+{
+    char h[mbCoreCapture::HeaderSize];
+    qToLittleEndian<quint64>(currentUSecsSinceEpoch(), h);
+    qToLittleEndian<quint16>(m_id, h+8);
+    qToLittleEndian<quint16>(source ? streamId(source) : 0, h+10);
+    h[12] = static_cast<char>(unit(buff, size));
+    h[13] = static_cast<char>(dir == Tx ? mbCoreCapture::Flag_Tx : 0);
+    qToLittleEndian<quint16>(size, h+14);
+
+    QMutexLocker _(&m_lock);
+    if (m_buffer.size() + mbCoreCapture::HeaderSize + size > mbCoreCapture::MaxChannelBuffer)
+    {
+        m_dropped++;
+        return;
+    }
+    m_buffer.append(h, mbCoreCapture::HeaderSize);
+    m_buffer.append(reinterpret_cast<const char*>(buff), size);
+}
+
+quint64 mbCoreCaptureChannel::droppedCount()
+{
+    QMutexLocker _(&m_lock);
+    return m_dropped;
+}
+
+quint16 mbCoreCaptureChannel::streamId(const char *source)
+{
+    // raw data key avoids copy of the source string
+    QByteArray key = QByteArray::fromRawData(source, static_cast<int>(strlen(source)));
+    QHash<QByteArray, quint16>::const_iterator it = m_streams.constFind(key);
+    if (it != m_streams.constEnd())
+        return it.value();
+    if (m_streams.count() >= 0xFFFF)
+        return 0;
+    quint16 id = static_cast<quint16>(m_streams.count());
+    m_streams.insert(QByteArray(source), id);
+    return id;
+}
+
+quint8 mbCoreCaptureChannel::unit(const uint8_t *buff, uint16_t size) const
+{
+    switch (m_type)
+    {
+    case Modbus::RTU:
+        if (size > 0)
+            return buff[0];
+        break;
+    case Modbus::ASC:
+        if ((size > 2) && (buff[0] == ':'))
+            return static_cast<quint8>((hexDigit(buff[1]) << 4) | hexDigit(buff[2]));
+        break;
+    default: // MBAP header: unit identifier is the 7th byte
+        if (size > 6)
+            return buff[6];
+        break;
+    }
+    return 0;
+}
+
+void mbCoreCaptureChannel::swap(QByteArray &buffer)
+{
+    QMutexLocker _(&m_lock);
+    m_buffer.swap(buffer);
+}
+
+mbCoreCapture::mbCoreCapture(QObject *parent) : QThread(parent)
+{
+    m_open = false;
+    m_stop = false;
+    m_maxFileSize = 0;
+    m_maxFileTime = 0;
+    m_fileTime = 0;
+    m_fileError = false;
+    m_lost = 0;
+    m_buffer.reserve(BufferSize);
+}
+
+mbCoreCapture::~mbCoreCapture()
+{
+    close();
+}
+
+bool mbCoreCapture::open(const QString &dir, const QString &prefix, qint64 maxFileSize, int maxFileTime)
+{
+    if (m_open)
+        return true;
+    if (!QDir().mkpath(dir))
+    {
+        m_errorString = QString("Can't create capture directory '%1'").arg(dir);
+        return false;
+    }
+    m_dir = dir;
+    m_prefix = prefix;
+    m_maxFileSize = maxFileSize;
+    m_maxFileTime = static_cast<qint64>(maxFileTime) * 1000;
+    m_fileError = false;
+    m_lost = 0;
+    if (!openFile())
+        return false;
+    m_stop = false;
+    m_open = true;
+    start();
+    return true;
+}
+
+void mbCoreCapture::close()
+{
+    if (!m_open)
+        return;
+    m_waitLock.lock();
+    m_stop = true;
+    m_wait.wakeAll();
+    m_waitLock.unlock();
+    wait();
+    m_file.close();
+    quint64 dropped = 0;
+    Q_FOREACH (mbCoreCaptureChannel *c, m_channels)
+        dropped += c->droppedCount();
+    if (dropped)
+        mbCore::LogWarning(QStringLiteral("Capture"), QString("%1 frame(s) dropped: disk could not keep up with traffic").arg(dropped));
+    if (m_lost)
+        mbCore::LogWarning(QStringLiteral("Capture"), QString("%1 frame(s) dropped: capture file could not be opened").arg(m_lost));
+    qDeleteAll(m_channels);
+    m_channels.clear();
+    m_newChannels.clear();
+    m_open = false;
+}
+
+mbCoreCaptureChannel *mbCoreCapture::createChannel(const QString &name, Modbus::ProtocolType type, bool server)
+{
+    QMutexLocker _(&m_channelsLock);
+    if (m_channels.count() >= 0xFFFF)
+        return nullptr;
+    mbCoreCaptureChannel *c = new mbCoreCaptureChannel(static_cast<quint16>(m_channels.count()), name, type, server);
+    m_channels.append(c);
+    m_newChannels.append(c);
+    return c;
+}
+
+void mbCoreCapture::run()
+{
+    m_waitLock.lock();
+    while (!m_stop)
+    {
+        m_wait.wait(&m_waitLock, FlushPeriod);
+        m_waitLock.unlock();
+        flush();
+        m_waitLock.lock();
+    }
+    m_waitLock.unlock();
+    flush(); // frames captured while stopping
+}
+
+void mbCoreCapture::flush()
+{
+    QList<mbCoreCaptureChannel*> channels;
+    QList<mbCoreCaptureChannel*> newChannels;
+    m_channelsLock.lock();
+    channels = m_channels;
+    newChannels = m_newChannels;
+    m_newChannels.clear();
+    m_channelsLock.unlock();
+
+    // Note: if new file couldn't be opened on rotation it's retried on every flush
+    bool rotate = !m_file.isOpen() ||
+                  (m_maxFileSize > 0 && m_file.size() >= m_maxFileSize) ||
+                  (m_maxFileTime > 0 && QDateTime::currentMSecsSinceEpoch() - m_fileTime >= m_maxFileTime);
+    if (rotate)
+        openFile(); // new file describes all channels itself
+    else
+    {
+        Q_FOREACH (mbCoreCaptureChannel *c, newChannels)
+            writeChannel(c);
+    }
+    Q_FOREACH (mbCoreCaptureChannel *c, channels)
+    {
+        c->swap(m_buffer);
+        if (m_buffer.size())
+        {
+            if (m_file.isOpen())
+                m_file.write(m_buffer);
+            else
+                m_lost += recordCount(m_buffer);
+        }
+        m_buffer.resize(0); // keeps reserved capacity
+    }
+    if (m_file.isOpen())
+        m_file.flush();
+}
+
+bool mbCoreCapture::openFile()
+{
+    if (m_file.isOpen())
+        m_file.close();
+    m_fileTime = QDateTime::currentMSecsSinceEpoch();
+    QString name = QString("%1_%2.mbcap").arg(m_prefix, QDateTime::fromMSecsSinceEpoch(m_fileTime).toString(QStringLiteral("yyyyMMdd_hhmmss_zzz")));
+    m_file.setFileName(QDir(m_dir).filePath(name));
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        m_errorString = QString("Can't open capture file '%1': %2").arg(m_file.fileName(), m_file.errorString());
+        if (m_open && !m_fileError) // Note: error is logged once while opening is retried
+            mbCore::LogError(QStringLiteral("Capture"), m_errorString);
+        m_fileError = true;
+        return false;
+    }
+    if (m_fileError)
+    {
+        mbCore::LogWarning(QStringLiteral("Capture"), QString("Capture is resumed into '%1', %2 frame(s) dropped so far").arg(m_file.fileName()).arg(m_lost));
+        m_fileError = false;
+    }
+    char h[8];
+    memcpy(h, CaptureMagic, 4);
+    qToLittleEndian<quint16>(Version, h+4);
+    qToLittleEndian<quint16>(0, h+6);
+    m_file.write(h, sizeof(h));
+    m_channelsLock.lock();
+    QList<mbCoreCaptureChannel*> channels = m_channels;
+    m_channelsLock.unlock();
+    Q_FOREACH (mbCoreCaptureChannel *c, channels)
+        writeChannel(c);
+    return true;
+}
+
+void mbCoreCapture::writeChannel(mbCoreCaptureChannel *c)
+{
+    if (!m_file.isOpen())
+        return;
+    QByteArray name = c->name().toUtf8();
+    quint16 size = static_cast<quint16>(qMin(name.size(), 0xFFFF-2) + 2);
+    char h[HeaderSize+2];
+    qToLittleEndian<quint64>(currentUSecsSinceEpoch(), h);
+    qToLittleEndian<quint16>(c->id(), h+8);
+    qToLittleEndian<quint16>(0, h+10);
+    h[12] = 0;
+    h[13] = static_cast<char>(Flag_Channel);
+    qToLittleEndian<quint16>(size, h+14);
+    h[16] = static_cast<char>(c->type());
+    h[17] = static_cast<char>(c->isServer());
+    m_file.write(h, sizeof(h));
+    m_file.write(name.constData(), size-2);
+}
+
+// ------------------------------------------------------------------------------------------
+// pcapng export
+// ------------------------------------------------------------------------------------------
+
+namespace {
+
+enum
+{
+    PcapngBlock_SHB     = 0x0A0D0D0A,
+    PcapngBlock_IDB     = 0x00000001,
+    PcapngBlock_EPB     = 0x00000006,
+    PcapngOption_IfName = 2,
+    LinkType_Raw        = 101, // raw IPv4 packets, Modbus/TCP is wrapped into synthesized TCP segments
+    LinkType_User0      = 147, // DLT_USER0: Modbus RTU frames
+    LinkType_User1      = 148, // DLT_USER1: Modbus ASCII frames
+    ModbusTcpPort       = 502,
+    ClientPortBase      = 49152
+};
+
+inline void appendU8(QByteArray &b, quint8 v) { b.append(static_cast<char>(v)); }
+inline void appendU16(QByteArray &b, quint16 v) { char d[2]; qToLittleEndian<quint16>(v, d); b.append(d, 2); }
+inline void appendU32(QByteArray &b, quint32 v) { char d[4]; qToLittleEndian<quint32>(v, d); b.append(d, 4); }
+inline void appendU16BE(QByteArray &b, quint16 v) { char d[2]; qToBigEndian<quint16>(v, d); b.append(d, 2); }
+inline void appendU32BE(QByteArray &b, quint32 v) { char d[4]; qToBigEndian<quint32>(v, d); b.append(d, 4); }
+inline void appendPadding(QByteArray &b) { while (b.size() % 4) b.append('\0'); }
+
+// Internet checksum (RFC 1071) over big-endian 16-bit words
+quint32 checksumAdd(quint32 sum, const char *data, int size)
+{
+    const uchar *d = reinterpret_cast<const uchar*>(data);
+    for (int i = 0; i+1 < size; i += 2)
+        sum += (static_cast<quint32>(d[i]) << 8) | d[i+1];
+    if (size & 1)
+        sum += static_cast<quint32>(d[size-1]) << 8;
+    return sum;
+}
+
+quint16 checksumFinish(quint32 sum)
+{
+    while (sum >> 16)
+        sum = (sum & 0xFFFF) + (sum >> 16);
+    return static_cast<quint16>(~sum);
+}
+
+void writeBlock(QFile &file, quint32 type, const QByteArray &body)
+{
+    QByteArray b;
+    quint32 len = static_cast<quint32>(body.size() + 12);
+    appendU32(b, type);
+    appendU32(b, len);
+    b.append(body);
+    appendU32(b, len);
+    file.write(b);
+}
+
+struct PcapChannel
+{
+    Modbus::ProtocolType type;
+    bool server;
+    QString name;
+    int interface;
+};
+
+// Wraps Modbus/TCP ADU into IPv4/TCP packet. Each channel gets own network 10.<id hi>.<id lo>.0/24
+// (16-bit channel id), server is .1:502, every stream (connection) is separate client port on .2
+QByteArray tcpPacket(quint16 channel, quint16 stream, bool toServer, quint32 seq, quint32 ack, const QByteArray &data)
+{
+    quint32 serverIp = (10u << 24) | (static_cast<quint32>(channel) << 8) | 1;
+    quint32 clientIp = serverIp + 1;
+    quint16 clientPort = static_cast<quint16>(ClientPortBase + (stream % 16384));
+    quint32 srcIp   = toServer ? clientIp   : serverIp;
+    quint32 dstIp   = toServer ? serverIp   : clientIp;
+    quint16 srcPort = toServer ? clientPort : static_cast<quint16>(ModbusTcpPort);
+    quint16 dstPort = toServer ? static_cast<quint16>(ModbusTcpPort) : clientPort;
+
+    QByteArray tcp;
+    appendU16BE(tcp, srcPort);
+    appendU16BE(tcp, dstPort);
+    appendU32BE(tcp, seq);
+    appendU32BE(tcp, ack);
+    appendU8(tcp, 0x50);        // data offset: 5 words
+    appendU8(tcp, 0x18);        // PSH|ACK
+    appendU16BE(tcp, 0xFFFF);   // window
+    appendU16BE(tcp, 0);        // checksum
+    appendU16BE(tcp, 0);        // urgent pointer
+    tcp.append(data);
+
+    QByteArray pseudo;
+    appendU32BE(pseudo, srcIp);
+    appendU32BE(pseudo, dstIp);
+    appendU16BE(pseudo, 6);
+    appendU16BE(pseudo, static_cast<quint16>(tcp.size()));
+    quint16 sum = checksumFinish(checksumAdd(checksumAdd(0, pseudo.constData(), pseudo.size()), tcp.constData(), tcp.size()));
+    qToBigEndian<quint16>(sum, tcp.data()+16);
+
+    QByteArray ip;
+    appendU8(ip, 0x45);         // IPv4, 5 words header
+    appendU8(ip, 0);
+    appendU16BE(ip, static_cast<quint16>(20 + tcp.size()));
+    appendU16BE(ip, 0);         // identification
+    appendU16BE(ip, 0x4000);    // don't fragment
+    appendU8(ip, 64);           // TTL
+    appendU8(ip, 6);            // TCP
+    appendU16BE(ip, 0);         // checksum
+    appendU32BE(ip, srcIp);
+    appendU32BE(ip, dstIp);
+    qToBigEndian<quint16>(checksumFinish(checksumAdd(0, ip.constData(), ip.size())), ip.data()+10);
+    return ip + tcp;
+}
+
+} // namespace
+
+bool mbCoreCapture::exportPcapng(const QString &input, const QString &output, QString *error)
+{
+    QFile in(input);
+    if (!in.open(QIODevice::ReadOnly))
+    {
+        if (error)
+            *error = QString("Can't open capture file '%1': %2").arg(input, in.errorString());
+        return false;
+    }
+    QByteArray h = in.read(8);
+    if ((h.size() != 8) || memcmp(h.constData(), CaptureMagic, 4) || (qFromLittleEndian<quint16>(h.constData()+4) > Version))
+    {
+        if (error)
+            *error = QString("'%1' is not a capture file of supported version").arg(input);
+        return false;
+    }
+    QFile out(output);
+    if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        if (error)
+            *error = QString("Can't open file '%1': %2").arg(output, out.errorString());
+        return false;
+    }
+
+    QByteArray b;
+    appendU32(b, 0x1A2B3C4D);   // byte-order magic
+    appendU16(b, 1);            // major version
+    appendU16(b, 0);            // minor version
+    appendU32(b, 0xFFFFFFFF);   // section length is not specified
+    appendU32(b, 0xFFFFFFFF);
+    writeBlock(out, PcapngBlock_SHB, b);
+
+    QHash<quint16, PcapChannel> channels;
+    QHash<quint64, quint32> seqs; // next sequence number by (channel, stream, direction)
+    int interfaces = 0;
+    while (!in.atEnd())
+    {
+        h = in.read(HeaderSize);
+        if (h.size() != HeaderSize)
+            break;
+        quint64 timestamp = qFromLittleEndian<quint64>(h.constData());
+        quint16 channel   = qFromLittleEndian<quint16>(h.constData()+8);
+        quint16 stream    = qFromLittleEndian<quint16>(h.constData()+10);
+        quint8  flags     = static_cast<quint8>(h.at(13));
+        quint16 size      = qFromLittleEndian<quint16>(h.constData()+14);
+        QByteArray data = in.read(size);
+        if (data.size() != size)
+            break; // file was cut while writing
+        if (flags & Flag_Channel)
+        {
+            if (size < 2 || channels.contains(channel))
+                continue;
+            PcapChannel c;
+            c.type = static_cast<Modbus::ProtocolType>(data.at(0));
+            c.server = data.at(1);
+            c.name = QString::fromUtf8(data.constData()+2, size-2);
+            c.interface = -1;
+            channels.insert(channel, c);
+            continue;
+        }
+        QHash<quint16, PcapChannel>::iterator it = channels.find(channel);
+        if (it == channels.end())
+            continue;
+        PcapChannel &c = it.value();
+        if (c.interface < 0)
+        {
+            b.clear();
+            switch (c.type)
+            {
+            case Modbus::RTU: appendU16(b, LinkType_User0); break;
+            case Modbus::ASC: appendU16(b, LinkType_User1); break;
+            default:          appendU16(b, LinkType_Raw  ); break;
+            }
+            appendU16(b, 0);    // reserved
+            appendU32(b, 0);    // snap length: unlimited
+            QByteArray name = c.name.toUtf8();
+            appendU16(b, PcapngOption_IfName);
+            appendU16(b, static_cast<quint16>(name.size()));
+            b.append(name);
+            appendPadding(b);
+            appendU32(b, 0);    // opt_endofopt
+            writeBlock(out, PcapngBlock_IDB, b);
+            c.interface = interfaces++;
+        }
+        QByteArray packet;
+        switch (c.type)
+        {
+        case Modbus::RTU:
+        case Modbus::ASC:
+            packet = data;
+            break;
+        default:
+        {
+            bool tx = flags & Flag_Tx;
+            bool toServer = c.server ? !tx : tx;
+            quint64 key = (static_cast<quint64>(channel) << 17) | (static_cast<quint64>(stream) << 1);
+            quint32 &seq = seqs[key | toServer];
+            quint32 ack = seqs.value(key | !toServer);
+            packet = tcpPacket(channel, stream, toServer, seq, ack, data);
+            seq += static_cast<quint32>(data.size());
+        }
+            break;
+        }
+        b.clear();
+        appendU32(b, static_cast<quint32>(c.interface));
+        appendU32(b, static_cast<quint32>(timestamp >> 32)); // default resolution is microseconds
+        appendU32(b, static_cast<quint32>(timestamp));
+        appendU32(b, static_cast<quint32>(packet.size()));
+        appendU32(b, static_cast<quint32>(packet.size()));
+        b.append(packet);
+        appendPadding(b);
+        writeBlock(out, PcapngBlock_EPB, b);
+    }
+    out.close();
+    return true;
+}
@@ -0,0 +1,148 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef CORE_CAPTURE_H
+#define CORE_CAPTURE_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QFile>
+#include <QHash>
+
+#include <Modbus.h>
+
+#include <mbcore.h>
+
+/*
+   Binary capture of Modbus traffic.
+   Port threads append raw frames into buffer of its own channel (short uncontended
+   lock, no allocation in steady state). Capture thread periodically swaps channel
+   buffers and writes them to file, so neither port threads nor GUI thread wait for disk.
+
+   File format (little-endian):
+     file header: "MBCP", quint16 version, quint16 reserved
+     record     : quint64 timestamp (usec since epoch), quint16 channel, quint16 stream,
+                  quint8 unit, quint8 flags, quint16 size, 'size' bytes of frame
+   Record with 'Flag_Channel' describes channel: data is quint8 protocol, quint8 server flag
+   and UTF-8 name of the port. Every file starts with descriptions of all channels,
+   so each rotated file can be exported independently.
+*/
+
+class MB_EXPORT mbCoreCaptureChannel
+{
+public:
+    enum Direction
+    {
+        Rx,
+        Tx
+    };
+
+public:
+    // Called from port thread only. 'source' distinguishes streams (e.g. TCP connections) of the channel
+    void capture(Direction dir, const uint8_t *buff, uint16_t size, const char *source = nullptr);
+    inline quint16 id() const { return m_id; }
+    inline QString name() const { return m_name; }
+    inline Modbus::ProtocolType type() const { return m_type; }
+    inline bool isServer() const { return m_server; }
+    quint64 droppedCount();
+
+private:
+    friend class mbCoreCapture;
+    mbCoreCaptureChannel(quint16 id, const QString &name, Modbus::ProtocolType type, bool server);
+    quint16 streamId(const char *source);
+    quint8 unit(const uint8_t *buff, uint16_t size) const;
+    void swap(QByteArray &buffer);
+
+private:
+    const quint16 m_id;
+    const QString m_name;
+    const Modbus::ProtocolType m_type;
+    const bool m_server;
+    QHash<QByteArray, quint16> m_streams; // port thread only
+    QMutex m_lock;
+    QByteArray m_buffer;
+    quint64 m_dropped;
+};
+
+class MB_EXPORT mbCoreCapture : public QThread
+{
+public:
+    enum
+    {
+        Version          = 1,
+        HeaderSize       = 16,                // size of record header
+        FlushPeriod      = 100,               // msec
+        BufferSize       = 64*1024,           // initial size of channel buffer
+        MaxChannelBuffer = 16*1024*1024       // frames are dropped when disk can't keep up
+    };
+
+    enum Flag
+    {
+        Flag_Tx      = 0x01,
+        Flag_Channel = 0x80
+    };
+
+public:
+    explicit mbCoreCapture(QObject *parent = nullptr);
+    ~mbCoreCapture();
+
+public:
+    inline bool isOpen() const { return m_open; }
+    inline QString errorString() const { return m_errorString; }
+    // 'maxFileSize' in bytes, 'maxFileTime' in seconds, 0 - no rotation by that criteria
+    bool open(const QString &dir, const QString &prefix, qint64 maxFileSize, int maxFileTime);
+    void close();
+    mbCoreCaptureChannel *createChannel(const QString &name, Modbus::ProtocolType type, bool server);
+
+public:
+    static bool exportPcapng(const QString &input, const QString &output, QString *error = nullptr);
+
+protected:
+    void run() override;
+
+private:
+    void flush();
+    bool openFile();
+    void writeChannel(mbCoreCaptureChannel *c);
+
+private:
+    bool m_open;
+    bool m_stop;
+    QString m_errorString;
+    QString m_dir;
+    QString m_prefix;
+    qint64 m_maxFileSize;
+    qint64 m_maxFileTime; // msec
+    qint64 m_fileTime;
+    bool m_fileError; // file couldn't be opened on rotation, so it's retried on next flush
+    quint64 m_lost;   // frames dropped while file is not open
+    QFile m_file;
+    QByteArray m_buffer;
+    QMutex m_waitLock;
+    QWaitCondition m_wait;
+    QMutex m_channelsLock;
+    QList<mbCoreCaptureChannel*> m_channels;
+    QList<mbCoreCaptureChannel*> m_newChannels;
+};
+
+#endif // CORE_CAPTURE_H
@@ -45,8 +45,12 @@ void mbCoreRunTaskThread::run()
     while (m_run)
     {
         ev.processEvents();
-        m_task->loop();
-        Modbus::msleep(1);
+        int sleep = m_task->loop();
+        if (sleep < 1)
+            sleep = 1;
+        else if (sleep > MaxSleep)
+            sleep = MaxSleep;
+        Modbus::msleep(sleep);
     }
     m_task->final();
 }
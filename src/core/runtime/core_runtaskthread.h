@@ -31,6 +31,9 @@ class mbCoreTask;
 
 class MB_EXPORT mbCoreRunTaskThread : public QThread
 {
+public:
+    enum { MaxSleep = 100 }; // max sleep time (milliseconds) between 'loop()'-calls, so stop request is processed in time
+
 public:
     explicit mbCoreRunTaskThread(mbCoreTask *task, QObject *parent = nullptr);
     ~mbCoreRunTaskThread();
@@ -27,11 +27,18 @@
 #include <core.h>
 
 #include "core_runtaskthread.h"
+#include "core_capture.h"
 
 mbCoreRuntime::mbCoreRuntime(QObject *parent)
     : QObject{parent}
 {
     m_project = nullptr;
+    m_capture = new mbCoreCapture(this);
+}
+
+mbCoreCapture *mbCoreRuntime::capture() const
+{
+    return m_capture->isOpen() ? m_capture : nullptr;
 }
 
 bool mbCoreRuntime::isRunning()
@@ -46,6 +53,15 @@ void mbCoreRuntime::start()
     m_project = mbCore::globalCore()->projectCore();
     if (!m_project)
         return;
+    mbCore *core = mbCore::globalCore();
+    if (core->captureEnable())
+    {
+        if (!m_capture->open(core->capturePath(),
+                             core->applicationName(),
+                             static_cast<qint64>(core->captureMaxFileSize()) * 1024 * 1024,
+                             core->captureMaxFileTime() * 60))
+            mbCore::LogError(QStringLiteral("Capture"), m_capture->errorString());
+    }
     createComponents();
     startComponents();
 }
@@ -64,6 +80,7 @@ void mbCoreRuntime::stop()
     }
     while (1);
     clearComponents();
+    m_capture->close();
     m_project = nullptr;
 }
 
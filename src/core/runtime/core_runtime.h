@@ -29,6 +29,7 @@
 
 class mbCoreProject;
 class mbCoreRunTaskThread;
+class mbCoreCapture;
 
 class MB_EXPORT mbCoreRuntime : public QObject
 {
@@ -38,6 +39,8 @@ public:
 
 public:
     inline mbCoreProject *projectCore() const { return m_project; }
+    // Returns traffic capture if it's enabled for current run, nullptr otherwise
+    mbCoreCapture *capture() const;
 
 public:
     bool isRunning();
@@ -55,6 +58,7 @@ public:
 
 protected:
     mbCoreProject *m_project;
+    mbCoreCapture *m_capture;
 
 protected: //  task threads
     typedef QList<mbCoreRunTaskThread*> TaskThreads_t;
@@ -1,7 +1,9 @@
 HEADERS += \
+    $$PWD/core_capture.h \
     $$PWD/core_runtaskthread.h \
     $$PWD/core_runtime.h
 
 SOURCES += \
+    $$PWD/core_capture.cpp \
     $$PWD/core_runtaskthread.cpp \
     $$PWD/core_runtime.cpp
@@ -36,6 +36,8 @@ public:
 
 public: // task interface
     virtual int init() = 0;
+    // Returns count of milliseconds task can sleep before next 'loop()'-call,
+    // '0' or negative value means default minimal sleep (1 ms)
     virtual int loop() = 0;
     virtual int final() = 0;
 };
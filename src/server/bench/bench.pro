@@ -0,0 +1,41 @@
+TEMPLATE = app
+
+include(../../version.pri)
+
+TARGET = mbbench-server
+
+CONFIG += no_keywords console
+CONFIG -= app_bundle
+
+DESTDIR  = ../../../bin
+
+QT = core gui widgets
+
+unix:QMAKE_RPATHDIR += .
+
+INCLUDEPATH += $$PWD/.. $$PWD/../..  \
+    $$PWD/../../../modbus/src       \
+    $$PWD/../../core/sdk            \
+    $$PWD/../../core/core           \
+    $$PWD/../../core                \
+    $$PWD/../core
+
+include(../core/core.pri)
+include(../project/project.pri)
+include(../gui/gui.pri)
+include(../runtime/runtime.pri)
+
+HEADERS += \
+    server_bench.h \
+    server_benchmaster.h
+
+SOURCES += \
+    server_bench.cpp \
+    server_benchmaster.cpp \
+    main.cpp
+
+RESOURCES += \
+    $$PWD/../resource/server_resource.qrc
+
+LIBS  += -L../../../bin -lcore
+LIBS  += -L../../../bin -lmodbus
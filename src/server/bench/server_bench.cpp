@@ -0,0 +1,480 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "server_bench.h"
+
+#include <iostream>
+#include <algorithm>
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <server.h>
+
+#include <project/server_project.h>
+#include <project/server_port.h>
+#include <project/server_deviceref.h>
+#include <project/server_builder.h>
+
+#include <runtime/server_rundevice.h>
+#include <runtime/server_runthread.h>
+
+mbServerBench::Strings::Strings() :
+    tcp        (QStringLiteral("tcp")),
+    inproc     (QStringLiteral("inproc")),
+    defaultHost(QStringLiteral("127.0.0.1"))
+{
+}
+
+const mbServerBench::Strings &mbServerBench::Strings::instance()
+{
+    static const Strings s;
+    return s;
+}
+
+mbServerBench::Defaults::Defaults() :
+    transport(Tcp),
+    masters  (1),
+    rate     (0),
+    duration (10),
+    mix      (QStringLiteral("1:10,3:50,5:5,6:10,15:5,16:15,23:5")),
+    offset   (0),
+    count    (10),
+    listenTimeout(5000)
+{
+}
+
+const mbServerBench::Defaults &mbServerBench::Defaults::instance()
+{
+    static const Defaults d;
+    return d;
+}
+
+mbServerBench::mbServerBench(QObject *parent) : QObject(parent)
+{
+    const Defaults &d = Defaults::instance();
+
+    m_options.transport = d.transport;
+    m_options.tcpPort   = -1;
+    m_options.masters   = d.masters;
+    m_options.rate      = d.rate;
+    m_options.duration  = d.duration;
+    m_options.mix       = d.mix;
+    m_options.unit      = -1;
+    m_options.offset    = d.offset;
+    m_options.count     = d.count;
+    m_project = nullptr;
+}
+
+mbServerBench::~mbServerBench()
+{
+    delete m_project;
+}
+
+int mbServerBench::exec(const QStringList &args)
+{
+    const Strings &s = Strings::instance();
+    const Defaults &d = Defaults::instance();
+
+    if (!parseArgs(args))
+    {
+        std::cerr << m_error.toStdString() << std::endl << usage().toStdString();
+        return 1;
+    }
+
+    QVector<mbServerBenchMaster::Request> mix;
+    if (!parseMix(m_options.mix, mix))
+    {
+        std::cerr << m_error.toStdString() << std::endl;
+        return 1;
+    }
+
+    mbServerBuilder builder;
+    m_project = builder.load(m_options.project);
+    if (!m_project)
+    {
+        setError(QString("Can't load project '%1': %2").arg(m_options.project, builder.errors().join("; ")));
+        std::cerr << m_error.toStdString() << std::endl;
+        return 1;
+    }
+
+    mbServerPort *port = findPort();
+    if (!port)
+    {
+        std::cerr << m_error.toStdString() << std::endl;
+        return 1;
+    }
+
+    mbServerBenchMaster::Config config;
+    config.settings = port->settings();
+    config.unit   = static_cast<quint8>(m_options.unit >= 0 ? m_options.unit : findUnit(port));
+    config.offset = m_options.offset;
+    config.count  = m_options.count;
+    config.rate   = m_options.rate;
+    config.mix    = mix;
+
+    mbServerRunThread *serverThread = nullptr;
+    if (m_options.transport == Tcp)
+    {
+        const Modbus::Strings &sModbus = Modbus::Strings::instance();
+        const mbCorePort::Strings &sPort = mbCorePort::Strings::instance();
+        config.settings[sPort.type] = Modbus::toString(Modbus::TCP);
+        config.settings[sModbus.host] = m_options.host.isEmpty() ? s.defaultHost : m_options.host;
+        if (m_options.tcpPort >= 0)
+            config.settings[sModbus.port] = m_options.tcpPort;
+        if (m_options.host.isEmpty())
+        {
+            if (port->type() != Modbus::TCP)
+            {
+                setError(QString("Port '%1' is not TCP port, use '-transport %2' or '-host'").arg(port->name(), s.inproc));
+                std::cerr << m_error.toStdString() << std::endl;
+                return 1;
+            }
+            serverThread = new mbServerRunThread(port, createRunDevice(port));
+            serverThread->start();
+            QElapsedTimer timer;
+            timer.start();
+            while (!serverThread->isOpen() && serverThread->isRunning() && (timer.elapsed() < d.listenTimeout))
+                QThread::msleep(1);
+            if (!serverThread->isOpen())
+            {
+                serverThread->stop();
+                serverThread->wait();
+                delete serverThread;
+                setError(QString("Port '%1' is not listening").arg(port->name()));
+                std::cerr << m_error.toStdString() << std::endl;
+                return 1;
+            }
+        }
+    }
+
+    QList<mbServerBenchMaster*> masters;
+    for (int i = 0; i < m_options.masters; i++)
+    {
+        config.seed = static_cast<quint32>(i + 1);
+        mbServerRunDevice *device = (m_options.transport == InProcess) ? createRunDevice(port) : nullptr;
+        masters.append(new mbServerBenchMaster(config, device));
+    }
+    Q_FOREACH (mbServerBenchMaster *m, masters)
+        m->start();
+    QThread::msleep(static_cast<unsigned long>(m_options.duration) * 1000);
+    Q_FOREACH (mbServerBenchMaster *m, masters)
+        m->stop();
+    Q_FOREACH (mbServerBenchMaster *m, masters)
+        m->wait();
+
+    if (serverThread)
+    {
+        serverThread->stop();
+        serverThread->wait();
+        delete serverThread;
+    }
+
+    int r = 0;
+    if (m_options.output.isEmpty())
+    {
+        QFile out;
+        out.open(stdout, QIODevice::WriteOnly);
+        writeReport(&out, port, masters);
+    }
+    else
+    {
+        QFile out(m_options.output);
+        if (out.open(QIODevice::WriteOnly | QIODevice::Truncate))
+            writeReport(&out, port, masters);
+        else
+        {
+            std::cerr << QString("Can't open output file '%1'").arg(m_options.output).toStdString() << std::endl;
+            r = 1;
+        }
+    }
+    qDeleteAll(masters);
+    return r;
+}
+
+QString mbServerBench::usage()
+{
+    const Defaults &d = Defaults::instance();
+    return QString("Usage: mbbench-server [options] <project.pjs>\n"
+                   "  -transport tcp|inproc  transport used by masters (default: tcp)\n"
+                   "  -port-name <name>      server port of the project to load (default: first port)\n"
+                   "  -host <host>           connect to external server instead of starting the port in-process\n"
+                   "  -tcp-port <port>       TCP port number (default: from the project)\n"
+                   "  -masters <n>           count of simulated masters (default: %1)\n"
+                   "  -rate <r>              requests per second for each master, 0 - unlimited (default: %2)\n"
+                   "  -duration <sec>        duration of the benchmark (default: %3)\n"
+                   "  -mix <fc:weight,...>   weighted mix of function codes 1,2,3,4,5,6,15,16,23 (default: %4)\n"
+                   "  -unit <unit>           unit address (default: first unit with device)\n"
+                   "  -offset <offset>       zero-based offset of requested memory (default: %5)\n"
+                   "  -count <count>         count of requested items (default: %6)\n"
+                   "  -output <file>         write JSON report to file instead of stdout\n")
+            .arg(QString::number(d.masters),
+                 QString::number(d.rate),
+                 QString::number(d.duration),
+                 d.mix,
+                 QString::number(d.offset),
+                 QString::number(d.count));
+}
+
+bool mbServerBench::parseArgs(const QStringList &args)
+{
+    const Strings &s = Strings::instance();
+    bool ok = true;
+    for (int i = 1; i < args.count(); i++)
+    {
+        const QString &arg = args.at(i);
+        if (!arg.startsWith('-'))
+        {
+            m_options.project = arg;
+            continue;
+        }
+        if (i+1 >= args.count())
+        {
+            setError(QString("Missing value for parameter '%1'").arg(arg));
+            return false;
+        }
+        const QString &value = args.at(++i);
+        if (arg == QStringLiteral("-transport"))
+        {
+            if (value == s.tcp)
+                m_options.transport = Tcp;
+            else if (value == s.inproc)
+                m_options.transport = InProcess;
+            else
+                ok = false;
+        }
+        else if (arg == QStringLiteral("-port-name"))
+            m_options.portName = value;
+        else if (arg == QStringLiteral("-host"))
+            m_options.host = value;
+        else if (arg == QStringLiteral("-tcp-port"))
+            m_options.tcpPort = value.toUShort(&ok);
+        else if (arg == QStringLiteral("-masters"))
+            m_options.masters = value.toInt(&ok);
+        else if (arg == QStringLiteral("-rate"))
+            m_options.rate = value.toDouble(&ok);
+        else if (arg == QStringLiteral("-duration"))
+            m_options.duration = value.toInt(&ok);
+        else if (arg == QStringLiteral("-mix"))
+            m_options.mix = value;
+        else if (arg == QStringLiteral("-unit"))
+            m_options.unit = value.toUShort(&ok);
+        else if (arg == QStringLiteral("-offset"))
+            m_options.offset = value.toUShort(&ok);
+        else if (arg == QStringLiteral("-count"))
+            m_options.count = value.toUShort(&ok);
+        else if (arg == QStringLiteral("-output"))
+            m_options.output = value;
+        else
+        {
+            setError(QString("Unknown parameter '%1'").arg(arg));
+            return false;
+        }
+        if (!ok)
+        {
+            setError(QString("Invalid value '%1' for parameter '%2'").arg(value, arg));
+            return false;
+        }
+    }
+    if (m_options.project.isEmpty())
+    {
+        setError(QStringLiteral("Project file is not specified"));
+        return false;
+    }
+    if ((m_options.masters < 1) || (m_options.duration < 1) || (m_options.rate < 0) || (m_options.unit > 255) || (m_options.count < 1))
+    {
+        setError(QStringLiteral("Invalid benchmark parameters"));
+        return false;
+    }
+    return true;
+}
+
+bool mbServerBench::parseMix(const QString &mix, QVector<mbServerBenchMaster::Request> &requests)
+{
+    Q_FOREACH (const QString &item, mix.split(',', Qt::SkipEmptyParts))
+    {
+        QStringList ls = item.split(':');
+        bool okFunc, okWeight = true;
+        mbServerBenchMaster::Request r;
+        r.func = static_cast<quint8>(ls.at(0).trimmed().toUShort(&okFunc));
+        r.weight = (ls.count() > 1) ? ls.at(1).trimmed().toUInt(&okWeight) : 1;
+        switch (r.func)
+        {
+        case MBF_READ_COILS:
+        case MBF_READ_DISCRETE_INPUTS:
+        case MBF_READ_HOLDING_REGISTERS:
+        case MBF_READ_INPUT_REGISTERS:
+        case MBF_WRITE_SINGLE_COIL:
+        case MBF_WRITE_SINGLE_REGISTER:
+        case MBF_WRITE_MULTIPLE_COILS:
+        case MBF_WRITE_MULTIPLE_REGISTERS:
+        case MBF_READ_WRITE_MULTIPLE_REGISTERS:
+            break;
+        default:
+            okFunc = false;
+            break;
+        }
+        if (!okFunc || !okWeight || (ls.count() > 2))
+        {
+            setError(QString("Invalid function mix item '%1'").arg(item));
+            return false;
+        }
+        if (r.weight)
+            requests.append(r);
+    }
+    if (requests.isEmpty())
+    {
+        setError(QStringLiteral("Function mix is empty"));
+        return false;
+    }
+    return true;
+}
+
+mbServerPort *mbServerBench::findPort()
+{
+    mbServerPort *port;
+    if (m_options.portName.isEmpty())
+        port = m_project->port(0);
+    else
+        port = m_project->port(m_options.portName);
+    if (!port)
+    {
+        if (m_options.portName.isEmpty())
+            setError(QStringLiteral("Project has no ports"));
+        else
+            setError(QString("Port '%1' not found").arg(m_options.portName));
+    }
+    return port;
+}
+
+int mbServerBench::findUnit(mbServerPort *port) const
+{
+    for (int unit = 1; unit <= 255; unit++)
+    {
+        if (port->deviceByUnit(static_cast<quint8>(unit)))
+            return unit;
+    }
+    return 1;
+}
+
+mbServerRunDevice *mbServerBench::createRunDevice(mbServerPort *port) const
+{
+    mbServerRunDevice *device = new mbServerRunDevice();
+    device->setBroadcastEnabled(port->isBroadcastEnabled());
+    for (int unit = 0; unit <= 255; unit++)
+    {
+        mbServerDeviceRef *ref = port->deviceByUnit(unit);
+        if (ref)
+            device->setDevice(static_cast<quint8>(unit), ref->device());
+    }
+    return device;
+}
+
+void mbServerBench::writeReport(QIODevice *io, mbServerPort *port, const QList<mbServerBenchMaster*> &masters)
+{
+    const Strings &s = Strings::instance();
+
+    quint64 requests = 0;
+    quint64 errors = 0;
+    qint64 elapsedUs = 0;
+    QMap<quint8, mbServerBenchMaster::FuncCounters> functions;
+    QMap<quint32, quint64> statuses;
+    QVector<quint32> latency;
+    Q_FOREACH (mbServerBenchMaster *m, masters)
+    {
+        const mbServerBenchMaster::Result &res = m->result();
+        requests += res.requests;
+        errors += res.errors;
+        elapsedUs = qMax(elapsedUs, res.elapsedUs);
+        for (QMap<quint8, mbServerBenchMaster::FuncCounters>::const_iterator it = res.functions.constBegin(); it != res.functions.constEnd(); ++it)
+        {
+            mbServerBenchMaster::FuncCounters &fc = functions[it.key()];
+            fc.requests += it.value().requests;
+            fc.errors += it.value().errors;
+        }
+        for (QMap<quint32, quint64>::const_iterator it = res.statuses.constBegin(); it != res.statuses.constEnd(); ++it)
+            statuses[it.key()] += it.value();
+        latency += res.latency;
+    }
+    std::sort(latency.begin(), latency.end());
+
+    double elapsed = elapsedUs / 1000000.0;
+    QJsonObject jLatency;
+    if (latency.count())
+    {
+        quint64 sum = 0;
+        Q_FOREACH (quint32 v, latency)
+            sum += v;
+        const int last = latency.count() - 1;
+        jLatency[QStringLiteral("min" )] = static_cast<qint64>(latency.first());
+        jLatency[QStringLiteral("avg" )] = static_cast<double>(sum) / latency.count();
+        jLatency[QStringLiteral("p50" )] = static_cast<qint64>(latency.at(last * 50   / 100  ));
+        jLatency[QStringLiteral("p90" )] = static_cast<qint64>(latency.at(last * 90   / 100  ));
+        jLatency[QStringLiteral("p99" )] = static_cast<qint64>(latency.at(last * 99   / 100  ));
+        jLatency[QStringLiteral("p999")] = static_cast<qint64>(latency.at(last * 999  / 1000 ));
+        jLatency[QStringLiteral("max" )] = static_cast<qint64>(latency.last());
+    }
+
+    QJsonObject jFunctions;
+    for (QMap<quint8, mbServerBenchMaster::FuncCounters>::const_iterator it = functions.constBegin(); it != functions.constEnd(); ++it)
+    {
+        QJsonObject jf;
+        jf[QStringLiteral("requests")] = static_cast<qint64>(it.value().requests);
+        jf[QStringLiteral("errors"  )] = static_cast<qint64>(it.value().errors);
+        jf[QStringLiteral("throughput")] = (elapsed > 0) ? (it.value().requests - it.value().errors) / elapsed : 0;
+        jFunctions[QString::number(it.key())] = jf;
+    }
+
+    QJsonObject jErrors;
+    for (QMap<quint32, quint64>::const_iterator it = statuses.constBegin(); it != statuses.constEnd(); ++it)
+        jErrors[mb::toString(static_cast<Modbus::StatusCode>(it.key()))] = static_cast<qint64>(it.value());
+
+    QJsonObject jConfig;
+    jConfig[QStringLiteral("project"  )] = m_options.project;
+    jConfig[QStringLiteral("port"     )] = port->name();
+    jConfig[QStringLiteral("transport")] = (m_options.transport == Tcp) ? s.tcp : s.inproc;
+    jConfig[QStringLiteral("masters"  )] = m_options.masters;
+    jConfig[QStringLiteral("rate"     )] = m_options.rate;
+    jConfig[QStringLiteral("duration" )] = m_options.duration;
+    jConfig[QStringLiteral("mix"      )] = m_options.mix;
+    jConfig[QStringLiteral("offset"   )] = m_options.offset;
+    jConfig[QStringLiteral("count"    )] = m_options.count;
+
+    QJsonObject j;
+    j[QStringLiteral("config"    )] = jConfig;
+    j[QStringLiteral("elapsed"   )] = elapsed;
+    j[QStringLiteral("requests"  )] = static_cast<qint64>(requests);
+    j[QStringLiteral("responses" )] = static_cast<qint64>(requests - errors);
+    j[QStringLiteral("errors"    )] = static_cast<qint64>(errors);
+    j[QStringLiteral("throughput")] = (elapsed > 0) ? (requests - errors) / elapsed : 0;
+    j[QStringLiteral("functions" )] = jFunctions;
+    j[QStringLiteral("latency_us")] = jLatency;
+    j[QStringLiteral("error_statuses")] = jErrors;
+    io->write(QJsonDocument(j).toJson());
+}
+
+void mbServerBench::setError(const QString &error)
+{
+    m_error = error;
+}
@@ -0,0 +1,112 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef SERVER_BENCH_H
+#define SERVER_BENCH_H
+
+#include <QObject>
+#include <QStringList>
+
+#include "server_benchmaster.h"
+
+class QIODevice;
+
+class mbServerPort;
+class mbServerProject;
+class mbServerRunDevice;
+
+class mbServerBench : public QObject
+{
+    Q_OBJECT
+public:
+    enum Transport
+    {
+        Tcp,
+        InProcess
+    };
+
+    struct Strings
+    {
+        const QString tcp;
+        const QString inproc;
+        const QString defaultHost;
+        //----------------
+        Strings();
+        static const Strings &instance();
+    };
+
+    struct Defaults
+    {
+        const Transport transport;
+        const int masters;
+        const double rate;
+        const int duration;
+        const QString mix;
+        const quint16 offset;
+        const quint16 count;
+        const int listenTimeout; // milliseconds
+        //----------------
+        Defaults();
+        static const Defaults &instance();
+    };
+
+    struct Options
+    {
+        QString project;
+        QString portName;
+        Transport transport;
+        QString host; // not empty - external server is used, no server port is started
+        int tcpPort;  // negative - port number from the project
+        int masters;
+        double rate;
+        int duration; // seconds
+        QString mix;
+        int unit;     // negative - first unit with assigned device
+        quint16 offset;
+        quint16 count;
+        QString output;
+    };
+
+public:
+    explicit mbServerBench(QObject *parent = nullptr);
+    ~mbServerBench();
+
+public:
+    int exec(const QStringList &args);
+    static QString usage();
+
+private:
+    bool parseArgs(const QStringList &args);
+    bool parseMix(const QString &mix, QVector<mbServerBenchMaster::Request> &requests);
+    mbServerPort *findPort();
+    int findUnit(mbServerPort *port) const;
+    mbServerRunDevice *createRunDevice(mbServerPort *port) const;
+    void writeReport(QIODevice *io, mbServerPort *port, const QList<mbServerBenchMaster*> &masters);
+    void setError(const QString &error);
+
+private:
+    Options m_options;
+    QString m_error;
+    mbServerProject *m_project;
+};
+
+#endif // SERVER_BENCH_H
@@ -0,0 +1,159 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "server_benchmaster.h"
+
+#include <QElapsedTimer>
+
+#include <ModbusClientPort.h>
+
+#include <runtime/server_rundevice.h>
+
+mbServerBenchMaster::mbServerBenchMaster(const Config &config, mbServerRunDevice *device, QObject *parent)
+    : QThread(parent)
+{
+    m_ctrlRun = true;
+    m_config = config;
+    m_device = device;
+    m_random = config.seed ? config.seed : 1;
+    m_weightSum = 0;
+    m_sequence = 0;
+    Q_FOREACH (const Request &r, m_config.mix)
+        m_weightSum += r.weight;
+    memset(m_buffer, 0, sizeof(m_buffer));
+}
+
+mbServerBenchMaster::~mbServerBenchMaster()
+{
+    delete m_device;
+}
+
+template<class T>
+Modbus::StatusCode mbServerBenchMaster::request(T *iface, quint8 func)
+{
+    const uint8_t unit = m_config.unit;
+    const uint16_t offset = m_config.offset;
+    const uint16_t count = m_config.count;
+    switch (func)
+    {
+    case MBF_READ_COILS:
+        return iface->readCoils(unit, offset, qMin<uint16_t>(count, MB_MAX_DISCRETS), m_buffer);
+    case MBF_READ_DISCRETE_INPUTS:
+        return iface->readDiscreteInputs(unit, offset, qMin<uint16_t>(count, MB_MAX_DISCRETS), m_buffer);
+    case MBF_READ_HOLDING_REGISTERS:
+        return iface->readHoldingRegisters(unit, offset, qMin<uint16_t>(count, MB_MAX_REGISTERS), m_buffer);
+    case MBF_READ_INPUT_REGISTERS:
+        return iface->readInputRegisters(unit, offset, qMin<uint16_t>(count, MB_MAX_REGISTERS), m_buffer);
+    case MBF_WRITE_SINGLE_COIL:
+        return iface->writeSingleCoil(unit, offset, m_sequence & 1);
+    case MBF_WRITE_SINGLE_REGISTER:
+        return iface->writeSingleRegister(unit, offset, m_sequence);
+    case MBF_WRITE_MULTIPLE_COILS:
+        return iface->writeMultipleCoils(unit, offset, qMin<uint16_t>(count, MaxWriteCoils), m_buffer);
+    case MBF_WRITE_MULTIPLE_REGISTERS:
+        return iface->writeMultipleRegisters(unit, offset, qMin<uint16_t>(count, MaxWriteRegisters), m_buffer);
+    case MBF_READ_WRITE_MULTIPLE_REGISTERS:
+        return iface->readWriteMultipleRegisters(unit, offset, qMin<uint16_t>(count, MB_MAX_REGISTERS), m_buffer,
+                                                 offset, qMin<uint16_t>(count, MaxReadWriteWrite), m_buffer);
+    default:
+        return Modbus::Status_BadIllegalFunction;
+    }
+}
+
+void mbServerBenchMaster::run()
+{
+    ModbusClientPort *clientPort = nullptr;
+    if (!m_device)
+        clientPort = Modbus::createClientPort(m_config.settings, false);
+
+    // Requests are paced against absolute deadlines so that a slow response
+    // does not shift the whole schedule and the target rate is kept on average
+    const qint64 periodNs = (m_config.rate > 0) ? static_cast<qint64>(1000000000.0 / m_config.rate) : 0;
+    qint64 deadlineNs = 0;
+    QElapsedTimer timer;
+    timer.start();
+    m_ctrlRun = true;
+    while (m_ctrlRun)
+    {
+        if (periodNs)
+        {
+            qint64 waitUs = (deadlineNs - timer.nsecsElapsed()) / 1000;
+            if (waitUs > 0)
+                QThread::usleep(static_cast<unsigned long>(waitUs));
+            deadlineNs += periodNs;
+        }
+        quint8 func = nextFunction();
+        qint64 beginNs = timer.nsecsElapsed();
+        Modbus::StatusCode status;
+        while (1)
+        {
+            if (clientPort)
+                status = request(clientPort, func);
+            else
+                status = request(m_device, func);
+            if (!Modbus::StatusIsProcessing(status) || !m_ctrlRun)
+                break;
+            QThread::yieldCurrentThread();
+        }
+        if (Modbus::StatusIsProcessing(status)) // interrupted by stop
+            break;
+        qint64 endNs = timer.nsecsElapsed();
+        FuncCounters &fc = m_result.functions[func];
+        m_result.requests++;
+        fc.requests++;
+        if (Modbus::StatusIsGood(status))
+        {
+            m_result.latency.append(static_cast<quint32>((endNs - beginNs) / 1000));
+        }
+        else
+        {
+            m_result.errors++;
+            fc.errors++;
+            m_result.statuses[static_cast<quint32>(status)]++;
+        }
+        m_sequence++;
+    }
+    m_result.elapsedUs = timer.nsecsElapsed() / 1000;
+    if (clientPort)
+    {
+        clientPort->close();
+        delete clientPort;
+    }
+}
+
+quint8 mbServerBenchMaster::nextFunction()
+{
+    // xorshift32: cheap and reproducible for the same seed
+    m_random ^= m_random << 13;
+    m_random ^= m_random >> 17;
+    m_random ^= m_random << 5;
+    if (m_weightSum == 0)
+        return MBF_READ_HOLDING_REGISTERS;
+    quint32 v = m_random % m_weightSum;
+    Q_FOREACH (const Request &r, m_config.mix)
+    {
+        if (v < r.weight)
+            return r.func;
+        v -= r.weight;
+    }
+    return m_config.mix.last().func;
+}
@@ -0,0 +1,108 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef SERVER_BENCHMASTER_H
+#define SERVER_BENCHMASTER_H
+
+#include <QThread>
+#include <QVector>
+#include <QMap>
+
+#include <ModbusQt.h>
+
+class mbServerRunDevice;
+
+class mbServerBenchMaster : public QThread
+{
+public:
+    enum
+    {
+        MaxWriteCoils       = 1968,
+        MaxWriteRegisters   = 123,
+        MaxReadWriteWrite   = 121
+    };
+
+    struct Request
+    {
+        quint8 func;
+        quint32 weight;
+    };
+
+    struct Config
+    {
+        Modbus::Settings settings; // used by TCP transport only
+        quint8 unit;
+        quint16 offset;
+        quint16 count;
+        double rate; // requests per second, 0 - unlimited
+        QVector<Request> mix;
+        quint32 seed;
+    };
+
+    struct FuncCounters
+    {
+        FuncCounters() : requests(0), errors(0) {}
+        quint64 requests;
+        quint64 errors;
+    };
+
+    struct Result
+    {
+        Result() : requests(0), errors(0), elapsedUs(0) {}
+        quint64 requests;
+        quint64 errors;
+        qint64 elapsedUs;
+        QMap<quint8, FuncCounters> functions;
+        QMap<quint32, quint64> statuses; // bad status code -> count
+        QVector<quint32> latency; // microseconds of good responses
+    };
+
+public:
+    // If 'device' is not null requests are made directly to it (in-process transport)
+    // and master takes ownership of it, otherwise TCP client port is created from config settings
+    explicit mbServerBenchMaster(const Config &config, mbServerRunDevice *device = nullptr, QObject *parent = nullptr);
+    ~mbServerBenchMaster();
+
+public:
+    inline void stop() { m_ctrlRun = false; }
+    inline const Result &result() const { return m_result; }
+
+protected:
+    void run() override;
+
+private:
+    quint8 nextFunction();
+    template<class T>
+    Modbus::StatusCode request(T *iface, quint8 func);
+
+private:
+    bool m_ctrlRun;
+    Config m_config;
+    mbServerRunDevice *m_device;
+    Result m_result;
+    quint32 m_random;
+    quint32 m_weightSum;
+    quint16 m_sequence;
+    uint16_t m_buffer[MB_MAX_BYTES/2+1];
+};
+
+#endif // SERVER_BENCHMASTER_H
@@ -44,10 +44,15 @@ mbServer::Strings::Strings() : mbCore::Strings(),
     default_server(settings_application),
     settings_scriptEnable         (QStringLiteral("Script.Enable")),
     settings_scriptUseOptimization(QStringLiteral("Script.UseOptimization")),
+    settings_scriptSharedMemory   (QStringLiteral("Script.SharedMemory")),
+    settings_scriptEmbedded       (QStringLiteral("Script.Embedded")),
+    settings_scriptSharedArena    (QStringLiteral("Script.SharedArena")),
+    settings_scriptWorkerCount    (QStringLiteral("Script.WorkerCount")),
     settings_scriptLoopPeriod     (QStringLiteral("Script.LoopPeriod")),
     settings_scriptManual         (QStringLiteral("Script.Manual")),
     settings_scriptDefault        (QStringLiteral("Script.DefaultInterpreter")),
-    settings_scriptImportPath     (QStringLiteral("Script.ImportPath"))
+    settings_scriptImportPath     (QStringLiteral("Script.ImportPath")),
+    settings_simWorkerCount       (QStringLiteral("Simulation.WorkerCount"))
 {
 }
 
@@ -139,7 +144,12 @@ mbServer::mbServer() :
     //Strings s = Strings::instance();
     m_scriptEnable = true;
     m_scriptUseOptimization = true;
+    m_scriptSharedMemory = false;
+    m_scriptEmbedded = false;
+    m_scriptSharedArena = false;
+    m_scriptWorkerCount = 0;
     m_scriptLoopPeriod = 100;
+    m_simWorkerCount = 1;
     m_autoDetectedExec = findPythonExecutables();
 }
 
@@ -153,10 +163,15 @@ MBSETTINGS mbServer::cachedSettings() const
     MBSETTINGS r = mbCore::cachedSettings();
     r[s.settings_scriptEnable           ] = scriptEnable           ();
     r[s.settings_scriptUseOptimization  ] = scriptUseOptimization  ();
+    r[s.settings_scriptSharedMemory     ] = scriptSharedMemory     ();
+    r[s.settings_scriptEmbedded         ] = scriptEmbedded         ();
+    r[s.settings_scriptSharedArena      ] = scriptSharedArena      ();
+    r[s.settings_scriptWorkerCount      ] = scriptWorkerCount      ();
     r[s.settings_scriptLoopPeriod       ] = scriptLoopPeriod       ();
     r[s.settings_scriptManual           ] = scriptManualExecutables();
     r[s.settings_scriptDefault          ] = scriptDefaultExecutable();
     r[s.settings_scriptImportPath       ] = scriptImportPath       ();
+    r[s.settings_simWorkerCount         ] = simWorkerCount         ();
     return r;
 }
 
@@ -170,10 +185,15 @@ void mbServer::setCachedSettings(const MBSETTINGS &settings)
 
     it = settings.find(s.settings_scriptEnable          ); if (it != end) setScriptEnable           (it.value().toBool      ());
     it = settings.find(s.settings_scriptUseOptimization ); if (it != end) setScriptUseOptimization  (it.value().toBool      ());
+    it = settings.find(s.settings_scriptSharedMemory    ); if (it != end) setScriptSharedMemory     (it.value().toBool      ());
+    it = settings.find(s.settings_scriptEmbedded        ); if (it != end) setScriptEmbedded         (it.value().toBool      ());
+    it = settings.find(s.settings_scriptSharedArena     ); if (it != end) setScriptSharedArena      (it.value().toBool      ());
+    it = settings.find(s.settings_scriptWorkerCount     ); if (it != end) setScriptWorkerCount      (it.value().toInt       ());
     it = settings.find(s.settings_scriptLoopPeriod      ); if (it != end) setScriptLoopPeriod       (it.value().toInt       ());
     it = settings.find(s.settings_scriptManual          ); if (it != end) scriptSetManualExecutables(it.value().toStringList());
     it = settings.find(s.settings_scriptDefault         ); if (it != end) scriptSetDefaultExecutable(it.value().toString    ());
     it = settings.find(s.settings_scriptImportPath      ); if (it != end) scriptSetImportPath       (it.value().toStringList());
+    it = settings.find(s.settings_simWorkerCount        ); if (it != end) setSimWorkerCount         (it.value().toInt       ());
 }
 
 QString mbServer::scriptDefaultExecutable() const
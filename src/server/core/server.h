@@ -51,10 +51,15 @@ public:
 
         const QString settings_scriptEnable         ;
         const QString settings_scriptUseOptimization;
+        const QString settings_scriptSharedMemory   ;
+        const QString settings_scriptEmbedded       ;
+        const QString settings_scriptSharedArena    ;
+        const QString settings_scriptWorkerCount    ;
         const QString settings_scriptLoopPeriod     ;
         const QString settings_scriptManual         ;
         const QString settings_scriptDefault        ;
         const QString settings_scriptImportPath     ;
+        const QString settings_simWorkerCount       ;
         Strings();
         static const Strings &instance();
     };
@@ -82,6 +87,14 @@ public:
     inline void setScriptEnable(bool enable) { m_scriptEnable = enable; }
     inline bool scriptUseOptimization() const { return m_scriptUseOptimization; }
     inline void setScriptUseOptimization(bool use) { m_scriptUseOptimization = use; }
+    inline bool scriptSharedMemory() const { return m_scriptSharedMemory; }
+    inline void setScriptSharedMemory(bool use) { m_scriptSharedMemory = use; }
+    inline bool scriptEmbedded() const { return m_scriptEmbedded; }
+    inline void setScriptEmbedded(bool use) { m_scriptEmbedded = use; }
+    inline bool scriptSharedArena() const { return m_scriptSharedArena; }
+    inline void setScriptSharedArena(bool use) { m_scriptSharedArena = use; }
+    inline int scriptWorkerCount() const { return m_scriptWorkerCount; }
+    inline void setScriptWorkerCount(int count) { m_scriptWorkerCount = count; }
     inline int scriptLoopPeriod() const { return m_scriptLoopPeriod; }
     inline void setScriptLoopPeriod(int period) { m_scriptLoopPeriod = period; }
     inline QStringList scriptAutoDetectedExecutables() const { return m_autoDetectedExec; }
@@ -93,6 +106,10 @@ public:
     QStringList scriptImportPath() const;
     void scriptSetImportPath(const QStringList &pathList);
 
+public:
+    inline int simWorkerCount() const { return m_simWorkerCount; }
+    inline void setSimWorkerCount(int count) { m_simWorkerCount = count; }
+
 private:
     QString createGUID() override;
     mbCoreUi* createUi() override;
@@ -103,11 +120,16 @@ private:
 private:
     bool m_scriptEnable;
     bool m_scriptUseOptimization;
+    bool m_scriptSharedMemory;
+    bool m_scriptEmbedded;
+    bool m_scriptSharedArena; // single shared memory segment for all devices
+    int m_scriptWorkerCount; // 0 - separate process for every device
     int m_scriptLoopPeriod;
     QStringList m_autoDetectedExec;
     QStringList m_manualExec;
     mutable QString m_defaultExec;
     QStringList m_importPath;
+    int m_simWorkerCount; // 0 - worker for every CPU core
 };
 
 #endif // SERVER_H
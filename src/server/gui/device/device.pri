@@ -1,10 +1,12 @@
 HEADERS += \
+    $$PWD/server_deviceaccessui.h \
     $$PWD/server_devicemanager.h \
     $$PWD/server_deviceui.h \
     $$PWD/server_deviceuidelegate.h \
     $$PWD/server_deviceuimodel.h
 
 SOURCES += \
+    $$PWD/server_deviceaccessui.cpp \
     $$PWD/server_devicemanager.cpp \
     $$PWD/server_deviceui.cpp \
     $$PWD/server_deviceuidelegate.cpp \
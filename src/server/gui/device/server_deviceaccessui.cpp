@@ -0,0 +1,254 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "server_deviceaccessui.h"
+
+#include <QColor>
+#include <QCheckBox>
+#include <QComboBox>
+#include <QPushButton>
+#include <QTableView>
+#include <QHeaderView>
+#include <QHBoxLayout>
+#include <QVBoxLayout>
+
+#include <project/server_device.h>
+#include <project/server_deviceaccess.h>
+
+mbServerDeviceAccessModel::mbServerDeviceAccessModel(mbServerDevice *device, QObject *parent) :
+    QAbstractTableModel(parent)
+{
+    m_device = device;
+    m_mem = mbServerDeviceAccess::Memory_4x;
+    m_mode = Total;
+    m_pageCount = pageCount();
+    m_max = 0;
+}
+
+void mbServerDeviceAccessModel::setMemoryIndex(int mem)
+{
+    if (m_mem != mem)
+    {
+        beginResetModel();
+        m_mem = mem;
+        m_pageCount = pageCount();
+        endResetModel();
+        refresh();
+    }
+}
+
+void mbServerDeviceAccessModel::setMode(Mode mode)
+{
+    if (m_mode != mode)
+    {
+        m_mode = mode;
+        refresh();
+    }
+}
+
+void mbServerDeviceAccessModel::refresh()
+{
+    int pages = pageCount();
+    if (m_pageCount != pages)
+    {
+        beginResetModel();
+        m_pageCount = pages;
+        endResetModel();
+    }
+    quint32 max = 0;
+    for (int p = 0; p < m_pageCount; p++)
+        max = qMax(max, value(p));
+    m_max = max;
+    int rows = rowCount();
+    if (rows > 0)
+        Q_EMIT dataChanged(createIndex(0, 0), createIndex(rows-1, ColumnCount-1));
+}
+
+QVariant mbServerDeviceAccessModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (role == Qt::DisplayRole)
+    {
+        if (orientation == Qt::Horizontal)
+            return QString("+%1").arg(section * mbServerDeviceAccess::PageSize);
+        return QString::number(section * ColumnCount * mbServerDeviceAccess::PageSize);
+    }
+    return QVariant();
+}
+
+int mbServerDeviceAccessModel::columnCount(const QModelIndex & /*parent*/) const
+{
+    return ColumnCount;
+}
+
+int mbServerDeviceAccessModel::rowCount(const QModelIndex & /*parent*/) const
+{
+    return (m_pageCount + ColumnCount - 1) / ColumnCount;
+}
+
+QVariant mbServerDeviceAccessModel::data(const QModelIndex &index, int role) const
+{
+    int page = index.row() * ColumnCount + index.column();
+    if (page >= m_pageCount)
+        return QVariant();
+    switch (role)
+    {
+    case Qt::DisplayRole:
+        return value(page);
+    case Qt::TextAlignmentRole:
+        return Qt::AlignCenter;
+    case Qt::BackgroundRole:
+    {
+        quint32 v = value(page);
+        if (v == 0 || m_max == 0)
+            return QVariant();
+        // cold (blue) to hot (red)
+        int hue = 240 - static_cast<int>((240.0 * v) / m_max);
+        return QColor::fromHsv(hue, 160, 255);
+    }
+    case Qt::ToolTipRole:
+    {
+        const mbServerDeviceAccess *access = m_device->accessCounters();
+        if (!access)
+            return QVariant();
+        int begin = page * mbServerDeviceAccess::PageSize;
+        int end = qMin(begin + mbServerDeviceAccess::PageSize, memoryCount()) - 1;
+        return QString("Offset: %1-%2\nReads: %3\nWrites: %4").arg(begin)
+                                                              .arg(end)
+                                                              .arg(access->reads(m_mem, page))
+                                                              .arg(access->writes(m_mem, page));
+    }
+    }
+    return QVariant();
+}
+
+int mbServerDeviceAccessModel::memoryCount() const
+{
+    switch (m_mem)
+    {
+    case mbServerDeviceAccess::Memory_0x: return m_device->count_0x();
+    case mbServerDeviceAccess::Memory_1x: return m_device->count_1x();
+    case mbServerDeviceAccess::Memory_3x: return m_device->count_3x();
+    default:
+        return m_device->count_4x();
+    }
+}
+
+int mbServerDeviceAccessModel::pageCount() const
+{
+    return (memoryCount() + mbServerDeviceAccess::PageSize - 1) / mbServerDeviceAccess::PageSize;
+}
+
+quint32 mbServerDeviceAccessModel::value(int page) const
+{
+    const mbServerDeviceAccess *access = m_device->accessCounters();
+    if (!access)
+        return 0;
+    switch (m_mode)
+    {
+    case Reads:
+        return access->reads(m_mem, page);
+    case Writes:
+        return access->writes(m_mem, page);
+    default:
+        return access->reads(m_mem, page) + access->writes(m_mem, page);
+    }
+}
+
+mbServerDeviceAccessUi::mbServerDeviceAccessUi(mbServerDevice *device, QWidget *parent) :
+    QWidget(parent)
+{
+    m_device = device;
+    m_model = new mbServerDeviceAccessModel(device, this);
+
+    m_chbEnable = new QCheckBox(QStringLiteral("Count access"), this);
+    m_chbEnable->setChecked(device->isAccessCounting());
+    m_chbEnable->setToolTip(QStringLiteral("Count read/write requests per page of %1 addresses").arg(mbServerDeviceAccess::PageSize));
+    connect(m_chbEnable, &QCheckBox::toggled, this, &mbServerDeviceAccessUi::setEnabledCounting);
+
+    m_cmbMemory = new QComboBox(this);
+    m_cmbMemory->addItem(QStringLiteral("0x"), mbServerDeviceAccess::Memory_0x);
+    m_cmbMemory->addItem(QStringLiteral("1x"), mbServerDeviceAccess::Memory_1x);
+    m_cmbMemory->addItem(QStringLiteral("3x"), mbServerDeviceAccess::Memory_3x);
+    m_cmbMemory->addItem(QStringLiteral("4x"), mbServerDeviceAccess::Memory_4x);
+    m_cmbMemory->setCurrentIndex(m_cmbMemory->findData(m_model->memoryIndex()));
+    connect(m_cmbMemory, SIGNAL(currentIndexChanged(int)), this, SLOT(setMemoryIndex(int)));
+
+    m_cmbMode = new QComboBox(this);
+    m_cmbMode->addItem(QStringLiteral("Reads") , mbServerDeviceAccessModel::Reads );
+    m_cmbMode->addItem(QStringLiteral("Writes"), mbServerDeviceAccessModel::Writes);
+    m_cmbMode->addItem(QStringLiteral("Total") , mbServerDeviceAccessModel::Total );
+    m_cmbMode->setCurrentIndex(m_cmbMode->findData(m_model->mode()));
+    connect(m_cmbMode, SIGNAL(currentIndexChanged(int)), this, SLOT(setMode(int)));
+
+    m_btnReset = new QPushButton(QStringLiteral("Reset"), this);
+    connect(m_btnReset, &QPushButton::clicked, this, &mbServerDeviceAccessUi::resetCounters);
+
+    m_view = new QTableView(this);
+    m_view->setModel(m_model);
+    m_view->setSelectionMode(QAbstractItemView::NoSelection);
+    m_view->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_view->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+    m_view->setStyleSheet("QHeaderView::section { background-color:lightgray; color:black }");
+
+    QHBoxLayout *top = new QHBoxLayout();
+    top->addWidget(m_chbEnable);
+    top->addWidget(m_cmbMemory);
+    top->addWidget(m_cmbMode);
+    top->addStretch();
+    top->addWidget(m_btnReset);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->addLayout(top);
+    layout->addWidget(m_view);
+}
+
+Modbus::MemoryType mbServerDeviceAccessUi::memoryType() const
+{
+    return mbServerDeviceAccess::memoryType(m_model->memoryIndex());
+}
+
+void mbServerDeviceAccessUi::refresh()
+{
+    m_chbEnable->setChecked(m_device->isAccessCounting());
+    m_model->refresh();
+}
+
+void mbServerDeviceAccessUi::setEnabledCounting(bool enable)
+{
+    m_device->setAccessCounting(enable);
+}
+
+void mbServerDeviceAccessUi::setMemoryIndex(int mem)
+{
+    m_model->setMemoryIndex(m_cmbMemory->itemData(mem).toInt());
+}
+
+void mbServerDeviceAccessUi::setMode(int mode)
+{
+    m_model->setMode(static_cast<mbServerDeviceAccessModel::Mode>(m_cmbMode->itemData(mode).toInt()));
+}
+
+void mbServerDeviceAccessUi::resetCounters()
+{
+    m_device->resetAccessCounters();
+    m_model->refresh();
+}
@@ -0,0 +1,112 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef SERVER_DEVICEACCESSUI_H
+#define SERVER_DEVICEACCESSUI_H
+
+#include <QWidget>
+#include <QAbstractTableModel>
+
+#include <mbcore.h>
+
+class QCheckBox;
+class QComboBox;
+class QPushButton;
+class QTableView;
+
+class mbServerDevice;
+
+class mbServerDeviceAccessModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    enum Mode
+    {
+        Reads,
+        Writes,
+        Total
+    };
+
+    enum
+    {
+        ColumnCount = 16 // pages per row
+    };
+
+public:
+    mbServerDeviceAccessModel(mbServerDevice *device, QObject *parent = nullptr);
+
+public:
+    inline mbServerDevice *device() const { return m_device; }
+    inline int memoryIndex() const { return m_mem; }
+    void setMemoryIndex(int mem);
+    inline Mode mode() const { return m_mode; }
+    void setMode(Mode mode);
+    void refresh();
+
+public: // QAbstractItemModel interface
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+private:
+    int memoryCount() const;
+    int pageCount() const;
+    quint32 value(int page) const;
+
+private:
+    mbServerDevice *m_device;
+    int m_mem;
+    Mode m_mode;
+    int m_pageCount;
+    quint32 m_max;
+};
+
+class mbServerDeviceAccessUi : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit mbServerDeviceAccessUi(mbServerDevice *device, QWidget *parent = nullptr);
+
+public:
+    Modbus::MemoryType memoryType() const;
+    void refresh();
+
+private Q_SLOTS:
+    void setEnabledCounting(bool enable);
+    void setMemoryIndex(int mem);
+    void setMode(int mode);
+    void resetCounters();
+
+private:
+    mbServerDevice *m_device;
+    mbServerDeviceAccessModel *m_model;
+    QCheckBox *m_chbEnable;
+    QComboBox *m_cmbMemory;
+    QComboBox *m_cmbMode;
+    QPushButton *m_btnReset;
+    QTableView *m_view;
+};
+
+#endif // SERVER_DEVICEACCESSUI_H
@@ -24,11 +24,13 @@
 #include "ui_server_deviceui.h"
 
 #include <QEvent>
+#include <QScrollBar>
 
 #include <project/server_device.h>
 
 #include "server_deviceuimodel.h"
 #include "server_deviceuidelegate.h"
+#include "server_deviceaccessui.h"
 
 mbServerDeviceUi::mbServerDeviceUi(mbServerDevice *device, QWidget *parent) :
     QWidget(parent),
@@ -77,6 +79,16 @@ mbServerDeviceUi::mbServerDeviceUi(mbServerDevice *device, QWidget *parent) :
     tbl->setAlternatingRowColors(true);
     tbl->setStyleSheet("QHeaderView::section { background-color:lightgray; color:black }");
 
+    // newly visible rows are fetched at once instead of waiting for the next refresh tick
+    connect(ui->tableView_0x->verticalScrollBar(), &QScrollBar::valueChanged, this, &mbServerDeviceUi::viewScrolled);
+    connect(ui->tableView_1x->verticalScrollBar(), &QScrollBar::valueChanged, this, &mbServerDeviceUi::viewScrolled);
+    connect(ui->tableView_3x->verticalScrollBar(), &QScrollBar::valueChanged, this, &mbServerDeviceUi::viewScrolled);
+    connect(ui->tableView_4x->verticalScrollBar(), &QScrollBar::valueChanged, this, &mbServerDeviceUi::viewScrolled);
+
+    // access counters heatmap
+    m_accessUi = new mbServerDeviceAccessUi(m_device, this);
+    ui->tabWidget->addTab(m_accessUi, QStringLiteral("Access"));
+
     connect(ui->tabWidget, &QTabWidget::currentChanged, this, &mbServerDeviceUi::tabChanged);
 }
 
@@ -95,6 +107,7 @@ Modbus::MemoryType mbServerDeviceUi::currentMemoryType() const
     if (ui->tabWidget->currentWidget() == ui->tab_0x) return Modbus::Memory_0x;
     if (ui->tabWidget->currentWidget() == ui->tab_1x) return Modbus::Memory_1x;
     if (ui->tabWidget->currentWidget() == ui->tab_3x) return Modbus::Memory_3x;
+    if (ui->tabWidget->currentWidget() == m_accessUi) return m_accessUi->memoryType();
     return Modbus::Memory_4x;
 }
 
@@ -170,13 +183,22 @@ void mbServerDeviceUi::deviceChanged()
 void mbServerDeviceUi::tabChanged(int)
 {
     stopScanning();
+    // snapshot of the tab was not refreshed while it was hidden
+    refreshData();
     startScanning(500);
 }
 
+void mbServerDeviceUi::viewScrolled()
+{
+    if (isScanning())
+        refreshData();
+}
+
 bool mbServerDeviceUi::event(QEvent *event)
 {
     if (event->type() == QEvent::Show)
     {
+        refreshData();
         startScanning(500);
     }
     else if (event->type() == QEvent::Hide)
@@ -209,15 +231,30 @@ void mbServerDeviceUi::stopScanning()
 
 void mbServerDeviceUi::refreshData()
 {
+    // hidden tabs are not refreshed at all
     QWidget *tab = ui->tabWidget->currentWidget();
     if (tab == ui->tab_0x)
-        m_model_0x->refresh();
+        refreshModel(ui->tableView_0x, m_model_0x);
     else if (tab == ui->tab_1x)
-        m_model_1x->refresh();
+        refreshModel(ui->tableView_1x, m_model_1x);
     else if (tab == ui->tab_3x)
-        m_model_3x->refresh();
+        refreshModel(ui->tableView_3x, m_model_3x);
     else if (tab == ui->tab_4x)
-        m_model_4x->refresh();
+        refreshModel(ui->tableView_4x, m_model_4x);
+    else if (tab == m_accessUi)
+        m_accessUi->refresh();
+}
+
+void mbServerDeviceUi::refreshModel(QTableView *view, mbServerDeviceUiModel *model)
+{
+    // only rows within viewport are fetched from device memory
+    int firstRow = view->rowAt(0);
+    if (firstRow < 0)
+        return;
+    int lastRow = view->rowAt(view->viewport()->height()-1);
+    if (lastRow < 0)
+        lastRow = model->rowCount()-1;
+    model->refresh(firstRow, lastRow);
 }
 
 
@@ -31,11 +31,14 @@ namespace Ui {
 class mbServerDeviceUi;
 }
 
+class QTableView;
 class mbServerDevice;
+class mbServerDeviceUiModel;
 class mbServerDeviceUiModel_0x;
 class mbServerDeviceUiModel_1x;
 class mbServerDeviceUiModel_3x;
 class mbServerDeviceUiModel_4x;
+class mbServerDeviceAccessUi;
 
 class mbServerDeviceUi : public QWidget
 {
@@ -63,6 +66,7 @@ public Q_SLOTS:
 private Q_SLOTS:
     void deviceChanged();
     void tabChanged(int);
+    void viewScrolled();
 
 protected:
     bool event(QEvent *event) override;
@@ -72,6 +76,7 @@ private:
     void startScanning(int period);
     void stopScanning();
     void refreshData();
+    void refreshModel(QTableView *view, mbServerDeviceUiModel *model);
 
 private:
     Ui::mbServerDeviceUi *ui;
@@ -81,6 +86,7 @@ private:
     mbServerDeviceUiModel_1x *m_model_1x;
     mbServerDeviceUiModel_3x *m_model_3x;
     mbServerDeviceUiModel_4x *m_model_4x;
+    mbServerDeviceAccessUi *m_accessUi;
     int m_timerId;
 };
 
@@ -22,6 +22,8 @@
 */
 #include "server_deviceuimodel.h"
 
+#include <QVarLengthArray>
+
 #include <server.h>
 #include <gui/server_ui.h>
 
@@ -58,11 +60,71 @@ mbServerDeviceUiModel::mbServerDeviceUiModel(mbServerDevice *device, QObject *pa
     m_rowCount = 0;
     m_changeCounter = 0;
     m_format = mb::DefaultDigitalFormat;
+    m_offset = 0;
 }
 
-void mbServerDeviceUiModel::refresh()
+void mbServerDeviceUiModel::refresh(int firstRow, int lastRow)
 {
-    Q_EMIT dataChanged(index(0, 0), index(rowCount()-1, columnCount()-1));
+    int offset = firstRow*ColumnCount;
+    int c = qMin((lastRow+1)*ColumnCount, count()) - offset;
+    if ((firstRow < 0) || (c <= 0))
+        return;
+    uint changeCounter = this->changeCounter();
+    if ((m_changeCounter == changeCounter) && (m_offset == offset) && (m_values.count() == c))
+        return;
+    m_changeCounter = changeCounter;
+    QVector<quint16> values(c);
+    fetch(offset, c, values.data());
+    int prevOffset = m_offset;
+    m_offset = offset;
+    m_values.swap(values); // 'values' is previous snapshot now
+    // notify only cells which differ from previous snapshot,
+    // changed cells of adjacent rows are joined into one range
+    int rowFirst = -1, rowLast = -1, colFirst = ColumnCount, colLast = -1;
+    for (int i = 0; i < c; i++)
+    {
+        int p = offset + i - prevOffset;
+        if ((p >= 0) && (p < values.count()) && (values.at(p) == m_values.at(i)))
+            continue;
+        int row = (offset + i) / ColumnCount;
+        int col = (offset + i) % ColumnCount;
+        if ((rowFirst >= 0) && (row > rowLast+1))
+        {
+            Q_EMIT dataChanged(index(rowFirst, colFirst), index(rowLast, colLast));
+            rowFirst = -1;
+            colFirst = ColumnCount;
+            colLast = -1;
+        }
+        if (rowFirst < 0)
+            rowFirst = row;
+        rowLast = row;
+        colFirst = qMin(colFirst, col);
+        colLast = qMax(colLast, col);
+    }
+    if (rowFirst >= 0)
+        Q_EMIT dataChanged(index(rowFirst, colFirst), index(rowLast, colLast));
+}
+
+quint16 mbServerDeviceUiModel::value(int offset) const
+{
+    int i = offset - m_offset;
+    if ((i >= 0) && (i < m_values.count()))
+        return m_values.at(i);
+    // cell is out of snapshot, e.g. view was scrolled between refresh ticks
+    quint16 v = 0;
+    fetch(offset, 1, &v);
+    return v;
+}
+
+void mbServerDeviceUiModel::updateValue(int offset)
+{
+    quint16 v = 0;
+    fetch(offset, 1, &v);
+    int i = offset - m_offset;
+    if ((i >= 0) && (i < m_values.count()))
+        m_values[i] = v;
+    QModelIndex index = this->index(offset / ColumnCount, offset % ColumnCount);
+    Q_EMIT dataChanged(index, index);
 }
 
 QVariant mbServerDeviceUiModel::headerData(int section, Qt::Orientation orientation, int role) const
@@ -110,6 +172,8 @@ void mbServerDeviceUiModel::setRowCount(int count)
 {
     beginResetModel();
     m_rowCount = (count+ColumnCount-1)/ColumnCount;
+    m_offset = 0;
+    m_values.clear();
     endResetModel();
 }
 
@@ -139,14 +203,14 @@ QVariant mbServerDeviceUiModel_0x::data(const QModelIndex &index, int role) cons
     {
         int offset = index.row()*ColumnCount+index.column();
         if (offset < m_device->count_0x())
-            return static_cast<int>(m_device->bool_0x(static_cast<quint16>(offset)));
+            return static_cast<int>(value(offset));
     }
         break;
     case Qt::BackgroundRole:
     {
         int offset = index.row()*ColumnCount+index.column();
         if (offset < m_device->count_0x())
-            if (m_device->bool_0x(static_cast<quint16>(offset)))
+            if (value(offset))
                 return QBrush(Qt::gray);
     }
         break;
@@ -164,6 +228,7 @@ bool mbServerDeviceUiModel_0x::setData(const QModelIndex &index, const QVariant
         if (offset < m_device->count_0x())
         {
             m_device->setBool_0x(static_cast<quint16>(offset), value.toBool());
+            updateValue(offset);
             return true;
         }
     }
@@ -180,14 +245,22 @@ Qt::ItemFlags mbServerDeviceUiModel_0x::flags(const QModelIndex &index) const
     return QAbstractTableModel::flags(index);
 }
 
-void mbServerDeviceUiModel_0x::refresh()
+int mbServerDeviceUiModel_0x::count() const
 {
-    uint c = m_device->changeCounter_0x();
-    if (m_changeCounter != c)
-    {
-        Q_EMIT dataChanged(index(0, 0), index(rowCount()-1, columnCount()-1));
-        m_changeCounter = c;
-    }
+    return m_device->count_0x();
+}
+
+uint mbServerDeviceUiModel_0x::changeCounter() const
+{
+    return m_device->changeCounter_0x();
+}
+
+void mbServerDeviceUiModel_0x::fetch(int offset, int count, quint16 *values) const
+{
+    QVarLengthArray<bool, 1024> bools(count);
+    m_device->read_0x_bool(static_cast<uint>(offset), static_cast<uint>(count), bools.data());
+    for (int i = 0; i < count; i++)
+        values[i] = bools[i];
 }
 
 mbServerDeviceUiModel_1x::mbServerDeviceUiModel_1x(mbServerDevice *device, QObject *parent) :
@@ -207,14 +280,14 @@ QVariant mbServerDeviceUiModel_1x::data(const QModelIndex &index, int role) cons
     {
         int offset = index.row()*ColumnCount+index.column();
         if (offset < m_device->count_1x())
-            return static_cast<int>(m_device->bool_1x(static_cast<quint16>(offset)));
+            return static_cast<int>(value(offset));
     }
         break;
     case Qt::BackgroundRole:
     {
         int offset = index.row()*ColumnCount+index.column();
         if (offset < m_device->count_1x())
-            if (m_device->bool_1x(static_cast<quint16>(offset)))
+            if (value(offset))
                 return QBrush(Qt::gray);
     }
         break;
@@ -232,6 +305,7 @@ bool mbServerDeviceUiModel_1x::setData(const QModelIndex &index, const QVariant
         if (offset < m_device->count_1x())
         {
             m_device->setBool_1x(static_cast<quint16>(offset), value.toBool());
+            updateValue(offset);
             return true;
         }
     }
@@ -248,14 +322,22 @@ Qt::ItemFlags mbServerDeviceUiModel_1x::flags(const QModelIndex &index) const
     return QAbstractTableModel::flags(index);
 }
 
-void mbServerDeviceUiModel_1x::refresh()
+int mbServerDeviceUiModel_1x::count() const
 {
-    uint c = m_device->changeCounter_1x();
-    if (m_changeCounter != c)
-    {
-        Q_EMIT dataChanged(index(0, 0), index(rowCount()-1, columnCount()-1));
-        m_changeCounter = c;
-    }
+    return m_device->count_1x();
+}
+
+uint mbServerDeviceUiModel_1x::changeCounter() const
+{
+    return m_device->changeCounter_1x();
+}
+
+void mbServerDeviceUiModel_1x::fetch(int offset, int count, quint16 *values) const
+{
+    QVarLengthArray<bool, 1024> bools(count);
+    m_device->read_1x_bool(static_cast<uint>(offset), static_cast<uint>(count), bools.data());
+    for (int i = 0; i < count; i++)
+        values[i] = bools[i];
 }
 
 mbServerDeviceUiModel_3x::mbServerDeviceUiModel_3x(mbServerDevice *device, QObject *parent) :
@@ -280,18 +362,19 @@ QVariant mbServerDeviceUiModel_3x::data(const QModelIndex &index, int role) cons
         int offset = index.row()*ColumnCount+index.column();
         if (offset < m_device->count_3x())
         {
+            quint16 v = value(offset);
             switch (m_format)
             {
             case mb::Bin:
-                return mb::toBinString(m_device->uint16_3x(static_cast<quint16>(offset)));
+                return mb::toBinString(v);
             case mb::Oct:
-                return mb::toOctString(m_device->uint16_3x(static_cast<quint16>(offset)));
+                return mb::toOctString(v);
             case mb::Hex:
-                return mb::toHexString(m_device->uint16_3x(static_cast<quint16>(offset)));
+                return mb::toHexString(v);
             case mb::UDec:
-                return m_device->uint16_3x(static_cast<quint16>(offset));
+                return v;
             default:
-                return m_device->int16_3x(static_cast<quint16>(offset));
+                return static_cast<qint16>(v);
             }
         }
     }
@@ -330,7 +413,10 @@ bool mbServerDeviceUiModel_3x::setData(const QModelIndex &index, const QVariant
                 break;
             }
             if (ok)
+            {
                 m_device->setUInt16_3x(static_cast<quint16>(offset), v);
+                updateValue(offset);
+            }
             return ok;
         }
     }
@@ -347,14 +433,19 @@ Qt::ItemFlags mbServerDeviceUiModel_3x::flags(const QModelIndex &index) const
     return QAbstractTableModel::flags(index);
 }
 
-void mbServerDeviceUiModel_3x::refresh()
+int mbServerDeviceUiModel_3x::count() const
 {
-    uint c = m_device->changeCounter_3x();
-    if (m_changeCounter != c)
-    {
-        Q_EMIT dataChanged(index(0, 0), index(rowCount()-1, columnCount()-1));
-        m_changeCounter = c;
-    }
+    return m_device->count_3x();
+}
+
+uint mbServerDeviceUiModel_3x::changeCounter() const
+{
+    return m_device->changeCounter_3x();
+}
+
+void mbServerDeviceUiModel_3x::fetch(int offset, int count, quint16 *values) const
+{
+    m_device->read_3x(static_cast<uint>(offset), static_cast<uint>(count), values);
 }
 
 mbServerDeviceUiModel_4x::mbServerDeviceUiModel_4x(mbServerDevice *device, QObject *parent) :
@@ -379,18 +470,19 @@ QVariant mbServerDeviceUiModel_4x::data(const QModelIndex &index, int role) cons
         int offset = index.row()*ColumnCount+index.column();
         if (offset < m_device->count_4x())
         {
+            quint16 v = value(offset);
             switch (m_format)
             {
             case mb::Bin:
-                return mb::toBinString(m_device->uint16_4x(static_cast<quint16>(offset)));
+                return mb::toBinString(v);
             case mb::Oct:
-                return mb::toOctString(m_device->uint16_4x(static_cast<quint16>(offset)));
+                return mb::toOctString(v);
             case mb::Hex:
-                return mb::toHexString(m_device->uint16_4x(static_cast<quint16>(offset)));
+                return mb::toHexString(v);
             case mb::UDec:
-                return m_device->uint16_4x(static_cast<quint16>(offset));
+                return v;
             default:
-                return m_device->int16_4x(static_cast<quint16>(offset));
+                return static_cast<qint16>(v);
             }
         }
     }
@@ -429,7 +521,10 @@ bool mbServerDeviceUiModel_4x::setData(const QModelIndex &index, const QVariant
                 break;
             }
             if (ok)
+            {
                 m_device->setUInt16_4x(static_cast<quint16>(offset), v);
+                updateValue(offset);
+            }
             return ok;
         }
     }
@@ -446,13 +541,18 @@ Qt::ItemFlags mbServerDeviceUiModel_4x::flags(const QModelIndex &index) const
     return QAbstractTableModel::flags(index);
 }
 
-void mbServerDeviceUiModel_4x::refresh()
+int mbServerDeviceUiModel_4x::count() const
 {
-    uint c = m_device->changeCounter_4x();
-    if (m_changeCounter != c)
-    {
-        Q_EMIT dataChanged(index(0, 0), index(rowCount()-1, columnCount()-1));
-        m_changeCounter = c;
-    }
+    return m_device->count_4x();
+}
+
+uint mbServerDeviceUiModel_4x::changeCounter() const
+{
+    return m_device->changeCounter_4x();
+}
+
+void mbServerDeviceUiModel_4x::fetch(int offset, int count, quint16 *values) const
+{
+    m_device->read_4x(static_cast<uint>(offset), static_cast<uint>(count), values);
 }
 
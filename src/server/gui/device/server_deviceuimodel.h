@@ -77,7 +77,7 @@ public:
 public:
     inline mbServerDevice* device() const { return m_device; }
     inline mb::DigitalFormat format() const { return m_format; }
-    virtual void refresh();
+    void refresh(int firstRow, int lastRow);
 
 public: // QAbstractItemModel interface
     QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const;
@@ -88,6 +88,15 @@ protected Q_SLOTS:
     void setRowCount(int count);
     void setFormat(int format);
 
+protected:
+    virtual int count() const = 0;
+    virtual uint changeCounter() const = 0;
+    // Reads 'count' values starting from 'offset' with single bulk read of device memory
+    virtual void fetch(int offset, int count, quint16 *values) const = 0;
+    quint16 value(int offset) const;
+    // Re-reads value of edited cell into snapshot and notifies view about it
+    void updateValue(int offset);
+
 protected:
     QString m_sym;
 
@@ -95,6 +104,9 @@ protected:
     int m_rowCount;
     mb::DigitalFormat m_format;
     uint m_changeCounter;
+    // snapshot of visible cells: 'm_values[i]' is value of cell with offset 'm_offset+i'
+    int m_offset;
+    QVector<quint16> m_values;
 };
 
 class mbServerDeviceUiModel_0x : public mbServerDeviceUiModel
@@ -104,7 +116,11 @@ public:
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
     bool setData(const QModelIndex &index, const QVariant &value, int role = Qt::EditRole) override;
     Qt::ItemFlags flags(const QModelIndex &index) const override;
-    void refresh() override;
+
+protected:
+    int count() const override;
+    uint changeCounter() const override;
+    void fetch(int offset, int count, quint16 *values) const override;
 };
 
 class mbServerDeviceUiModel_1x : public mbServerDeviceUiModel
@@ -114,7 +130,11 @@ public:
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
     bool setData(const QModelIndex &index, const QVariant &value, int role = Qt::EditRole) override;
     Qt::ItemFlags flags(const QModelIndex &index) const override;
-    void refresh() override;
+
+protected:
+    int count() const override;
+    uint changeCounter() const override;
+    void fetch(int offset, int count, quint16 *values) const override;
 };
 
 class mbServerDeviceUiModel_3x : public mbServerDeviceUiModel
@@ -124,7 +144,11 @@ public:
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
     bool setData(const QModelIndex &index, const QVariant &value, int role = Qt::EditRole) override;
     Qt::ItemFlags flags(const QModelIndex &index) const override;
-    void refresh() override;
+
+protected:
+    int count() const override;
+    uint changeCounter() const override;
+    void fetch(int offset, int count, quint16 *values) const override;
 };
 
 class mbServerDeviceUiModel_4x : public mbServerDeviceUiModel
@@ -134,7 +158,11 @@ public:
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
     bool setData(const QModelIndex &index, const QVariant &value, int role = Qt::EditRole) override;
     Qt::ItemFlags flags(const QModelIndex &index) const override;
-    void refresh() override;
+
+protected:
+    int count() const override;
+    uint changeCounter() const override;
+    void fetch(int offset, int count, quint16 *values) const override;
 };
 
 
@@ -111,6 +111,10 @@ mbServerDialogDevice::mbServerDialogDevice(QWidget *parent) :
     sp->setValue(dDevice.count4x);
     // Save Data
     ui->chbSaveData->setChecked(dDevice.isSaveData);
+    // Memory-mapped data file
+    ui->chbMemoryMapped->setChecked(dDevice.isMemoryMapped);
+    ui->chbMemoryMapped->setEnabled(dDevice.isSaveData);
+    connect(ui->chbSaveData, &QCheckBox::toggled, ui->chbMemoryMapped, &QCheckBox::setEnabled);
     // Read Only
     ui->chbReadOnly->setChecked(dDevice.isReadOnly);
 
@@ -139,6 +143,7 @@ MBSETTINGS mbServerDialogDevice::cachedSettings() const
     m[prefix+ms.count3x       ] = ui->spCount3x      ->value    ();
     m[prefix+ms.count4x       ] = ui->spCount4x      ->value    ();
     m[prefix+ms.isSaveData    ] = ui->chbSaveData    ->isChecked();
+    m[prefix+ms.isMemoryMapped] = ui->chbMemoryMapped->isChecked();
     m[prefix+ms.isReadOnly    ] = ui->chbReadOnly    ->isChecked();
     m[prefix+ms.delay         ] = ui->spDelay        ->value    ();
     m[prefix+ms.isEnableScript] = ui->chbEnableScript->isChecked();
@@ -167,6 +172,7 @@ void mbServerDialogDevice::setCachedSettings(const MBSETTINGS &m)
     it = m.find(prefix+vs.count3x   ); if (it != end) ui->spCount3x  ->setValue  (it.value().toInt   ());
     it = m.find(prefix+vs.count4x   ); if (it != end) ui->spCount4x  ->setValue  (it.value().toInt   ());
     it = m.find(prefix+vs.isSaveData); if (it != end) ui->chbSaveData->setChecked(it.value().toBool  ());
+    it = m.find(prefix+vs.isMemoryMapped); if (it != end) ui->chbMemoryMapped->setChecked(it.value().toBool());
     it = m.find(prefix+vs.isReadOnly); if (it != end) ui->chbReadOnly->setChecked(it.value().toBool  ());
     it = m.find(prefix+vs.delay     ); if (it != end) ui->spDelay    ->setValue  (it.value().toInt   ());
 
@@ -287,6 +293,7 @@ void mbServerDialogDevice::fillFormDevice(const MBSETTINGS &m)
     it = m.find(vs.count3x       ); if (it != end) ui->spCount3x      ->setValue  (it.value().toInt ());
     it = m.find(vs.count4x       ); if (it != end) ui->spCount4x      ->setValue  (it.value().toInt ());
     it = m.find(vs.isSaveData    ); if (it != end) ui->chbSaveData    ->setChecked(it.value().toBool());
+    it = m.find(vs.isMemoryMapped); if (it != end) ui->chbMemoryMapped->setChecked(it.value().toBool());
     it = m.find(vs.isReadOnly    ); if (it != end) ui->chbReadOnly    ->setChecked(it.value().toBool());
     it = m.find(vs.delay         ); if (it != end) ui->spDelay        ->setValue  (it.value().toInt ());
     it = m.find(vs.isEnableScript); if (it != end) ui->chbEnableScript->setChecked(it.value().toBool());
@@ -311,6 +318,7 @@ void mbServerDialogDevice::fillDataDevice(MBSETTINGS &settings) const
     settings[s.count3x       ] = ui->spCount3x      ->value    ();
     settings[s.count4x       ] = ui->spCount4x      ->value    ();
     settings[s.isSaveData    ] = ui->chbSaveData    ->isChecked();
+    settings[s.isMemoryMapped] = ui->chbMemoryMapped->isChecked();
     settings[s.isReadOnly    ] = ui->chbReadOnly    ->isChecked();
     settings[s.delay         ] = ui->spDelay        ->value    ();
     settings[s.isEnableScript] = ui->chbEnableScript->isChecked();
@@ -26,6 +26,8 @@
 #include <QMetaEnum>
 
 #include <server.h>
+#include <gui/server_ui.h>
+#include <gui/dialogs/server_dialogs.h>
 #include <project/server_project.h>
 #include <project/server_simaction.h>
 
@@ -102,22 +104,33 @@ mbServerDialogSimAction::mbServerDialogSimAction(QWidget *parent) :
     ui->lnActionIncrement->setText(QString::number(d.incrementValue));
     ui->lnActionIncrementMin->setText(QString::number(d.incrementMin));
     ui->lnActionIncrementMax->setText(QString::number(d.incrementMax));
+    ui->spIncrementSize->setValue(d.incrementSize);
 
     // Action Sine
     ui->lnActionSinePeriod->setText(QString::number(d.sinePeriod));
     ui->lnActionSinePhaseShift->setText(QString::number(d.sinePhaseShift));
     ui->lnActionSineAmplitude->setText(QString::number(d.sineAmplitude));
     ui->lnActionSineVerticalShift->setText(QString::number(d.sineVerticalShift));
+    ui->spSineSize->setValue(d.sineSize);
+    ui->lnActionSineElementPhaseShift->setText(QString::number(d.sineElementPhaseShift));
 
     // Action Random
     ui->lnActionRandomMin->setText(QString::number(d.randomMin));
     ui->lnActionRandomMax->setText(QString::number(d.randomMax));
+    ui->spRandomSize->setValue(d.randomSize);
 
     // Action Copy address type + Offset
     sp = ui->spCopySize;
     sp->setMinimum(0);
     sp->setMaximum(USHRT_MAX);
 
+    // Action Playback
+    ui->spPlaybackSpeed->setValue(d.playbackSpeed);
+    ui->spPlaybackSize->setValue(d.playbackSize);
+    ui->chbPlaybackLoop->setChecked(d.playbackLoop);
+    ui->chbPlaybackInterpolation->setChecked(d.playbackInterpolation);
+    connect(ui->btnActionPlaybackBrowse, &QPushButton::clicked, this, &mbServerDialogSimAction::browsePlaybackFile);
+
     //--------------------- ADVANCED ---------------------
     // Byte Order
     cmb = ui->cmbByteOrder;
@@ -161,14 +174,24 @@ MBSETTINGS mbServerDialogSimAction::cachedSettings() const
     m[prefix+vs.incrementValue   ] = ui->lnActionIncrement->text();
     m[prefix+vs.incrementMin     ] = ui->lnActionIncrementMin->text();
     m[prefix+vs.incrementMax     ] = ui->lnActionIncrementMax->text();
+    m[prefix+vs.incrementSize    ] = ui->spIncrementSize->value();
     m[prefix+vs.sinePeriod       ] = ui->lnActionSinePeriod->text();
     m[prefix+vs.sinePhaseShift   ] = ui->lnActionSinePhaseShift->text();
     m[prefix+vs.sineAmplitude    ] = ui->lnActionSineAmplitude->text();
     m[prefix+vs.sineVerticalShift] = ui->lnActionSineVerticalShift->text();
+    m[prefix+vs.sineSize         ] = ui->spSineSize->value();
+    m[prefix+vs.sineElementPhaseShift] = ui->lnActionSineElementPhaseShift->text();
     m[prefix+vs.randomMin        ] = ui->lnActionRandomMin->text();
     m[prefix+vs.randomMax        ] = ui->lnActionRandomMax->text();
+    m[prefix+vs.randomSize       ] = ui->spRandomSize->value();
     m[prefix+vs.copySourceAddress] = mb::toInt(adrCopy);
     m[prefix+vs.copySize         ] = ui->spCopySize->value();
+    m[prefix+vs.expression       ] = ui->lnActionExpression->text();
+    m[prefix+vs.playbackFile     ] = ui->lnActionPlaybackFile->text();
+    m[prefix+vs.playbackSpeed    ] = ui->spPlaybackSpeed->value();
+    m[prefix+vs.playbackLoop     ] = ui->chbPlaybackLoop->isChecked();
+    m[prefix+vs.playbackInterpolation] = ui->chbPlaybackInterpolation->isChecked();
+    m[prefix+vs.playbackSize     ] = ui->spPlaybackSize->value();
     m[prefix+vs.actionType       ] = ui->cmbActionType->currentText();
     m[prefix+vs.byteOrder        ] = ui->cmbByteOrder->currentText();
     m[prefix+vs.registerOrder    ] = ui->cmbRegisterOrder->currentText();
@@ -205,13 +228,23 @@ void mbServerDialogSimAction::setCachedSettings(const MBSETTINGS &m)
     it = m.find(prefix+vs.incrementValue   ); if (it != end) ui->lnActionIncrement->setText(it.value().toString());
     it = m.find(prefix+vs.incrementMin     ); if (it != end) ui->lnActionIncrementMin->setText(it.value().toString());
     it = m.find(prefix+vs.incrementMax     ); if (it != end) ui->lnActionIncrementMax->setText(it.value().toString());
+    it = m.find(prefix+vs.incrementSize    ); if (it != end) ui->spIncrementSize->setValue(it.value().toInt());
     it = m.find(prefix+vs.sinePeriod       ); if (it != end) ui->lnActionSinePeriod->setText(it.value().toString());
     it = m.find(prefix+vs.sinePhaseShift   ); if (it != end) ui->lnActionSinePhaseShift->setText(it.value().toString());
     it = m.find(prefix+vs.sineAmplitude    ); if (it != end) ui->lnActionSineAmplitude->setText(it.value().toString());
     it = m.find(prefix+vs.sineVerticalShift); if (it != end) ui->lnActionSineVerticalShift->setText(it.value().toString());
+    it = m.find(prefix+vs.sineSize         ); if (it != end) ui->spSineSize->setValue(it.value().toInt());
+    it = m.find(prefix+vs.sineElementPhaseShift); if (it != end) ui->lnActionSineElementPhaseShift->setText(it.value().toString());
     it = m.find(prefix+vs.randomMin        ); if (it != end) ui->lnActionRandomMin->setText(it.value().toString());
     it = m.find(prefix+vs.randomMax        ); if (it != end) ui->lnActionRandomMax->setText(it.value().toString());
+    it = m.find(prefix+vs.randomSize       ); if (it != end) ui->spRandomSize->setValue(it.value().toInt());
     it = m.find(prefix+vs.copySize         ); if (it != end) ui->spCopySize->setValue(it.value().toInt());
+    it = m.find(prefix+vs.expression       ); if (it != end) ui->lnActionExpression->setText(it.value().toString());
+    it = m.find(prefix+vs.playbackFile     ); if (it != end) ui->lnActionPlaybackFile->setText(it.value().toString());
+    it = m.find(prefix+vs.playbackSpeed    ); if (it != end) ui->spPlaybackSpeed->setValue(it.value().toDouble());
+    it = m.find(prefix+vs.playbackLoop     ); if (it != end) ui->chbPlaybackLoop->setChecked(it.value().toBool());
+    it = m.find(prefix+vs.playbackInterpolation); if (it != end) ui->chbPlaybackInterpolation->setChecked(it.value().toBool());
+    it = m.find(prefix+vs.playbackSize     ); if (it != end) ui->spPlaybackSize->setValue(it.value().toInt());
     it = m.find(prefix+vs.actionType       ); if (it != end) ui->cmbActionType->setCurrentText(mb::enumKey(mb::enumValue<mbServerSimAction::ActionType>(it.value())));
     it = m.find(prefix+vs.byteOrder        ); if (it != end) fillFormByteOrder(mb::enumDataOrderValue(it.value()));
     it = m.find(prefix+vs.registerOrder    ); if (it != end) fillFormRegisterOrder(mb::toRegisterOrder(it.value()));
@@ -324,16 +357,20 @@ void mbServerDialogSimAction::fillFormActionType(const MBSETTINGS &settings)
         ui->lnActionIncrement->setText(settings.value(sItem.incrementValue).toString());
         ui->lnActionIncrementMin->setText(settings.value(sItem.incrementMin).toString());
         ui->lnActionIncrementMax->setText(settings.value(sItem.incrementMax).toString());
+        it = settings.find(sItem.incrementSize); if (it != end) ui->spIncrementSize->setValue(it.value().toInt());
         break;
     case mbServerSimAction::Sine:
         it = settings.find(sItem.sinePeriod       ); if (it != end) ui->lnActionSinePeriod       ->setText(it.value().toString());
         it = settings.find(sItem.sinePhaseShift   ); if (it != end) ui->lnActionSinePhaseShift   ->setText(it.value().toString());
         it = settings.find(sItem.sineAmplitude    ); if (it != end) ui->lnActionSineAmplitude    ->setText(it.value().toString());
         it = settings.find(sItem.sineVerticalShift); if (it != end) ui->lnActionSineVerticalShift->setText(it.value().toString());
+        it = settings.find(sItem.sineSize         ); if (it != end) ui->spSineSize               ->setValue(it.value().toInt());
+        it = settings.find(sItem.sineElementPhaseShift); if (it != end) ui->lnActionSineElementPhaseShift->setText(it.value().toString());
         break;
     case mbServerSimAction::Random:
         it = settings.find(sItem.randomMin); if (it != end) ui->lnActionRandomMin->setText(it.value().toString());
         it = settings.find(sItem.randomMax); if (it != end) ui->lnActionRandomMax->setText(it.value().toString());
+        it = settings.find(sItem.randomSize); if (it != end) ui->spRandomSize->setValue(it.value().toInt());
         break;
     case mbServerSimAction::Copy:
     {
@@ -348,6 +385,16 @@ void mbServerDialogSimAction::fillFormActionType(const MBSETTINGS &settings)
             ui->spCopySize->setValue(it.value().toInt());
     }
         break;
+    case mbServerSimAction::Expression:
+        it = settings.find(sItem.expression); if (it != end) ui->lnActionExpression->setText(it.value().toString());
+        break;
+    case mbServerSimAction::Playback:
+        it = settings.find(sItem.playbackFile         ); if (it != end) ui->lnActionPlaybackFile    ->setText(it.value().toString());
+        it = settings.find(sItem.playbackSpeed        ); if (it != end) ui->spPlaybackSpeed         ->setValue(it.value().toDouble());
+        it = settings.find(sItem.playbackLoop         ); if (it != end) ui->chbPlaybackLoop         ->setChecked(it.value().toBool());
+        it = settings.find(sItem.playbackInterpolation); if (it != end) ui->chbPlaybackInterpolation->setChecked(it.value().toBool());
+        it = settings.find(sItem.playbackSize         ); if (it != end) ui->spPlaybackSize          ->setValue(it.value().toInt());
+        break;
     }
     ui->cmbActionType->setCurrentText(mb::enumKey<mbServerSimAction::ActionType>(t));
 }
@@ -427,16 +474,20 @@ void mbServerDialogSimAction::fillDataActionType(MBSETTINGS &settings)
         settings[sItem.incrementValue] = ui->lnActionIncrement->text();
         settings[sItem.incrementMin  ] = ui->lnActionIncrementMin->text();
         settings[sItem.incrementMax  ] = ui->lnActionIncrementMax->text();
+        settings[sItem.incrementSize ] = ui->spIncrementSize->value();
         break;
     case mbServerSimAction::Sine:
         settings[sItem.sinePeriod       ] = ui->lnActionSinePeriod->text();
         settings[sItem.sinePhaseShift   ] = ui->lnActionSinePhaseShift->text();
         settings[sItem.sineAmplitude    ] = ui->lnActionSineAmplitude->text();
         settings[sItem.sineVerticalShift] = ui->lnActionSineVerticalShift->text();
+        settings[sItem.sineSize         ] = ui->spSineSize->value();
+        settings[sItem.sineElementPhaseShift] = ui->lnActionSineElementPhaseShift->text();
         break;
     case mbServerSimAction::Random:
         settings[sItem.randomMin] = ui->lnActionRandomMin->text();
         settings[sItem.randomMax] = ui->lnActionRandomMax->text();
+        settings[sItem.randomSize] = ui->spRandomSize->value();
         break;
     case mbServerSimAction::Copy:
     {
@@ -445,6 +496,16 @@ void mbServerDialogSimAction::fillDataActionType(MBSETTINGS &settings)
         settings[sItem.copySize         ] = ui->spCopySize->value();
     }
         break;
+    case mbServerSimAction::Expression:
+        settings[sItem.expression] = ui->lnActionExpression->text();
+        break;
+    case mbServerSimAction::Playback:
+        settings[sItem.playbackFile         ] = ui->lnActionPlaybackFile->text();
+        settings[sItem.playbackSpeed        ] = ui->spPlaybackSpeed->value();
+        settings[sItem.playbackLoop         ] = ui->chbPlaybackLoop->isChecked();
+        settings[sItem.playbackInterpolation] = ui->chbPlaybackInterpolation->isChecked();
+        settings[sItem.playbackSize         ] = ui->spPlaybackSize->value();
+        break;
     }
     settings[sItem.actionType] = t;
 }
@@ -504,3 +565,13 @@ void mbServerDialogSimAction::setActionType(int i)
     ui->swActionType->setCurrentIndex(i);
 }
 
+void mbServerDialogSimAction::browsePlaybackFile()
+{
+    QString file = mbServer::global()->ui()->dialogs()->getOpenFileName(this,
+                                                                       QStringLiteral("Browse Trace File"),
+                                                                       QString(),
+                                                                       QStringLiteral("Trace (*.mbtrace *.csv);;All files (*)"));
+    if (file.count())
+        ui->lnActionPlaybackFile->setText(file);
+}
+
@@ -82,6 +82,7 @@ private Q_SLOTS:
     void setModbusAddresNotation(mb::AddressNotation notation);
     void deviceChanged(int i);
     void setActionType(int i);
+    void browsePlaybackFile();
 
 private:
     Ui::mbServerDialogSimAction *ui;
@@ -6,6 +6,7 @@
 #include <server.h>
 
 #include "server_widgetsettingsscript.h"
+#include "server_widgetsettingssimulation.h"
 #include <gui/server_outputview.h>
 #include <gui/script/server_scriptmanager.h>
 
@@ -27,6 +28,9 @@ mbServerDialogSettings::mbServerDialogSettings(QWidget *parent) :
     m_listWidget->addItem(QStringLiteral("Script"));
     m_script = new mbServerWidgetSettingsScript(m_stackedWidget);
     m_stackedWidget->addWidget(m_script);
+    m_listWidget->addItem(QStringLiteral("Simulation"));
+    m_simulation = new mbServerWidgetSettingsSimulation(m_stackedWidget);
+    m_stackedWidget->addWidget(m_simulation);
 }
 
 void mbServerDialogSettings::fillForm(const MBSETTINGS &m)
@@ -38,6 +42,10 @@ void mbServerDialogSettings::fillForm(const MBSETTINGS &m)
 
     m_script->setScriptEnable            (m.value(ssrv.settings_scriptEnable         ).toBool      ());
     m_script->setScriptUseOptimization   (m.value(ssrv.settings_scriptUseOptimization).toBool      ());
+    m_script->setScriptSharedMemory      (m.value(ssrv.settings_scriptSharedMemory   ).toBool      ());
+    m_script->setScriptEmbedded          (m.value(ssrv.settings_scriptEmbedded       ).toBool      ());
+    m_script->setScriptSharedArena       (m.value(ssrv.settings_scriptSharedArena    ).toBool      ());
+    m_script->setScriptWorkerCount       (m.value(ssrv.settings_scriptWorkerCount    ).toInt       ());
     m_script->setScriptLoopPeriod        (m.value(ssrv.settings_scriptLoopPeriod     ).toInt       ());
     m_script->setScriptGenerateComment   (m.value(sscr.settings_scriptGenerateComment).toBool      ());
     m_script->setScriptWordWrap          (m.value(sscr.settings_wordWrap             ).toBool      ());
@@ -49,6 +57,7 @@ void mbServerDialogSettings::fillForm(const MBSETTINGS &m)
     m_script->scriptSetManualExecutables (m.value(ssrv.settings_scriptManual         ).toStringList());
     m_script->scriptSetDefaultExecutable (m.value(ssrv.settings_scriptDefault        ).toString    ());
     m_script->scriptSetImportPath        (m.value(ssrv.settings_scriptImportPath     ).toStringList());
+    m_simulation->setSimWorkerCount      (m.value(ssrv.settings_simWorkerCount       ).toInt       ());
 }
 
 void mbServerDialogSettings::fillData(MBSETTINGS &m)
@@ -59,6 +68,10 @@ void mbServerDialogSettings::fillData(MBSETTINGS &m)
     mbCoreDialogSettings::fillData(m);
     m[ssrv.settings_scriptEnable         ] = m_script->scriptEnable            ();
     m[ssrv.settings_scriptUseOptimization] = m_script->scriptUseOptimization   ();
+    m[ssrv.settings_scriptSharedMemory   ] = m_script->scriptSharedMemory      ();
+    m[ssrv.settings_scriptEmbedded       ] = m_script->scriptEmbedded          ();
+    m[ssrv.settings_scriptSharedArena    ] = m_script->scriptSharedArena       ();
+    m[ssrv.settings_scriptWorkerCount    ] = m_script->scriptWorkerCount       ();
     m[ssrv.settings_scriptLoopPeriod     ] = m_script->scriptLoopPeriod        ();
     m[sscr.settings_scriptGenerateComment] = m_script->scriptGenerateComment   ();
     m[sscr.settings_wordWrap             ] = m_script->scriptWordWrap          ();
@@ -70,4 +83,5 @@ void mbServerDialogSettings::fillData(MBSETTINGS &m)
     m[ssrv.settings_scriptManual         ] = m_script->scriptManualExecutables ();
     m[ssrv.settings_scriptDefault        ] = m_script->scriptDefaultExecutable ();
     m[ssrv.settings_scriptImportPath     ] = m_script->scriptImportPath        ();
+    m[ssrv.settings_simWorkerCount       ] = m_simulation->simWorkerCount      ();
 }
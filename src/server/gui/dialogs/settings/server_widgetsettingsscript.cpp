@@ -30,6 +30,10 @@ mbServerWidgetSettingsScript::mbServerWidgetSettingsScript(QWidget *parent) :
     sp->setMinimum(1);
     sp->setMaximum(INT_MAX);
 
+    sp = ui->spWorkerCount;
+    sp->setMinimum(0);
+    sp->setMaximum(256);
+
     sp = ui->spTabSpaces;
     sp->setMinimum(1);
     sp->setMaximum(8);
@@ -108,6 +112,46 @@ void mbServerWidgetSettingsScript::setScriptUseOptimization(bool use)
     ui->chbScriptUseOptimization->setChecked(use);
 }
 
+bool mbServerWidgetSettingsScript::scriptSharedMemory() const
+{
+    return ui->chbScriptSharedMemory->isChecked();
+}
+
+void mbServerWidgetSettingsScript::setScriptSharedMemory(bool use)
+{
+    ui->chbScriptSharedMemory->setChecked(use);
+}
+
+bool mbServerWidgetSettingsScript::scriptEmbedded() const
+{
+    return ui->chbScriptEmbedded->isChecked();
+}
+
+void mbServerWidgetSettingsScript::setScriptEmbedded(bool use)
+{
+    ui->chbScriptEmbedded->setChecked(use);
+}
+
+bool mbServerWidgetSettingsScript::scriptSharedArena() const
+{
+    return ui->chbScriptSharedArena->isChecked();
+}
+
+void mbServerWidgetSettingsScript::setScriptSharedArena(bool use)
+{
+    ui->chbScriptSharedArena->setChecked(use);
+}
+
+int mbServerWidgetSettingsScript::scriptWorkerCount() const
+{
+    return ui->spWorkerCount->value();
+}
+
+void mbServerWidgetSettingsScript::setScriptWorkerCount(int count)
+{
+    ui->spWorkerCount->setValue(count);
+}
+
 int mbServerWidgetSettingsScript::scriptLoopPeriod() const
 {
     return ui->spLoopPeriod->value();
@@ -27,6 +27,14 @@ public:
 
     bool scriptUseOptimization() const;
     void setScriptUseOptimization(bool use);
+    bool scriptSharedMemory() const;
+    void setScriptSharedMemory(bool use);
+    bool scriptEmbedded() const;
+    void setScriptEmbedded(bool use);
+    bool scriptSharedArena() const;
+    void setScriptSharedArena(bool use);
+    int scriptWorkerCount() const;
+    void setScriptWorkerCount(int count);
 
     int scriptLoopPeriod() const;
     void setScriptLoopPeriod(int period);
@@ -0,0 +1,35 @@
+#include "server_widgetsettingssimulation.h"
+#include "ui_server_widgetsettingssimulation.h"
+
+#include <server.h>
+
+mbServerWidgetSettingsSimulation::mbServerWidgetSettingsSimulation(QWidget *parent) :
+    QWidget(parent),
+    ui(new Ui::mbServerWidgetSettingsSimulation)
+{
+    ui->setupUi(this);
+
+    QSpinBox *sp;
+
+    sp = ui->spWorkerCount;
+    sp->setMinimum(0);
+    sp->setMaximum(256);
+    sp->setSpecialValueText(QStringLiteral("Auto"));
+
+    setSimWorkerCount(mbServer::global()->simWorkerCount());
+}
+
+mbServerWidgetSettingsSimulation::~mbServerWidgetSettingsSimulation()
+{
+    delete ui;
+}
+
+int mbServerWidgetSettingsSimulation::simWorkerCount() const
+{
+    return ui->spWorkerCount->value();
+}
+
+void mbServerWidgetSettingsSimulation::setSimWorkerCount(int count)
+{
+    ui->spWorkerCount->setValue(count);
+}
@@ -0,0 +1,26 @@
+#ifndef SERVER_WIDGETSETTINGSSIMULATION_H
+#define SERVER_WIDGETSETTINGSSIMULATION_H
+
+#include <QWidget>
+
+namespace Ui {
+class mbServerWidgetSettingsSimulation;
+}
+
+class mbServerWidgetSettingsSimulation : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit mbServerWidgetSettingsSimulation(QWidget *parent = nullptr);
+    ~mbServerWidgetSettingsSimulation();
+
+public:
+    int simWorkerCount() const;
+    void setSimWorkerCount(int count);
+
+private:
+    Ui::mbServerWidgetSettingsSimulation *ui;
+};
+
+#endif // SERVER_WIDGETSETTINGSSIMULATION_H
@@ -3,14 +3,17 @@ HEADERS += \
     $$PWD/server_dialogsettings.h \
     $$PWD/server_modelsettingsscripteditorcolors.h \
     $$PWD/server_modelsettingsscriptinterpreters.h \
-    $$PWD/server_widgetsettingsscript.h
+    $$PWD/server_widgetsettingsscript.h \
+    $$PWD/server_widgetsettingssimulation.h
 
 SOURCES += \
     $$PWD/server_delegatesettingsscripteditorcolors.cpp \
     $$PWD/server_dialogsettings.cpp \
     $$PWD/server_modelsettingsscripteditorcolors.cpp \
     $$PWD/server_modelsettingsscriptinterpreters.cpp \
-    $$PWD/server_widgetsettingsscript.cpp
+    $$PWD/server_widgetsettingsscript.cpp \
+    $$PWD/server_widgetsettingssimulation.cpp
 
 FORMS += \
-    $$PWD/server_widgetsettingsscript.ui
+    $$PWD/server_widgetsettingsscript.ui \
+    $$PWD/server_widgetsettingssimulation.ui
@@ -8,11 +8,13 @@ include(script/script.pri)
 
 HEADERS += \
     $$PWD/server_outputview.h \
+    $$PWD/server_statisticview.h \
     $$PWD/server_windowmanager.h    \
     $$PWD/server_ui.h               \
     
 SOURCES += \
     $$PWD/server_outputview.cpp \
+    $$PWD/server_statisticview.cpp \
     $$PWD/server_windowmanager.cpp  \
     $$PWD/server_ui.cpp             \
 
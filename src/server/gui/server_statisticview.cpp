@@ -0,0 +1,305 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "server_statisticview.h"
+
+#include <QTabWidget>
+#include <QTreeWidget>
+#include <QHeaderView>
+#include <QVBoxLayout>
+
+#include <server.h>
+#include <project/server_project.h>
+#include <project/server_port.h>
+#include <project/server_device.h>
+
+mbServerStatisticView::mbServerStatisticView(QWidget *parent) :
+    QWidget(parent)
+{
+    m_project = nullptr;
+
+    m_tabs = new QTabWidget(this);
+    m_tabs->setTabPosition(QTabWidget::South);
+
+    m_view = new QTreeWidget(m_tabs);
+    m_view->setColumnCount(ColumnCount);
+    m_view->setHeaderLabels(QStringList() << QStringLiteral("Name"      )
+                                          << QStringLiteral("Requests"  )
+                                          << QStringLiteral("Responses" )
+                                          << QStringLiteral("Exceptions")
+                                          << QStringLiteral("Bytes In"  )
+                                          << QStringLiteral("Bytes Out" )
+                                          << QStringLiteral("Avg, us"   )
+                                          << QStringLiteral("Min, us"   )
+                                          << QStringLiteral("Max, us"   )
+                                          << QStringLiteral("Functions" ));
+    m_view->setAlternatingRowColors(true);
+    m_view->header()->setStretchLastSection(true);
+    m_tabs->addTab(m_view, QStringLiteral("Ports"));
+
+    m_scriptView = new QTreeWidget(m_tabs);
+    m_scriptView->setColumnCount(ScriptColumnCount);
+    m_scriptView->setRootIsDecorated(false);
+    m_scriptView->setHeaderLabels(QStringList() << QStringLiteral("Device"      )
+                                                << QStringLiteral("State"       )
+                                                << QStringLiteral("Period, ms"  )
+                                                << QStringLiteral("Cycles"      )
+                                                << QStringLiteral("Last, us"    )
+                                                << QStringLiteral("Avg, us"     )
+                                                << QStringLiteral("Max, us"     )
+                                                << QStringLiteral("Overruns"    ));
+    m_scriptView->setAlternatingRowColors(true);
+    m_scriptView->header()->setStretchLastSection(true);
+    m_tabs->addTab(m_scriptView, QStringLiteral("Scripts"));
+
+    m_simView = new QTreeWidget(m_tabs);
+    m_simView->setColumnCount(SimColumnCount);
+    m_simView->setRootIsDecorated(false);
+    m_simView->setHeaderLabels(QStringList() << QStringLiteral("Worker"      )
+                                             << QStringLiteral("Devices"     )
+                                             << QStringLiteral("Actions"     )
+                                             << QStringLiteral("Execs/s"     )
+                                             << QStringLiteral("Load, %"     )
+                                             << QStringLiteral("Avg, us"     )
+                                             << QStringLiteral("Max, us"     )
+                                             << QStringLiteral("Overruns"    ));
+    m_simView->setAlternatingRowColors(true);
+    m_simView->header()->setStretchLastSection(true);
+    m_tabs->addTab(m_simView, QStringLiteral("Simulation"));
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addWidget(m_tabs);
+
+    mbServer *core = mbServer::global();
+    setProject(core->project());
+    connect(core, &mbServer::projectChanged, this, &mbServerStatisticView::setProject);
+}
+
+QString mbServerStatisticView::functionsString(const mbServerPortStatistic::Counters &c)
+{
+    QStringList ls;
+    for (int i = 0; i < mbServerPortStatistic::FunctionCount; i++)
+    {
+        if (c.functions[i])
+            ls.append(QString("%1:%2").arg(i, 2, 10, QChar('0')).arg(c.functions[i]));
+    }
+    return ls.join(' ');
+}
+
+QString mbServerStatisticView::exceptionsString(const mbServerPortStatistic::Counters &c)
+{
+    QStringList ls;
+    for (int i = 0; i < mbServerPortStatistic::ExceptionCount; i++)
+    {
+        if (c.exceptions[i])
+            ls.append(QString("%1:%2").arg(i, 2, 10, QChar('0')).arg(c.exceptions[i]));
+    }
+    return ls.join(' ');
+}
+
+void mbServerStatisticView::setProject(mbCoreProject *project)
+{
+    if (m_project)
+        m_project->disconnect(this);
+    Q_FOREACH (mbServerPort *port, m_items.keys())
+        port->disconnect(this);
+    Q_FOREACH (mbServerDevice *device, m_scriptItems.keys())
+        device->disconnect(this);
+    m_items.clear();
+    m_scriptItems.clear();
+    m_view->clear();
+    m_scriptView->clear();
+    m_simView->clear();
+    m_project = static_cast<mbServerProject*>(project);
+    if (m_project)
+    {
+        Q_FOREACH (mbServerPort *port, m_project->ports())
+            portAdd(port);
+        connect(m_project, &mbServerProject::portAdded   , this, &mbServerStatisticView::portAdd   );
+        connect(m_project, &mbServerProject::portRemoving, this, &mbServerStatisticView::portRemove);
+        Q_FOREACH (mbServerDevice *device, m_project->devices())
+            deviceAdd(device);
+        connect(m_project, &mbServerProject::deviceAdded   , this, &mbServerStatisticView::deviceAdd   );
+        connect(m_project, &mbServerProject::deviceRemoving, this, &mbServerStatisticView::deviceRemove);
+        connect(m_project, &mbServerProject::simStatisticChanged, this, &mbServerStatisticView::simStatisticChanged);
+        simStatisticChanged();
+    }
+}
+
+void mbServerStatisticView::portAdd(mbCorePort *p)
+{
+    mbServerPort *port = static_cast<mbServerPort*>(p);
+    QTreeWidgetItem *item = new QTreeWidgetItem(m_view);
+    m_items.insert(port, item);
+    connect(port, &mbServerPort::runStatisticChanged, this, &mbServerStatisticView::portStatisticChanged);
+    refreshPort(port);
+}
+
+void mbServerStatisticView::portRemove(mbCorePort *p)
+{
+    mbServerPort *port = static_cast<mbServerPort*>(p);
+    port->disconnect(this);
+    delete m_items.take(port);
+}
+
+void mbServerStatisticView::portStatisticChanged()
+{
+    mbServerPort *port = qobject_cast<mbServerPort*>(sender());
+    if (port)
+        refreshPort(port);
+}
+
+void mbServerStatisticView::deviceAdd(mbCoreDevice *d)
+{
+    mbServerDevice *device = static_cast<mbServerDevice*>(d);
+    QTreeWidgetItem *item = new QTreeWidgetItem(m_scriptView);
+    m_scriptItems.insert(device, item);
+    connect(device, &mbServerDevice::scriptStatisticChanged, this, &mbServerStatisticView::deviceScriptStatisticChanged);
+    connect(device, &mbServerDevice::nameChanged           , this, &mbServerStatisticView::deviceScriptStatisticChanged);
+    refreshDevice(device);
+}
+
+void mbServerStatisticView::deviceRemove(mbCoreDevice *d)
+{
+    mbServerDevice *device = static_cast<mbServerDevice*>(d);
+    device->disconnect(this);
+    delete m_scriptItems.take(device);
+}
+
+void mbServerStatisticView::deviceScriptStatisticChanged()
+{
+    mbServerDevice *device = qobject_cast<mbServerDevice*>(sender());
+    if (device)
+        refreshDevice(device);
+}
+
+void mbServerStatisticView::simStatisticChanged()
+{
+    if (!m_project)
+        return;
+    QList<mbServerSimStatistic> stat = m_project->simStatistic();
+    // Note: count of workers is changed only when project is started, so rows are reused
+    while (m_simView->topLevelItemCount() > stat.count())
+        delete m_simView->takeTopLevelItem(m_simView->topLevelItemCount()-1);
+    while (m_simView->topLevelItemCount() < stat.count())
+        new QTreeWidgetItem(m_simView);
+    for (int i = 0; i < stat.count(); i++)
+    {
+        const mbServerSimStatistic &s = stat.at(i);
+        QTreeWidgetItem *item = m_simView->topLevelItem(i);
+        item->setText(SimColumn_Name, QString("Worker %1").arg(i));
+        if (s.timestamp.isNull())
+        {
+            // Note: worker has not published its statistic yet
+            for (int c = SimColumn_Devices; c < SimColumnCount; c++)
+                item->setText(c, QString());
+            continue;
+        }
+        item->setText(SimColumn_Devices , QString::number(s.devices));
+        item->setText(SimColumn_Actions , QString::number(s.actions));
+        item->setText(SimColumn_Execs   , QString::number(s.execs));
+        item->setText(SimColumn_Load    , QString::number(s.load));
+        item->setText(SimColumn_TimeAvg , QString::number(s.timeAvg));
+        item->setText(SimColumn_TimeMax , QString::number(s.timeMax));
+        item->setText(SimColumn_Overruns, QString::number(s.overruns));
+        item->setToolTip(SimColumn_Name, s.timestamp.toString(Qt::ISODateWithMs));
+    }
+}
+
+void mbServerStatisticView::refreshDevice(mbServerDevice *device)
+{
+    QTreeWidgetItem *item = m_scriptItems.value(device);
+    if (!item)
+        return;
+    mbServerScriptStatistic stat = device->scriptStatistic();
+    item->setText(ScriptColumn_Name    , device->name());
+    if (stat.timestamp.isNull())
+    {
+        // Note: script of the device was not executed yet
+        for (int i = ScriptColumn_State; i < ScriptColumnCount; i++)
+            item->setText(i, QString());
+        return;
+    }
+    item->setText(ScriptColumn_State   , stat.isRunning ? QStringLiteral("Running") : QStringLiteral("Stopped"));
+    item->setText(ScriptColumn_Period  , QString::number(stat.period));
+    item->setText(ScriptColumn_Cycles  , QString::number(stat.cycles));
+    item->setText(ScriptColumn_TimeLast, QString::number(stat.timeLast));
+    item->setText(ScriptColumn_TimeAvg , QString::number(stat.timeAvg));
+    item->setText(ScriptColumn_TimeMax , QString::number(stat.timeMax));
+    item->setText(ScriptColumn_Overruns, QString::number(stat.overruns));
+    // Note: highlight the script that doesn't fit into its period
+    item->setForeground(ScriptColumn_Overruns, stat.overruns ? QBrush(Qt::red) : QBrush());
+    item->setToolTip(ScriptColumn_Name, stat.timestamp.toString(Qt::ISODateWithMs));
+}
+
+void mbServerStatisticView::refreshPort(mbServerPort *port)
+{
+    QTreeWidgetItem *item = m_items.value(port);
+    if (!item)
+        return;
+    mbServerPortStatistic stat = port->runStatistic();
+    fillItem(item, port->name(), stat.total);
+    // Note: number of connections and units is small, so rebuild the subtree
+    //       only when its shape is changed and just update values otherwise
+    if (item->childCount() != stat.connections.count())
+    {
+        clearChildren(item);
+        for (int i = 0; i < stat.connections.count(); i++)
+            new QTreeWidgetItem(item);
+    }
+    for (int i = 0; i < stat.connections.count(); i++)
+    {
+        const mbServerPortStatistic::Connection &c = stat.connections.at(i);
+        QTreeWidgetItem *ci = item->child(i);
+        fillItem(ci, c.isOpen ? c.name : QString("%1 (closed)").arg(c.name), c.total);
+        if (ci->childCount() != c.units.count())
+        {
+            clearChildren(ci);
+            for (int j = 0; j < c.units.count(); j++)
+                new QTreeWidgetItem(ci);
+        }
+        int j = 0;
+        for (QMap<quint8, mbServerPortStatistic::Counters>::const_iterator it = c.units.constBegin(); it != c.units.constEnd(); ++it, ++j)
+            fillItem(ci->child(j), QString("Unit %1").arg(it.key()), it.value());
+    }
+}
+
+void mbServerStatisticView::fillItem(QTreeWidgetItem *item, const QString &name, const mbServerPortStatistic::Counters &c)
+{
+    item->setText(Column_Name      , name);
+    item->setText(Column_Requests  , QString::number(c.requests));
+    item->setText(Column_Responses , QString::number(c.responses));
+    item->setText(Column_Exceptions, QString::number(c.exceptionCount()));
+    item->setText(Column_BytesIn   , QString::number(c.bytesIn));
+    item->setText(Column_BytesOut  , QString::number(c.bytesOut));
+    item->setText(Column_TimeAvg   , QString::number(c.timeAvg()));
+    item->setText(Column_TimeMin   , QString::number(c.timeMin));
+    item->setText(Column_TimeMax   , QString::number(c.timeMax));
+    item->setText(Column_Functions , functionsString(c));
+    item->setToolTip(Column_Exceptions, exceptionsString(c));
+}
+
+void mbServerStatisticView::clearChildren(QTreeWidgetItem *item)
+{
+    qDeleteAll(item->takeChildren());
+}
@@ -0,0 +1,123 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef SERVER_STATISTICVIEW_H
+#define SERVER_STATISTICVIEW_H
+
+#include <QHash>
+#include <QWidget>
+
+#include <project/server_portstatistic.h>
+#include <project/server_scriptstatistic.h>
+#include <project/server_simstatistic.h>
+
+class QTabWidget;
+class QTreeWidget;
+class QTreeWidgetItem;
+
+class mbCoreProject;
+class mbCorePort;
+class mbCoreDevice;
+class mbServerProject;
+class mbServerPort;
+class mbServerDevice;
+
+class mbServerStatisticView : public QWidget
+{
+    Q_OBJECT
+
+public:
+    enum Column
+    {
+        Column_Name,
+        Column_Requests,
+        Column_Responses,
+        Column_Exceptions,
+        Column_BytesIn,
+        Column_BytesOut,
+        Column_TimeAvg,
+        Column_TimeMin,
+        Column_TimeMax,
+        Column_Functions,
+        ColumnCount
+    };
+
+    enum ScriptColumn
+    {
+        ScriptColumn_Name,
+        ScriptColumn_State,
+        ScriptColumn_Period,
+        ScriptColumn_Cycles,
+        ScriptColumn_TimeLast,
+        ScriptColumn_TimeAvg,
+        ScriptColumn_TimeMax,
+        ScriptColumn_Overruns,
+        ScriptColumnCount
+    };
+
+    enum SimColumn
+    {
+        SimColumn_Name,
+        SimColumn_Devices,
+        SimColumn_Actions,
+        SimColumn_Execs,
+        SimColumn_Load,
+        SimColumn_TimeAvg,
+        SimColumn_TimeMax,
+        SimColumn_Overruns,
+        SimColumnCount
+    };
+
+public:
+    explicit mbServerStatisticView(QWidget *parent = nullptr);
+
+public:
+    static QString functionsString(const mbServerPortStatistic::Counters &c);
+    static QString exceptionsString(const mbServerPortStatistic::Counters &c);
+
+private Q_SLOTS:
+    void setProject(mbCoreProject *project);
+    void portAdd(mbCorePort *port);
+    void portRemove(mbCorePort *port);
+    void portStatisticChanged();
+    void deviceAdd(mbCoreDevice *device);
+    void deviceRemove(mbCoreDevice *device);
+    void deviceScriptStatisticChanged();
+    void simStatisticChanged();
+
+private:
+    void refreshPort(mbServerPort *port);
+    void fillItem(QTreeWidgetItem *item, const QString &name, const mbServerPortStatistic::Counters &c);
+    void refreshDevice(mbServerDevice *device);
+    void clearChildren(QTreeWidgetItem *item);
+
+private:
+    mbServerProject *m_project;
+    QTabWidget *m_tabs;
+    QTreeWidget *m_view;
+    QTreeWidget *m_scriptView;
+    QTreeWidget *m_simView;
+    QHash<mbServerPort*, QTreeWidgetItem*> m_items;
+    QHash<mbServerDevice*, QTreeWidgetItem*> m_scriptItems;
+};
+
+#endif // SERVER_STATISTICVIEW_H
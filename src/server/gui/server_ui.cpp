@@ -35,6 +35,7 @@
 #include <project/server_project.h>
 #include <project/server_port.h>
 #include <project/server_deviceref.h>
+#include <project/server_devicetemplate.h>
 #include <project/server_dataview.h>
 #include <project/server_simaction.h>
 #include <project/server_scriptmodule.h>
@@ -57,6 +58,7 @@
 #include "simactions/server_simactionsui.h"
 #include "scriptmodules/server_scriptmodulesui.h"
 #include "server_outputview.h"
+#include "server_statisticview.h"
 
 mbServerUi::Strings::Strings() :
     cacheFormat(QStringLiteral("Ui.format"))
@@ -227,6 +229,14 @@ void mbServerUi::initialize()
     this->addDockWidget(Qt::BottomDockWidgetArea, m_dockScriptModules);
     this->tabifyDockWidget(ui->dockLogView, m_dockScriptModules);
 
+    // Statistic
+    m_dockStatistic = new QDockWidget("Statistic", this);
+    m_dockStatistic->setObjectName(QStringLiteral("dockStatistic"));
+    m_statisticView = new mbServerStatisticView(m_dockStatistic);
+    m_dockStatistic->setWidget(m_statisticView);
+    this->addDockWidget(Qt::BottomDockWidgetArea, m_dockStatistic);
+    this->tabifyDockWidget(ui->dockLogView, m_dockStatistic);
+
     ui->dockLogView->raise();
 
     // Menu Edit
@@ -240,18 +250,22 @@ void mbServerUi::initialize()
     connect(ui->actionViewSimulation   , &QAction::triggered, this, &mbServerUi::menuSlotViewSimulation   );
     connect(ui->actionViewScriptModules, &QAction::triggered, this, &mbServerUi::menuSlotViewScriptModules);
     connect(ui->actionViewOutput       , &QAction::triggered, this, &mbServerUi::menuSlotViewOutput       );
+    connect(ui->actionViewStatistic    , &QAction::triggered, this, &mbServerUi::menuSlotViewStatistic    );
 
     // Menu Port
     connect(ui->actionPortDeviceNew   , &QAction::triggered, this, &mbServerUi::menuSlotPortDeviceNew   );
     connect(ui->actionPortDeviceAdd   , &QAction::triggered, this, &mbServerUi::menuSlotPortDeviceAdd   );
     connect(ui->actionPortDeviceEdit  , &QAction::triggered, this, &mbServerUi::menuSlotPortDeviceEdit  );
     connect(ui->actionPortDeviceDelete, &QAction::triggered, this, &mbServerUi::menuSlotPortDeviceDelete);
+    connect(ui->actionPortStatisticExport, &QAction::triggered, this, &mbServerUi::menuSlotPortStatisticExport);
 
     // Menu Device
+    connect(ui->actionDeviceInstantiate   , &QAction::triggered, this, &mbServerUi::menuSlotDeviceInstantiate   );
     connect(ui->actionDeviceMemoryZerro   , &QAction::triggered, this, &mbServerUi::menuSlotDeviceMemoryZerro   );
     connect(ui->actionDeviceMemoryZerroAll, &QAction::triggered, this, &mbServerUi::menuSlotDeviceMemoryZerroAll);
     connect(ui->actionDeviceMemoryImport  , &QAction::triggered, this, &mbServerUi::menuSlotDeviceMemoryImport  );
     connect(ui->actionDeviceMemoryExport  , &QAction::triggered, this, &mbServerUi::menuSlotDeviceMemoryExport  );
+    connect(ui->actionDeviceAccessExport  , &QAction::triggered, this, &mbServerUi::menuSlotDeviceAccessExport  );
     connect(ui->actionDeviceScriptInit    , &QAction::triggered, this, &mbServerUi::menuSlotDeviceScriptInit    );
     connect(ui->actionDeviceScriptLoop    , &QAction::triggered, this, &mbServerUi::menuSlotDeviceScriptLoop    );
     connect(ui->actionDeviceScriptFinal   , &QAction::triggered, this, &mbServerUi::menuSlotDeviceScriptFinal   );
@@ -466,6 +480,12 @@ void mbServerUi::menuSlotViewOutput()
     m_dockOutput->show();
 }
 
+void mbServerUi::menuSlotViewStatistic()
+{
+    m_dockStatistic->show();
+    m_dockStatistic->raise();
+}
+
 void mbServerUi::menuSlotPortNew()
 {
     if (core()->isRunning())
@@ -628,6 +648,22 @@ void mbServerUi::menuSlotPortDeviceDelete()
     }
 }
 
+void mbServerUi::menuSlotPortStatisticExport()
+{
+    mbServerPort *port = projectUi()->currentPort();
+    if (!port)
+        return;
+    QString file = dialogs()->getSaveFileName(this,
+                                              QString("Export statistic of '%1' ...").arg(port->name()),
+                                              QString(),
+                                              m_dialogs->getFilterString(mbCoreDialogs::Filter_CsvFiles));
+    if (file.isEmpty())
+        return;
+    builder()->clearErrors();
+    if (!builder()->exportPortStatistic(file, port))
+        mbServer::LogError(port->name(), builder()->errors().join(QStringLiteral("; ")));
+}
+
 void mbServerUi::menuSlotDeviceNew()
 {
     if (core()->isRunning())
@@ -713,6 +749,56 @@ void mbServerUi::menuSlotDeviceExport()
     }
 }
 
+void mbServerUi::menuSlotDeviceInstantiate()
+{
+    if (core()->isRunning())
+        return;
+    mbServerProject *project = core()->project();
+    if (!project)
+        return;
+    mbServerDeviceUi *deviceUi = this->activeDeviceUi();
+    if (!deviceUi)
+        return;
+    mbServerDevice *device = deviceUi->device();
+    QString title = QString("Instantiate '%1'").arg(device->name());
+    bool ok;
+    QString unitsStr = dialogs()->getText(this, title, QStringLiteral("Units (e.g. '1-247'):"), QLineEdit::Normal, QStringLiteral("1"), &ok);
+    if (!ok)
+        return;
+    QList<quint8> units = mb::toUnitsList(unitsStr, &ok);
+    if (!ok || units.isEmpty())
+    {
+        QMessageBox::warning(this, title, QString("Invalid units list '%1'").arg(unitsStr));
+        return;
+    }
+    QString portsStr = dialogs()->getText(this, title, QStringLiteral("TCP ports (e.g. '502-601'):"), QLineEdit::Normal, QStringLiteral("502"), &ok);
+    if (!ok)
+        return;
+    QList<quint16> tcpPorts;
+    Q_FOREACH (const QString &param, portsStr.split(',', Qt::SkipEmptyParts))
+    {
+        QStringList range = param.split('-');
+        int begin = range.first().trimmed().toInt(&ok);
+        int end = (ok && range.count() == 2) ? range.last().trimmed().toInt(&ok) : begin;
+        if (!ok || (range.count() > 2) || (begin < 1) || (end > USHRT_MAX) || (begin > end))
+        {
+            QMessageBox::warning(this, title, QString("Invalid TCP ports list '%1'").arg(portsStr));
+            return;
+        }
+        for (int p = begin; p <= end; p++)
+            tcpPorts.append(static_cast<quint16>(p));
+    }
+    QList<mbServerDevice*> instances = project->deviceInstantiate(device, units, tcpPorts, projectUi()->currentPort());
+    if (instances.count())
+    {
+        mbServerDeviceTemplate *t = project->deviceTemplate(device, false);
+        if (t && (t->instanceCount() < instances.count()))
+            mbServer::LogWarning(QStringLiteral("Project"), t->errorString());
+        mbServer::LogInfo(QStringLiteral("Project"), QString("%1 instance(s) of device '%2' created").arg(instances.count()).arg(device->name()));
+        m_project->setModifiedFlag(true);
+    }
+}
+
 void mbServerUi::menuSlotDeviceMemoryZerro()
 {
     if (mbServerDeviceUi *deviceUi = this->activeDeviceUi())
@@ -786,6 +872,23 @@ void mbServerUi::menuSlotDeviceMemoryExport()
     }
 }
 
+void mbServerUi::menuSlotDeviceAccessExport()
+{
+    if (mbServerDeviceUi *deviceUi = this->activeDeviceUi())
+    {
+        mbServerDevice *device = deviceUi->device();
+        QString file = dialogs()->getSaveFileName(this,
+                                                  QString("Export access counters of '%1' ...").arg(device->name()),
+                                                  QString(),
+                                                  m_dialogs->getFilterString(mbCoreDialogs::Filter_CsvFiles));
+        if (file.isEmpty())
+            return;
+        builder()->clearErrors();
+        if (!builder()->exportDeviceAccess(file, device))
+            mbServer::LogError(device->name(), builder()->errors().join(QStringLiteral("; ")));
+    }
+}
+
 void mbServerUi::menuSlotDeviceScriptInit()
 {
     mbServerDeviceUi *deviceUi = this->activeDeviceUi();
@@ -39,6 +39,7 @@ class mbServerDevice;
 class mbServerDeviceRef;
 class mbServerSimAction;
 class mbServerOutputView;
+class mbServerStatisticView;
 
 class mbServer;
 class mbServerBuilder;
@@ -117,6 +118,7 @@ private Q_SLOTS:
     // ------------VIEW------------
     // ----------------------------
     void menuSlotViewOutput();
+    void menuSlotViewStatistic();
     // ----------------------------
     // ------------EDIT------------
     // ----------------------------
@@ -143,6 +145,7 @@ private Q_SLOTS:
     void menuSlotPortDeviceAdd   ();
     void menuSlotPortDeviceEdit  ();
     void menuSlotPortDeviceDelete();
+    void menuSlotPortStatisticExport();
     // ----------------------------
     // -----------DEVICE-----------
     // ----------------------------
@@ -151,10 +154,12 @@ private Q_SLOTS:
     void menuSlotDeviceDelete        () override;
     void menuSlotDeviceImport        () override;
     void menuSlotDeviceExport        () override;
+    void menuSlotDeviceInstantiate   ();
     void menuSlotDeviceMemoryZerro   ();
     void menuSlotDeviceMemoryZerroAll();
     void menuSlotDeviceMemoryImport  ();
     void menuSlotDeviceMemoryExport  ();
+    void menuSlotDeviceAccessExport  ();
     void menuSlotDeviceScriptInit    ();
     void menuSlotDeviceScriptLoop    ();
     void menuSlotDeviceScriptFinal   ();
@@ -221,6 +226,9 @@ private:
     // Output
     QDockWidget *m_dockOutput;
     mbServerOutputView *m_outputView;
+    // Statistic
+    QDockWidget *m_dockStatistic;
+    mbServerStatisticView *m_statisticView;
     // SimAction
     mbServerSimActionsUi *m_simActionsUi;
     QDockWidget *m_dockSimActions;
@@ -1,10 +1,16 @@
 HEADERS += \
     $$PWD/server_builder.h \
     $$PWD/server_device.h \
+    $$PWD/server_deviceaccess.h \
+    $$PWD/server_deviceimage.h \
     $$PWD/server_deviceref.h \
+    $$PWD/server_devicetemplate.h \
     $$PWD/server_dom.h \
     $$PWD/server_port.h \
+    $$PWD/server_portstatistic.h \
     $$PWD/server_project.h \
+    $$PWD/server_scriptstatistic.h \
+    $$PWD/server_simstatistic.h \
     $$PWD/server_dataview.h \
     $$PWD/server_scriptmodule.h \
     $$PWD/server_simaction.h
@@ -12,7 +18,10 @@ HEADERS += \
 SOURCES += \
     $$PWD/server_builder.cpp \
     $$PWD/server_device.cpp \
+    $$PWD/server_deviceaccess.cpp \
+    $$PWD/server_deviceimage.cpp \
     $$PWD/server_deviceref.cpp \
+    $$PWD/server_devicetemplate.cpp \
     $$PWD/server_dom.cpp \
     $$PWD/server_port.cpp \
     $$PWD/server_project.cpp \
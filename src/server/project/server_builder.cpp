@@ -32,13 +32,16 @@
 #include "server_project.h"
 #include "server_port.h"
 #include "server_device.h"
+#include "server_deviceimage.h"
+#include "server_deviceaccess.h"
 #include "server_deviceref.h"
 #include "server_simaction.h"
 #include "server_scriptmodule.h"
 #include "server_dataview.h"
 
 mbServerBuilder::Strings::Strings() :
-    sep(QChar(';'))
+    sep(QChar(';')),
+    deviceImageSuffix(QStringLiteral("mbdata"))
 
 {
 }
@@ -69,6 +72,71 @@ QStringList mbServerBuilder::csvSimActionAttributes() const
         ;
 }
 
+mbCoreProject *mbServerBuilder::loadXml(const QString &file)
+{
+    mbServerProject *project = static_cast<mbServerProject*>(mbCoreBuilder::loadXml(file));
+    if (project)
+    {
+        Q_FOREACH (mbServerDevice *device, project->devices())
+        {
+            // device that saves its own data doesn't use memory of template
+            if (device->templateName().count() && !device->isSaveData() && !project->deviceTemplateAttach(device))
+                mbServer::LogWarning(QStringLiteral("Builder"), QString("Device '%1' can't use memory of template device '%2'").arg(device->name(), device->templateName()));
+        }
+        openDeviceImages(project);
+    }
+    return project;
+}
+
+bool mbServerBuilder::saveXml(mbCoreProject *project)
+{
+    // project file path or device names could be changed since last save,
+    // so images are reopened (if needed) before device data is skipped in xml-file.
+    // Image is written from current memory: file left in target folder must not overwrite it
+    QDir().mkpath(QFileInfo(project->absoluteFilePath()).absolutePath());
+    openDeviceImages(static_cast<mbServerProject*>(project), false);
+    Q_FOREACH (mbServerDevice *device, static_cast<mbServerProject*>(project)->devices())
+        device->flushImage(true);
+    return mbCoreBuilder::saveXml(project);
+}
+
+QString mbServerBuilder::deviceImageFile(mbServerProject *project, mbServerDevice *device) const
+{
+    const Strings &s = Strings::instance();
+    QFileInfo fi(project->absoluteFilePath());
+    QString fileName = QString("%1.%2.%3").arg(fi.completeBaseName(), device->name(), s.deviceImageSuffix);
+    return QDir(fi.absolutePath()).filePath(fileName);
+}
+
+void mbServerBuilder::openDeviceImages(mbServerProject *project, bool restore)
+{
+    bool hasFile = !project->absoluteFilePath().isEmpty();
+    Q_FOREACH (mbServerDevice *device, project->devices())
+    {
+        if (hasFile && device->isSaveData() && device->isMemoryMapped())
+        {
+            QString file = deviceImageFile(project, device);
+            if (device->imageFile() == file)
+                continue;
+            QString err;
+            if (!device->openImage(file, &err, restore))
+            {
+                if (restore)
+                {
+                    setError(err);
+                    mbServer::LogError(QStringLiteral("Builder"), err);
+                }
+                else
+                    mbServer::LogWarning(QStringLiteral("Builder"), QString("Device '%1' image '%2' can't be opened (%3). Device data is saved into project file").arg(device->name(), file, err));
+            }
+            else if (device->image()->isRestored() && !device->image()->isCleanRestored())
+                mbServer::LogWarning(QStringLiteral("Builder"), QString("Device '%1' image '%2' was not closed properly. Last flushed data is used").arg(device->name(), file));
+        }
+        else
+            device->closeImage();
+    }
+}
+
 mbCoreProject *mbServerBuilder::newProject() const
 {
     return new mbServerProject;
@@ -179,20 +247,23 @@ mbCorePort *mbServerBuilder::toPort(mbCoreDomPort *dom)
 mbCoreDevice *mbServerBuilder::toDevice(mbCoreDomDevice *dom)
 {
     mbServerDevice *device = static_cast<mbServerDevice*>(mbCoreBuilder::toDevice(dom));
+    // Note: memory-mapped device data is restored from its binary image, but xml-data (if any)
+    //       is still loaded to initialize new image (e.g. when option was enabled for existing project)
+    bool mapped = device->isMemoryMapped();
     const mbServerDomDeviceData *data = &static_cast<mbServerDomDevice*>(dom)->data0x();
-    if (device->isSaveData())
+    if (device->isSaveData() && !(mapped && data->data().isEmpty()))
         device->write_0x_bool(data->offset(), data->count(), reinterpret_cast<const bool*>(toBoolData(data->data()).constData()));
 
     data = &static_cast<mbServerDomDevice*>(dom)->data1x();
-    if (device->isSaveData())
+    if (device->isSaveData() && !(mapped && data->data().isEmpty()))
         device->write_1x_bool(data->offset(), data->count(), reinterpret_cast<const bool*>(toBoolData(data->data()).constData()));
 
     data = &static_cast<mbServerDomDevice*>(dom)->data3x();
-    if (device->isSaveData())
+    if (device->isSaveData() && !(mapped && data->data().isEmpty()))
         device->write_3x(data->offset(), data->count(), reinterpret_cast<const quint16*>(toUInt16Data(data->data()).constData()));
 
     data = &static_cast<mbServerDomDevice*>(dom)->data4x();
-    if (device->isSaveData())
+    if (device->isSaveData() && !(mapped && data->data().isEmpty()))
         device->write_4x(data->offset(), data->count(), reinterpret_cast<const quint16*>(toUInt16Data(data->data()).constData()));
     return device;
 }
@@ -237,7 +308,8 @@ mbCoreDomDevice *mbServerBuilder::toDomDevice(mbCoreDevice *device)
     // 4x
     mbServerDomDeviceData* data4x = &domDevice->data4x();
     data4x->setCount(static_cast<mbServerDevice*>(device)->count_4x());
-    if (static_cast<mbServerDevice*>(device)->isSaveData())
+    // Note: data of memory-mapped device is kept in xml-file when its image can't be opened
+    if (static_cast<mbServerDevice*>(device)->isSaveData() && !static_cast<mbServerDevice*>(device)->hasImage())
     {
         // 0x
         data0x->setOffset(0);
@@ -625,6 +697,141 @@ bool mbServerBuilder::exportUInt16Data(QIODevice *buff, const QByteArray &data,
     return true;
 }
 
+bool mbServerBuilder::exportDeviceAccess(const QString &file, mbServerDevice *device, const QChar &sep)
+{
+    if (!device->accessCounters())
+    {
+        setError(QString("Access counting was never enabled for device '%1'").arg(device->name()));
+        return false;
+    }
+    QFileInfo info(file);
+    QDir dir = info.absoluteDir();
+    if (!dir.mkpath(dir.absolutePath()))
+    {
+        setError(QString("Can't create directory '%1'").arg(dir.absolutePath()));
+        return false;
+    }
+    QFile f(info.absoluteFilePath());
+    if (f.open(QIODevice::WriteOnly))
+        return exportDeviceAccess(&f, device, sep);
+    setError(f.errorString());
+    return false;
+}
+
+bool mbServerBuilder::exportDeviceAccess(QIODevice *buff, mbServerDevice *device, const QChar &sep)
+{
+    const mbServerDeviceAccess *access = device->accessCounters();
+    if (!access)
+        return false;
+    const char s = sep.toLatin1();
+    const char *memNames[mbServerDeviceAccess::MemoryCount] = { "0x", "1x", "3x", "4x" };
+    const int   memCount[mbServerDeviceAccess::MemoryCount] = { device->count_0x(), device->count_1x(), device->count_3x(), device->count_4x() };
+
+    QByteArray line = QByteArray("Memory") + s + "Page" + s + "Begin" + s + "End" + s + "Reads" + s + "Writes\n";
+    buff->write(line);
+    for (int m = 0; m < mbServerDeviceAccess::MemoryCount; m++)
+    {
+        int pages = (memCount[m] + mbServerDeviceAccess::PageSize - 1) / mbServerDeviceAccess::PageSize;
+        for (int p = 0; p < pages; p++)
+        {
+            mbServerDeviceAccess::Counters c = access->counters(m, p);
+            int begin = p * mbServerDeviceAccess::PageSize;
+            int end = qMin(begin + mbServerDeviceAccess::PageSize, memCount[m]) - 1;
+            line = QByteArray(memNames[m])  + s +
+                   QByteArray::number(p)        + s +
+                   QByteArray::number(begin)    + s +
+                   QByteArray::number(end)      + s +
+                   QByteArray::number(c.reads)  + s +
+                   QByteArray::number(c.writes) + '\n';
+            buff->write(line);
+        }
+    }
+    return true;
+}
+
+bool mbServerBuilder::exportPortStatistic(const QString &file, mbServerPort *port, const QChar &sep)
+{
+    QFileInfo info(file);
+    QDir dir = info.absoluteDir();
+    if (!dir.mkpath(dir.absolutePath()))
+    {
+        setError(QString("Can't create directory '%1'").arg(dir.absolutePath()));
+        return false;
+    }
+    QFile f(info.absoluteFilePath());
+    if (f.open(QIODevice::WriteOnly))
+        return exportPortStatistic(&f, port->runStatistic(), sep);
+    setError(f.errorString());
+    return false;
+}
+
+bool mbServerBuilder::exportPortStatistic(QIODevice *buff, const mbServerPortStatistic &stat, const QChar &sep)
+{
+    typedef mbServerPortStatistic::Counters Counters;
+
+    // use only function and exception codes which are present in statistic
+    QList<int> funcs;
+    for (int i = 0; i < mbServerPortStatistic::FunctionCount; i++)
+    {
+        if (stat.total.functions[i])
+            funcs.append(i);
+    }
+    QList<int> excs;
+    for (int i = 0; i < mbServerPortStatistic::ExceptionCount; i++)
+    {
+        if (stat.total.exceptions[i])
+            excs.append(i);
+    }
+
+    QStringList header;
+    header << QStringLiteral("Connection")
+           << QStringLiteral("Unit")
+           << QStringLiteral("Requests")
+           << QStringLiteral("Responses")
+           << QStringLiteral("Exceptions")
+           << QStringLiteral("BytesIn")
+           << QStringLiteral("BytesOut")
+           << QStringLiteral("TimeAvgUs")
+           << QStringLiteral("TimeMinUs")
+           << QStringLiteral("TimeMaxUs");
+    Q_FOREACH (int i, funcs)
+        header << QString("FC%1").arg(i, 2, 10, QChar('0'));
+    Q_FOREACH (int i, excs)
+        header << QString("EX%1").arg(i, 2, 10, QChar('0'));
+    buff->write(header.join(sep).toUtf8());
+    buff->write("\n");
+
+    writePortStatisticRow(buff, QStringLiteral("*"), QStringLiteral("*"), stat.total, funcs, excs, sep);
+    Q_FOREACH (const mbServerPortStatistic::Connection &c, stat.connections)
+    {
+        writePortStatisticRow(buff, c.name, QStringLiteral("*"), c.total, funcs, excs, sep);
+        for (QMap<quint8, Counters>::const_iterator it = c.units.constBegin(); it != c.units.constEnd(); ++it)
+            writePortStatisticRow(buff, c.name, QString::number(it.key()), it.value(), funcs, excs, sep);
+    }
+    return true;
+}
+
+void mbServerBuilder::writePortStatisticRow(QIODevice *buff, const QString &connection, const QString &unit, const mbServerPortStatistic::Counters &c, const QList<int> &funcs, const QList<int> &excs, const QChar &sep)
+{
+    QStringList row;
+    row << connection
+        << unit
+        << QString::number(c.requests)
+        << QString::number(c.responses)
+        << QString::number(c.exceptionCount())
+        << QString::number(c.bytesIn)
+        << QString::number(c.bytesOut)
+        << QString::number(c.timeAvg())
+        << QString::number(c.timeMin)
+        << QString::number(c.timeMax);
+    Q_FOREACH (int i, funcs)
+        row << QString::number(c.functions[i]);
+    Q_FOREACH (int i, excs)
+        row << QString::number(c.exceptions[i]);
+    buff->write(row.join(sep).toUtf8());
+    buff->write("\n");
+}
+
 void mbServerBuilder::importDomProject(mbCoreDomProject *dom)
 {
     mbServerProject *project = this->project();
@@ -25,6 +25,7 @@
 
 #include <project/core_builder.h>
 #include <project/server_project.h>
+#include <project/server_portstatistic.h>
 
 class QIODevice;
 
@@ -50,6 +51,7 @@ public:
     struct Strings : public mbCoreBuilder::Strings
     {
         const QChar sep;
+        const QString deviceImageSuffix;
         //----------------
         Strings();
         static const Strings &instance();
@@ -71,6 +73,17 @@ public:
 public:
     QStringList csvSimActionAttributes() const;
 
+public: // .xml project
+    using mbCoreBuilder::loadXml;
+    using mbCoreBuilder::saveXml;
+    mbCoreProject *loadXml(const QString &file) override;
+    bool saveXml(mbCoreProject *project) override;
+
+public: // memory-mapped device data images
+    QString deviceImageFile(mbServerProject *project, mbServerDevice *device) const;
+    // 'restore' - device data is restored from existing image, otherwise image is written from current device data
+    void openDeviceImages(mbServerProject *project, bool restore = true);
+
 public: // 'mbCoreBuilder'-interface
     mbCoreProject         *newProject        () const override;
     mbCorePort            *newPort           () const override;
@@ -140,12 +153,19 @@ public:
     bool exportUInt16Data(const QString& file, const QByteArray &data, int columns, const QChar& sep = Strings::instance().sep);
     bool exportUInt16Data(QIODevice* buff, const QByteArray &data, int columns, const QChar& sep = Strings::instance().sep);
 
+    bool exportDeviceAccess(const QString& file, mbServerDevice *device, const QChar& sep = Strings::instance().sep);
+    bool exportDeviceAccess(QIODevice* buff, mbServerDevice *device, const QChar& sep = Strings::instance().sep);
+
+    bool exportPortStatistic(const QString& file, mbServerPort *port, const QChar& sep = Strings::instance().sep);
+    bool exportPortStatistic(QIODevice* buff, const mbServerPortStatistic &stat, const QChar& sep = Strings::instance().sep);
+
 private:
     void importDomProject(mbCoreDomProject *dom) override;
     BoolData_t toBoolData(const QString &str, int reserve = MB_MEMORY_MAX_COUNT);
     UInt16Data_t toUInt16Data(const QString &str, int reserve = MB_MEMORY_MAX_COUNT);
     QString fromBoolData(const BoolData_t &data);
     QString fromUInt16Data(const UInt16Data_t &data);
+    void writePortStatisticRow(QIODevice *buff, const QString &connection, const QString &unit, const mbServerPortStatistic::Counters &c, const QList<int> &funcs, const QList<int> &excs, const QChar &sep);
 
 };
 
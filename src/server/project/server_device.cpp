@@ -28,7 +28,22 @@
     when setUnits-method with project incharge
 */
 
+#include <atomic>
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#else
+#include <signal.h>
+#include <errno.h>
+#endif
+
 #include <QSet>
+#include <QThread>
+#include <QElapsedTimer>
+#include <QCoreApplication>
+
+#include "server_deviceimage.h"
+#include "server_deviceaccess.h"
 
 mbServerDevice::Strings::Strings() :
     count0x               (QStringLiteral("count0x")),
@@ -36,10 +51,12 @@ mbServerDevice::Strings::Strings() :
     count3x               (QStringLiteral("count3x")),
     count4x               (QStringLiteral("count4x")),
     isSaveData            (QStringLiteral("isSaveData")),
+    isMemoryMapped        (QStringLiteral("isMemoryMapped")),
     isReadOnly            (QStringLiteral("isReadOnly")),
     exceptionStatusAddress(QStringLiteral("exceptionStatusAddress")),
     delay                 (QStringLiteral("delay")),
     isEnableScript        (QStringLiteral("isEnableScript")),
+    templateName          (QStringLiteral("templateName")),
     scriptInit            (QStringLiteral("scriptInit")),
     scriptLoop            (QStringLiteral("scriptLoop")),
     scriptFinal           (QStringLiteral("scriptFinal"))
@@ -62,10 +79,12 @@ mbServerDevice::Defaults::Defaults() :
     count3x(65536),
     count4x(65536),
     isSaveData(false),
+    isMemoryMapped(false),
     isReadOnly(false),
     exceptionStatusAddress(1),
     delay(0),
-    isEnableScript(true)
+    isEnableScript(true),
+    templateName()
 {
 }
 
@@ -77,6 +96,12 @@ const mbServerDevice::Defaults &mbServerDevice::Defaults::instance()
 
 mbServerDevice::MemoryBlock::MemoryBlock()
 {
+    m_ptr = m_data.data();
+    m_size = 0;
+    m_attached = false;
+    m_seqOwn = nullptr;
+    m_seqPeer = nullptr;
+    m_writeLock = nullptr;
     m_sizeBits = 0;
     m_changeCounter = 0;
 }
@@ -84,23 +109,173 @@ mbServerDevice::MemoryBlock::MemoryBlock()
 void mbServerDevice::MemoryBlock::resize(int bytes)
 {
     QWriteLocker _(&m_lock);
+    // Note: resizing always returns block to its own (not attached) memory
+    m_attached = false;
+    m_seqOwn = nullptr;
+    m_seqPeer = nullptr;
+    m_writeLock = nullptr;
     m_data.resize(bytes);
-    memset(m_data.data(), 0, m_data.size());
-    m_sizeBits = m_data.size() * MB_BYTE_SZ_BITES;
+    m_ptr = m_data.data();
+    m_size = m_data.size();
+    memset(m_ptr, 0, m_size);
+    m_sizeBits = m_size * MB_BYTE_SZ_BITES;
 }
 
 void mbServerDevice::MemoryBlock::resizeBits(int bits)
 {
     QWriteLocker _(&m_lock);
+    m_attached = false;
+    m_seqOwn = nullptr;
+    m_seqPeer = nullptr;
+    m_writeLock = nullptr;
     m_data.resize((bits+7)/8);
-    memset(m_data.data(), 0, m_data.size());
+    m_ptr = m_data.data();
+    m_size = m_data.size();
+    memset(m_ptr, 0, m_size);
     m_sizeBits = bits;
 }
 
+void mbServerDevice::MemoryBlock::attachMemory(void *mem, bool copyData)
+{
+    QWriteLocker _(&m_lock);
+    if (copyData)
+        memcpy(mem, m_ptr, m_size);
+    m_ptr = reinterpret_cast<char*>(mem);
+    m_data = QByteArray();
+    m_attached = true;
+    m_changeCounter++;
+}
+
+void mbServerDevice::MemoryBlock::detachMemory()
+{
+    QWriteLocker _(&m_lock);
+    if (!m_attached)
+        return;
+    m_data = QByteArray(m_ptr, m_size);
+    m_ptr = m_data.data();
+    m_attached = false;
+    m_seqOwn = nullptr;
+    m_seqPeer = nullptr;
+    m_writeLock = nullptr;
+    m_changeCounter++;
+}
+
+void mbServerDevice::MemoryBlock::setSequenceLock(quint32 *ownSequence, const quint32 *peerSequence, quint32 *writeLock)
+{
+    QWriteLocker _(&m_lock);
+    m_seqOwn = reinterpret_cast<QAtomicInteger<quint32>*>(ownSequence);
+    m_seqPeer = reinterpret_cast<const QAtomicInteger<quint32>*>(peerSequence);
+    m_writeLock = reinterpret_cast<QAtomicInteger<quint32>*>(writeLock);
+}
+
+void mbServerDevice::MemoryBlock::notifyChanged()
+{
+    QWriteLocker _(&m_lock);
+    m_changeCounter++;
+}
+
+quint32 mbServerDevice::MemoryBlock::seqReadBegin() const
+{
+    if (!m_seqPeer)
+        return 0;
+    // Note: spinning is limited, so process that died in the middle of writing can't block the server
+    quint32 seq = m_seqPeer->loadAcquire();
+    for (int i = 0; (seq & 1) && (i < 1000); i++)
+    {
+        QThread::yieldCurrentThread();
+        seq = m_seqPeer->loadAcquire();
+    }
+    return seq;
+}
+
+bool mbServerDevice::MemoryBlock::seqReadRetry(quint32 seq) const
+{
+    if (!m_seqPeer || (seq & 1))
+        return false;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return m_seqPeer->loadAcquire() != seq;
+}
+
+static quint32 currentProcessId()
+{
+    static const quint32 pid = static_cast<quint32>(QCoreApplication::applicationPid());
+    return pid;
+}
+
+static bool isProcessAlive(quint32 pid)
+{
+#if defined(Q_OS_WIN)
+    HANDLE h = OpenProcess(SYNCHRONIZE, FALSE, static_cast<DWORD>(pid));
+    if (!h)
+        return GetLastError() == ERROR_ACCESS_DENIED;
+    bool alive = (WaitForSingleObject(h, 0) == WAIT_TIMEOUT);
+    CloseHandle(h);
+    return alive;
+#else
+    return (kill(static_cast<pid_t>(pid), 0) == 0) || (errno == EPERM);
+#endif
+}
+
+void mbServerDevice::MemoryBlock::lockWrite()
+{
+    m_lock.lockForWrite();
+    const quint32 pid = currentProcessId();
+    if (!m_writeLock || m_writeLock->testAndSetAcquire(0, pid))
+        return;
+    // Note: local lock is released while waiting, so readers of the block (e.g. port threads) are not stalled.
+    //       Lock is taken over only when its owner process is not alive (died holding the lock)
+    const qint64 OwnerCheckPeriod = 100; // milliseconds
+    QElapsedTimer timer;
+    timer.start();
+    qint64 nextCheck = OwnerCheckPeriod;
+    for (;;)
+    {
+        m_lock.unlock();
+        QThread::yieldCurrentThread();
+        m_lock.lockForWrite();
+        if (!m_writeLock) // memory was detached while waiting
+            return;
+        quint32 owner;
+        if (m_writeLock->testAndSetAcquire(0, pid, owner))
+            return;
+        if (timer.elapsed() >= nextCheck)
+        {
+            nextCheck = timer.elapsed() + OwnerCheckPeriod;
+            if (owner && (owner != pid) && !isProcessAlive(owner) && m_writeLock->testAndSetAcquire(owner, pid))
+                return;
+        }
+    }
+}
+
+void mbServerDevice::MemoryBlock::unlockWrite()
+{
+    if (m_writeLock)
+        m_writeLock->storeRelease(0);
+    m_lock.unlock();
+}
+
+void mbServerDevice::MemoryBlock::seqWriteBegin()
+{
+    if (m_seqOwn)
+        m_seqOwn->fetchAndAddOrdered(1);
+}
+
+void mbServerDevice::MemoryBlock::seqWriteEnd()
+{
+    if (m_seqOwn)
+        m_seqOwn->fetchAndAddOrdered(1);
+}
+
 void mbServerDevice::MemoryBlock::memGet(uint byteOffset, void *buff, size_t size)
 {
     QReadLocker _(&m_lock);
-    memcpy(buff, m_data.data()+byteOffset, size);
+    quint32 seq;
+    do
+    {
+        seq = seqReadBegin();
+        memcpy(buff, m_ptr+byteOffset, size);
+    }
+    while (seqReadRetry(seq));
 }
 
 void mbServerDevice::MemoryBlock::memSetMask(uint byteOffset, const void *buff, const void *mask, size_t size)
@@ -108,15 +283,16 @@ void mbServerDevice::MemoryBlock::memSetMask(uint byteOffset, const void *buff,
     size_t c = 0;
     size_t prefix = byteOffset % sizeof(size_t);
 
-    QWriteLocker _(&m_lock);
-    if (byteOffset >= m_data.size())
+    WriteLocker _(this);
+    if (byteOffset >= m_size)
         return;
-    if ((byteOffset + size) > m_data.size())
-        size = m_data.size() - byteOffset;
+    if ((byteOffset + size) > m_size)
+        size = m_size - byteOffset;
     // 1. Copy prefix
-    quint8 *membyte = reinterpret_cast<quint8*>(m_data.data())+byteOffset;
+    quint8 *membyte = reinterpret_cast<quint8*>(m_ptr)+byteOffset;
     const quint8 *bufbyte = reinterpret_cast<const quint8*>(buff);
     const quint8 *mskbyte = reinterpret_cast<const quint8*>(mask);
+    seqWriteBegin();
     if (prefix)
     {
         if (prefix > size)
@@ -152,29 +328,38 @@ void mbServerDevice::MemoryBlock::memSetMask(uint byteOffset, const void *buff,
         quint8 m = mskbyte[i];
         membyte[i] = (membyte[i] & ~m) | (bufbyte[i] & m);
     }
+    seqWriteEnd();
 
     m_changeCounter++;
 }
 
 void mbServerDevice::MemoryBlock::zerroAll()
 {
-    QWriteLocker _(&m_lock);
+    WriteLocker _(this);
     m_changeCounter++;
-    memset(m_data.data(), 0, m_data.size());
+    seqWriteBegin();
+    memset(m_ptr, 0, m_size);
+    seqWriteEnd();
 }
 
 Modbus::StatusCode mbServerDevice::MemoryBlock::read(uint offset, uint count, void *buff, uint *fact) const
 {
     QReadLocker _(&m_lock);
     uint c;
-    if (offset >= static_cast<uint>(static_cast<uint>(m_data.size())))
+    if (offset >= static_cast<uint>(static_cast<uint>(m_size)))
         return Modbus::Status_BadIllegalDataAddress;
 
-    if ((offset+count) > static_cast<uint>(m_data.size()))
-        c = static_cast<uint>(static_cast<uint>(m_data.size())) - offset;
+    if ((offset+count) > static_cast<uint>(m_size))
+        c = static_cast<uint>(static_cast<uint>(m_size)) - offset;
     else
         c = count;
-    memcpy(buff, m_data.data()+offset, c);
+    quint32 seq;
+    do
+    {
+        seq = seqReadBegin();
+        memcpy(buff, m_ptr+offset, c);
+    }
+    while (seqReadRetry(seq));
     if (fact)
         *fact = c;
     return Modbus::Status_Good;
@@ -182,18 +367,20 @@ Modbus::StatusCode mbServerDevice::MemoryBlock::read(uint offset, uint count, vo
 
 Modbus::StatusCode mbServerDevice::MemoryBlock::write(uint offset, uint count, const void *buff, uint *fact)
 {
-    QWriteLocker _(&m_lock);
+    WriteLocker _(this);
     uint c;
-    if (offset >= static_cast<uint>(m_data.size()))
+    if (offset >= static_cast<uint>(m_size))
         return Modbus::Status_BadIllegalDataAddress;
 
-    if ((offset+count) > static_cast<uint>(m_data.size()))
-        c = static_cast<uint>(m_data.size()) - offset;
+    if ((offset+count) > static_cast<uint>(m_size))
+        c = static_cast<uint>(m_size) - offset;
     else
         c = count;
     if (c == 0)
         return Modbus::Status_BadIllegalDataAddress;
-    memcpy(m_data.data()+offset, buff, c);
+    seqWriteBegin();
+    memcpy(m_ptr+offset, buff, c);
+    seqWriteEnd();
     m_changeCounter++;
     if (fact)
         *fact = c;
@@ -203,6 +390,11 @@ Modbus::StatusCode mbServerDevice::MemoryBlock::write(uint offset, uint count, c
 Modbus::StatusCode mbServerDevice::MemoryBlock::readBits(uint bitOffset, uint bitCount, void *buff, uint *fact) const
 {
     QReadLocker _(&m_lock);
+    return readBitsUnlocked(bitOffset, bitCount, buff, fact);
+}
+
+Modbus::StatusCode mbServerDevice::MemoryBlock::readBitsUnlocked(uint bitOffset, uint bitCount, void *buff, uint *fact) const
+{
     uint c;
     if (bitOffset >= m_sizeBits)
         return Modbus::Status_BadIllegalDataAddress;
@@ -212,40 +404,46 @@ Modbus::StatusCode mbServerDevice::MemoryBlock::readBits(uint bitOffset, uint bi
     else
         c = bitCount;
 
-    uint byteOffset = bitOffset/MB_BYTE_SZ_BITES;
-    uint bytes = c/MB_BYTE_SZ_BITES;
-    uint shift = bitOffset%MB_BYTE_SZ_BITES;
-    const quint8 *mem = reinterpret_cast<const quint8*>(m_data.data());
-    if (shift)
+    quint32 seq;
+    do
     {
-        for (uint i = 0; i < bytes; i++)
+        seq = seqReadBegin();
+        uint byteOffset = bitOffset/MB_BYTE_SZ_BITES;
+        uint bytes = c/MB_BYTE_SZ_BITES;
+        uint shift = bitOffset%MB_BYTE_SZ_BITES;
+        const quint8 *mem = reinterpret_cast<const quint8*>(m_ptr);
+        if (shift)
         {
-            quint16 v = *(reinterpret_cast<const quint16*>(&mem[byteOffset+i])) >> shift; // no need to check (i+1) < bytes because if (shift > 0) then target bits are located in both nearest bytes (i) and (i+1)
-            reinterpret_cast<quint8*>(buff)[i] = static_cast<quint8>(v);
-        }
-        if (quint16 resid = c%MB_BYTE_SZ_BITES)
-        {
-            qint8 mask = static_cast<qint8>(0x80);
-            mask = ~(mask>>(7-resid));
-            if ((shift+resid) > MB_BYTE_SZ_BITES)
+            for (uint i = 0; i < bytes; i++)
             {
-                quint16 v = ((*reinterpret_cast<const quint16*>(&mem[byteOffset+bytes])) >> shift) & mask;
-                reinterpret_cast<quint8*>(buff)[bytes] = static_cast<quint8>(v);
+                quint16 v = *(reinterpret_cast<const quint16*>(&mem[byteOffset+i])) >> shift; // no need to check (i+1) < bytes because if (shift > 0) then target bits are located in both nearest bytes (i) and (i+1)
+                reinterpret_cast<quint8*>(buff)[i] = static_cast<quint8>(v);
+            }
+            if (quint16 resid = c%MB_BYTE_SZ_BITES)
+            {
+                qint8 mask = static_cast<qint8>(0x80);
+                mask = ~(mask>>(7-resid));
+                if ((shift+resid) > MB_BYTE_SZ_BITES)
+                {
+                    quint16 v = ((*reinterpret_cast<const quint16*>(&mem[byteOffset+bytes])) >> shift) & mask;
+                    reinterpret_cast<quint8*>(buff)[bytes] = static_cast<quint8>(v);
+                }
+                else
+                    reinterpret_cast<quint8*>(buff)[bytes] = (mem[byteOffset+bytes]>>shift) & mask;
             }
-            else
-                reinterpret_cast<quint8*>(buff)[bytes] = (mem[byteOffset+bytes]>>shift) & mask;
         }
-    }
-    else
-    {
-        memcpy(buff, &mem[byteOffset], static_cast<size_t>(bytes));
-        if (quint16 resid = c%MB_BYTE_SZ_BITES)
+        else
         {
-            qint8 mask = static_cast<qint8>(0x80);
-            mask = ~(mask>>(7-resid));
-            reinterpret_cast<quint8*>(buff)[bytes] = mem[byteOffset+bytes] & mask;
+            memcpy(buff, &mem[byteOffset], static_cast<size_t>(bytes));
+            if (quint16 resid = c%MB_BYTE_SZ_BITES)
+            {
+                qint8 mask = static_cast<qint8>(0x80);
+                mask = ~(mask>>(7-resid));
+                reinterpret_cast<quint8*>(buff)[bytes] = mem[byteOffset+bytes] & mask;
+            }
         }
     }
+    while (seqReadRetry(seq));
     if (fact)
         *fact = c;
     return Modbus::Status_Good;
@@ -253,7 +451,17 @@ Modbus::StatusCode mbServerDevice::MemoryBlock::readBits(uint bitOffset, uint bi
 
 Modbus::StatusCode mbServerDevice::MemoryBlock::writeBits(uint bitOffset, uint bitCount, const void *buff, uint *fact)
 {
-    QWriteLocker _(&m_lock);
+    WriteLocker _(this);
+    seqWriteBegin();
+    Modbus::StatusCode r = writeBitsUnlocked(bitOffset, bitCount, buff, fact);
+    seqWriteEnd();
+    if (Modbus::StatusIsGood(r))
+        m_changeCounter++;
+    return r;
+}
+
+Modbus::StatusCode mbServerDevice::MemoryBlock::writeBitsUnlocked(uint bitOffset, uint bitCount, const void *buff, uint *fact)
+{
     uint c;
     if (bitOffset >= m_sizeBits)
         return Modbus::Status_BadIllegalDataAddress;
@@ -267,7 +475,7 @@ Modbus::StatusCode mbServerDevice::MemoryBlock::writeBits(uint bitOffset, uint b
     uint byteOffset = bitOffset/MB_BYTE_SZ_BITES;
     uint bytes = c/MB_BYTE_SZ_BITES;
     uint shift = bitOffset%MB_BYTE_SZ_BITES;
-    quint8 *mem = reinterpret_cast<quint8*>(m_data.data());
+    quint8 *mem = reinterpret_cast<quint8*>(m_ptr);
     if (shift)
     {
         for (uint i = 0; i < bytes; i++)
@@ -313,12 +521,40 @@ Modbus::StatusCode mbServerDevice::MemoryBlock::writeBits(uint bitOffset, uint b
             mem[byteOffset+bytes] |= (reinterpret_cast<const quint8*>(buff)[bytes] & mask);
         }
     }
-    m_changeCounter++;
     if (fact)
         *fact = c;
     return Modbus::Status_Good;
 }
 
+mbServerDevice::MemoryBlock::Batch::Batch(MemoryBlock *block) :
+    m_block(block),
+    m_changed(false)
+{
+    m_block->lockWrite();
+    m_block->seqWriteBegin();
+}
+
+mbServerDevice::MemoryBlock::Batch::~Batch()
+{
+    m_block->seqWriteEnd();
+    if (m_changed)
+        m_block->m_changeCounter++;
+    m_block->unlockWrite();
+}
+
+Modbus::StatusCode mbServerDevice::MemoryBlock::Batch::readBits(uint bitOffset, uint bitCount, void *values) const
+{
+    return m_block->readBitsUnlocked(bitOffset, bitCount, values, nullptr);
+}
+
+Modbus::StatusCode mbServerDevice::MemoryBlock::Batch::writeBits(uint bitOffset, uint bitCount, const void *values)
+{
+    Modbus::StatusCode r = m_block->writeBitsUnlocked(bitOffset, bitCount, values, nullptr);
+    if (Modbus::StatusIsGood(r))
+        m_changed = true;
+    return r;
+}
+
 Modbus::StatusCode mbServerDevice::MemoryBlock::readBools(uint bitOffset, uint bitCount, bool *values, uint *fact) const
 {
     QReadLocker _(&m_lock);
@@ -330,15 +566,21 @@ Modbus::StatusCode mbServerDevice::MemoryBlock::readBools(uint bitOffset, uint b
         c = m_sizeBits - bitOffset;
     else
         c = bitCount;
-    uint byte = bitOffset / MB_BYTE_SZ_BITES;
-    uint bit  = bitOffset % MB_BYTE_SZ_BITES;
-    const quint8 *mem = reinterpret_cast<const quint8*>(m_data.data());
-    for (uint by = byte, i = 0; i < c; by++)
+    quint32 seq;
+    do
     {
-        for (uint bi = bit; bi < MB_BYTE_SZ_BITES && i < c; bi++, i++)
-            values[i] = (mem[by] & (1<<bi)) != 0;
-        bit = 0;
+        seq = seqReadBegin();
+        uint byte = bitOffset / MB_BYTE_SZ_BITES;
+        uint bit  = bitOffset % MB_BYTE_SZ_BITES;
+        const quint8 *mem = reinterpret_cast<const quint8*>(m_ptr);
+        for (uint by = byte, i = 0; i < c; by++)
+        {
+            for (uint bi = bit; bi < MB_BYTE_SZ_BITES && i < c; bi++, i++)
+                values[i] = (mem[by] & (1<<bi)) != 0;
+            bit = 0;
+        }
     }
+    while (seqReadRetry(seq));
     if (fact)
         *fact = c;
     return Modbus::Status_Good;
@@ -346,7 +588,7 @@ Modbus::StatusCode mbServerDevice::MemoryBlock::readBools(uint bitOffset, uint b
 
 Modbus::StatusCode mbServerDevice::MemoryBlock::writeBools(uint bitOffset, uint bitCount, const bool *values, uint *fact)
 {
-    QWriteLocker _(&m_lock);
+    WriteLocker _(this);
     uint c;
     if (bitOffset >= m_sizeBits)
         return Modbus::Status_BadIllegalDataAddress;
@@ -357,7 +599,8 @@ Modbus::StatusCode mbServerDevice::MemoryBlock::writeBools(uint bitOffset, uint
         c = bitCount;
     uint byte = bitOffset / MB_BYTE_SZ_BITES;
     uint bit  = bitOffset % MB_BYTE_SZ_BITES;
-    quint8 *mem = reinterpret_cast<quint8*>(m_data.data());
+    quint8 *mem = reinterpret_cast<quint8*>(m_ptr);
+    seqWriteBegin();
     for (uint by = byte, i = 0; i < c; by++)
     {
         for (uint bi = bit; bi < MB_BYTE_SZ_BITES && i < c; bi++, i++)
@@ -369,6 +612,7 @@ Modbus::StatusCode mbServerDevice::MemoryBlock::writeBools(uint bitOffset, uint
         }
         bit = 0;
     }
+    seqWriteEnd();
     m_changeCounter++;
     if (fact)
         *fact = c;
@@ -481,6 +725,9 @@ mbServerDevice::mbServerDevice(QObject * /*parent*/)
 {
     Defaults d = Defaults::instance();
     m_project = nullptr;
+    m_image = nullptr;
+    m_accessData = nullptr;
+    m_notifier = nullptr;
     setName(d.name);
     this->realloc_0x(d.count0x);
     this->realloc_1x(d.count1x);
@@ -489,8 +736,17 @@ mbServerDevice::mbServerDevice(QObject * /*parent*/)
     setExceptionStatusAddressInt(d.exceptionStatusAddress);
     setReadOnly(d.isReadOnly);
     m_settings.isSaveData = d.isSaveData;
+    m_settings.isMemoryMapped = d.isMemoryMapped;
     m_settings.delay = d.delay;
     m_settings.isEnableScript = d.isEnableScript;
+    m_settings.templateName = d.templateName;
+}
+
+mbServerDevice::~mbServerDevice()
+{
+    closeImage();
+    m_access.storeRelease(nullptr);
+    delete m_accessData;
 }
 
 quint8 mbServerDevice::exceptionStatus() const
@@ -518,10 +774,13 @@ Modbus::Settings mbServerDevice::settings() const
     r.insert(s.count3x                  , count_3x                  ());
     r.insert(s.count4x                  , count_4x                  ());
     r.insert(s.isSaveData               , isSaveData                ());
+    r.insert(s.isMemoryMapped           , isMemoryMapped            ());
     r.insert(s.isReadOnly               , isReadOnly                ());
     r.insert(s.exceptionStatusAddress   , exceptionStatusAddressInt ());
     r.insert(s.delay                    , delay                     ());
     r.insert(s.isEnableScript           , isEnableScript            ());
+    if (templateName().count())
+        r.insert(s.templateName         , templateName              ());
 
     mb::unite(r, scriptSources());
 
@@ -581,6 +840,13 @@ bool mbServerDevice::setSettings(const Modbus::Settings &settings)
         setSaveData(var.toBool());
     }
 
+    it = settings.find(s.isMemoryMapped);
+    if (it != end)
+    {
+        QVariant var = it.value();
+        setMemoryMapped(var.toBool());
+    }
+
     it = settings.find(s.isReadOnly);
     if (it != end)
     {
@@ -613,11 +879,106 @@ bool mbServerDevice::setSettings(const Modbus::Settings &settings)
         setEnableScript(var.toBool());
     }
 
+    it = settings.find(s.templateName);
+    if (it != end)
+    {
+        QVariant var = it.value();
+        setTemplateName(var.toString());
+    }
+
     setScriptSources(settings);
     mbCoreDevice::setSettings(settings);
     return true;
 }
 
+QString mbServerDevice::imageFile() const
+{
+    if (m_image)
+        return m_image->fileName();
+    return QString();
+}
+
+bool mbServerDevice::openImage(const QString &file, QString *errorString, bool restore)
+{
+    // memory that is attached without image belongs to other storage (e.g. template device) and must not be replaced
+    if (!m_image && m_mem_0x.isAttached())
+    {
+        if (errorString)
+            *errorString = QString("Memory of device '%1' is already attached to other storage (e.g. template device)").arg(name());
+        return false;
+    }
+    closeImage();
+    mbServerDeviceImage *image = new mbServerDeviceImage(this);
+    if (!image->open(file, restore))
+    {
+        if (errorString)
+            *errorString = image->errorString();
+        delete image;
+        return false;
+    }
+    m_image = image;
+    return true;
+}
+
+void mbServerDevice::closeImage()
+{
+    if (m_image)
+    {
+        m_image->close();
+        delete m_image;
+        m_image = nullptr;
+    }
+}
+
+bool mbServerDevice::flushImage(bool sync)
+{
+    if (m_image)
+        return m_image->flush(sync);
+    return true;
+}
+
+void mbServerDevice::setAccessCounting(bool enable)
+{
+    if (enable)
+    {
+        if (!m_accessData)
+            m_accessData = new mbServerDeviceAccess();
+        m_access.storeRelease(m_accessData);
+    }
+    else
+    {
+        // keep counters storage alive: port thread can still be incrementing it
+        m_access.storeRelease(nullptr);
+    }
+}
+
+void mbServerDevice::resetAccessCounters()
+{
+    if (m_accessData)
+        m_accessData->reset();
+}
+
+void mbServerDevice::setChangeNotifier(ChangeNotifier *notifier)
+{
+    QWriteLocker _(&m_lock);
+    m_notifier = notifier;
+}
+
+mbServerScriptStatistic mbServerDevice::scriptStatistic() const
+{
+    QReadLocker _(&m_scriptStatLock);
+    return m_scriptStat;
+}
+
+void mbServerDevice::setScriptStatistic(const mbServerScriptStatistic &stat)
+{
+    {
+        QWriteLocker _(&m_scriptStatLock);
+        m_scriptStat = stat;
+    }
+    Q_EMIT scriptStatisticChanged();
+}
+
 QByteArray mbServerDevice::readData(const mb::Address &address, quint16 count)
 {
     QByteArray v;
@@ -681,7 +1042,13 @@ Modbus::StatusCode mbServerDevice::readCoils(uint16_t offset, uint16_t count, vo
         return Modbus::Status_BadIllegalDataAddress;
     if ((offset+count) > this->count_0x())
         return Modbus::Status_BadIllegalDataAddress;
-    return this->read_0x(offset, count, values);
+    Modbus::StatusCode r = this->read_0x(offset, count, values);
+    if (Modbus::StatusIsGood(r))
+    {
+        if (mbServerDeviceAccess *a = m_access.loadAcquire())
+            a->countRead(mbServerDeviceAccess::Memory_0x, offset, count);
+    }
+    return r;
 }
 
 Modbus::StatusCode mbServerDevice::readDiscreteInputs(uint16_t offset, uint16_t count, void *values)
@@ -691,7 +1058,13 @@ Modbus::StatusCode mbServerDevice::readDiscreteInputs(uint16_t offset, uint16_t
         return Modbus::Status_BadIllegalDataAddress;
     if ((offset+count) > this->count_1x())
         return Modbus::Status_BadIllegalDataAddress;
-    return this->read_1x(offset, count, values);
+    Modbus::StatusCode r = this->read_1x(offset, count, values);
+    if (Modbus::StatusIsGood(r))
+    {
+        if (mbServerDeviceAccess *a = m_access.loadAcquire())
+            a->countRead(mbServerDeviceAccess::Memory_1x, offset, count);
+    }
+    return r;
 }
 
 Modbus::StatusCode mbServerDevice::readHoldingRegisters(uint16_t offset, uint16_t count, uint16_t *values)
@@ -701,7 +1074,13 @@ Modbus::StatusCode mbServerDevice::readHoldingRegisters(uint16_t offset, uint16_
         return Modbus::Status_BadIllegalDataAddress;
     if ((offset+count) > this->count_4x())
         return Modbus::Status_BadIllegalDataAddress;
-    return this->read_4x(offset, count, values);
+    Modbus::StatusCode r = this->read_4x(offset, count, values);
+    if (Modbus::StatusIsGood(r))
+    {
+        if (mbServerDeviceAccess *a = m_access.loadAcquire())
+            a->countRead(mbServerDeviceAccess::Memory_4x, offset, count);
+    }
+    return r;
 }
 
 Modbus::StatusCode mbServerDevice::readInputRegisters(uint16_t offset, uint16_t count, uint16_t *values)
@@ -711,7 +1090,13 @@ Modbus::StatusCode mbServerDevice::readInputRegisters(uint16_t offset, uint16_t
         return Modbus::Status_BadIllegalDataAddress;
     if ((offset+count) > this->count_3x())
         return Modbus::Status_BadIllegalDataAddress;
-    return this->read_3x(offset, count, values);
+    Modbus::StatusCode r = this->read_3x(offset, count, values);
+    if (Modbus::StatusIsGood(r))
+    {
+        if (mbServerDeviceAccess *a = m_access.loadAcquire())
+            a->countRead(mbServerDeviceAccess::Memory_3x, offset, count);
+    }
+    return r;
 }
 
 Modbus::StatusCode mbServerDevice::writeSingleCoil(uint16_t offset, bool value)
@@ -722,6 +1107,9 @@ Modbus::StatusCode mbServerDevice::writeSingleCoil(uint16_t offset, bool value)
     if (offset >= this->count_0x())
         return Modbus::Status_BadIllegalDataAddress;
     this->setBool_0x(offset, value);
+    notifyChangeBits(Modbus::Memory_0x, offset, 1);
+    if (mbServerDeviceAccess *a = m_access.loadAcquire())
+        a->countWrite(mbServerDeviceAccess::Memory_0x, offset, 1);
     return Modbus::Status_Good;
 }
 
@@ -733,6 +1121,9 @@ Modbus::StatusCode mbServerDevice::writeSingleRegister(uint16_t offset, uint16_t
     if (offset >= this->count_4x())
         return Modbus::Status_BadIllegalDataAddress;
     this->setUInt16_4x(offset, value);
+    notifyChangeRegs(Modbus::Memory_4x, offset, 1);
+    if (mbServerDeviceAccess *a = m_access.loadAcquire())
+        a->countWrite(mbServerDeviceAccess::Memory_4x, offset, 1);
     return Modbus::Status_Good;
 }
 
@@ -752,7 +1143,14 @@ Modbus::StatusCode mbServerDevice::writeMultipleCoils(uint16_t offset, uint16_t
         return Modbus::Status_BadIllegalDataAddress;
     if ((offset+count) > this->count_0x())
         return Modbus::Status_BadIllegalDataAddress;
-    return this->write_0x(offset, count, values);
+    Modbus::StatusCode r = this->write_0x(offset, count, values);
+    if (Modbus::StatusIsGood(r))
+    {
+        notifyChangeBits(Modbus::Memory_0x, offset, count);
+        if (mbServerDeviceAccess *a = m_access.loadAcquire())
+            a->countWrite(mbServerDeviceAccess::Memory_0x, offset, count);
+    }
+    return r;
 }
 
 Modbus::StatusCode mbServerDevice::writeMultipleRegisters(uint16_t offset, uint16_t count, const uint16_t *values)
@@ -764,7 +1162,14 @@ Modbus::StatusCode mbServerDevice::writeMultipleRegisters(uint16_t offset, uint1
         return Modbus::Status_BadIllegalDataAddress;
     if ((offset+count) > this->count_4x())
         return Modbus::Status_BadIllegalDataAddress;
-    return this->write_4x(offset, count, values);
+    Modbus::StatusCode r = this->write_4x(offset, count, values);
+    if (Modbus::StatusIsGood(r))
+    {
+        notifyChangeRegs(Modbus::Memory_4x, offset, count);
+        if (mbServerDeviceAccess *a = m_access.loadAcquire())
+            a->countWrite(mbServerDeviceAccess::Memory_4x, offset, count);
+    }
+    return r;
 }
 
 Modbus::StatusCode mbServerDevice::reportServerID(uint8_t *count, uint8_t *data)
@@ -789,6 +1194,12 @@ Modbus::StatusCode mbServerDevice::maskWriteRegister(uint16_t offset, uint16_t a
     uint16_t c = this->uint16_4x(offset);
     uint16_t r = (c & andMask) | (orMask & ~andMask);
     this->setUInt16_4x(offset, r);
+    notifyChangeRegs(Modbus::Memory_4x, offset, 1);
+    if (mbServerDeviceAccess *a = m_access.loadAcquire())
+    {
+        a->countRead (mbServerDeviceAccess::Memory_4x, offset, 1);
+        a->countWrite(mbServerDeviceAccess::Memory_4x, offset, 1);
+    }
     return Modbus::Status_Good;
 }
 
@@ -808,14 +1219,26 @@ Modbus::StatusCode mbServerDevice::readWriteMultipleRegisters(uint16_t readOffse
     Modbus::StatusCode s = this->write_4x(writeOffset, writeCount, writeValues);
     if (!Modbus::StatusIsGood(s))
         return s;
-    return this->read_4x(readOffset, readCount, readValues);
+    notifyChangeRegs(Modbus::Memory_4x, writeOffset, writeCount);
+    s = this->read_4x(readOffset, readCount, readValues);
+    if (mbServerDeviceAccess *a = m_access.loadAcquire())
+    {
+        a->countWrite(mbServerDeviceAccess::Memory_4x, writeOffset, writeCount);
+        if (Modbus::StatusIsGood(s))
+            a->countRead(mbServerDeviceAccess::Memory_4x, readOffset, readCount);
+    }
+    return s;
 }
 
 void mbServerDevice::realloc_0x(int count)
 {
     if (count_0x() != count)
     {
+        QString image = imageFile();
+        closeImage();
         m_mem_0x.resizeBits(count);
+        if (image.count())
+            openImage(image);
         Q_EMIT count_0x_changed(count);
     }
 }
@@ -824,7 +1247,11 @@ void mbServerDevice::realloc_1x(int count)
 {
     if (count_1x() != count)
     {
+        QString image = imageFile();
+        closeImage();
         m_mem_1x.resizeBits(count);
+        if (image.count())
+            openImage(image);
         Q_EMIT count_1x_changed(count);
     }
 }
@@ -833,7 +1260,11 @@ void mbServerDevice::realloc_3x(int count)
 {
     if (count_3x() != count)
     {
+        QString image = imageFile();
+        closeImage();
         m_mem_3x.resizeRegs(count);
+        if (image.count())
+            openImage(image);
         Q_EMIT count_3x_changed(count);
     }
 }
@@ -842,7 +1273,11 @@ void mbServerDevice::realloc_4x(int count)
 {
     if (count_4x() != count)
     {
+        QString image = imageFile();
+        closeImage();
         m_mem_4x.resizeRegs(count);
+        if (image.count())
+            openImage(image);
         Q_EMIT count_4x_changed(count);
     }
 }
@@ -23,13 +23,19 @@
 #ifndef SERVER_DEVICE_H
 #define SERVER_DEVICE_H
 
+#include <QAtomicInteger>
+#include <QAtomicPointer>
 #include <QReadWriteLock>
 #include <QSharedMemory>
 
 #include <project/core_device.h>
 #include <server_global.h>
 
+#include "server_scriptstatistic.h"
+
 class mbServerProject;
+class mbServerDeviceImage;
+class mbServerDeviceAccess;
 
 class mbServerDevice :  public mbCoreDevice
 {
@@ -42,10 +48,12 @@ public:
         const QString count3x               ;
         const QString count4x               ;
         const QString isSaveData            ;
+        const QString isMemoryMapped        ;
         const QString isReadOnly            ;
         const QString exceptionStatusAddress;
         const QString delay                 ;
         const QString isEnableScript        ;
+        const QString templateName          ;
         const QString scriptInit            ;
         const QString scriptLoop            ;
         const QString scriptFinal           ;
@@ -65,25 +73,35 @@ public:
         const int  count3x               ;
         const int  count4x               ;
         const bool isSaveData            ;
+        const bool isMemoryMapped        ;
         const bool isReadOnly            ;
         const int  exceptionStatusAddress;
         const uint delay                 ;
         const bool isEnableScript        ;
+        const QString templateName       ;
 
         Defaults();
         static const Defaults &instance();
     };
 
+    // Receives memory changes made by 'Modbus'-like interface (called with device locked)
+    class ChangeNotifier
+    {
+    public:
+        virtual ~ChangeNotifier() {}
+        virtual void memoryChanged(Modbus::MemoryType memType, uint byteOffset, uint byteCount) = 0;
+    };
+
     class MemoryBlock
     {
     public:
         MemoryBlock();
 
     public:
-        inline int size() const { QReadLocker _(&m_lock); return m_data.size(); }
+        inline int size() const { QReadLocker _(&m_lock); return m_size; }
         inline int sizeBits() const { QReadLocker _(&m_lock); return m_sizeBits; }
         inline int sizeBytes() const { return size(); }
-        inline int sizeRegs() const { QReadLocker _(&m_lock); return m_data.size() / MB_REGE_SZ_BYTES; }
+        inline int sizeRegs() const { QReadLocker _(&m_lock); return m_size / MB_REGE_SZ_BYTES; }
         void resize(int bytes);
         void resizeBits(int bits);
         inline void resizeBytes(int bytes) { resize(bytes); }
@@ -91,8 +109,19 @@ public:
         void memGet(uint byteOffset, void *buff, size_t size);
         void memSetMask(uint byteOffset, const void *buff, const void *mask, size_t size);
 
+    public: // external storage (e.g. memory-mapped file), must be at least 'sizeBytes()' long
+        inline bool isAttached() const { QReadLocker _(&m_lock); return m_attached; }
+        void attachMemory(void *mem, bool copyData);
+        void detachMemory();
+
+    public: // cross-process sequence lock, used when attached storage is shared with other process:
+            // 'ownSequence' is odd while this block writes memory, 'peerSequence' is odd while other process does,
+            // 'writeLock' is shared word which holds process id of writer of any side (0 - free)
+        void setSequenceLock(quint32 *ownSequence, const quint32 *peerSequence, quint32 *writeLock);
+
     public:
         inline uint changeCounter() const { QReadLocker _(&m_lock); return m_changeCounter; }
+        void notifyChanged();
         void zerroAll();
         Modbus::StatusCode read(uint offset, uint count, void *values, uint *fact = nullptr) const;
         Modbus::StatusCode write(uint offset, uint count, const void *values, uint *fact = nullptr);
@@ -107,9 +136,55 @@ public:
         Modbus::StatusCode readFrameRegs(uint regOffset, int columns, QByteArray &values, int maxColumns) const;
         Modbus::StatusCode writeFrameRegs(uint regOffset, int columns, const QByteArray &values, int maxColumns);
 
+    public:
+        // Holds write lock of the block during its lifetime, so group of writes (e.g. due simulation actions)
+        // costs single lock, single sequence lock round and single change counter increment
+        class Batch
+        {
+        public:
+            explicit Batch(MemoryBlock *block);
+            ~Batch();
+
+        public:
+            Modbus::StatusCode readBits(uint bitOffset, uint bitCount, void *values) const;
+            Modbus::StatusCode writeBits(uint bitOffset, uint bitCount, const void *values);
+
+        private:
+            MemoryBlock *m_block;
+            bool m_changed;
+        };
+
+    private:
+        Modbus::StatusCode readBitsUnlocked(uint bitOffset, uint bitCount, void *values, uint *fact) const;
+        Modbus::StatusCode writeBitsUnlocked(uint bitOffset, uint bitCount, const void *values, uint *fact);
+        quint32 seqReadBegin() const;
+        bool seqReadRetry(quint32 seq) const;
+        void lockWrite();
+        void unlockWrite();
+        void seqWriteBegin();
+        void seqWriteEnd();
+
+    private:
+        // Holds local and cross-process write locks of the block during its lifetime
+        class WriteLocker
+        {
+        public:
+            explicit WriteLocker(MemoryBlock *block) : m_block(block) { m_block->lockWrite(); }
+            ~WriteLocker() { m_block->unlockWrite(); }
+
+        private:
+            MemoryBlock *m_block;
+        };
+
     private:
         mutable QReadWriteLock m_lock;
+        QAtomicInteger<quint32> *m_seqOwn;
+        const QAtomicInteger<quint32> *m_seqPeer;
+        QAtomicInteger<quint32> *m_writeLock;
         QByteArray m_data;
+        char *m_ptr;
+        int m_size;
+        bool m_attached;
         uint m_sizeBits;
         uint m_changeCounter;
     };
@@ -123,6 +198,7 @@ public:
 
 public:
     explicit mbServerDevice(QObject *parent = nullptr);
+    ~mbServerDevice();
 
 public:
     inline mbServerProject* project() const { return reinterpret_cast<mbServerProject*>(mbCoreDevice::projectCore()); }
@@ -144,14 +220,39 @@ public: // settings
     inline void setReadOnly(bool v) { m_settings.isReadOnly = v; }
     inline bool isSaveData() const { return m_settings.isSaveData; }
     inline void setSaveData(bool save) { m_settings.isSaveData = save; }
+    inline bool isMemoryMapped() const { return m_settings.isMemoryMapped; }
+    inline void setMemoryMapped(bool v) { m_settings.isMemoryMapped = v; }
     inline uint delay() const { return m_settings.delay; }
     inline void setDelay(uint delay) { m_settings.delay = delay; }
     inline bool isEnableScript() const { return m_settings.isEnableScript; }
     inline void setEnableScript(bool v) { m_settings.isEnableScript = v; }
+    inline QString templateName() const { return m_settings.templateName; }
+    inline void setTemplateName(const QString &name) { m_settings.templateName = name; }
 
     Modbus::Settings settings() const;
     bool setSettings(const Modbus::Settings& settings);
 
+public: // memory-mapped data image
+    inline bool hasImage() const { return m_image != nullptr; }
+    inline mbServerDeviceImage *image() const { return m_image; }
+    QString imageFile() const;
+    bool openImage(const QString &file, QString *errorString = nullptr, bool restore = true);
+    void closeImage();
+    bool flushImage(bool sync = false);
+
+public: // access counters (disabled by default, updated by 'Modbus'-like interface only)
+    inline bool isAccessCounting() const { return m_access.loadAcquire() != nullptr; }
+    void setAccessCounting(bool enable);
+    inline mbServerDeviceAccess *accessCounters() const { return m_accessData; }
+    void resetAccessCounters();
+
+public: // change notification (e.g. for Python script), notifier is not owned by device
+    void setChangeNotifier(ChangeNotifier *notifier);
+
+public: // script runtime statistic (published by script thread)
+    mbServerScriptStatistic scriptStatistic() const;
+    void setScriptStatistic(const mbServerScriptStatistic &stat);
+
 public:
     QByteArray readData(const mb::Address &address, quint16 count);
     void writeData(const mb::Address &address, quint16 count, const QByteArray &data);
@@ -379,6 +480,7 @@ Q_SIGNALS:
     void count_1x_changed(int count);
     void count_3x_changed(int count);
     void count_4x_changed(int count);
+    void scriptStatisticChanged();
 
 private: // Memory
     mutable QReadWriteLock m_lock;
@@ -386,15 +488,37 @@ private: // Memory
     MemoryBlock m_mem_1x;
     MemoryBlock m_mem_3x;
     MemoryBlock m_mem_4x;
+    mbServerDeviceImage *m_image;
+    QAtomicPointer<mbServerDeviceAccess> m_access; // null when counting is disabled
+    mbServerDeviceAccess *m_accessData;
+    ChangeNotifier *m_notifier;
+
+private: // script runtime statistic
+    mutable QReadWriteLock m_scriptStatLock;
+    mbServerScriptStatistic m_scriptStat;
+
+private:
+    inline void notifyChangeBits(Modbus::MemoryType memType, uint offset, uint count)
+    {
+        if (m_notifier)
+            m_notifier->memoryChanged(memType, offset/MB_BYTE_SZ_BITES, (offset+count+MB_BYTE_SZ_BITES-1)/MB_BYTE_SZ_BITES - offset/MB_BYTE_SZ_BITES);
+    }
+    inline void notifyChangeRegs(Modbus::MemoryType memType, uint offset, uint count)
+    {
+        if (m_notifier)
+            m_notifier->memoryChanged(memType, offset*MB_REGE_SZ_BYTES, count*MB_REGE_SZ_BYTES);
+    }
 
 private: // settings
     struct
     {
         bool        isSaveData            ;
+        bool        isMemoryMapped        ;
         bool        isReadOnly            ;
         mb::Address exceptionStatusAddress;
         uint        delay                 ;
         bool        isEnableScript        ;
+        QString     templateName          ;
     } m_settings;
 
     struct
@@ -0,0 +1,88 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "server_deviceaccess.h"
+
+mbServerDeviceAccess::mbServerDeviceAccess()
+{
+    reset();
+}
+
+int mbServerDeviceAccess::memoryIndex(Modbus::MemoryType memoryType)
+{
+    switch (memoryType)
+    {
+    case Modbus::Memory_0x: return Memory_0x;
+    case Modbus::Memory_1x: return Memory_1x;
+    case Modbus::Memory_3x: return Memory_3x;
+    default:
+        return Memory_4x;
+    }
+}
+
+Modbus::MemoryType mbServerDeviceAccess::memoryType(int memoryIndex)
+{
+    switch (memoryIndex)
+    {
+    case Memory_0x: return Modbus::Memory_0x;
+    case Memory_1x: return Modbus::Memory_1x;
+    case Memory_3x: return Modbus::Memory_3x;
+    default:
+        return Modbus::Memory_4x;
+    }
+}
+
+mbServerDeviceAccess::Counters mbServerDeviceAccess::counters(int mem, int page) const
+{
+    Counters c;
+    c.reads  = reads (mem, page);
+    c.writes = writes(mem, page);
+    return c;
+}
+
+quint32 mbServerDeviceAccess::maxReads(int mem) const
+{
+    quint32 r = 0;
+    for (int p = 0; p < PageCount; p++)
+        r = qMax(r, reads(mem, p));
+    return r;
+}
+
+quint32 mbServerDeviceAccess::maxWrites(int mem) const
+{
+    quint32 r = 0;
+    for (int p = 0; p < PageCount; p++)
+        r = qMax(r, writes(mem, p));
+    return r;
+}
+
+void mbServerDeviceAccess::reset()
+{
+    for (int m = 0; m < MemoryCount; m++)
+    {
+        for (int p = 0; p < PageCount; p++)
+        {
+            m_reads [m][p].storeRelease(0);
+            m_writes[m][p].storeRelease(0);
+        }
+    }
+}
@@ -0,0 +1,95 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef SERVER_DEVICEACCESS_H
+#define SERVER_DEVICEACCESS_H
+
+#include <QAtomicInteger>
+
+#include <mbcore.h>
+
+/*
+   Per-page read/write access counters of server device memory.
+   Counters are updated from port threads without locks (atomic
+   increments), so values read by GUI are a consistent-enough snapshot.
+   One request increments every page it touches exactly once.
+*/
+class mbServerDeviceAccess
+{
+public:
+    enum
+    {
+        PageBits  = 6,
+        PageSize  = 1 << PageBits, // addresses per page
+        PageCount = MB_MEMORY_MAX_COUNT / PageSize,
+        MemoryCount = 4
+    };
+
+    enum Memory
+    {
+        Memory_0x,
+        Memory_1x,
+        Memory_3x,
+        Memory_4x
+    };
+
+    struct Counters
+    {
+        quint32 reads;
+        quint32 writes;
+    };
+
+public:
+    mbServerDeviceAccess();
+
+public:
+    static int memoryIndex(Modbus::MemoryType memoryType);
+    static Modbus::MemoryType memoryType(int memoryIndex);
+
+public:
+    inline void countRead(int mem, uint offset, uint count) { count_(m_reads[mem], offset, count); }
+    inline void countWrite(int mem, uint offset, uint count) { count_(m_writes[mem], offset, count); }
+    inline quint32 reads(int mem, int page) const { return m_reads[mem][page].loadAcquire(); }
+    inline quint32 writes(int mem, int page) const { return m_writes[mem][page].loadAcquire(); }
+    Counters counters(int mem, int page) const;
+    quint32 maxReads(int mem) const;
+    quint32 maxWrites(int mem) const;
+    void reset();
+
+private:
+    inline static void count_(QAtomicInteger<quint32> *c, uint offset, uint count)
+    {
+        if (count == 0)
+            return;
+        uint last = (offset + count - 1) >> PageBits;
+        if (last >= static_cast<uint>(PageCount))
+            last = PageCount - 1;
+        for (uint p = offset >> PageBits; p <= last; p++)
+            c[p].fetchAndAddRelaxed(1);
+    }
+
+private:
+    QAtomicInteger<quint32> m_reads [MemoryCount][PageCount];
+    QAtomicInteger<quint32> m_writes[MemoryCount][PageCount];
+};
+
+#endif // SERVER_DEVICEACCESS_H
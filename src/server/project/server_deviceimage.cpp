@@ -0,0 +1,207 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "server_deviceimage.h"
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#include <io.h>
+#else
+#include <sys/mman.h>
+#endif
+
+#include "server_device.h"
+
+#define MB_DEVICE_IMAGE_MAGIC   0x4D44424D // 'MBDM'
+#define MB_DEVICE_IMAGE_VERSION 1
+#define MB_DEVICE_IMAGE_ALIGN   8
+#define MB_DEVICE_IMAGE_BLOCKS  4
+
+mbServerDeviceImage::Defaults::Defaults() :
+    flushPeriod(1000)
+{
+}
+
+const mbServerDeviceImage::Defaults &mbServerDeviceImage::Defaults::instance()
+{
+    static const Defaults d;
+    return d;
+}
+
+mbServerDeviceImage::mbServerDeviceImage(mbServerDevice *device, QObject *parent) :
+    QObject(parent)
+{
+    Q_STATIC_ASSERT(sizeof(Header) == 64);
+    m_device = device;
+    m_mem = nullptr;
+    m_size = 0;
+    m_restored = false;
+    m_cleanRestored = false;
+    m_changeCounter = 0;
+    m_timer.setInterval(Defaults::instance().flushPeriod);
+    connect(&m_timer, &QTimer::timeout, this, &mbServerDeviceImage::slotFlush);
+}
+
+mbServerDeviceImage::~mbServerDeviceImage()
+{
+    close();
+}
+
+bool mbServerDeviceImage::open(const QString &fileName, bool restore)
+{
+    close();
+    m_errorString.clear();
+
+    mbServerDevice::MemoryBlock *blocks[MB_DEVICE_IMAGE_BLOCKS] = { &m_device->memBlockRef_0x(),
+                                                                    &m_device->memBlockRef_1x(),
+                                                                    &m_device->memBlockRef_3x(),
+                                                                    &m_device->memBlockRef_4x() };
+    Header h;
+    memset(&h, 0, sizeof(h));
+    h.magic   = MB_DEVICE_IMAGE_MAGIC;
+    h.version = MB_DEVICE_IMAGE_VERSION;
+    h.state   = State_Dirty;
+    qint64 size = sizeof(Header);
+    for (int i = 0; i < MB_DEVICE_IMAGE_BLOCKS; i++)
+    {
+        h.sizeBits[i] = static_cast<quint32>(blocks[i]->sizeBits());
+        h.offset[i] = static_cast<quint32>(size);
+        size += ((blocks[i]->sizeBytes() + MB_DEVICE_IMAGE_ALIGN - 1) / MB_DEVICE_IMAGE_ALIGN + 1) * MB_DEVICE_IMAGE_ALIGN;
+    }
+
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::ReadWrite))
+    {
+        setError(m_file.errorString());
+        return false;
+    }
+
+    // Existing image is used only if it matches current memory configuration of the device
+    Header fh;
+    m_restored = restore &&
+                 (m_file.size() == size) &&
+                 (m_file.read(reinterpret_cast<char*>(&fh), sizeof(fh)) == static_cast<qint64>(sizeof(fh))) &&
+                 (fh.magic == h.magic) &&
+                 (fh.version == h.version) &&
+                 !memcmp(fh.sizeBits, h.sizeBits, sizeof(h.sizeBits)) &&
+                 !memcmp(fh.offset, h.offset, sizeof(h.offset));
+    if (m_restored)
+    {
+        m_cleanRestored = (fh.state == State_Clean);
+        h.flushCounter = fh.flushCounter;
+    }
+    else
+    {
+        m_cleanRestored = false;
+        if (!m_file.resize(0) || !m_file.resize(size))
+        {
+            setError(m_file.errorString());
+            m_file.close();
+            return false;
+        }
+    }
+
+    m_mem = m_file.map(0, size);
+    if (!m_mem)
+    {
+        setError(m_file.errorString());
+        m_file.close();
+        return false;
+    }
+    m_size = size;
+    for (int i = 0; i < MB_DEVICE_IMAGE_BLOCKS; i++)
+        blocks[i]->attachMemory(m_mem + h.offset[i], !m_restored);
+    // Header is written after data, so partially created image is never considered valid
+    syncMemory(m_mem, m_size, true);
+    memcpy(m_mem, &h, sizeof(h));
+    syncMemory(m_mem, sizeof(Header), true);
+    m_changeCounter = changeCounter();
+    m_timer.start();
+    return true;
+}
+
+void mbServerDeviceImage::close()
+{
+    m_timer.stop();
+    if (m_mem)
+    {
+        // return device to its own memory before image is marked as clean
+        m_device->memBlockRef_0x().detachMemory();
+        m_device->memBlockRef_1x().detachMemory();
+        m_device->memBlockRef_3x().detachMemory();
+        m_device->memBlockRef_4x().detachMemory();
+        flush(true);
+        reinterpret_cast<Header*>(m_mem)->state = State_Clean;
+        syncMemory(m_mem, sizeof(Header), true);
+        m_file.unmap(m_mem);
+        m_mem = nullptr;
+        m_size = 0;
+    }
+    if (m_file.isOpen())
+        m_file.close();
+}
+
+bool mbServerDeviceImage::flush(bool sync)
+{
+    if (!m_mem)
+        return false;
+    uint c = changeCounter();
+    if ((c == m_changeCounter) && !sync)
+        return true;
+    m_changeCounter = c;
+    // Data is synchronized before flush counter, so counter never refers to partially written data
+    if (!syncMemory(m_mem, m_size, sync))
+        return false;
+    reinterpret_cast<Header*>(m_mem)->flushCounter++;
+    return syncMemory(m_mem, sizeof(Header), sync);
+}
+
+void mbServerDeviceImage::slotFlush()
+{
+    flush(false);
+}
+
+void mbServerDeviceImage::setError(const QString &text)
+{
+    m_errorString = QString("Device '%1' image '%2': %3").arg(m_device->name(), m_file.fileName(), text);
+}
+
+uint mbServerDeviceImage::changeCounter() const
+{
+    return m_device->changeCounter_0x() +
+           m_device->changeCounter_1x() +
+           m_device->changeCounter_3x() +
+           m_device->changeCounter_4x();
+}
+
+bool mbServerDeviceImage::syncMemory(void *mem, qint64 size, bool sync)
+{
+#if defined(Q_OS_WIN)
+    if (!FlushViewOfFile(mem, static_cast<SIZE_T>(size)))
+        return false;
+    if (sync)
+        return FlushFileBuffers(reinterpret_cast<HANDLE>(_get_osfhandle(m_file.handle()))) != 0;
+    return true;
+#else
+    return msync(mem, static_cast<size_t>(size), sync ? MS_SYNC : MS_ASYNC) == 0;
+#endif
+}
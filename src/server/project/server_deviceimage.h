@@ -0,0 +1,117 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef SERVER_DEVICEIMAGE_H
+#define SERVER_DEVICEIMAGE_H
+
+#include <QObject>
+#include <QFile>
+#include <QTimer>
+
+class mbServerDevice;
+
+/*
+   Binary memory-mapped image of device memory (0x, 1x, 3x, 4x).
+   While image is open all four memory blocks of the device work
+   directly with mapped file memory, so data is persisted continuously
+   and loaded without parsing. File layout:
+
+   [Header (64 bytes)][0x data][1x data][3x data][4x data]
+
+   Every data block is aligned to 8 bytes and padded with at least
+   8 zero bytes because bit-access functions can read one word beyond
+   the last byte of the block.
+*/
+class mbServerDeviceImage : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Defaults
+    {
+        const int flushPeriod; // msec
+
+        Defaults();
+        static const Defaults &instance();
+    };
+
+public:
+    explicit mbServerDeviceImage(mbServerDevice *device, QObject *parent = nullptr);
+    ~mbServerDeviceImage();
+
+public:
+    inline mbServerDevice *device() const { return m_device; }
+    inline QString fileName() const { return m_file.fileName(); }
+    inline bool isOpen() const { return m_mem != nullptr; }
+    inline QString errorString() const { return m_errorString; }
+    // true if device data was restored from existing image, false if image was created from current device data
+    inline bool isRestored() const { return m_restored; }
+    // false if restored image was not closed properly (e.g. application was crashed)
+    inline bool isCleanRestored() const { return m_cleanRestored; }
+    inline int flushPeriod() const { return m_timer.interval(); }
+    inline void setFlushPeriod(int msec) { m_timer.setInterval(msec); }
+
+public:
+    // 'restore' - use data of existing matching image, otherwise image is always written from current device memory
+    bool open(const QString &fileName, bool restore = true);
+    void close();
+    bool flush(bool sync = false);
+
+private Q_SLOTS:
+    void slotFlush();
+
+private:
+    enum State
+    {
+        State_Clean = 0,
+        State_Dirty = 1
+    };
+
+    struct Header
+    {
+        quint32 magic;
+        quint16 version;
+        quint16 state;
+        quint32 sizeBits[4];
+        quint32 offset[4];
+        quint64 flushCounter;
+        quint8  reserved[16];
+    };
+
+private:
+    void setError(const QString &text);
+    uint changeCounter() const;
+    bool syncMemory(void *mem, qint64 size, bool sync);
+
+private:
+    mbServerDevice *m_device;
+    QFile m_file;
+    uchar *m_mem;
+    qint64 m_size;
+    QString m_errorString;
+    bool m_restored;
+    bool m_cleanRestored;
+    uint m_changeCounter;
+    QTimer m_timer;
+};
+
+#endif // SERVER_DEVICEIMAGE_H
@@ -0,0 +1,162 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "server_devicetemplate.h"
+
+#include "server_device.h"
+
+#define MB_DEVICE_TEMPLATE_BLOCKS 4
+#define MB_DEVICE_TEMPLATE_PAGE   4096
+// bit-access functions can read one word beyond the last byte of the block
+#define MB_DEVICE_TEMPLATE_PAD    8
+
+static inline void getMemoryBlocks(mbServerDevice *device, mbServerDevice::MemoryBlock **blocks)
+{
+    blocks[0] = &device->memBlockRef_0x();
+    blocks[1] = &device->memBlockRef_1x();
+    blocks[2] = &device->memBlockRef_3x();
+    blocks[3] = &device->memBlockRef_4x();
+}
+
+mbServerDeviceTemplate::mbServerDeviceTemplate(mbServerDevice *device, QObject *parent) :
+    QObject(parent)
+{
+    m_device = device;
+    memset(m_offset, 0, sizeof(m_offset));
+    m_size = 0;
+    connect(m_device, &mbServerDevice::nameChanged, this, &mbServerDeviceTemplate::slotNameChanged);
+}
+
+mbServerDeviceTemplate::~mbServerDeviceTemplate()
+{
+    detachAll();
+}
+
+bool mbServerDeviceTemplate::isCompatible(mbServerDevice *instance) const
+{
+    return (instance != m_device) &&
+           (instance->count_0x() == m_device->count_0x()) &&
+           (instance->count_1x() == m_device->count_1x()) &&
+           (instance->count_3x() == m_device->count_3x()) &&
+           (instance->count_4x() == m_device->count_4x());
+}
+
+bool mbServerDeviceTemplate::attach(mbServerDevice *instance)
+{
+    if (m_instances.contains(instance))
+        return true;
+    if (!isCompatible(instance))
+    {
+        setError(QString("Memory configuration of device '%1' differs from template").arg(instance->name()));
+        return false;
+    }
+    if (!snapshot())
+        return false;
+    uchar *mem = m_file.map(0, m_size, QFileDevice::MapPrivateOption);
+    if (!mem)
+    {
+        setError(m_file.errorString());
+        return false;
+    }
+    mbServerDevice::MemoryBlock *blocks[MB_DEVICE_TEMPLATE_BLOCKS];
+    getMemoryBlocks(instance, blocks);
+    for (int i = 0; i < MB_DEVICE_TEMPLATE_BLOCKS; i++)
+        blocks[i]->attachMemory(mem + m_offset[i], false);
+    m_instances.insert(instance, mem);
+    instance->setTemplateName(m_device->name());
+    connect(instance, &QObject::destroyed, this, &mbServerDeviceTemplate::slotInstanceDestroyed);
+    return true;
+}
+
+void mbServerDeviceTemplate::detach(mbServerDevice *instance)
+{
+    Instances_t::iterator it = m_instances.find(instance);
+    if (it == m_instances.end())
+        return;
+    // instance gets its own copy of memory (all pages are materialized)
+    mbServerDevice::MemoryBlock *blocks[MB_DEVICE_TEMPLATE_BLOCKS];
+    getMemoryBlocks(instance, blocks);
+    for (int i = 0; i < MB_DEVICE_TEMPLATE_BLOCKS; i++)
+        blocks[i]->detachMemory();
+    m_file.unmap(it.value());
+    m_instances.erase(it);
+    disconnect(instance, &QObject::destroyed, this, &mbServerDeviceTemplate::slotInstanceDestroyed);
+}
+
+void mbServerDeviceTemplate::detachAll()
+{
+    Q_FOREACH (mbServerDevice *instance, instances())
+        detach(instance);
+}
+
+void mbServerDeviceTemplate::slotNameChanged(const QString &name)
+{
+    for (Instances_t::const_iterator it = m_instances.constBegin(); it != m_instances.constEnd(); ++it)
+        it.key()->setTemplateName(name);
+}
+
+void mbServerDeviceTemplate::slotInstanceDestroyed(QObject *obj)
+{
+    // instance device is already destroyed, so only its memory mapping is released
+    Instances_t::iterator it = m_instances.find(reinterpret_cast<mbServerDevice*>(obj));
+    if (it != m_instances.end())
+    {
+        m_file.unmap(it.value());
+        m_instances.erase(it);
+    }
+}
+
+bool mbServerDeviceTemplate::snapshot()
+{
+    if (m_size)
+        return true;
+    mbServerDevice::MemoryBlock *blocks[MB_DEVICE_TEMPLATE_BLOCKS];
+    getMemoryBlocks(m_device, blocks);
+    // every block begins from the page boundary, so write to one memory type never copies page of another
+    qint64 size = 0;
+    for (int i = 0; i < MB_DEVICE_TEMPLATE_BLOCKS; i++)
+    {
+        m_offset[i] = size;
+        size += ((blocks[i]->sizeBytes() + MB_DEVICE_TEMPLATE_PAD + MB_DEVICE_TEMPLATE_PAGE - 1) / MB_DEVICE_TEMPLATE_PAGE) * MB_DEVICE_TEMPLATE_PAGE;
+    }
+    if (!m_file.open() || !m_file.resize(size))
+    {
+        setError(m_file.errorString());
+        return false;
+    }
+    uchar *mem = m_file.map(0, size);
+    if (!mem)
+    {
+        setError(m_file.errorString());
+        return false;
+    }
+    for (int i = 0; i < MB_DEVICE_TEMPLATE_BLOCKS; i++)
+        blocks[i]->memGet(0, mem + m_offset[i], static_cast<size_t>(blocks[i]->sizeBytes()));
+    m_file.unmap(mem);
+    m_size = size;
+    return true;
+}
+
+void mbServerDeviceTemplate::setError(const QString &text)
+{
+    m_errorString = QString("Device template '%1': %2").arg(m_device->name(), text);
+}
@@ -0,0 +1,82 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef SERVER_DEVICETEMPLATE_H
+#define SERVER_DEVICETEMPLATE_H
+
+#include <QObject>
+#include <QHash>
+#include <QTemporaryFile>
+
+class mbServerDevice;
+
+/*
+   Device template shares memory of template device with many device instances.
+   When first instance is attached template makes read-only snapshot of its
+   device memory into temporary file and every instance maps this file privately
+   (copy-on-write), so instance memory pages are materialized by OS only when
+   they are actually written. Memory usage is proportional to modified data
+   and not to the count of instances.
+
+   Note: snapshot is made once, so changes of template device memory made after
+   first instance was attached are not visible for instances.
+*/
+class mbServerDeviceTemplate : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit mbServerDeviceTemplate(mbServerDevice *device, QObject *parent = nullptr);
+    ~mbServerDeviceTemplate();
+
+public:
+    inline mbServerDevice *device() const { return m_device; }
+    inline QString errorString() const { return m_errorString; }
+    inline QList<mbServerDevice*> instances() const { return m_instances.keys(); }
+    inline int instanceCount() const { return m_instances.count(); }
+    inline bool hasInstance(mbServerDevice *instance) const { return m_instances.contains(instance); }
+    bool isCompatible(mbServerDevice *instance) const;
+
+public:
+    bool attach(mbServerDevice *instance);
+    void detach(mbServerDevice *instance);
+    void detachAll();
+
+private Q_SLOTS:
+    void slotNameChanged(const QString &name);
+    void slotInstanceDestroyed(QObject *obj);
+
+private:
+    bool snapshot();
+    void setError(const QString &text);
+
+private:
+    mbServerDevice *m_device;
+    QTemporaryFile m_file;
+    qint64 m_offset[4];
+    qint64 m_size;
+    QString m_errorString;
+    typedef QHash<mbServerDevice*, uchar*> Instances_t;
+    Instances_t m_instances;
+};
+
+#endif // SERVER_DEVICETEMPLATE_H
@@ -54,6 +54,21 @@ QString mbServerPort::extendedName() const
     return name();
 }
 
+mbServerPortStatistic mbServerPort::runStatistic() const
+{
+    QReadLocker _(&m_runStatLock);
+    return m_runStat;
+}
+
+void mbServerPort::setRunStatistic(const mbServerPortStatistic &stat)
+{
+    {
+        QWriteLocker _(&m_runStatLock);
+        m_runStat = stat;
+    }
+    Q_EMIT runStatisticChanged();
+}
+
 int mbServerPort::freeDeviceUnit() const
 {
     for (int i = 1; i < 255; i++)
@@ -24,11 +24,14 @@
 #define SERVER_PORT_H
 
 #include <QSet>
+#include <QReadWriteLock>
 
 #include <ModbusQt.h>
 
 #include <project/core_port.h>
 
+#include "server_portstatistic.h"
+
 class mbServerProject;
 class mbServerDevice;
 class mbServerDeviceRef;
@@ -69,10 +72,15 @@ public: // devices
 public:
     inline mbServerDevice *device(uint8_t unit) const;
 
+public: // runtime statistic (published by port thread)
+    mbServerPortStatistic runStatistic() const;
+    void setRunStatistic(const mbServerPortStatistic &stat);
+
 Q_SIGNALS:
     void deviceAdded(mbServerDeviceRef*);
     void deviceRemoving(mbServerDeviceRef*);
     void deviceRemoved(mbServerDeviceRef*);
+    void runStatisticChanged();
 
 private:
     void deviceRemoveUnits(mbServerDeviceRef *device);
@@ -83,6 +91,10 @@ private: // devices
     typedef QList<mbServerDeviceRef*> Devices_t;
     typedef QHash<QString, mbServerDeviceRef*> HashDevices_t;
     Devices_t m_devices;
+
+private: // runtime statistic
+    mutable QReadWriteLock m_runStatLock;
+    mbServerPortStatistic m_runStat;
 };
 
 #endif // SERVER_PORT_H
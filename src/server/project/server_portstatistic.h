@@ -0,0 +1,82 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef SERVER_PORTSTATISTIC_H
+#define SERVER_PORTSTATISTIC_H
+
+#include <QMap>
+#include <QList>
+#include <QDateTime>
+
+/*
+   Snapshot of server port runtime statistic. It is collected by the port
+   thread (see 'mbServerRunStatistic') and published at a fixed interval.
+*/
+struct mbServerPortStatistic
+{
+    enum
+    {
+        FunctionCount  = 128,
+        ExceptionCount = 16   // exception codes >= 'ExceptionCount' are counted in 0-item
+    };
+
+    struct Counters
+    {
+        Counters() { memset(this, 0, sizeof(*this)); }
+
+        inline quint64 timeAvg() const { return timeCount ? timeSum / timeCount : 0; }
+        quint64 exceptionCount() const
+        {
+            quint64 c = 0;
+            for (int i = 0; i < ExceptionCount; i++)
+                c += exceptions[i];
+            return c;
+        }
+
+        quint64 requests  ;
+        quint64 responses ;
+        quint64 bytesIn   ;
+        quint64 bytesOut  ;
+        quint64 timeCount ; // count of measured request-response pairs
+        quint64 timeSum   ; // microseconds
+        quint64 timeMin   ; // microseconds
+        quint64 timeMax   ; // microseconds
+        quint64 functions [FunctionCount ]; // requests by function code
+        quint64 exceptions[ExceptionCount]; // exception responses by exception code
+    };
+
+    struct Connection
+    {
+        Connection() : isOpen(false) {}
+
+        QString name;
+        bool isOpen;
+        Counters total;
+        QMap<quint8, Counters> units;
+    };
+
+    Counters total;
+    QList<Connection> connections;
+    QDateTime timestamp;
+};
+
+#endif // SERVER_PORTSTATISTIC_H
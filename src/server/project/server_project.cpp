@@ -22,6 +22,10 @@
 */
 #include "server_project.h"
 
+#include "server_port.h"
+#include "server_device.h"
+#include "server_deviceref.h"
+#include "server_devicetemplate.h"
 #include "server_simaction.h"
 #include "server_scriptmodule.h"
 
@@ -33,6 +37,115 @@ mbServerProject::mbServerProject(QObject *parent) :
 mbServerProject::~mbServerProject()
 {
     qDeleteAll(m_simActions);
+    // template instances are deleted before templates themselves,
+    // so instance memory is never copied back (materialized) while closing project
+    Q_FOREACH (mbServerDeviceTemplate *t, m_deviceTemplates)
+    {
+        Q_FOREACH (mbServerDevice *instance, t->instances())
+        {
+            m_devices.removeOne(instance);
+            delete instance;
+        }
+    }
+}
+
+mbServerDeviceTemplate *mbServerProject::deviceTemplate(mbServerDevice *device, bool create)
+{
+    DeviceTemplates_t::const_iterator it = m_deviceTemplates.find(device);
+    if (it != m_deviceTemplates.end())
+        return it.value();
+    if (!create)
+        return nullptr;
+    // template is owned by its device and deleted together with it
+    mbServerDeviceTemplate *t = new mbServerDeviceTemplate(device, device);
+    m_deviceTemplates.insert(device, t);
+    connect(t, &QObject::destroyed, this, &mbServerProject::slotDeviceTemplateDestroyed);
+    return t;
+}
+
+bool mbServerProject::deviceTemplateAttach(mbServerDevice *instance)
+{
+    if (instance->templateName().isEmpty())
+        return false;
+    mbServerDevice *templateDevice = device(instance->templateName());
+    if (!templateDevice || (templateDevice == instance))
+        return false;
+    return deviceTemplate(templateDevice)->attach(instance);
+}
+
+QList<mbServerDevice *> mbServerProject::deviceInstantiate(mbServerDevice *templateDevice, const QList<quint8> &units, const QList<quint16> &tcpPorts, mbServerPort *basePort)
+{
+    QList<mbServerDevice*> res;
+    mbServerDeviceTemplate *t = deviceTemplate(templateDevice);
+    MBSETTINGS settings = templateDevice->settings();
+    Q_FOREACH (quint16 tcpPort, tcpPorts)
+    {
+        mbServerPort *port = nullptr;
+        Q_FOREACH (mbServerPort *p, ports())
+        {
+            if ((p->type() == Modbus::TCP) && (p->port() == tcpPort))
+            {
+                port = p;
+                break;
+            }
+        }
+        if (!port)
+        {
+            port = new mbServerPort;
+            if (basePort)
+                port->setSettings(basePort->settings());
+            port->setName(QString("%1_%2").arg(templateDevice->name()).arg(tcpPort));
+            port->setType(Modbus::TCP);
+            port->setPort(tcpPort);
+            portAdd(port);
+        }
+        Q_FOREACH (quint8 unit, units)
+        {
+            if (port->deviceByUnit(unit)) // unit is already in use
+                continue;
+            mbServerDevice *instance = new mbServerDevice;
+            instance->setSettings(settings);
+            // instance uses memory of template, so it doesn't save (or map) its own data
+            instance->setSaveData(false);
+            instance->setMemoryMapped(false);
+            instance->setName(QString("%1_%2_%3").arg(templateDevice->name()).arg(tcpPort).arg(unit));
+            deviceAdd(instance);
+            t->attach(instance);
+            mbServerDeviceRef *ref = new mbServerDeviceRef(instance);
+            ref->setUnits(QList<quint8>() << unit);
+            port->deviceAdd(ref);
+            res.append(instance);
+        }
+    }
+    return res;
+}
+
+QList<mbServerSimStatistic> mbServerProject::simStatistic() const
+{
+    QReadLocker _(&m_simStatLock);
+    return m_simStat;
+}
+
+void mbServerProject::setSimStatistic(int worker, const mbServerSimStatistic &stat)
+{
+    {
+        QWriteLocker _(&m_simStatLock);
+        if ((worker < 0) || (worker >= m_simStat.count()))
+            return;
+        m_simStat[worker] = stat;
+    }
+    Q_EMIT simStatisticChanged();
+}
+
+void mbServerProject::resetSimStatistic(int workerCount)
+{
+    {
+        QWriteLocker _(&m_simStatLock);
+        m_simStat.clear();
+        for (int i = 0; i < workerCount; i++)
+            m_simStat.append(mbServerSimStatistic());
+    }
+    Q_EMIT simStatisticChanged();
 }
 
 int mbServerProject::simActionInsert(mbServerSimAction *simAction, int index)
@@ -156,6 +269,18 @@ bool mbServerProject::scriptModuleRename(mbServerScriptModule *d, const QString
     return false;
 }
 
+void mbServerProject::slotDeviceTemplateDestroyed(QObject *obj)
+{
+    for (DeviceTemplates_t::iterator it = m_deviceTemplates.begin(); it != m_deviceTemplates.end(); ++it)
+    {
+        if (it.value() == obj)
+        {
+            m_deviceTemplates.erase(it);
+            return;
+        }
+    }
+}
+
 void mbServerProject::slotSimActionChanged()
 {
     mbServerSimAction *simAction = static_cast<mbServerSimAction*>(sender());
@@ -24,11 +24,15 @@
 #define SERVER_PROJECT_H
 
 #include <QObject>
+#include <QReadWriteLock>
 
 #include <project/core_project.h>
 
+#include "server_simstatistic.h"
+
 class mbServerPort;
 class mbServerDevice;
+class mbServerDeviceTemplate;
 class mbServerDataView;
 class mbServerSimAction;
 class mbServerScriptModule;
@@ -73,6 +77,11 @@ public: // devices
     inline int deviceRemove(mbServerDevice* device) { return mbCoreProject::deviceRemove(reinterpret_cast<mbCoreDevice*>(device)); }
     inline bool deviceRename(mbServerDevice* device, const QString& newName)  { return mbCoreProject::deviceRename(reinterpret_cast<mbCoreDevice*>(device), newName); }
 
+public: // device templates
+    mbServerDeviceTemplate *deviceTemplate(mbServerDevice *device, bool create = true);
+    bool deviceTemplateAttach(mbServerDevice *instance);
+    QList<mbServerDevice*> deviceInstantiate(mbServerDevice *templateDevice, const QList<quint8> &units, const QList<quint16> &tcpPorts, mbServerPort *basePort = nullptr);
+
 public: // dataViews
     using mbCoreProject::dataViewIndex;
     using mbCoreProject::dataViewAdd;
@@ -104,6 +113,12 @@ public: // sim actions
     int simActionRemove(int index);
     inline int simActionRemove(mbServerSimAction *simAction) { return simActionRemove(simActionIndex(simAction)); }
 
+public: // simulation workers statistic
+    // Note: statistic is published by simulation workers from their own threads
+    QList<mbServerSimStatistic> simStatistic() const;
+    void setSimStatistic(int worker, const mbServerSimStatistic &stat);
+    void resetSimStatistic(int workerCount);
+
 public: // script modules
     QString freeScriptModuleName(const QString& s = QString()) const;
     inline bool hasScriptModule(const QString& name) const { return m_hashScriptModules.contains(name); }
@@ -127,6 +142,7 @@ Q_SIGNALS:
     void simActionRemoving(mbServerSimAction *simAction);
     void simActionRemoved(mbServerSimAction *simAction);
     void simActionChanged(mbServerSimAction *simAction);
+    void simStatisticChanged();
 
 Q_SIGNALS:
     void scriptModuleAdded(mbServerScriptModule*);
@@ -135,11 +151,18 @@ Q_SIGNALS:
     void scriptModuleChanged(mbServerScriptModule *scriptModule);
 
 private Q_SLOTS:
+    void slotDeviceTemplateDestroyed(QObject *obj);
     void slotSimActionChanged();
     void slotScriptModuleChanged();
 
+private: // device templates
+    typedef QHash<mbServerDevice*, mbServerDeviceTemplate*> DeviceTemplates_t;
+    DeviceTemplates_t m_deviceTemplates;
+
 private: // actions
     QList<mbServerSimAction*> m_simActions;
+    mutable QReadWriteLock m_simStatLock;
+    QList<mbServerSimStatistic> m_simStat;
 
 private: // script modules
     typedef QList<mbServerScriptModule*> ScriptModules_t;
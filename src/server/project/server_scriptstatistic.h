@@ -0,0 +1,55 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef SERVER_SCRIPTSTATISTIC_H
+#define SERVER_SCRIPTSTATISTIC_H
+
+#include <QDateTime>
+
+/*
+   Snapshot of device 'Loop'-script timing. It is measured by Python side
+   (see 'PythonBlock') and published by device script thread at a fixed interval.
+*/
+struct mbServerScriptStatistic
+{
+    mbServerScriptStatistic() :
+        isRunning(false),
+        period   (0),
+        cycles   (0),
+        timeLast (0),
+        timeAvg  (0),
+        timeMax  (0),
+        overruns (0)
+    {
+    }
+
+    bool    isRunning;
+    quint32 period   ; // milliseconds
+    quint32 cycles   ; // count of executed 'Loop'-scripts
+    quint32 timeLast ; // microseconds
+    quint32 timeAvg  ; // microseconds, exponential moving average
+    quint32 timeMax  ; // microseconds
+    quint32 overruns ; // count of 'Loop'-scripts that were finished after next deadline
+    QDateTime timestamp;
+};
+
+#endif // SERVER_SCRIPTSTATISTIC_H
@@ -38,14 +38,24 @@ mbServerSimAction::Strings::Strings() :
     incrementValue   (QStringLiteral("incrementValue")),
     incrementMin     (QStringLiteral("min")),
     incrementMax     (QStringLiteral("max")),
+    incrementSize    (QStringLiteral("incrementSize")),
     sinePeriod       (QStringLiteral("sinePeriod")),
     sinePhaseShift   (QStringLiteral("sinePhaseShift")),
     sineAmplitude    (QStringLiteral("sineAmplitude")),
     sineVerticalShift(QStringLiteral("sineVerticalShift")),
+    sineSize         (QStringLiteral("sineSize")),
+    sineElementPhaseShift(QStringLiteral("sineElementPhaseShift")),
     randomMin        (QStringLiteral("randomMin")),
     randomMax        (QStringLiteral("randomMax")),
+    randomSize       (QStringLiteral("randomSize")),
     copySourceAddress(QStringLiteral("sourceAddress")),
-    copySize         (QStringLiteral("size"))
+    copySize         (QStringLiteral("size")),
+    expression       (QStringLiteral("expression")),
+    playbackFile     (QStringLiteral("playbackFile")),
+    playbackSpeed    (QStringLiteral("playbackSpeed")),
+    playbackLoop     (QStringLiteral("playbackLoop")),
+    playbackInterpolation(QStringLiteral("playbackInterpolation")),
+    playbackSize     (QStringLiteral("playbackSize"))
 {
 }
 
@@ -66,14 +76,24 @@ mbServerSimAction::Defaults::Defaults() :
     incrementValue   (1),
     incrementMin     (0),
     incrementMax     (65535),
+    incrementSize    (1),
     sinePeriod       (10000),
     sinePhaseShift   (0),
     sineAmplitude    (100),
     sineVerticalShift(0),
+    sineSize         (1),
+    sineElementPhaseShift(0),
     randomMin        (0),
     randomMax        (100),
+    randomSize       (1),
     copySourceAddress(300001),
-    copySize         (1)
+    copySize         (1),
+    expression       (QString()),
+    playbackFile     (QString()),
+    playbackSpeed    (1.0),
+    playbackLoop     (true),
+    playbackInterpolation(false),
+    playbackSize     (1)
 {
 }
 
@@ -294,12 +314,20 @@ int mbServerSimAction::length() const
     {
     case Modbus::Memory_0x:
     case Modbus::Memory_1x:
-        return bitLength();
+        return bitLength() * arraySize();
     default:
-        return registerLength();
+        if (m_dataType == mb::Bit)
+            return (arraySize()+MB_REGE_SZ_BITES-1)/MB_REGE_SZ_BITES;
+        return (byteLength()*arraySize()+1)/2;
     }
 }
 
+int mbServerSimAction::arraySize() const
+{
+    int size = m_actionExtended->arraySize();
+    return size > 0 ? size : 1;
+}
+
 QString mbServerSimAction::byteOrderStr() const
 {
     return mb::enumDataOrderKey(m_byteOrder);
@@ -353,6 +381,12 @@ void mbServerSimAction::setNewActionExtended(ActionType actionType)
     case Copy:
         m_actionExtended = new ActionCopy(this);
         break;
+    case Expression:
+        m_actionExtended = new ActionExpression(this);
+        break;
+    case Playback:
+        m_actionExtended = new ActionPlayback(this);
+        break;
     default:
         return;
     }
@@ -374,6 +408,7 @@ MBSETTINGS mbServerSimAction::ActionIncrement::extendedSettings() const
     p[s.incrementValue] = value;
     p[s.incrementMin  ] = min  ;
     p[s.incrementMax  ] = max  ;
+    p[s.incrementSize ] = size ;
     return p;
 }
 
@@ -394,15 +429,20 @@ void mbServerSimAction::ActionIncrement::setExtendedSettings(const MBSETTINGS &s
     it = settings.find(s.incrementMax);
     if (it != end)
         max = it.value();
+
+    it = settings.find(s.incrementSize);
+    if (it != end)
+        size = static_cast<quint16>(it.value().toUInt());
     mb::processMinMax(action->dataType(), min, max);
 }
 
 QString mbServerSimAction::ActionIncrement::extendedSettingsStr() const
 {
     const Strings &s = Strings::instance();
-    return QString("%1=%2;%3=%4;%5=%6").arg(s.incrementValue, value.toString(),
-                                            s.incrementMin, min.toString(),
-                                            s.incrementMax, max.toString());
+    return QString("%1=%2;%3=%4;%5=%6;%7=%8").arg(s.incrementValue, value.toString(),
+                                                  s.incrementMin, min.toString(),
+                                                  s.incrementMax, max.toString(),
+                                                  s.incrementSize, QString::number(size));
 }
 
 // -----------------------------------------------------------------------------------------------------------------------
@@ -417,6 +457,8 @@ MBSETTINGS mbServerSimAction::ActionSine::extendedSettings() const
     p[s.sinePhaseShift   ] = phaseShift   ;
     p[s.sineAmplitude    ] = amplitude    ;
     p[s.sineVerticalShift] = verticalShift;
+    p[s.sineSize         ] = size         ;
+    p[s.sineElementPhaseShift] = elementPhaseShift;
     return p;
 }
 
@@ -455,6 +497,18 @@ void mbServerSimAction::ActionSine::setExtendedSettings(const MBSETTINGS &settin
     {
         verticalShift = it.value();
     }
+
+    it = settings.find(s.sineSize);
+    if (it != end)
+        size = static_cast<quint16>(it.value().toUInt());
+
+    it = settings.find(s.sineElementPhaseShift);
+    if (it != end)
+    {
+        qint64 v = it.value().toLongLong(&ok);
+        if (ok)
+            elementPhaseShift = v;
+    }
 }
 
 QString mbServerSimAction::ActionSine::extendedSettingsStr() const
@@ -464,7 +518,10 @@ QString mbServerSimAction::ActionSine::extendedSettingsStr() const
         .arg(s.sinePeriod       , QString::number(sinePeriod),
              s.sinePhaseShift   , QString::number(phaseShift),
              s.sineAmplitude    , amplitude.toString(),
-             s.sineVerticalShift, verticalShift.toString());
+             s.sineVerticalShift, verticalShift.toString())
+        + QString(";%1=%2;%3=%4")
+        .arg(s.sineSize             , QString::number(size),
+             s.sineElementPhaseShift, QString::number(elementPhaseShift));
 }
 
 // -----------------------------------------------------------------------------------------------------------------------
@@ -477,6 +534,7 @@ MBSETTINGS mbServerSimAction::ActionRandom::extendedSettings() const
     MBSETTINGS p;
     p[s.randomMin] = min;
     p[s.randomMax] = max;
+    p[s.randomSize] = size;
     return p;
 }
 
@@ -494,14 +552,19 @@ void mbServerSimAction::ActionRandom::setExtendedSettings(const MBSETTINGS &sett
     it = settings.find(s.randomMax);
     if (it != end)
         max = it.value();
+
+    it = settings.find(s.randomSize);
+    if (it != end)
+        size = static_cast<quint16>(it.value().toUInt());
     mb::processMinMax(action->dataType(), min, max);
 }
 
 QString mbServerSimAction::ActionRandom::extendedSettingsStr() const
 {
     const Strings &s = Strings::instance();
-    return QString("%1=%2;%3=%4").arg(s.randomMin, min.toString(),
-                                      s.randomMax, max.toString());
+    return QString("%1=%2;%3=%4;%5=%6").arg(s.randomMin, min.toString(),
+                                            s.randomMax, max.toString(),
+                                            s.randomSize, QString::number(size));
 }
 
 // -----------------------------------------------------------------------------------------------------------------------
@@ -540,3 +603,101 @@ QString mbServerSimAction::ActionCopy::extendedSettingsStr() const
                                       s.copySize         , QString::number(size));
 }
 
+// -----------------------------------------------------------------------------------------------------------------------
+// ------------------------------------------------------ EXPRESSION -----------------------------------------------------
+// -----------------------------------------------------------------------------------------------------------------------
+
+MBSETTINGS mbServerSimAction::ActionExpression::extendedSettings() const
+{
+    const Strings &s = Strings::instance();
+    MBSETTINGS p;
+    p[s.expression] = expression;
+    return p;
+}
+
+void mbServerSimAction::ActionExpression::setExtendedSettings(const MBSETTINGS &settings)
+{
+    const Strings &s = Strings::instance();
+
+    MBSETTINGS::const_iterator it = settings.find(s.expression);
+    if (it != settings.end())
+        expression = it.value().toString();
+}
+
+QString mbServerSimAction::ActionExpression::extendedSettingsStr() const
+{
+    const Strings &s = Strings::instance();
+    return QString("%1=%2").arg(s.expression, expression);
+}
+
+void mbServerSimAction::ActionExpression::setExtendedSettingsStr(const QString &settings)
+{
+    const Strings &s = Strings::instance();
+    QString prefix = s.expression + QLatin1Char('=');
+    QString str = settings.trimmed();
+    if (str.startsWith(prefix))
+        expression = str.mid(prefix.length()).trimmed();
+    else
+        expression = str;
+}
+
+
+// -----------------------------------------------------------------------------------------------------------------------
+// ------------------------------------------------------- PLAYBACK ------------------------------------------------------
+// -----------------------------------------------------------------------------------------------------------------------
+
+MBSETTINGS mbServerSimAction::ActionPlayback::extendedSettings() const
+{
+    const Strings &s = Strings::instance();
+    MBSETTINGS p;
+    p[s.playbackFile         ] = file         ;
+    p[s.playbackSpeed        ] = speed        ;
+    p[s.playbackLoop         ] = loop         ;
+    p[s.playbackInterpolation] = interpolation;
+    p[s.playbackSize         ] = size         ;
+    return p;
+}
+
+void mbServerSimAction::ActionPlayback::setExtendedSettings(const MBSETTINGS &settings)
+{
+    const Strings &s = Strings::instance();
+
+    MBSETTINGS::const_iterator it;
+    auto end = settings.end();
+    bool ok;
+
+    it = settings.find(s.playbackFile);
+    if (it != end)
+        file = it.value().toString();
+
+    it = settings.find(s.playbackSpeed);
+    if (it != end)
+    {
+        double v = it.value().toDouble(&ok);
+        if (ok && (v > 0))
+            speed = v;
+    }
+
+    it = settings.find(s.playbackLoop);
+    if (it != end)
+        loop = it.value().toBool();
+
+    it = settings.find(s.playbackInterpolation);
+    if (it != end)
+        interpolation = it.value().toBool();
+
+    it = settings.find(s.playbackSize);
+    if (it != end)
+        size = static_cast<quint16>(it.value().toUInt());
+}
+
+QString mbServerSimAction::ActionPlayback::extendedSettingsStr() const
+{
+    const Strings &s = Strings::instance();
+    return QString("%1=%2;%3=%4;%5=%6;%7=%8")
+        .arg(s.playbackFile         , file,
+             s.playbackSpeed        , QString::number(speed),
+             s.playbackLoop         , QVariant(loop).toString(),
+             s.playbackInterpolation, QVariant(interpolation).toString())
+        + QString(";%1=%2").arg(s.playbackSize, QString::number(size));
+}
@@ -37,7 +37,9 @@ public:
         Increment,
         Sine,
         Random,
-        Copy
+        Copy,
+        Expression,
+        Playback
     };
     Q_ENUM(ActionType)
 
@@ -55,14 +57,24 @@ public:
         const QString incrementValue   ;
         const QString incrementMin     ;
         const QString incrementMax     ;
+        const QString incrementSize    ;
         const QString sinePeriod       ;
         const QString sinePhaseShift   ;
         const QString sineAmplitude    ;
         const QString sineVerticalShift;
+        const QString sineSize         ;
+        const QString sineElementPhaseShift;
         const QString randomMin        ;
         const QString randomMax        ;
+        const QString randomSize       ;
         const QString copySourceAddress;
         const QString copySize         ;
+        const QString expression       ;
+        const QString playbackFile     ;
+        const QString playbackSpeed    ;
+        const QString playbackLoop     ;
+        const QString playbackInterpolation;
+        const QString playbackSize     ;
 
         Strings();
         static const Strings &instance();
@@ -80,14 +92,24 @@ public:
         const int               incrementValue   ;
         const int               incrementMin     ;
         const int               incrementMax     ;
+        const quint16           incrementSize    ;
         const int               sinePeriod       ;
         const int               sinePhaseShift   ;
         const int               sineAmplitude    ;
         const int               sineVerticalShift;
+        const quint16           sineSize         ;
+        const int               sineElementPhaseShift;
         const int               randomMin        ;
         const int               randomMax        ;
+        const quint16           randomSize       ;
         const int               copySourceAddress;
         const quint16           copySize         ;
+        const QString           expression       ;
+        const QString           playbackFile     ;
+        const double            playbackSpeed    ;
+        const bool              playbackLoop     ;
+        const bool              playbackInterpolation;
+        const quint16           playbackSize     ;
 
         Defaults();
         static const Defaults &instance();
@@ -129,6 +151,7 @@ public:
     inline int registerLength() const { return (byteLength()+1)/2; }
     int length() const;
     inline int count() const { return length(); }
+    int arraySize() const; // count of consecutive values the action drives
 
     inline mb::DataOrder byteOrder() const { return m_byteOrder; }
     inline void setByteOrder(mb::DataOrder order) { m_byteOrder = order; }
@@ -163,7 +186,8 @@ private:
         virtual MBSETTINGS extendedSettings() const = 0;
         virtual void setExtendedSettings(const MBSETTINGS &settings) = 0;
         virtual QString extendedSettingsStr() const = 0;
-        inline void setExtendedSettingsStr(const QString &settings) { setExtendedSettings(mb::parseExtendedAttributesStr(settings)); }
+        virtual int arraySize() const { return 1; }
+        virtual void setExtendedSettingsStr(const QString &settings) { setExtendedSettings(mb::parseExtendedAttributesStr(settings)); }
     };
 
     struct ActionIncrement : public ActionExtended
@@ -171,15 +195,18 @@ private:
         QVariant value;
         QVariant min;
         QVariant max;
+        quint16 size;
         MBSETTINGS extendedSettings() const override;
         void setExtendedSettings(const MBSETTINGS &settings) override;
         QString extendedSettingsStr() const override;
+        int arraySize() const override { return size; }
         ActionIncrement(mbServerSimAction *a) : ActionExtended(a)
         {
             Defaults d = Defaults::instance();
             value = d.incrementValue;
             min = d.incrementMin;
             max = d.incrementMax;
+            size = d.incrementSize;
         }
     };
 
@@ -189,10 +216,13 @@ private:
         qint64 phaseShift;
         QVariant amplitude;
         QVariant verticalShift;
+        quint16 size;
+        qint64 elementPhaseShift; // phase shift between neighbour array elements
 
         MBSETTINGS extendedSettings() const override;
         void setExtendedSettings(const MBSETTINGS &settings) override;
         QString extendedSettingsStr() const override;
+        int arraySize() const override { return size; }
 
         ActionSine(mbServerSimAction *a) : ActionExtended(a)
         {
@@ -201,6 +231,8 @@ private:
             phaseShift    = d.sinePhaseShift   ;
             amplitude     = d.sineAmplitude    ;
             verticalShift = d.sineVerticalShift;
+            size          = d.sineSize         ;
+            elementPhaseShift = d.sineElementPhaseShift;
         }
     };
 
@@ -208,16 +240,19 @@ private:
     {
         QVariant min;
         QVariant max;
+        quint16 size;
 
         MBSETTINGS extendedSettings() const override;
         void setExtendedSettings(const MBSETTINGS &settings) override;
         QString extendedSettingsStr() const override;
+        int arraySize() const override { return size; }
 
         ActionRandom(mbServerSimAction *a) : ActionExtended(a)
         {
             Defaults d = Defaults::instance();
             min = d.randomMin;
             max = d.randomMax;
+            size = d.randomSize;
         }
     };
 
@@ -229,6 +264,7 @@ private:
         MBSETTINGS extendedSettings() const override;
         void setExtendedSettings(const MBSETTINGS &settings) override;
         QString extendedSettingsStr() const override;
+        int arraySize() const override { return size; }
 
         ActionCopy(mbServerSimAction *a) : ActionExtended(a)
         {
@@ -238,6 +274,47 @@ private:
         }
     };
 
+    struct ActionExpression : public ActionExtended
+    {
+        QString expression;
+
+        MBSETTINGS extendedSettings() const override;
+        void setExtendedSettings(const MBSETTINGS &settings) override;
+        QString extendedSettingsStr() const override;
+        // Note: expression can contain ';' and '=' so its string isn't split into 'key=value' pairs
+        void setExtendedSettingsStr(const QString &settings) override;
+
+        ActionExpression(mbServerSimAction *a) : ActionExtended(a)
+        {
+            Defaults d = Defaults::instance();
+            expression = d.expression;
+        }
+    };
+
+    struct ActionPlayback : public ActionExtended
+    {
+        QString file;
+        double speed;
+        bool loop;
+        bool interpolation;
+        quint16 size; // count of trace channels written to consecutive values
+
+        MBSETTINGS extendedSettings() const override;
+        void setExtendedSettings(const MBSETTINGS &settings) override;
+        QString extendedSettingsStr() const override;
+        int arraySize() const override { return size; }
+
+        ActionPlayback(mbServerSimAction *a) : ActionExtended(a)
+        {
+            Defaults d = Defaults::instance();
+            file          = d.playbackFile         ;
+            speed         = d.playbackSpeed        ;
+            loop          = d.playbackLoop         ;
+            interpolation = d.playbackInterpolation;
+            size          = d.playbackSize         ;
+        }
+    };
+
 private:
     void setNewActionExtended(ActionType actionType);
 
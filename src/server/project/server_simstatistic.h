@@ -0,0 +1,55 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef SERVER_SIMSTATISTIC_H
+#define SERVER_SIMSTATISTIC_H
+
+#include <QDateTime>
+
+/*
+   Snapshot of simulation worker load. It is measured by the worker
+   (see 'mbServerRunSimActionTask') and published at a fixed interval.
+*/
+struct mbServerSimStatistic
+{
+    mbServerSimStatistic() :
+        devices (0),
+        actions (0),
+        execs   (0),
+        load    (0),
+        timeAvg (0),
+        timeMax (0),
+        overruns(0)
+    {
+    }
+
+    quint32 devices ; // count of devices simulated by the worker
+    quint32 actions ; // count of actions executed by the worker
+    quint32 execs   ; // count of executed actions per second
+    quint32 load    ; // percent of time the worker was busy executing actions
+    quint32 timeAvg ; // microseconds, average time of single loop with due actions
+    quint32 timeMax ; // microseconds
+    quint32 overruns; // count of skipped action periods since start
+    QDateTime timestamp;
+};
+
+#endif // SERVER_SIMSTATISTIC_H
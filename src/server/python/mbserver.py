@@ -7,10 +7,23 @@ More details.
 #from typing import Union
 
 from os import path
+import os as _os
 from ctypes import *
 import struct
+import threading
+import sys as _sys
+import platform as _platform
+import time as _time
 
-from PyQt5.QtCore import QSharedMemory
+try:
+    from PyQt5.QtCore import QSharedMemory
+except ImportError: # Note: not required by embedded interpreter (see '_mbsetlocalmemory')
+    QSharedMemory = None
+
+try:
+    import numpy as _np
+except ImportError:
+    _np = None
 
 from mbconfig import *
 import modbus
@@ -62,14 +75,235 @@ class CDeviceBlock(Structure):
                 ("stringTableSize"   , c_uint)]
 
 class CPythonBlock(Structure): 
-    _fields_ = [("pycycle"           , c_uint)]
+    _fields_ = [("pycycle"           , c_uint),
+                ("flags"             , c_uint),
+                ("loopTimeLast"      , c_uint),  # microseconds
+                ("loopTimeAvg"       , c_uint),  # microseconds, exponential moving average
+                ("loopTimeMax"       , c_uint),  # microseconds
+                ("loopOverruns"      , c_uint)]
+
+# Python block flags (CPythonBlock.flags)
+_MB_PYTHONFLAG_FINISHED     = 0x01 # 'Final'-script of hosted device was executed (see 'scriptworker.py')
+_MB_PYTHONFLAG_SHAREDMEMORY = 0x02 # script accepts offered shared memory (atomic compare-and-swap is available)
+_MB_PYTHONFLAG_COPYMEMORY   = 0x04 # script declines offered shared memory, memory is copied
+
+_MB_DIRTYRANGE_COUNT = 16  # count of dirty ranges in memory block header
+_MB_DIRTYPAGE_SIZE   = 256 # count of memory bytes covered by one bit of dirty-page bitmap
+
+class CMemoryDirtyRange(Structure): 
+    _fields_ = [("byteOffset"        , c_uint),
+                ("byteCount"         , c_uint)]
 
 class CMemoryBlockHeader(Structure): 
     _fields_ = [("changeCounter"     , c_uint),
-                ("changeByteOffset"  , c_uint),
-                ("changeByteCount"   , c_uint),
+                ("rangeCount"        , c_uint),
+                ("pageOverflow"      , c_uint),
+                ("sequence"          , c_uint),
+                ("writeLock"         , c_uint),  # 0 - free, 1 - held by writer of server or script
+                ("ranges"            , CMemoryDirtyRange * _MB_DIRTYRANGE_COUNT)]
+
+class CNotifyRecord(Structure): 
+    _fields_ = [("sequence"          , c_uint),
+                ("memory"            , c_uint),
+                ("byteOffset"        , c_uint),
+                ("byteCount"         , c_uint)]
+
+class CNotifyBlock(Structure): 
+    _fields_ = [("wakeCounter"       , c_uint),
+                ("head"              , c_uint),
+                ("ringSize"          , c_uint),
                 ("dummy"             , c_uint)]
 
+# Device flags (CDeviceBlock.flags)
+_MB_DEVICEFLAG_RUN          = 0x01
+_MB_DEVICEFLAG_SHAREDMEMORY = 0x02  # server device memory lives in shared segment (zero-copy):
+                                    # 'changeCounter' is sequence lock of Python side (odd while writing),
+                                    # 'sequence' is sequence lock of server side
+_MB_DEVICEFLAG_SHAREDMEMORYOFFER = 0x04 # shared memory is offered, script answers by _MB_PYTHONFLAG_SHAREDMEMORY
+                                        # or _MB_PYTHONFLAG_COPYMEMORY and waits until server clears this flag
+
+# Array types for `getarray()`/`setarray()`: name -> (struct format, numpy format, register count)
+_MB_ARRAYTYPES = { 'int16'  : ('h', '<i2', 1),
+                   'uint16' : ('H', '<u2', 1),
+                   'int32'  : ('i', '<i4', 2),
+                   'uint32' : ('I', '<u4', 2),
+                   'int64'  : ('q', '<i8', 4),
+                   'uint64' : ('Q', '<u8', 4),
+                   'float32': ('f', '<f4', 2),
+                   'float64': ('d', '<f8', 4) }
+_MB_ARRAYTYPE_ALIASES = { 'float': 'float32', 'double': 'float64' } # same as getfloat()/getdouble()
+
+# Register permutation (register count, register order) -> source register for each position
+_MB_REGISTERPERM = { (2, MB_REGISTERORDER_R3R2R1R0): (1, 0),
+                     (2, MB_REGISTERORDER_R1R0R3R2): (1, 0),
+                     (4, MB_REGISTERORDER_R3R2R1R0): (3, 2, 1, 0),
+                     (4, MB_REGISTERORDER_R1R0R3R2): (1, 0, 3, 2),
+                     (4, MB_REGISTERORDER_R2R3R0R1): (2, 3, 0, 1) }
+
+def _mbarraytype(dtype):
+    if isinstance(dtype, str):
+        name = _MB_ARRAYTYPE_ALIASES.get(dtype, dtype)
+    elif _np is not None:
+        name = _np.dtype(dtype).name
+    else:
+        name = str(dtype)
+    t = _MB_ARRAYTYPES.get(name)
+    if t is None:
+        raise ValueError(f"Unsupported array type '{dtype}'")
+    return t
+
+_MB_NOTIFY_WHOLEMEMORY = 0xFFFFFFFF # CNotifyRecord.byteCount: whole memory was changed
+
+_MB_SEQREAD_RETRIES       = 1000 # spin limit of sequence lock reader (same as server)
+_MB_WRITELOCK_CHECKPERIOD = 0.1 # seconds, period of check if owner of writer lock is alive (same as server)
+_MB_SHAREDMEMORY_TIMEOUT  = 5.0 # seconds, waiting for server to answer for accepting of shared memory
+
+# Note: 'futex' syscall number depends on architecture
+_MB_SYS_FUTEX = { 'x86_64': 202, 'amd64': 202, 'aarch64': 98, 'arm64': 98,
+                  'i386': 240, 'i686': 240, 'x86': 240, 'armv7l': 240, 'armv6l': 240 }
+_MB_FUTEX_WAIT = 0
+
+class _CTimespec(Structure): 
+    _fields_ = [("tv_sec"            , c_long),
+                ("tv_nsec"           , c_long)]
+
+
+class CArenaHeader(Structure): 
+    _fields_ = [("magic"             , c_uint),
+                ("version"           , c_uint),
+                ("entryCount"        , c_uint),
+                ("size"              , c_uint)]
+
+class CArenaEntry(Structure): 
+    _fields_ = [("keyOffset"         , c_uint),
+                ("keySize"           , c_uint),
+                ("offset"            , c_uint),
+                ("size"              , c_uint)]
+
+_MB_ARENA_MAGIC = 0x5241424D # 'MBAR'
+
+
+class _LocalMemory:
+    """Memory block that is already mapped into the current process: memory of the server
+       process (embedded interpreter) or block of shared memory arena (see `_mbsetarena()`).
+       Has the same interface as QSharedMemory. Locking is not needed because embedded server
+       synchronizes memory in the same thread between script calls and arena memory is always
+       shared with device and synchronized by sequence locks of memory block header.
+    """
+    def __init__(self, address:int, size:int):
+        self._address = address
+        self._size = size
+
+    def attach(self)->bool:
+        return True
+
+    def detach(self)->bool:
+        return True
+
+    def data(self)->int:
+        return self._address
+
+    def size(self)->int:
+        return self._size
+
+    def lock(self)->bool:
+        return True
+
+    def unlock(self)->bool:
+        return True
+
+# Memory blocks of embedded interpreter or shared memory arena: key -> (address, size)
+_mblocalmemory = {}
+_mbarena = None # attached arena segment (must live while its blocks are used)
+
+def _mbsetlocalmemory(blocks:dict):
+    _mblocalmemory.update(blocks)
+
+def _mbsetarena(key:str):
+    """Attaches shared memory arena of server process once and maps blocks of all its devices"""
+    global _mbarena
+    if not key or (_mbarena is not None):
+        return
+    if QSharedMemory is None:
+        raise RuntimeError("PyQt5 is required to access Shared Memory")
+    shm = QSharedMemory(key)
+    if not shm.attach():
+        raise RuntimeError(f"Cannot attach to Shared Memory arena with id = '{key}'")
+    base = shm.data().__int__()
+    head = CArenaHeader.from_address(base)
+    if head.magic != _MB_ARENA_MAGIC:
+        shm.detach()
+        raise RuntimeError(f"Shared Memory with id = '{key}' is not valid arena")
+    toc = (CArenaEntry * head.entryCount).from_address(base + sizeof(CArenaHeader))
+    blocks = {}
+    for e in toc:
+        blocks[string_at(base + e.keyOffset, e.keySize).decode('utf-8')] = (base + e.offset, e.size)
+    _mbsetlocalmemory(blocks)
+    _mbarena = shm
+
+def _mbloadcas32():
+    """Returns function `cas(address, expected, desired)->bool`: atomic compare-and-swap of 32-bit word
+       shared with server (writer lock of memory block header) or None if there is no such function"""
+    try:
+        import _mbembedded # embedded interpreter: function is provided by server process
+        return _mbembedded.cas32
+    except ImportError:
+        pass
+    try:
+        if _sys.platform == 'win32':
+            if _platform.architecture()[0] == '32bit':
+                f = windll.kernel32.InterlockedCompareExchange # Note: exported only by 32-bit kernel32
+                f.argtypes = [c_void_p, c_uint, c_uint]
+                f.restype = c_uint
+                return lambda address, expected, desired: f(address, desired, expected) == expected
+        elif _sys.platform == 'darwin':
+            f = CDLL(None).OSAtomicCompareAndSwap32Barrier
+            f.argtypes = [c_int, c_int, c_void_p]
+            f.restype = c_bool
+            return lambda address, expected, desired: f(expected, desired, address)
+        else:
+            from ctypes.util import find_library
+            f = getattr(CDLL(find_library('atomic') or 'libatomic.so.1'), '__atomic_compare_exchange_4')
+            f.argtypes = [c_void_p, POINTER(c_uint), c_uint, c_int, c_int]
+            f.restype = c_bool
+            return lambda address, expected, desired: f(address, byref(c_uint(expected)), desired, 5, 5) # __ATOMIC_SEQ_CST
+    except (OSError, AttributeError):
+        pass
+    return None
+
+_mbcas32 = None # loaded on first use of shared memory mode
+
+def _mbpidalive(pid:int)->bool:
+    """Returns True if process with id `pid` (owner of writer lock of memory block header) is running"""
+    if _sys.platform == 'win32':
+        k = WinDLL('kernel32', use_last_error=True)
+        k.OpenProcess.argtypes = [c_uint, c_int, c_uint]
+        k.OpenProcess.restype = c_void_p
+        k.WaitForSingleObject.argtypes = [c_void_p, c_uint]
+        k.WaitForSingleObject.restype = c_uint
+        k.CloseHandle.argtypes = [c_void_p]
+        h = k.OpenProcess(0x00100000, False, pid) # SYNCHRONIZE
+        if not h:
+            return get_last_error() == 5 # ERROR_ACCESS_DENIED
+        alive = (k.WaitForSingleObject(h, 0) == 0x102) # WAIT_TIMEOUT
+        k.CloseHandle(h)
+        return alive
+    try:
+        _os.kill(pid, 0)
+    except ProcessLookupError:
+        return False
+    except PermissionError:
+        pass
+    return True
+
+def _mbsharedmemory(shmid:str):
+    local = _mblocalmemory.get(shmid)
+    if local is not None:
+        return _LocalMemory(*local)
+    if QSharedMemory is None:
+        raise RuntimeError("PyQt5 is required to access Shared Memory")
+    return QSharedMemory(shmid)
+
 ## @endcond
 
 
@@ -79,7 +313,7 @@ class _MemoryBlock:
        Class is abstract (can't be used directly). 
     """
     ## @cond
-    def __init__(self, shmid:str, bytecount:int, id:int, byteorder, regorder:int):
+    def __init__(self, shmid:str, bytecount:int, id:int, byteorder, regorder:int, shared:bool=False):
         if isinstance(byteorder, int):
             if byteorder == MB_DATAORDER_BIGENDIAN:
                 self._byteorder = 'big'
@@ -93,7 +327,7 @@ class _MemoryBlock:
         else:
             self._byteorder = 'little'
         self._registerorder = regorder
-        shm = QSharedMemory(shmid)
+        shm = _mbsharedmemory(shmid)
         res = shm.attach()
         if not res:
             raise RuntimeError(f"Cannot attach to Shared Memory with id = '{shmid}'")
@@ -102,12 +336,24 @@ class _MemoryBlock:
         sz = shm.size()
         cbytes = bytecount if bytecount <= sz else sz
         self._shm = shm
+        self._shared = shared
+        self._wlock = threading.Lock()
+        if shared:
+            global _mbcas32
+            if _mbcas32 is None:
+                _mbcas32 = _mbloadcas32()
+            if _mbcas32 is None:
+                raise RuntimeError("Atomic compare-and-swap is not available on this platform, "
+                                   "shared memory arena of script can't be used")
+            self._writelock = memptr.value + CMemoryBlockHeader.writeLock.offset
+            self._pid = _os.getpid() # Note: embedded interpreter has the same id as server process
         self._countbytes = cbytes
         self._id = id
         ptrhead = cast(memptr, POINTER(CMemoryBlockHeader))
         self._head = ptrhead[0]
         self._pmembytes = cast(byref(ptrhead[1]),POINTER(c_ubyte*1))
         self._pmaskbytes = cast(byref(cast(byref(ptrhead[1]),POINTER(c_byte*cbytes))[1]),POINTER(c_ubyte*1))
+        self._ppagebits = cast(byref(cast(byref(ptrhead[1]),POINTER(c_byte*(cbytes*2)))[1]),POINTER(c_ubyte))
 
     def __del__(self):
         try:
@@ -116,16 +362,90 @@ class _MemoryBlock:
             pass
     
     def _recalcheader(self, byteoffset:int, bytecount:int):
-        rightedge = byteoffset + bytecount
-        if self._head.changeByteOffset > byteoffset:
-            if self._head.changeByteCount == 0:
-                self._head.changeByteCount = rightedge - byteoffset
+        if self._shared: # server works with the same memory, nothing to merge
+            return
+        head = self._head
+        if head.pageOverflow:
+            self._markpages(byteoffset, bytecount)
+        else:
+            rightedge = byteoffset + bytecount
+            n = head.rangeCount
+            last = head.ranges[n-1] if n else None
+            # Note: merge with the last range when touching it (e.g. sequential writes)
+            if last and (byteoffset <= last.byteOffset + last.byteCount) and (last.byteOffset <= rightedge):
+                lastedge = max(last.byteOffset + last.byteCount, rightedge)
+                last.byteOffset = min(last.byteOffset, byteoffset)
+                last.byteCount = lastedge - last.byteOffset
+            elif n < _MB_DIRTYRANGE_COUNT:
+                r = head.ranges[n]
+                r.byteOffset = byteoffset
+                r.byteCount = bytecount
+                head.rangeCount = n + 1
             else:
-                self._head.changeByteCount += self._head.changeByteOffset - byteoffset # Fixed Jan 30 2025
-            self._head.changeByteOffset = byteoffset
-        if self._head.changeByteOffset + self._head.changeByteCount < rightedge:
-            self._head.changeByteCount = rightedge - self._head.changeByteOffset
-        self._head.changeCounter += 1
+                # ranges are full: move them to dirty-page bitmap
+                for i in range(n):
+                    self._markpages(head.ranges[i].byteOffset, head.ranges[i].byteCount)
+                self._markpages(byteoffset, bytecount)
+                head.rangeCount = 0
+                head.pageOverflow = 1
+        head.changeCounter += 1
+
+    def _markpages(self, byteoffset:int, bytecount:int):
+        if bytecount <= 0:
+            return
+        pagebits = self._ppagebits
+        for page in range(byteoffset // _MB_DIRTYPAGE_SIZE, (byteoffset + bytecount - 1) // _MB_DIRTYPAGE_SIZE + 1):
+            pagebits[page >> 3] |= (1 << (page & 7))
+
+    # Note: in shared memory mode reads are lock-free and repeated while server is changing memory.
+    #       Sequence lock relies on ordered stores that is guaranteed by x86/x64 platforms
+    #       (server uses shared memory mode on such platforms only).
+    #       Spinning is limited, so server that died in the middle of writing can't block the script
+    def _beginread(self)->int:
+        if self._shared:
+            seq = self._head.sequence
+            i = 0
+            while (seq & 1) and (i < _MB_SEQREAD_RETRIES):
+                _time.sleep(0) # yield
+                seq = self._head.sequence
+                i += 1
+            return seq
+        self._shm.lock()
+        return 0
+
+    def _endread(self, seq:int)->bool:
+        if self._shared:
+            return bool(seq & 1) or (self._head.sequence == seq)
+        self._shm.unlock()
+        return True
+
+    # Note: in shared memory mode server writes the same memory, so both sides write only while holding
+    #       writer lock of memory block header (read-modify-write of one side can't lose change of other one).
+    #       Lock word holds process id of its owner and is taken over only when the owner is not alive
+    def _beginwrite(self):
+        if self._shared:
+            self._wlock.acquire()
+            pid = self._pid
+            if not _mbcas32(self._writelock, 0, pid):
+                check = _time.monotonic() + _MB_WRITELOCK_CHECKPERIOD
+                while not _mbcas32(self._writelock, 0, pid):
+                    if _time.monotonic() >= check:
+                        owner = self._head.writeLock
+                        if owner and (owner != pid) and not _mbpidalive(owner) and _mbcas32(self._writelock, owner, pid):
+                            break # server died holding the lock
+                        check = _time.monotonic() + _MB_WRITELOCK_CHECKPERIOD
+                    _time.sleep(0) # yield
+            self._head.changeCounter += 1
+        else:
+            self._shm.lock()
+
+    def _endwrite(self):
+        if self._shared:
+            self._head.changeCounter += 1
+            _mbcas32(self._writelock, self._pid, 0)
+            self._wlock.release()
+        else:
+            self._shm.unlock()
 
     def _getbytes(self, byteoffset:int, count:int, bytestype=bytes)->bytes:
         if 0 <= byteoffset < self._countbytes:
@@ -133,12 +453,28 @@ class _MemoryBlock:
                 c = self._countbytes - byteoffset
             else:
                 c = count
-            self._shm.lock()
-            b = bytestype(cast(self._pmembytes[byteoffset], POINTER(c_ubyte*c))[0])
-            self._shm.unlock()
+            while True:
+                seq = self._beginread()
+                b = bytestype(cast(self._pmembytes[byteoffset], POINTER(c_ubyte*c))[0])
+                if self._endread(seq):
+                    break
             return b
         return bytestype()
 
+    def _reorder(self, ba:bytearray, regcount:int)->bytearray:
+        # Converts array of values (each of `regcount` registers) between memory and 'little'/R0R1R2R3 order.
+        # Note: all conversions are symmetric so the same function is used for read and write
+        if self._byteorder == 'big':
+            ba[0::2], ba[1::2] = ba[1::2], ba[0::2]
+        perm = _MB_REGISTERPERM.get((regcount, self._registerorder))
+        if perm:
+            src = bytes(ba)
+            step = regcount * 2
+            for i, p in enumerate(perm):
+                ba[i*2  ::step] = src[p*2  ::step]
+                ba[i*2+1::step] = src[p*2+1::step]
+        return ba
+
     def swap32(self, ba:bytearray)->bytearray:
         # Split into 2 16-bit (2-byte) regs
         regs = [ba[i:i+2] for i in range(0, 4, 2)]  # R0, R1, R2, R3
@@ -257,11 +593,11 @@ class _MemoryBlock:
                 c = count
             if not isinstance(value, bytes):
                 value = bytes(value)
-            self._shm.lock()
+            self._beginwrite()
             memmove(self._pmembytes[byteoffset], value, c)
             memset(self._pmaskbytes[byteoffset], -1, c)
             self._recalcheader(byteoffset, c)
-            self._shm.unlock()
+            self._endwrite()
         ## @endcond
 
     def getbitbytearray(self, bitoffset:int, bitcount:int)->bytearray:
@@ -383,9 +719,11 @@ class _MemoryBlock:
         ## @cond
         byteoffset = bitoffset // 8
         if 0 <= byteoffset < self._countbytes:
-            self._shm.lock()
-            vbyte = self._pmembytes[byteoffset][0]
-            self._shm.unlock()
+            while True:
+                seq = self._beginread()
+                vbyte = self._pmembytes[byteoffset][0]
+                if self._endread(seq):
+                    break
             return (vbyte & (1 << bitoffset % 8)) != 0
         return False
         ## @endcond
@@ -408,14 +746,14 @@ class _MemoryBlock:
         ## @cond
         byteoffset = bitoffset // 8
         if 0 <= byteoffset < self._countbytes:
-            self._shm.lock()
+            self._beginwrite()
             if value:
                 self._pmembytes[byteoffset][0] |= (1 << (bitoffset % 8))
             else:
                 self._pmembytes[byteoffset][0] &= ~(1 << (bitoffset % 8))
             self._pmaskbytes[byteoffset][0] |= (1 << bitoffset % 8)
             self._recalcheader(byteoffset, 1)
-            self._shm.unlock()
+            self._endwrite()
         ## @endcond
 
     def getbitstring(self, bitoffset:int, bytecount:int)->str:
@@ -567,8 +905,8 @@ class _MemoryBlockBits(_MemoryBlock):
        More details. 
     """
     ## @cond
-    def __init__(self, shmid:str, count:int, id:int, byteorder, regorder:int):
-        super().__init__(shmid, (count+7)//8, id, byteorder, regorder)
+    def __init__(self, shmid:str, count:int, id:int, byteorder, regorder:int, shared:bool=False):
+        super().__init__(shmid, (count+7)//8, id, byteorder, regorder, shared)
         c = self._countbytes * 8
         self._count = count if count <= c else c
     ## @endcond
@@ -936,6 +1274,56 @@ class _MemoryBlockBits(_MemoryBlock):
         """
         self.setbitstring(bitoffset, value)
 
+    def getarray(self, bitoffset:int, count:int):
+        """
+        @note Since v0.4.4
+
+        @details
+        Function returns `count` bits starting with `bitoffset` using single memory access.
+        Result is `numpy` array of `bool` if `numpy` is installed, otherwise `memoryview` of `bool` format.
+
+        @note Array is truncated if range exceeds device memory.
+        """
+        c = min(count, self._count - bitoffset) if bitoffset >= 0 else 0
+        if c <= 0:
+            if _np is not None:
+                return _np.zeros(0, dtype=bool)
+            return memoryview(bytearray()).cast('?')
+        byteoffset = bitoffset // 8
+        shift = bitoffset % 8
+        raw = self._getbytes(byteoffset, (shift + c + 7) // 8, bytes)
+        if _np is not None:
+            bits = _np.unpackbits(_np.frombuffer(raw, dtype=_np.uint8), bitorder='little')
+            return bits[shift:shift+c].astype(bool)
+        res = bytearray(c)
+        for i in range(c):
+            j = i + shift
+            res[i] = (raw[j >> 3] >> (j & 7)) & 1
+        return memoryview(res).cast('?')
+
+    def setarray(self, bitoffset:int, values):
+        """
+        @note Since v0.4.4
+
+        @details
+        Function sets bits from `values` (`numpy` array or any sequence of `bool`/`int`)
+        starting with `bitoffset` using single memory access.
+
+        @note Values that exceed device memory are ignored.
+        """
+        c = min(len(values), self._count - bitoffset) if bitoffset >= 0 else 0
+        if c <= 0:
+            return
+        if _np is not None:
+            packed = _np.packbits(_np.asarray(values[:c], dtype=bool), bitorder='little').tobytes()
+        else:
+            ba = bytearray((c + 7) // 8)
+            for i in range(c):
+                if values[i]:
+                    ba[i >> 3] |= 1 << (i & 7)
+            packed = bytes(ba)
+        self.setbitbytes(bitoffset, c, packed)
+
 
 class _MemoryBlockRegs(_MemoryBlock):
     """Class for the register memory objects: mem3x, mem4x.
@@ -943,8 +1331,8 @@ class _MemoryBlockRegs(_MemoryBlock):
        More details. 
     """
     ## @cond
-    def __init__(self, shmid:str, count:int, id:int, byteorder, regorder:int):
-        super().__init__(shmid, count*2, id, byteorder, regorder)
+    def __init__(self, shmid:str, count:int, id:int, byteorder, regorder:int, shared:bool=False):
+        super().__init__(shmid, count*2, id, byteorder, regorder, shared)
         c = self._countbytes // 2
         self._count = count if count <= c else c
         self._pmem = cast(self._pmembytes,POINTER(c_ushort*1))
@@ -987,9 +1375,11 @@ class _MemoryBlockRegs(_MemoryBlock):
         ## @cond
         byteoffset = regoffset * 2
         if 0 <= byteoffset < self._countbytes:
-            self._shm.lock()
-            value = cast(self._pmembytes[byteoffset], POINTER(c_byte))[0]
-            self._shm.unlock()
+            while True:
+                seq = self._beginread()
+                value = cast(self._pmembytes[byteoffset], POINTER(c_byte))[0]
+                if self._endread(seq):
+                    break
             return value
         return 0
         ## @endcond
@@ -1030,9 +1420,11 @@ class _MemoryBlockRegs(_MemoryBlock):
         ## @cond
         byteoffset = regoffset * 2
         if 0 <= byteoffset < self._countbytes:
-            self._shm.lock()
-            r = self._pmembytes[byteoffset][0]
-            self._shm.unlock()
+            while True:
+                seq = self._beginread()
+                r = self._pmembytes[byteoffset][0]
+                if self._endread(seq):
+                    break
             return r
         return 0
         ## @endcond
@@ -1056,11 +1448,11 @@ class _MemoryBlockRegs(_MemoryBlock):
         ## @cond
         byteoffset = regoffset * 2
         if 0 <= byteoffset < self._countbytes:
-            self._shm.lock()
+            self._beginwrite()
             self._pmembytes [byteoffset][0] = value
             self._pmaskbytes[byteoffset][0] = 0xFF
             self._recalcheader(byteoffset, 1)
-            self._shm.unlock()
+            self._endwrite()
         ## @endcond
             
     def getint16(self, offset:int)->int:
@@ -1073,9 +1465,11 @@ class _MemoryBlockRegs(_MemoryBlock):
         @note If `offset` is out of range, function returns `0`.
         """
         if 0 <= offset < self._count:
-            self._shm.lock()
-            value = cast(self._pmem[offset], POINTER(c_short))[0]
-            self._shm.unlock()
+            while True:
+                seq = self._beginread()
+                value = cast(self._pmem[offset], POINTER(c_short))[0]
+                if self._endread(seq):
+                    break
             if self._byteorder == 'big':
                 value = struct.unpack('<h', struct.pack('>h', value))[0]
             return value
@@ -1094,11 +1488,11 @@ class _MemoryBlockRegs(_MemoryBlock):
         if 0 <= offset < self._count:
             if self._byteorder == 'big':
                 value = struct.unpack('<h', struct.pack('>h', value))[0]
-            self._shm.lock()
+            self._beginwrite()
             self._pmem [offset][0] = value
             self._pmask[offset][0] = 0xFFFF
             self._recalcheader(offset*2, 2)
-            self._shm.unlock()
+            self._endwrite()
 
     def getuint16(self, offset:int)->int:
         """
@@ -1110,9 +1504,11 @@ class _MemoryBlockRegs(_MemoryBlock):
         @note If `offset` is out of range, function returns `0`.
         """
         if 0 <= offset < self._count:
-            self._shm.lock()
-            value = self._pmem[offset][0]
-            self._shm.unlock()
+            while True:
+                seq = self._beginread()
+                value = self._pmem[offset][0]
+                if self._endread(seq):
+                    break
             if self._byteorder == 'big':
                 value = struct.unpack('<H', struct.pack('>H', value))[0]
             return value
@@ -1131,11 +1527,11 @@ class _MemoryBlockRegs(_MemoryBlock):
         if 0 <= offset < self._count:
             if self._byteorder == 'big':
                 value = struct.unpack('<H', struct.pack('>H', value))[0]
-            self._shm.lock()
+            self._beginwrite()
             self._pmem [offset][0] = value
             self._pmask[offset][0] = 0xFFFF
             self._recalcheader(offset*2, 2)
-            self._shm.unlock()
+            self._endwrite()
 
     def getint32(self, offset:int)->int:
         """
@@ -1147,9 +1543,11 @@ class _MemoryBlockRegs(_MemoryBlock):
         @note If `offset` is out of range, function returns `0`.
         """
         if 0 <= offset < self._count-1:
-            self._shm.lock()
-            value = int(cast(self._pmem[offset], POINTER(c_int))[0])
-            self._shm.unlock()
+            while True:
+                seq = self._beginread()
+                value = int(cast(self._pmem[offset], POINTER(c_int))[0])
+                if self._endread(seq):
+                    break
             if not (self._byteorder == MB_BYTEORDER_DEFAULT and self._registerorder == MB_REGISTERORDER_R0R1R2R3):
                 b = self.swap32(value.to_bytes(4, MB_BYTEORDER_DEFAULT, signed=True))
                 value = int.from_bytes(b, byteorder=MB_BYTEORDER_DEFAULT, signed=True)
@@ -1170,11 +1568,11 @@ class _MemoryBlockRegs(_MemoryBlock):
             if not (self._byteorder == MB_BYTEORDER_DEFAULT and self._registerorder == MB_REGISTERORDER_R0R1R2R3):
                 b = self.swap32(value.to_bytes(4, MB_BYTEORDER_DEFAULT, signed=True))
                 value = int.from_bytes(b, byteorder=MB_BYTEORDER_DEFAULT, signed=True)
-            self._shm.lock()
+            self._beginwrite()
             cast(self._pmem [offset], POINTER(c_int))[0] = value
             cast(self._pmask[offset], POINTER(c_int))[0] = 0xFFFFFFFF
             self._recalcheader(offset*2, 4)
-            self._shm.unlock()
+            self._endwrite()
 
     def getuint32(self, offset:int)->int:
         """
@@ -1186,9 +1584,11 @@ class _MemoryBlockRegs(_MemoryBlock):
         @note If `offset` is out of range, function returns `0`.
         """
         if 0 <= offset < self._count-1:
-            self._shm.lock()
-            value = int(cast(self._pmem[offset], POINTER(c_uint))[0])
-            self._shm.unlock()
+            while True:
+                seq = self._beginread()
+                value = int(cast(self._pmem[offset], POINTER(c_uint))[0])
+                if self._endread(seq):
+                    break
             if not (self._byteorder == MB_BYTEORDER_DEFAULT and self._registerorder == MB_REGISTERORDER_R0R1R2R3):
                 b = self.swap32(value.to_bytes(4, MB_BYTEORDER_DEFAULT, signed=False))
                 value = int.from_bytes(b, byteorder=MB_BYTEORDER_DEFAULT, signed=False)
@@ -1209,11 +1609,11 @@ class _MemoryBlockRegs(_MemoryBlock):
             if not (self._byteorder == MB_BYTEORDER_DEFAULT and self._registerorder == MB_REGISTERORDER_R0R1R2R3):
                 b = self.swap32(value.to_bytes(4, MB_BYTEORDER_DEFAULT, signed=False))
                 value = int.from_bytes(b, byteorder=MB_BYTEORDER_DEFAULT, signed=False)
-            self._shm.lock()
+            self._beginwrite()
             cast(self._pmem [offset], POINTER(c_uint))[0] = value
             cast(self._pmask[offset], POINTER(c_uint))[0] = 0xFFFFFFFF
             self._recalcheader(offset*2, 4)
-            self._shm.unlock()
+            self._endwrite()
 
     def getint64(self, offset:int)->int:
         """
@@ -1226,9 +1626,11 @@ class _MemoryBlockRegs(_MemoryBlock):
         @note If `offset` is out of range, function returns `0`.
         """
         if 0 <= offset < self._count-3:
-            self._shm.lock()
-            value = int(cast(self._pmem[offset], POINTER(c_longlong))[0])
-            self._shm.unlock()
+            while True:
+                seq = self._beginread()
+                value = int(cast(self._pmem[offset], POINTER(c_longlong))[0])
+                if self._endread(seq):
+                    break
             if not (self._byteorder == MB_BYTEORDER_DEFAULT and self._registerorder == MB_REGISTERORDER_R0R1R2R3):
                 b = self.swap64(value.to_bytes(8, MB_BYTEORDER_DEFAULT, signed=True))
                 value = int.from_bytes(b, byteorder=MB_BYTEORDER_DEFAULT, signed=True)
@@ -1250,11 +1652,11 @@ class _MemoryBlockRegs(_MemoryBlock):
             if not (self._byteorder == MB_BYTEORDER_DEFAULT and self._registerorder == MB_REGISTERORDER_R0R1R2R3):
                 b = self.swap64(value.to_bytes(8, MB_BYTEORDER_DEFAULT, signed=True))
                 value = int.from_bytes(b, byteorder=MB_BYTEORDER_DEFAULT, signed=True)
-            self._shm.lock()
+            self._beginwrite()
             cast(self._pmem [offset], POINTER(c_longlong))[0] = value
             cast(self._pmask[offset], POINTER(c_longlong))[0] = 0xFFFFFFFFFFFFFFFF
             self._recalcheader(offset*2, 8)
-            self._shm.unlock()
+            self._endwrite()
 
     def getuint64(self, offset:int)->int:
         """
@@ -1267,9 +1669,11 @@ class _MemoryBlockRegs(_MemoryBlock):
         @note If `offset` is out of range, function returns `0`.
         """
         if 0 <= offset < self._count-3:
-            self._shm.lock()
-            value = int(cast(self._pmem[offset], POINTER(c_ulonglong))[0])
-            self._shm.unlock()
+            while True:
+                seq = self._beginread()
+                value = int(cast(self._pmem[offset], POINTER(c_ulonglong))[0])
+                if self._endread(seq):
+                    break
             if not (self._byteorder == MB_BYTEORDER_DEFAULT and self._registerorder == MB_REGISTERORDER_R0R1R2R3):
                 b = self.swap64(value.to_bytes(8, MB_BYTEORDER_DEFAULT, signed=False))
                 value = int.from_bytes(b, byteorder=MB_BYTEORDER_DEFAULT, signed=False)
@@ -1291,11 +1695,11 @@ class _MemoryBlockRegs(_MemoryBlock):
             if not (self._byteorder == MB_BYTEORDER_DEFAULT and self._registerorder == MB_REGISTERORDER_R0R1R2R3):
                 b = self.swap64(value.to_bytes(8, MB_BYTEORDER_DEFAULT, signed=False))
                 value = int.from_bytes(b, byteorder=MB_BYTEORDER_DEFAULT, signed=False)
-            self._shm.lock()
+            self._beginwrite()
             cast(self._pmem [offset], POINTER(c_ulonglong))[0] = value
             cast(self._pmask[offset], POINTER(c_ulonglong))[0] = 0xFFFFFFFFFFFFFFFF
             self._recalcheader(offset*2, 8)
-            self._shm.unlock()
+            self._endwrite()
 
     def getfloat(self, offset:int)->int:
         """
@@ -1307,9 +1711,11 @@ class _MemoryBlockRegs(_MemoryBlock):
         @note If `offset` is out of range, function returns `0`.
         """
         if 0 <= offset < self._count-1:
-            self._shm.lock()
-            value = float(cast(self._pmem[offset], POINTER(c_float))[0])
-            self._shm.unlock()
+            while True:
+                seq = self._beginread()
+                value = float(cast(self._pmem[offset], POINTER(c_float))[0])
+                if self._endread(seq):
+                    break
             if not (self._byteorder == MB_BYTEORDER_DEFAULT and self._registerorder == MB_REGISTERORDER_R0R1R2R3):
                 b = self.swap32(struct.pack('<f', value))
                 value = struct.unpack('<f', b)[0]
@@ -1330,11 +1736,11 @@ class _MemoryBlockRegs(_MemoryBlock):
             if not (self._byteorder == MB_BYTEORDER_DEFAULT and self._registerorder == MB_REGISTERORDER_R0R1R2R3):
                 b = self.swap32(struct.pack('<f', value))
                 value = struct.unpack('<f', b)[0]
-            self._shm.lock()
+            self._beginwrite()
             cast(self._pmem [offset], POINTER(c_float))[0] = value
             cast(self._pmask[offset], POINTER(c_uint))[0] = 0xFFFFFFFF
             self._recalcheader(offset*2, 4)
-            self._shm.unlock()
+            self._endwrite()
 
     def getdouble(self, offset:int)->int:
         """
@@ -1346,9 +1752,11 @@ class _MemoryBlockRegs(_MemoryBlock):
         @note If `offset` is out of range, function returns `0`.
         """
         if 0 <= offset < self._count-3:
-            self._shm.lock()
-            value = float(cast(self._pmem[offset], POINTER(c_double))[0])
-            self._shm.unlock()
+            while True:
+                seq = self._beginread()
+                value = float(cast(self._pmem[offset], POINTER(c_double))[0])
+                if self._endread(seq):
+                    break
             if not (self._byteorder == MB_BYTEORDER_DEFAULT and self._registerorder == MB_REGISTERORDER_R0R1R2R3):
                 b = self.swap64(struct.pack('<d', value))
                 value = struct.unpack('<d', b)[0]
@@ -1369,11 +1777,11 @@ class _MemoryBlockRegs(_MemoryBlock):
             if not (self._byteorder == MB_BYTEORDER_DEFAULT and self._registerorder == MB_REGISTERORDER_R0R1R2R3):
                 b = self.swap64(struct.pack('<d', value))
                 value = struct.unpack('<d', b)[0]
-            self._shm.lock()
+            self._beginwrite()
             cast(self._pmem [offset], POINTER(c_double))[0] = value
             cast(self._pmask[offset], POINTER(c_ulonglong))[0] = 0xFFFFFFFFFFFFFFFF
             self._recalcheader(offset*2, 8)
-            self._shm.unlock()
+            self._endwrite()
 
     def getstring(self, regoffset:int, bytecount:int)->str:
         """
@@ -1397,6 +1805,58 @@ class _MemoryBlockRegs(_MemoryBlock):
         """
         self.setregstring(regoffset, value)
 
+    def getarray(self, offset:int, count:int, dtype='uint16'):
+        """
+        @note Since v0.4.4
+
+        @details
+        Function returns `count` values of type `dtype` starting with register `offset`
+        using single memory access. Device byte order and register order are applied like for
+        single-value functions (`getint32()`, `getfloat()` etc).
+        Result is `numpy` array if `numpy` is installed, otherwise `memoryview` of corresponding format.
+
+        @param[in]  offset  Offset of the first register (0-based).
+        @param[in]  count   Count of values (not registers) to read.
+        @param[in]  dtype   Type of values: 'int16', 'uint16', 'int32', 'uint32', 'int64', 'uint64',
+                            'float32' ('float'), 'float64' ('double') or equivalent `numpy` type.
+
+        @note Array is truncated if range exceeds device memory.
+        """
+        fmt, npfmt, regs = _mbarraytype(dtype)
+        c = min(count, (self._count - offset) // regs) if offset >= 0 else 0
+        if c <= 0:
+            if _np is not None:
+                return _np.zeros(0, dtype=npfmt)
+            return memoryview(bytearray()).cast(fmt)
+        ba = self._reorder(self._getbytes(offset*2, c*regs*2, bytearray), regs)
+        if _np is not None:
+            return _np.frombuffer(ba, dtype=npfmt)
+        return memoryview(ba).cast(fmt)
+
+    def setarray(self, offset:int, values, dtype=None):
+        """
+        @note Since v0.4.4
+
+        @details
+        Function sets `values` (`numpy` array or any sequence of numbers) starting with register `offset`
+        using single memory access and single change mask update.
+        If `dtype` is `None` then type of `numpy` array is used or 'uint16' for other sequences.
+        Parameters are the same as `getarray()` function.
+
+        @note Values that exceed device memory are ignored.
+        """
+        if dtype is None:
+            dtype = values.dtype if hasattr(values, 'dtype') else 'uint16'
+        fmt, npfmt, regs = _mbarraytype(dtype)
+        c = min(len(values), (self._count - offset) // regs) if offset >= 0 else 0
+        if c <= 0:
+            return
+        if _np is not None:
+            ba = bytearray(_np.asarray(values[:c]).astype(npfmt).tobytes())
+        else:
+            ba = bytearray(struct.pack(f'<{c}{fmt}', *values[:c]))
+        self.setbytes(offset*2, self._reorder(ba, regs))
+
 
 class _MbDevice:
     """Class for access device parameters.
@@ -1414,7 +1874,8 @@ class _MbDevice:
         shmid_mem1x  = shmidprefix + ".mem1x"
         shmid_mem3x  = shmidprefix + ".mem3x"
         shmid_mem4x  = shmidprefix + ".mem4x"
-        shm = QSharedMemory(shmid_device)
+        shmid_notify = shmidprefix + ".notify"
+        shm = _mbsharedmemory(shmid_device)
         res = shm.attach()
         if not res:
             raise RuntimeError(f"Cannot attach to Shared Memory with id = '{shmid_device}'")
@@ -1434,16 +1895,20 @@ class _MbDevice:
         self._byteorder     = int(self._control.byteOrder)
         self._registerorder = int(self._control.registerOrder)
         self._strtablesize  = int(self._control.stringTableSize)
+        flags = int(self._control.flags)
+        shared = (flags & _MB_DEVICEFLAG_SHAREDMEMORY) != 0
         stoDeviceName = int(self._control.stoDeviceName)
         self._pmemstrtable = cast(byref(pcontrol[1]),POINTER(c_ubyte*1))
         self._name = self._getstring(stoDeviceName)
         self._shm.unlock()
         # submodules
         self._python = _MemoryPythonBlock(shmid_python)
-        self._mem0x  = _MemoryBlockBits(shmid_mem0x, self._count0x, 0, self._byteorder, self._registerorder)
-        self._mem1x  = _MemoryBlockBits(shmid_mem1x, self._count1x, 1, self._byteorder, self._registerorder)
-        self._mem3x  = _MemoryBlockRegs(shmid_mem3x, self._count3x, 3, self._byteorder, self._registerorder)
-        self._mem4x  = _MemoryBlockRegs(shmid_mem4x, self._count4x, 4, self._byteorder, self._registerorder)
+        if flags & _MB_DEVICEFLAG_SHAREDMEMORYOFFER:
+            shared = self._answersharedmemory()
+        self._mem0x  = _MemoryBlockBits(shmid_mem0x, self._count0x, 0, self._byteorder, self._registerorder, shared)
+        self._mem1x  = _MemoryBlockBits(shmid_mem1x, self._count1x, 1, self._byteorder, self._registerorder, shared)
+        self._mem3x  = _MemoryBlockRegs(shmid_mem3x, self._count3x, 3, self._byteorder, self._registerorder, shared)
+        self._mem4x  = _MemoryBlockRegs(shmid_mem4x, self._count4x, 4, self._byteorder, self._registerorder, shared)
         self._memdict = { modbus.Memory_0x: self._mem0x,
                           modbus.Memory_1x: self._mem1x,
                           modbus.Memory_3x: self._mem3x,
@@ -1455,6 +1920,12 @@ class _MbDevice:
         if self._excmem is None:
             self._excmem = self._mem0x
             self._excoffset = 0
+        # Change notifications
+        self._notify = _MemoryNotifyBlock(shmid_notify)
+        self._waittail = self._notify.gethead()
+        self._subtail = self._waittail
+        self._subscriptions = {}
+        self._subid = 0
 
     def __del__(self):
         try:
@@ -1462,6 +1933,25 @@ class _MbDevice:
         except RuntimeError:
             pass
     
+    # Note: shared memory is accepted only when atomic compare-and-swap is available for writer lock
+    #       of memory block header, otherwise server keeps copying memory
+    def _answersharedmemory(self)->bool:
+        global _mbcas32
+        if _mbcas32 is None:
+            _mbcas32 = _mbloadcas32()
+        self._python.setflags(_MB_PYTHONFLAG_COPYMEMORY if _mbcas32 is None else _MB_PYTHONFLAG_SHAREDMEMORY)
+        deadline = _time.monotonic() + _MB_SHAREDMEMORY_TIMEOUT
+        while True:
+            self._shm.lock()
+            flags = int(self._control.flags)
+            self._shm.unlock()
+            if not (flags & _MB_DEVICEFLAG_SHAREDMEMORYOFFER) or not (flags & _MB_DEVICEFLAG_RUN):
+                break
+            if _time.monotonic() >= deadline:
+                raise RuntimeError(f"Server did not answer for shared memory of device '{self._name}'")
+            _time.sleep(0.001)
+        return (flags & _MB_DEVICEFLAG_SHAREDMEMORY) != 0
+
     def _getstring(self, offset:int)->str:
         c = 0
         while self._pmemstrtable[offset+c][0] != 0:
@@ -1609,8 +2099,115 @@ class _MbDevice:
     ## @cond
     def _incpycycle(self):
         return self._python.incpycycle()
+
+    def _setfinished(self):
+        self._python.setflags(_MB_PYTHONFLAG_FINISHED)
+
+    def _endloop(self, start:float, deadline:float, period:float)->float:
+        # Returns next deadline of 'Loop'-script (all values are 'time.monotonic()'-based seconds)
+        now = _time.monotonic()
+        overrun = False
+        if period > 0:
+            deadline += period
+            if deadline <= now:
+                overrun = True
+                # skip periods that were missed but keep the phase of schedule
+                deadline += ((now - deadline) // period + 1) * period
+        else:
+            deadline = now
+        self._python.setlooptime(int((now - start) * 1000000), overrun)
+        return deadline
+
+    def _memunits(self, mem:int, byteoffset:int, bytecount:int):
+        memobj = self._memdict[mem]
+        if bytecount == _MB_NOTIFY_WHOLEMEMORY:
+            byteoffset = 0
+            bytecount = memobj._countbytes
+        if mem in (modbus.Memory_0x, modbus.Memory_1x):
+            return (byteoffset * 8, bytecount * 8)
+        return (byteoffset // 2, bytecount // 2)
+
+    def _dispatch(self):
+        self._subtail, records = self._notify.take(self._subtail)
+        if not self._subscriptions:
+            return
+        for rec in records:
+            mem = rec[0]
+            if mem not in self._memdict:
+                continue
+            offset, count = self._memunits(*rec)
+            for (submem, suboffset, subcount, callback) in list(self._subscriptions.values()):
+                if submem == mem and offset < suboffset + subcount and suboffset < offset + count:
+                    callback(mem, offset, count)
+
+    def _idle(self, timeout:float):
+        deadline = _time.monotonic() + timeout
+        while self._control.flags & _MB_DEVICEFLAG_RUN:
+            wakecounter = self._notify.getwakecounter()
+            self._dispatch()
+            remaining = deadline - _time.monotonic()
+            if remaining <= 0:
+                break
+            self._notify.wait(wakecounter, remaining)
     ## @endcond
 
+    def wait_for_change(self, mem=None, timeout:float=None)->bool:
+        """
+        @note Since v0.4.4
+
+        @details Blocks until Modbus master changes memory of the device or `timeout` expires.
+        Callbacks of subscriptions (see `subscribe`) are called for every change found while waiting.
+
+        @param[in]  mem     memory type to wait for (`modbus.Memory_0x`, `modbus.Memory_1x`,
+                            `modbus.Memory_3x`, `modbus.Memory_4x`) or `None` for any memory
+        @param[in]  timeout timeout in seconds or `None` to wait infinitely
+
+        @return `True` if memory was changed, `False` if timeout expired or device is stopping
+        """
+        deadline = None if timeout is None else _time.monotonic() + timeout
+        while True:
+            wakecounter = self._notify.getwakecounter()
+            self._dispatch()
+            self._waittail, records = self._notify.take(self._waittail)
+            for rec in records:
+                if mem is None or rec[0] == mem:
+                    return True
+            if not (self._control.flags & _MB_DEVICEFLAG_RUN):
+                return False
+            remaining = None
+            if deadline is not None:
+                remaining = deadline - _time.monotonic()
+                if remaining <= 0:
+                    return False
+            self._notify.wait(wakecounter, remaining)
+
+    def subscribe(self, mem:int, offset:int, count:int, callback)->int:
+        """
+        @note Since v0.4.4
+
+        @details Subscribes `callback` for changes of memory `mem` made by Modbus master within range
+        [`offset`, `offset+count`). Offset and count are measured in bits for `0x`, `1x`
+        and in registers for `3x`, `4x` memory.
+        Callback is called from the script loop (during its idle time) or from `wait_for_change`
+        with signature `callback(mem, offset, count)` where `offset` and `count` define changed range
+        (for bit memory range is aligned to bytes).
+
+        @return Identifier of subscription that can be used with `unsubscribe`
+        """
+        if mem not in self._memdict:
+            raise ValueError(f"Invalid memory type '{mem}'")
+        self._subid += 1
+        self._subscriptions[self._subid] = (mem, offset, count, callback)
+        return self._subid
+
+    def unsubscribe(self, subid:int):
+        """
+        @note Since v0.4.4
+
+        @details Removes subscription with identifier `subid` returned by `subscribe`.
+        """
+        self._subscriptions.pop(subid, None)
+
     def getmem0x(self)->_MemoryBlockBits:
         """
         @details Returns object that provide access to device `0x` memory.
@@ -1892,7 +2489,7 @@ class _MbDevice:
 ## @cond
 class _MemoryPythonBlock:
     def __init__(self, shmid:str):
-        shm = QSharedMemory(shmid)
+        shm = _mbsharedmemory(shmid)
         res = shm.attach()
         if not res:
             raise RuntimeError(f"Cannot attach to Shared Memory with id = '{shmid}'")
@@ -1922,5 +2519,109 @@ class _MemoryPythonBlock:
         self._shm.lock()
         self._control.pycycle = self._cyclecounter
         self._shm.unlock()
+
+    def setflags(self, flags:int):
+        self._shm.lock()
+        self._control.flags |= flags
+        self._shm.unlock()
+
+    def setlooptime(self, us:int, overrun:bool):
+        # Note: same calculation is made by server side (see 'mbServerRunScriptThread::updateLoopTime')
+        us = min(us, 0xFFFFFFFF)
+        self._cyclecounter += 1
+        self._shm.lock()
+        c = self._control
+        c.loopTimeLast = us
+        if self._cyclecounter == 1:
+            c.loopTimeAvg = us
+        else:
+            avg = c.loopTimeAvg
+            c.loopTimeAvg = avg + int((us - avg) / 16)
+        if us > c.loopTimeMax:
+            c.loopTimeMax = us
+        if overrun:
+            c.loopOverruns += 1
+        c.pycycle = self._cyclecounter
+        self._shm.unlock()
+
+
+class _MemoryNotifyBlock:
+    def __init__(self, shmid:str):
+        shm = _mbsharedmemory(shmid)
+        res = shm.attach()
+        if not res:
+            raise RuntimeError(f"Cannot attach to Shared Memory with id = '{shmid}'")
+        qptr = shm.data()
+        memptr = c_void_p(qptr.__int__())
+        pcontrol = cast(memptr, POINTER(CNotifyBlock))
+        self._shm = shm
+        self._pcontrol = pcontrol
+        self._control = pcontrol.contents
+        self._ringsize = int(self._control.ringSize)
+        self._ring = cast(byref(pcontrol[1]), POINTER(CNotifyRecord))
+        self._futex = None
+        if _sys.platform.startswith('linux'):
+            nr = _MB_SYS_FUTEX.get(_platform.machine().lower())
+            if nr is not None:
+                try:
+                    self._libc = CDLL(None, use_errno=True)
+                    self._futexnr = nr
+                    self._futex = self._libc.syscall
+                except (OSError, AttributeError):
+                    self._futex = None
+
+    def __del__(self):
+        try:
+            self._shm.detach()
+        except RuntimeError:
+            pass
+
+    def gethead(self)->int:
+        return int(self._control.head)
+
+    def getwakecounter(self)->int:
+        return int(self._control.wakeCounter)
+
+    def wait(self, wakecounter:int, timeout:float=None):
+        """Waits until 'wakeCounter' differs from `wakecounter` or `timeout` (seconds) expires"""
+        if self._futex is not None:
+            ts = None
+            if timeout is not None:
+                ts = _CTimespec(int(timeout), int((timeout - int(timeout)) * 1e9))
+            self._futex(c_long(self._futexnr), byref(self._control, CNotifyBlock.wakeCounter.offset),
+                        c_int(_MB_FUTEX_WAIT), c_uint(wakecounter),
+                        byref(ts) if ts is not None else None, None, c_int(0))
+            return
+        # Note: no futex on this platform, so poll the counter
+        deadline = None if timeout is None else _time.monotonic() + timeout
+        while self._control.wakeCounter == wakecounter:
+            if deadline is None:
+                _time.sleep(0.001)
+                continue
+            remaining = deadline - _time.monotonic()
+            if remaining <= 0:
+                break
+            _time.sleep(min(remaining, 0.001))
+
+    def take(self, tail:int):
+        """Returns tuple of new tail and list of records (memory, byteoffset, bytecount) published after `tail`"""
+        head = int(self._control.head)
+        count = (head - tail) & 0xFFFFFFFF
+        if count == 0:
+            return (tail, [])
+        full = [ (m, 0, _MB_NOTIFY_WHOLEMEMORY) for m in (modbus.Memory_0x, modbus.Memory_1x, modbus.Memory_3x, modbus.Memory_4x) ]
+        if count > self._ringsize:
+            return (head, full) # records were overwritten
+        res = []
+        for i in range(tail, tail + count):
+            seq = (i + 1) & 0xFFFFFFFF
+            rec = self._ring[i % self._ringsize]
+            if rec.sequence != seq:
+                return (head, full)
+            r = (int(rec.memory), int(rec.byteOffset), int(rec.byteCount))
+            if rec.sequence != seq: # record was overwritten while reading
+                return (head, full)
+            res.append(r)
+        return (head, res)
 ## @endcond
 
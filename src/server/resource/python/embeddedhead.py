@@ -0,0 +1,34 @@
+# Program header for embedded interpreter: variables '_mb_*' are set by server
+# before execution (see 'mbServerRunScriptEmbedded')
+
+from os import sys, path
+from time import sleep, time
+
+for _p in _mb_importpath:
+    if _p and (_p not in sys.path):
+        sys.path.append(_p)
+
+import _mbembedded
+
+class _MbOutput:
+    _mbembedded = True
+    def write(self, text):
+        _mbembedded.output(text)
+    def flush(self):
+        pass
+
+if not getattr(sys.stdout, '_mbembedded', False):
+    sys.stdout = _MbOutput()
+    sys.stderr = sys.stdout
+
+from mbserver import _MbDevice, _mbsetlocalmemory
+
+_mbsetlocalmemory(_mb_localmemory)
+mbdevice = _MbDevice(_mb_memid, _mb_project)
+mem0x = mbdevice.getmem0x()
+mem1x = mbdevice.getmem1x()
+mem3x = mbdevice.getmem3x()
+mem4x = mbdevice.getmem4x()
+
+_mb_time_period = _mb_period / 1000
+
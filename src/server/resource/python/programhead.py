@@ -9,6 +9,7 @@ _parser.add_argument('-prj', '--project', type=str, default="")
 _parser.add_argument('-imp', '--importpath', type=str, default="")
 _parser.add_argument('-i', '--memid' , type=str, default="")
 _parser.add_argument('-p', '--period' , type=int, default=100)
+_parser.add_argument('-a', '--arena' , type=str, default="")
 _args = _parser.parse_args()
 
 _pathList = _args.importpath.split(";")
@@ -16,8 +17,9 @@ _pathList = _args.importpath.split(";")
 sys.path.insert(0, path.normpath(path.dirname(path.abspath(__file__))))
 sys.path.extend(_pathList)
 
-from mbserver import _MbDevice
+from mbserver import _MbDevice, _mbsetarena
 
+_mbsetarena(_args.arena)
 mbdevice = _MbDevice(_args.memid, _args.project)
 mem0x = mbdevice.getmem0x()
 mem1x = mbdevice.getmem1x()
@@ -0,0 +1,123 @@
+#!/usr/bin/python
+# Worker program that hosts scripts of several devices (see 'mbServerRunScriptWorker').
+# Loop-scripts are scheduled cooperatively against their periods, so blocking calls
+# inside one script (e.g. 'sleep()') delay scripts of other devices of the same worker.
+
+from os import sys, path
+from time import sleep, time, monotonic
+import argparse
+import heapq
+import json
+import traceback
+
+_parser = argparse.ArgumentParser()
+_parser.add_argument('-prj', '--project', type=str, default="")
+_parser.add_argument('-imp', '--importpath', type=str, default="")
+_parser.add_argument('-m', '--manifest', type=str, default="")
+_args = _parser.parse_args()
+
+_pathList = _args.importpath.split(";")
+
+sys.path.insert(0, path.normpath(path.dirname(path.abspath(__file__))))
+sys.path.extend(_pathList)
+
+from mbserver import _MbDevice, _mbsetarena
+
+_MB_CHECK_PERIOD = 0.1 # period (sec) to check stop request for all devices
+
+
+class _MbHostedDevice:
+    def __init__(self, cfg:dict):
+        self.name = cfg['name']
+        self.period = cfg['period'] / 1000
+        self.mbdevice = _MbDevice(cfg['memid'], _args.project)
+        self.ns = { '__name__'        : '__main__',
+                    '__builtins__'    : __builtins__,
+                    'sleep'           : sleep,
+                    'time'            : time,
+                    'mbdevice'        : self.mbdevice,
+                    'mem0x'           : self.mbdevice.getmem0x(),
+                    'mem1x'           : self.mbdevice.getmem1x(),
+                    'mem3x'           : self.mbdevice.getmem3x(),
+                    'mem4x'           : self.mbdevice.getmem4x(),
+                    '_mb_time_period' : self.period }
+        self.init  = compile(cfg['init' ], f"<{self.name}:init>" , 'exec')
+        self.loop  = compile(cfg['loop' ], f"<{self.name}:loop>" , 'exec')
+        self.final = compile(cfg['final'], f"<{self.name}:final>", 'exec')
+        self.deadline = 0.0
+
+    def isrunning(self)->bool:
+        return (self.mbdevice.getflags() & 1) != 0
+
+    def exec(self, code)->bool:
+        try:
+            exec(code, self.ns)
+            return True
+        except SystemExit:
+            return False
+        except Exception:
+            print(f"Script of device '{self.name}' is stopped because of error:")
+            traceback.print_exc(file=sys.stdout)
+            return False
+
+    def finish(self, final:bool=True):
+        if final:
+            self.exec(self.final)
+        self.mbdevice._setfinished()
+
+
+def _load(manifest:str)->list:
+    with open(manifest, 'r', encoding='utf-8') as f:
+        root = json.load(f)
+    _mbsetarena(root.get('arena', ""))
+    cfgs = root['devices']
+    res = []
+    for cfg in cfgs:
+        try:
+            d = _MbHostedDevice(cfg)
+        except Exception:
+            print(f"Can't load script of device '{cfg.get('name')}':")
+            traceback.print_exc(file=sys.stdout)
+            continue
+        if d.exec(d.init):
+            d.deadline = monotonic()
+            res.append(d)
+        else:
+            d.finish(False)
+    return res
+
+
+_devices = _load(_args.manifest)
+_queue = [ (d.deadline, i) for i, d in enumerate(_devices) ]
+heapq.heapify(_queue)
+_lastcheck = monotonic()
+while _queue:
+    now = monotonic()
+    if now - _lastcheck >= _MB_CHECK_PERIOD:
+        _lastcheck = now
+        stopped = [ e for e in _queue if not _devices[e[1]].isrunning() ]
+        if stopped:
+            for e in stopped:
+                _devices[e[1]].finish()
+            _queue = [ e for e in _queue if e not in stopped ]
+            heapq.heapify(_queue)
+            continue
+    deadline, i = _queue[0]
+    if deadline > now:
+        sleep(min(deadline, _lastcheck + _MB_CHECK_PERIOD) - now)
+        continue
+    heapq.heappop(_queue)
+    d = _devices[i]
+    if not d.isrunning():
+        d.finish()
+        continue
+    start = monotonic()
+    if not d.exec(d.loop):
+        d.finish(False)
+        continue
+    if d.ns.get('_mb_loop_break'): # 'break' statement of loop-script stops it (see 'getScriptLoopBody()')
+        d.finish()
+        continue
+    d.deadline = d.mbdevice._endloop(start, d.deadline, d.period)
+    heapq.heappush(_queue, (d.deadline, i))
+
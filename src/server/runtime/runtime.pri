@@ -1,17 +1,38 @@
 HEADERS +=                              \
     $$PWD/server_portrunnable.h         \
     $$PWD/server_rundevice.h            \
+    $$PWD/server_runscriptarena.h       \
+    $$PWD/server_runscriptembedded.h    \
+    $$PWD/server_runscriptnotify.h      \
     $$PWD/server_runscriptthread.h      \
+    $$PWD/server_runscriptworker.h      \
     $$PWD/server_runsimaction.h         \
     $$PWD/server_runsimactiontask.h     \
+    $$PWD/server_runsimexpression.h     \
+    $$PWD/server_runsimtrace.h          \
+    $$PWD/server_runstatistic.h         \
     $$PWD/server_runthread.h            \
     $$PWD/server_runtime.h
 
 SOURCES +=                              \
     $$PWD/server_portrunnable.cpp       \
     $$PWD/server_rundevice.cpp          \
+    $$PWD/server_runscriptarena.cpp     \
+    $$PWD/server_runscriptembedded.cpp  \
+    $$PWD/server_runscriptnotify.cpp    \
     $$PWD/server_runscriptthread.cpp    \
+    $$PWD/server_runscriptworker.cpp    \
     $$PWD/server_runsimaction.cpp       \
     $$PWD/server_runsimactiontask.cpp   \
+    $$PWD/server_runsimexpression.cpp   \
+    $$PWD/server_runsimtrace.cpp        \
+    $$PWD/server_runstatistic.cpp       \
     $$PWD/server_runthread.cpp          \
     $$PWD/server_runtime.cpp
+
+# Embedded Python interpreter for device scripts: qmake CONFIG+=mb_embedded_python
+mb_embedded_python {
+    DEFINES += MB_EMBEDDED_PYTHON
+    CONFIG += link_pkgconfig
+    PKGCONFIG += python3-embed
+}
@@ -26,6 +26,8 @@
 #include <ModbusTcpServer.h>
 
 #include <server.h>
+#include <runtime/core_capture.h>
+#include <runtime/core_runtime.h>
 
 #include <project/server_port.h>
 
@@ -39,6 +41,7 @@ mbServerPortRunnable::mbServerPortRunnable(mbServerPort *serverPort, const Modbu
     m_device = device;
     m_modbusPort = Modbus::createServerPort(device, settings);
     m_modbusPort->setBroadcastEnabled(serverPort->isBroadcastEnabled());
+    m_runStat.setType(m_modbusPort->type());
 
     // units map
     uint8_t unitmap[MB_UNITMAP_SIZE];
@@ -71,6 +74,9 @@ mbServerPortRunnable::mbServerPortRunnable(mbServerPort *serverPort, const Modbu
     QString name = settings.value(mbServerPort::Strings::instance().name).toString();
     m_modbusPort->setObjectName(name.toUtf8().constData());
     setName(name);
+
+    mbCoreCapture *capture = mbCore::globalCore()->coreRuntime()->capture();
+    m_capture = capture ? capture->createChannel(name, m_modbusPort->type(), true) : nullptr;
 }
 
 mbServerPortRunnable::~mbServerPortRunnable()
@@ -84,9 +90,16 @@ void mbServerPortRunnable::setName(const QString &name)
     setObjectName(name);
 }
 
+bool mbServerPortRunnable::isOpen() const
+{
+    return m_modbusPort->isOpen();
+}
+
 void mbServerPortRunnable::run()
 {
     m_modbusPort->process();
+    if (m_runStat.isPublishTime())
+        m_serverPort->setRunStatistic(m_runStat.snapshot());
 }
 
 void mbServerPortRunnable::close()
@@ -97,11 +110,15 @@ void mbServerPortRunnable::close()
         m_modbusPort->process();
         QThread::yieldCurrentThread();
     }
+    m_serverPort->setRunStatistic(m_runStat.snapshot());
 }
 
 void mbServerPortRunnable::slotBytesTx(const Modbus::Char *source, const uint8_t* buff, uint16_t size)
 {
     mbServer::LogTx(source, Modbus::bytesToString(buff, size).data());
+    if (m_capture)
+        m_capture->capture(mbCoreCaptureChannel::Tx, buff, size, source);
+    m_runStat.tx(source, buff, size);
     m_stat.countTx++;
     m_serverPort->setStatCountTx(m_stat.countTx);
 }
@@ -109,6 +126,9 @@ void mbServerPortRunnable::slotBytesTx(const Modbus::Char *source, const uint8_t
 void mbServerPortRunnable::slotBytesRx(const Modbus::Char *source, const uint8_t* buff, uint16_t size)
 {
     mbServer::LogRx(source, Modbus::bytesToString(buff, size).data());
+    if (m_capture)
+        m_capture->capture(mbCoreCaptureChannel::Rx, buff, size, source);
+    m_runStat.rx(source, buff, size);
     m_stat.countRx++;
     m_serverPort->setStatCountRx(m_stat.countRx);
 }
@@ -116,6 +136,9 @@ void mbServerPortRunnable::slotBytesRx(const Modbus::Char *source, const uint8_t
 void mbServerPortRunnable::slotAsciiTx(const Modbus::Char *source, const uint8_t* buff, uint16_t size)
 {
     mbServer::LogTx(source, Modbus::asciiToString(buff, size).data());
+    if (m_capture)
+        m_capture->capture(mbCoreCaptureChannel::Tx, buff, size, source);
+    m_runStat.tx(source, buff, size);
     m_stat.countTx++;
     m_serverPort->setStatCountTx(m_stat.countTx);
 }
@@ -123,6 +146,9 @@ void mbServerPortRunnable::slotAsciiTx(const Modbus::Char *source, const uint8_t
 void mbServerPortRunnable::slotAsciiRx(const Modbus::Char *source, const uint8_t* buff, uint16_t size)
 {
     mbServer::LogRx(source, Modbus::asciiToString(buff, size).data());
+    if (m_capture)
+        m_capture->capture(mbCoreCaptureChannel::Rx, buff, size, source);
+    m_runStat.rx(source, buff, size);
     m_stat.countRx++;
     m_serverPort->setStatCountRx(m_stat.countRx);
 }
@@ -136,10 +162,12 @@ void mbServerPortRunnable::slotError(const Modbus::Char *source, Modbus::StatusC
 void mbServerPortRunnable::slotNewConnection(const Modbus::Char *source)
 {
     mbServer::LogInfo(name(), QStringLiteral("New Connection: ") + source);
+    m_runStat.connectionOpened(source);
 }
 
 void mbServerPortRunnable::slotCloseConnection(const Modbus::Char *source)
 {
     mbServer::LogInfo(name(), QStringLiteral("Close Connection: ") + source);
+    m_runStat.connectionClosed(source);
 }
 
@@ -29,7 +29,10 @@
 
 #include <project/server_port.h>
 
+#include "server_runstatistic.h"
+
 class mbServerRunDevice;
+class mbCoreCaptureChannel;
 
 class mbServerPortRunnable : public QObject
 {
@@ -43,6 +46,7 @@ public:
     void setName(const QString &name);
     
 public:
+    bool isOpen() const;
     void run();
     void close();
 
@@ -60,6 +64,8 @@ private:
     mbServerRunDevice *m_device;
     ModbusServerPort  *m_modbusPort;
     mbServerPort::Statistic m_stat;
+    mbServerRunStatistic m_runStat;
+    mbCoreCaptureChannel *m_capture;
 };
 
 #endif // SERVER_PORTRUNNABLE_H
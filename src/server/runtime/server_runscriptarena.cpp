@@ -0,0 +1,92 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "server_runscriptarena.h"
+
+static inline uint32_t alignArena(uint32_t size)
+{
+    return (size + mbServerRunScriptArena::Alignment - 1) & ~static_cast<uint32_t>(mbServerRunScriptArena::Alignment - 1);
+}
+
+mbServerRunScriptArena::mbServerRunScriptArena(const QString &key) :
+    m_shm(key)
+{
+}
+
+void mbServerRunScriptArena::addBlock(const QString &key, uint32_t size)
+{
+    m_keys.append(key);
+    m_sizes.append(size);
+}
+
+bool mbServerRunScriptArena::create()
+{
+    QList<QByteArray> keys;
+    uint32_t szStrings = 0;
+    Q_FOREACH (const QString &key, m_keys)
+    {
+        QByteArray k = key.toUtf8();
+        szStrings += k.size() + 1;
+        keys.append(k);
+    }
+    const uint32_t count = static_cast<uint32_t>(m_keys.count());
+    uint32_t offsetStrings = sizeof(ArenaHeader) + sizeof(ArenaEntry) * count;
+    uint32_t offset = alignArena(offsetStrings + szStrings);
+    QList<uint32_t> offsets;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        offsets.append(offset);
+        offset = alignArena(offset + m_sizes.at(i));
+    }
+    const uint32_t size = offset;
+    if (!m_shm.create(static_cast<int>(size)))
+    {
+        if ((m_shm.error() != QSharedMemory::AlreadyExists) || !m_shm.attach() || (m_shm.size() < static_cast<int>(size)))
+            return false;
+    }
+    uint8_t *base = reinterpret_cast<uint8_t*>(m_shm.data());
+    memset(base, 0, size);
+    ArenaEntry *toc = reinterpret_cast<ArenaEntry*>(base + sizeof(ArenaHeader));
+    uint32_t offsetKey = offsetStrings;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const QByteArray &k = keys.at(i);
+        memcpy(base + offsetKey, k.constData(), k.size());
+        toc[i].keyOffset = offsetKey;
+        toc[i].keySize   = static_cast<uint32_t>(k.size());
+        toc[i].offset    = offsets.at(i);
+        toc[i].size      = m_sizes.at(i);
+        offsetKey += k.size() + 1;
+        m_blocks.insert(m_keys.at(i), base + offsets.at(i));
+    }
+    ArenaHeader *head = reinterpret_cast<ArenaHeader*>(base);
+    head->version    = ArenaVersion;
+    head->entryCount = count;
+    head->size       = size;
+    head->magic      = ArenaMagic; // Note: set last, arena is valid from this point
+    return true;
+}
+
+void *mbServerRunScriptArena::block(const QString &key) const
+{
+    return m_blocks.value(key, nullptr);
+}
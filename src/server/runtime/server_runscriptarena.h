@@ -0,0 +1,77 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef SERVER_RUNSCRIPTARENA_H
+#define SERVER_RUNSCRIPTARENA_H
+
+#include <QHash>
+#include <QSharedMemory>
+#include <QStringList>
+
+// Layout of arena shared memory segment (see '_mbsetarena' of 'mbserver.py'):
+// 'ArenaHeader', 'ArenaEntry' table of contents, string table of block keys and blocks itself
+typedef struct
+{
+    uint32_t magic;      // 'ArenaMagic'
+    uint32_t version;
+    uint32_t entryCount; // count of 'ArenaEntry' that follow header
+    uint32_t size;       // size of the whole arena
+} ArenaHeader;
+
+typedef struct
+{
+    uint32_t keyOffset;  // offset of UTF-8 key of block (e.g. 'ModbusTools.Server.<pid>.<device>.mem4x') from arena start
+    uint32_t keySize;
+    uint32_t offset;     // offset of block from arena start
+    uint32_t size;
+} ArenaEntry;
+
+class mbServerRunScriptArena
+{
+public:
+    enum
+    {
+        ArenaMagic   = 0x5241424D, // 'MBAR'
+        ArenaVersion = 1,
+        Alignment    = 64          // every block starts at cache line to prevent false sharing
+    };
+
+public:
+    explicit mbServerRunScriptArena(const QString &key);
+
+public:
+    inline QString key() const { return m_shm.key(); }
+    inline int blockCount() const { return m_keys.count(); }
+    // blocks must be added before arena is created
+    void addBlock(const QString &key, uint32_t size);
+    bool create();
+    void *block(const QString &key) const;
+    inline QString errorString() const { return m_shm.errorString(); }
+
+private:
+    QSharedMemory m_shm;
+    QStringList m_keys;
+    QList<uint32_t> m_sizes;
+    QHash<QString, void*> m_blocks;
+};
+
+#endif // SERVER_RUNSCRIPTARENA_H
@@ -0,0 +1,383 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifdef MB_EMBEDDED_PYTHON
+// Note: Python.h must be included before any standard header (it may define some preprocessor
+//       macros affecting them) and is compatible with Qt headers only with 'QT_NO_KEYWORDS'
+#include <Python.h>
+#endif // MB_EMBEDDED_PYTHON
+
+#include "server_runscriptembedded.h"
+
+#include <QAtomicInteger>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMutex>
+#include <QVector>
+
+#include <server.h>
+#include <project/server_project.h>
+
+#include "server_runscriptnotify.h"
+
+#ifdef MB_EMBEDDED_PYTHON
+
+// Memory block in server process with the same layout as shared memory segment
+struct LocalBlock
+{
+    QVector<quint64> buffer; // Note: 'quint64' for proper alignment of 64-bit values
+    size_t size;
+
+    void init(size_t sz)
+    {
+        size = sz;
+        buffer.fill(0, static_cast<int>((sz+sizeof(quint64)-1)/sizeof(quint64)));
+    }
+    void *data() { return buffer.data(); }
+};
+
+static QMutex s_pythonLock;
+static bool s_pythonInitialized = false;
+
+// '_mbembedded.output(text)' redirects script output into server Output window
+static PyObject *mbembedded_output(PyObject * /*self*/, PyObject *args)
+{
+    const char *text;
+    if (!PyArg_ParseTuple(args, "s", &text))
+        return nullptr;
+    QString s = QString::fromUtf8(text);
+    Py_BEGIN_ALLOW_THREADS
+    mbServer::OutputMessage(s);
+    Py_END_ALLOW_THREADS
+    Py_RETURN_NONE;
+}
+
+// '_mbembedded.cas32(address, expected, desired)' - atomic compare-and-swap of 32-bit word
+// (writer lock of memory block header which is shared with server threads)
+static PyObject *mbembedded_cas32(PyObject * /*self*/, PyObject *args)
+{
+    PyObject *address;
+    unsigned int expected, desired;
+    if (!PyArg_ParseTuple(args, "OII", &address, &expected, &desired))
+        return nullptr;
+    void *ptr = PyLong_AsVoidPtr(address);
+    if (!ptr)
+        return PyErr_Occurred() ? nullptr : PyBool_FromLong(0);
+    bool r = reinterpret_cast<QAtomicInteger<quint32>*>(ptr)->testAndSetOrdered(expected, desired);
+    return PyBool_FromLong(r);
+}
+
+static PyMethodDef s_mbembeddedMethods[] =
+{
+    {"output", mbembedded_output, METH_VARARGS, "Print text into server Output window"},
+    {"cas32" , mbembedded_cas32 , METH_VARARGS, "Atomic compare-and-swap of 32-bit word"},
+    {nullptr, nullptr, 0, nullptr}
+};
+
+static PyModuleDef s_mbembeddedModule =
+{
+    PyModuleDef_HEAD_INIT, "_mbembedded", nullptr, -1, s_mbembeddedMethods,
+    nullptr, nullptr, nullptr, nullptr
+};
+
+static PyObject *mbembedded_init()
+{
+    return PyModule_Create(&s_mbembeddedModule);
+}
+
+// Interpreter is initialized once on first use and lives until application exit
+static bool initPython()
+{
+    QMutexLocker _(&s_pythonLock);
+    if (!s_pythonInitialized)
+    {
+        PyImport_AppendInittab("_mbembedded", &mbembedded_init);
+        Py_InitializeEx(0); // Note: signal handlers belong to application
+        if (!Py_IsInitialized())
+            return false;
+        PyEval_SaveThread(); // release GIL, every script thread acquires it when needed
+        s_pythonInitialized = true;
+    }
+    return true;
+}
+
+// 'value' reference is stolen
+static void setGlobal(PyObject *globals, const char *name, PyObject *value)
+{
+    PyDict_SetItemString(globals, name, value);
+    Py_XDECREF(value);
+}
+
+static PyObject *toPyString(const QString &s)
+{
+    QByteArray b = s.toUtf8();
+    return PyUnicode_FromStringAndSize(b.constData(), b.size());
+}
+
+static PyObject *toPyBlock(LocalBlock &block)
+{
+    return Py_BuildValue("(NN)", PyLong_FromVoidPtr(block.data()), PyLong_FromSize_t(block.size));
+}
+
+// Returns true if there was no error, otherwise error is printed into Output window
+static bool checkPyError(PyObject *result)
+{
+    if (result)
+    {
+        Py_DECREF(result);
+        return true;
+    }
+    if (PyErr_ExceptionMatches(PyExc_SystemExit))
+        PyErr_Clear(); // Note: 'PyErr_Print()' exits application for 'SystemExit'
+    else
+        PyErr_Print();
+    return false;
+}
+
+static PyObject *compileScript(const QString &code, const QString &name)
+{
+    PyObject *c = Py_CompileString(code.toUtf8().constData(), name.toUtf8().constData(), Py_file_input);
+    if (!c)
+        checkPyError(c);
+    return c;
+}
+
+static bool execScript(PyObject *globals, const QString &code, const QString &name)
+{
+    PyObject *c = compileScript(code, name);
+    if (!c)
+        return false;
+    bool r = checkPyError(PyEval_EvalCode(c, globals, globals));
+    Py_DECREF(c);
+    return r;
+}
+
+#endif // MB_EMBEDDED_PYTHON
+
+mbServerRunScriptEmbedded::mbServerRunScriptEmbedded(mbServerDevice *device, const MBSETTINGS &scripts, QObject *parent) :
+    mbServerRunScriptThread(device, scripts, parent)
+{
+    m_pyThreadId = 0;
+}
+
+void mbServerRunScriptEmbedded::stop()
+{
+    mbServerRunScriptThread::stop();
+#ifdef MB_EMBEDDED_PYTHON
+    {
+        QMutexLocker _(&s_pythonLock);
+        if (!s_pythonInitialized)
+            return;
+    }
+    // Note: 'PyErr_SetInterrupt()' is handled by main thread of interpreter only, so blocked script
+    //       is interrupted by 'SystemExit' which is raised asynchronously inside its own thread
+    PyGILState_STATE gil = PyGILState_Ensure();
+    if (m_pyThreadId)
+        PyThreadState_SetAsyncExc(m_pyThreadId, PyExc_SystemExit);
+    PyGILState_Release(gil);
+#endif // MB_EMBEDDED_PYTHON
+}
+
+#ifdef MB_EMBEDDED_PYTHON
+// Called with GIL held when script code is finished: drops interruption that was requested
+// by 'stop()' but was not raised yet, so it can't break 'Final'-script
+void mbServerRunScriptEmbedded::clearInterrupt()
+{
+    if (!m_ctrlRun)
+        PyThreadState_SetAsyncExc(m_pyThreadId, nullptr);
+    m_pyThreadId = 0;
+}
+#endif // MB_EMBEDDED_PYTHON
+
+bool mbServerRunScriptEmbedded::isAvailable()
+{
+#ifdef MB_EMBEDDED_PYTHON
+    return true;
+#else
+    return false;
+#endif
+}
+
+void mbServerRunScriptEmbedded::run()
+{
+#ifdef MB_EMBEDDED_PYTHON
+    if (!initPython())
+    {
+        mbServer::LogError("Python", QStringLiteral("Can't initialize embedded Python interpreter"));
+        return;
+    }
+
+    const QString deviceName = m_device->name();
+    const QString prefix = QString("ModbusTools.Server.Embedded.%1").arg(deviceName);
+
+    LocalBlock memDev, memPy, memNtf;
+    LocalBlock memBlocks[4];
+    memDev.init(sizeof(DeviceBlock)+m_deviceName.size()+1);
+    memPy.init(sizeof(PythonBlock));
+    memBlocks[0].init(memoryBlockSize(m_device->count_0x_bytes()));
+    memBlocks[1].init(memoryBlockSize(m_device->count_1x_bytes()));
+    memBlocks[2].init(memoryBlockSize(m_device->count_3x_bytes()));
+    memBlocks[3].init(memoryBlockSize(m_device->count_4x_bytes()));
+    memNtf.init(mbServerRunScriptNotify::blockSize());
+
+    DeviceBlock *devMem = reinterpret_cast<DeviceBlock*>(memDev.data());
+    PythonBlock *pyMem = reinterpret_cast<PythonBlock*>(memPy.data());
+    initDeviceBlock(devMem);
+    memset(pyMem, 0, sizeof(PythonBlock));
+
+    MemWork memWork[4];
+    void *const blocks[4] = { memBlocks[0].data(), memBlocks[1].data(), memBlocks[2].data(), memBlocks[3].data() };
+    QSharedMemory *const shm[4] = { nullptr, nullptr, nullptr, nullptr }; // Note: memory is synchronized in this thread
+    initMemWork(memWork, blocks, shm);
+
+    // Script is running inside server process, so memory is always shared with it when it's possible
+    bool sharedMemory = canShareMemory(memWork);
+    initMemory(memWork, sharedMemory);
+
+    devMem->flags |= DeviceFlag_Run;
+    if (sharedMemory)
+        devMem->flags |= DeviceFlag_SharedMemory;
+    m_ctrlRun = true;
+
+    mbServerRunScriptNotify notify(memNtf.data(), sharedMemory);
+    m_device->setChangeNotifier(&notify);
+
+    QString head;
+    QFile qrcfile(":/server/python/embeddedhead.py");
+    if (qrcfile.open(QIODevice::ReadOnly | QIODevice::Text))
+        head = QString::fromUtf8(qrcfile.readAll());
+
+    PyGILState_STATE gil = PyGILState_Ensure();
+    m_pyThreadId = PyThread_get_thread_ident();
+    PyObject *globals = PyDict_New();
+    setGlobal(globals, "__builtins__", PyImport_ImportModule("builtins"));
+    setGlobal(globals, "__name__", toPyString(QStringLiteral("__main__")));
+    setGlobal(globals, "_mb_memid", toPyString(prefix));
+    setGlobal(globals, "_mb_project", toPyString(mbServer::global()->project()->absoluteFilePath()));
+    setGlobal(globals, "_mb_period", PyLong_FromLong(m_scriptLoopPeriod));
+    PyObject *importPath = PyList_New(0);
+    Q_FOREACH (const QString &p, getImportPath().split(';'))
+    {
+        PyObject *item = toPyString(p);
+        PyList_Append(importPath, item);
+        Py_DECREF(item);
+    }
+    setGlobal(globals, "_mb_importpath", importPath);
+    PyObject *localMemory = PyDict_New();
+    setGlobal(localMemory, (prefix+QStringLiteral(".device")).toUtf8().constData(), toPyBlock(memDev));
+    setGlobal(localMemory, (prefix+QStringLiteral(".python")).toUtf8().constData(), toPyBlock(memPy));
+    setGlobal(localMemory, (prefix+QStringLiteral(".mem0x" )).toUtf8().constData(), toPyBlock(memBlocks[0]));
+    setGlobal(localMemory, (prefix+QStringLiteral(".mem1x" )).toUtf8().constData(), toPyBlock(memBlocks[1]));
+    setGlobal(localMemory, (prefix+QStringLiteral(".mem3x" )).toUtf8().constData(), toPyBlock(memBlocks[2]));
+    setGlobal(localMemory, (prefix+QStringLiteral(".mem4x" )).toUtf8().constData(), toPyBlock(memBlocks[3]));
+    setGlobal(localMemory, (prefix+QStringLiteral(".notify")).toUtf8().constData(), toPyBlock(memNtf));
+    setGlobal(globals, "_mb_localmemory", localMemory);
+
+    bool initialized = execScript(globals, head, QString("<%1:head>").arg(deviceName)) &&
+                       execScript(globals, getScriptInit(), QString("<%1:init>").arg(deviceName));
+    PyObject *loop = nullptr;
+    if (initialized)
+        loop = compileScript(getScriptLoopBody(), QString("<%1:loop>").arg(deviceName));
+    clearInterrupt();
+    PyGILState_Release(gil);
+
+    if (initialized)
+        mbServer::LogDebug("Python", QString("Embedded script of device '%1' is started").arg(deviceName));
+    else if (m_ctrlRun)
+        mbServer::LogError("Python", QString("Can't initialize embedded script of device '%1'").arg(deviceName));
+
+    // Main Loop
+    // Note: loop is scheduled against absolute deadlines of monotonic clock, so periods don't drift
+    QElapsedTimer clock;
+    clock.start();
+    const qint64 period = static_cast<qint64>(m_scriptLoopPeriod) * 1000000; // nanoseconds
+    qint64 tmNext = clock.nsecsElapsed();
+    qint64 tmStat = clock.elapsed();
+    while (m_ctrlRun && loop)
+    {
+        QVector<NotifyRecord> changes;
+        if (!sharedMemory)
+            changes = notify.takePending();
+        syncMemory(memWork, sharedMemory);
+        notify.publish(changes);
+        qint64 tmStart = clock.nsecsElapsed();
+        if (tmStart >= tmNext)
+        {
+            gil = PyGILState_Ensure();
+            m_pyThreadId = PyThread_get_thread_ident();
+            bool ok = checkPyError(PyEval_EvalCode(loop, globals, globals));
+            clearInterrupt();
+            bool loopBreak = ok && (PyDict_GetItemString(globals, "_mb_loop_break") == Py_True);
+            PyGILState_Release(gil);
+            if (!ok)
+            {
+                if (m_ctrlRun) // Note: otherwise script is interrupted by 'stop()'
+                    mbServer::LogError("Python", QString("Embedded script of device '%1' is stopped because of error").arg(deviceName));
+                break;
+            }
+            if (loopBreak)
+                break;
+            qint64 tm = clock.nsecsElapsed();
+            bool overrun = false;
+            if (period > 0)
+            {
+                tmNext += period;
+                if (tmNext <= tm)
+                {
+                    overrun = true;
+                    tmNext += ((tm - tmNext) / period + 1) * period; // Note: skip periods that were missed but keep the phase
+                }
+            }
+            else
+                tmNext = tm;
+            updateLoopTime(pyMem, static_cast<uint32_t>(qMin<qint64>((tm - tmStart) / 1000, UINT32_MAX)), overrun);
+            pyMem->pycycle++;
+            syncMemory(memWork, sharedMemory); // Note: make script changes visible immediately
+        }
+        devMem->cycle++;
+        if (clock.elapsed() - tmStat >= StatisticPeriod)
+        {
+            tmStat = clock.elapsed();
+            publishStatistic(*pyMem, true);
+        }
+        mb::msleep(1);
+    }
+
+    // Finish
+    devMem->flags &= (~DeviceFlag_Run);
+    notify.wake();
+    gil = PyGILState_Ensure();
+    if (initialized)
+        execScript(globals, getScriptFinal(), QString("<%1:final>").arg(deviceName));
+    Py_XDECREF(loop);
+    // Note: objects of script that are still referenced after this point must not access device memory
+    PyDict_Clear(globals);
+    Py_DECREF(globals);
+    PyGILState_Release(gil);
+    syncMemory(memWork, sharedMemory);
+    publishStatistic(*pyMem, false);
+    m_device->setChangeNotifier(nullptr);
+    releaseMemory(memWork, sharedMemory);
+#else
+    mbServer::LogError("Python", QStringLiteral("Server is built without embedded Python interpreter"));
+#endif // MB_EMBEDDED_PYTHON
+}
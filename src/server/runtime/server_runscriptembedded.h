@@ -0,0 +1,54 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef SERVER_RUNSCRIPTEMBEDDED_H
+#define SERVER_RUNSCRIPTEMBEDDED_H
+
+#include "server_runscriptthread.h"
+
+// Runs device scripts by Python interpreter embedded into server process (built with 'MB_EMBEDDED_PYTHON').
+// All devices share single interpreter, every device has its own global namespace.
+// Memory blocks have the same layout as shared memory of 'mbServerRunScriptThread' but are located
+// in server process, so device memory is accessed by script directly when possible.
+class mbServerRunScriptEmbedded : public mbServerRunScriptThread
+{
+public:
+    explicit mbServerRunScriptEmbedded(mbServerDevice *device, const MBSETTINGS &scripts, QObject *parent = nullptr);
+
+public:
+    static bool isAvailable();
+
+public:
+    void stop() override;
+
+protected:
+    void run() override;
+
+private:
+    void clearInterrupt();
+
+private:
+    // id of the thread while script code is executed by it, so it can be interrupted by 'stop()' (guarded by GIL)
+    unsigned long m_pyThreadId;
+};
+
+#endif // SERVER_RUNSCRIPTEMBEDDED_H
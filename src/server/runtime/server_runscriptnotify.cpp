@@ -0,0 +1,124 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "server_runscriptnotify.h"
+
+#include <climits>
+
+#ifdef Q_OS_LINUX
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+mbServerRunScriptNotify::mbServerRunScriptNotify(void *shm, bool immediate)
+{
+    m_block = reinterpret_cast<NotifyBlock*>(shm);
+    m_immediate = immediate;
+    m_pendingOverflow = false;
+    memset(m_block, 0, blockSize());
+    m_block->ringSize = RingSize;
+}
+
+void mbServerRunScriptNotify::setImmediate(bool immediate)
+{
+    m_immediate.storeRelease(immediate);
+}
+
+void mbServerRunScriptNotify::memoryChanged(Modbus::MemoryType memType, uint byteOffset, uint byteCount)
+{
+    if (isImmediate())
+    {
+        // Note: device is locked for writing so there is only one publisher at a time
+        publish(static_cast<uint32_t>(memType), byteOffset, byteCount);
+        wake();
+        return;
+    }
+    QMutexLocker _(&m_pendingLock);
+    if (m_pending.count() < RingSize)
+    {
+        NotifyRecord r;
+        r.sequence = 0;
+        r.memory = static_cast<uint32_t>(memType);
+        r.byteOffset = byteOffset;
+        r.byteCount = byteCount;
+        m_pending.append(r);
+    }
+    else
+        m_pendingOverflow = true;
+}
+
+QVector<NotifyRecord> mbServerRunScriptNotify::takePending()
+{
+    QMutexLocker _(&m_pendingLock);
+    QVector<NotifyRecord> r;
+    r.swap(m_pending);
+    if (m_pendingOverflow)
+    {
+        // too many changes: report whole memory of each type as changed
+        const uint32_t memTypes[] = { Modbus::Memory_0x, Modbus::Memory_1x, Modbus::Memory_3x, Modbus::Memory_4x };
+        r.clear();
+        for (uint32_t memType : memTypes)
+        {
+            NotifyRecord rec;
+            rec.sequence = 0;
+            rec.memory = memType;
+            rec.byteOffset = 0;
+            rec.byteCount = 0xFFFFFFFF;
+            r.append(rec);
+        }
+        m_pendingOverflow = false;
+    }
+    return r;
+}
+
+void mbServerRunScriptNotify::publish(const QVector<NotifyRecord> &records)
+{
+    if (records.isEmpty())
+        return;
+    Q_FOREACH (const NotifyRecord &r, records)
+        publish(r.memory, r.byteOffset, r.byteCount);
+    wake();
+}
+
+void mbServerRunScriptNotify::wake()
+{
+    reinterpret_cast<QAtomicInteger<quint32>*>(&m_block->wakeCounter)->fetchAndAddOrdered(1);
+#ifdef Q_OS_LINUX
+    syscall(SYS_futex, &m_block->wakeCounter, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#endif
+}
+
+void mbServerRunScriptNotify::publish(uint32_t memory, uint32_t byteOffset, uint32_t byteCount)
+{
+    QAtomicInteger<quint32> *head = reinterpret_cast<QAtomicInteger<quint32>*>(&m_block->head);
+    uint32_t i = head->loadAcquire();
+    NotifyRecord &r = m_block->ring[i % RingSize];
+    QAtomicInteger<quint32> *seq = reinterpret_cast<QAtomicInteger<quint32>*>(&r.sequence);
+    // record is invalid while it's being changed
+    seq->fetchAndStoreOrdered(0);
+    r.memory = memory;
+    r.byteOffset = byteOffset;
+    r.byteCount = byteCount;
+    seq->storeRelease(i + 1);
+    head->storeRelease(i + 1);
+}
@@ -0,0 +1,86 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef SERVER_RUNSCRIPTNOTIFY_H
+#define SERVER_RUNSCRIPTNOTIFY_H
+
+#include <QMutex>
+#include <QVector>
+
+#include <project/server_device.h>
+
+// Layout of '.notify' shared memory block (see 'mbserver.py')
+typedef struct
+{
+    uint32_t sequence;   // index of record + 1 when record is valid
+    uint32_t memory;     // 0, 1, 3 or 4
+    uint32_t byteOffset;
+    uint32_t byteCount;  // 0xFFFFFFFF - whole memory
+} NotifyRecord;
+
+typedef struct
+{
+    uint32_t wakeCounter; // incremented after each publication, can be waited by script (futex word on Linux)
+    uint32_t head;        // count of published records, record 'i' is located in 'ring[i % ringSize]'
+    uint32_t ringSize;
+    uint32_t dummy;
+    NotifyRecord ring[1];
+} NotifyBlock;
+
+class mbServerRunScriptNotify : public mbServerDevice::ChangeNotifier
+{
+public:
+    enum
+    {
+        RingSize = 256
+    };
+
+public:
+    // if 'immediate' is true records are published right from 'memoryChanged()' (memory is shared with script),
+    // otherwise they are kept until 'publishPending()' is called (after memory is copied for script)
+    mbServerRunScriptNotify(void *shm, bool immediate);
+
+public:
+    inline bool isImmediate() const { return m_immediate.loadAcquire() != 0; }
+    void setImmediate(bool immediate);
+
+public:
+    static inline size_t blockSize() { return sizeof(NotifyBlock) + sizeof(NotifyRecord) * (RingSize - 1); }
+
+public:
+    void memoryChanged(Modbus::MemoryType memType, uint byteOffset, uint byteCount) override;
+    QVector<NotifyRecord> takePending();
+    void publish(const QVector<NotifyRecord> &records);
+    void wake();
+
+private:
+    void publish(uint32_t memory, uint32_t byteOffset, uint32_t byteCount);
+
+private:
+    NotifyBlock *m_block;
+    QAtomicInt m_immediate;
+    QMutex m_pendingLock;
+    QVector<NotifyRecord> m_pending;
+    bool m_pendingOverflow;
+};
+
+#endif // SERVER_RUNSCRIPTNOTIFY_H
@@ -13,46 +13,8 @@
 #include <project/server_project.h>
 #include <project/server_device.h>
 
-typedef struct
-{
-    uint32_t flags;
-    uint32_t cycle;
-    uint32_t count0x;
-    uint32_t count1x;
-    uint32_t count3x;
-    uint32_t count4x;
-    uint32_t exceptionStatusRef;
-    uint32_t byteOrder;
-    uint32_t registerOrder;
-    uint32_t stoDeviceName;
-    uint32_t stringTableSize;
-    //char stringTable[1];
-} DeviceBlock;
-
-typedef struct
-{
-    uint32_t pycycle;
-} PythonBlock;
-
-
-typedef struct
-{
-    uint32_t changeCounter;
-    uint32_t changeByteOffset;
-    uint32_t changeByteCount;
-    uint32_t dummy;
-} MemoryBlockHeader;
-
-struct MemWork
-{
-    mbServerDevice::MemoryBlock *devMemBlock;
-    uint devMemChangeCounter;
-    QSharedMemory *shm;
-    MemoryBlockHeader *shmHeader;
-    uint8_t *shmMem;
-    uint8_t *shmMask;
-    uint32_t changeCounter;
-};
+#include "server_runscriptnotify.h"
+#include "server_runscriptarena.h"
 
 QSharedMemory::SharedMemoryError initMem(QSharedMemory &mem, size_t size)
 {
@@ -94,7 +56,12 @@ mbServerRunScriptThread::mbServerRunScriptThread(mbServerDevice *device, const M
     m_settingImportPath = mbServer::global()->scriptImportPath();
     m_pyInterpreter = mbServer::global()->scriptDefaultExecutable();
     m_scriptUseOptimization = mbServer::global()->scriptUseOptimization();
+    m_scriptSharedMemory = mbServer::global()->scriptSharedMemory();
     m_scriptLoopPeriod = mbServer::global()->scriptLoopPeriod();
+    m_memId = QString("%1.%2").arg(processMemoryId(), m_device->name());
+    m_hosted = false;
+    m_hostedRunning = 0;
+    m_arena = nullptr;
     moveToThread(this);
     m_scriptInit  = scripts.value(s.scriptInit ).toString();
     m_scriptLoop  = scripts.value(s.scriptLoop ).toString();
@@ -106,7 +73,7 @@ void mbServerRunScriptThread::run()
     QEventLoop eloop;
     mbCoreFileManager *fileManager = mbServer::global()->fileManager();
 
-    const QString prefix = QString("ModbusTools.Server.%1.%2").arg(getProcessIdString(), m_device->name());
+    const QString &prefix = m_memId;
 
     const QString sMemDev = prefix+QStringLiteral(".device");
     const QString sMemPy  = prefix+QStringLiteral(".python");
@@ -114,6 +81,7 @@ void mbServerRunScriptThread::run()
     const QString sMem1x  = prefix+QStringLiteral(".mem1x" );
     const QString sMem3x  = prefix+QStringLiteral(".mem3x" );
     const QString sMem4x  = prefix+QStringLiteral(".mem4x" );
+    const QString sMemNtf = prefix+QStringLiteral(".notify");
 
     QSharedMemory memDev(sMemDev);
     QSharedMemory memPy(sMemPy);
@@ -121,185 +89,225 @@ void mbServerRunScriptThread::run()
     QSharedMemory mem1x(sMem1x);
     QSharedMemory mem3x(sMem3x);
     QSharedMemory mem4x(sMem4x);
+    QSharedMemory memNtf(sMemNtf);
 
-    int szMemDevStringTable = m_deviceName.size()+1;
-    int szMemDev = sizeof(DeviceBlock)+szMemDevStringTable;
-    initMem(memDev, szMemDev);
-    initMem(memPy, sizeof(PythonBlock));
-    initMem(mem0x, sizeof(MemoryBlockHeader)+m_device->count_0x_bytes()*2);
-    initMem(mem1x, sizeof(MemoryBlockHeader)+m_device->count_1x_bytes()*2);
-    initMem(mem3x, sizeof(MemoryBlockHeader)+m_device->count_3x_bytes()*2);
-    initMem(mem4x, sizeof(MemoryBlockHeader)+m_device->count_4x_bytes()*2);
-
-    DeviceBlock *devMem = reinterpret_cast<DeviceBlock*>(memDev.data());
-    devMem->count0x = m_device->count_0x();
-    devMem->count1x = m_device->count_1x();
-    devMem->count3x = m_device->count_3x();
-    devMem->count4x = m_device->count_4x();
-    devMem->exceptionStatusRef = m_device->exceptionStatusAddressInt();
-    devMem->byteOrder = m_device->byteOrder();
-    devMem->registerOrder = m_device->registerOrder();
-    devMem->stoDeviceName = 0;
-    devMem->stringTableSize = szMemDevStringTable;
-    uint8_t *ptrDevMemStringTable = reinterpret_cast<uint8_t*>(&devMem[1]);
-    memcpy(ptrDevMemStringTable, m_deviceName.data(), m_deviceName.size());
-    ptrDevMemStringTable[m_deviceName.size()] = 0;
-
-    MemWork memWork[4];
-
-    memWork[0].devMemBlock = &m_device->memBlockRef_0x();
-    memWork[1].devMemBlock = &m_device->memBlockRef_1x();
-    memWork[2].devMemBlock = &m_device->memBlockRef_3x();
-    memWork[3].devMemBlock = &m_device->memBlockRef_4x();
-
-    memWork[0].shm = &mem0x;
-    memWork[1].shm = &mem1x;
-    memWork[2].shm = &mem3x;
-    memWork[3].shm = &mem4x;
-
-    memWork[0].shmHeader = reinterpret_cast<MemoryBlockHeader*>(mem0x.data());
-    memWork[1].shmHeader = reinterpret_cast<MemoryBlockHeader*>(mem1x.data());
-    memWork[2].shmHeader = reinterpret_cast<MemoryBlockHeader*>(mem3x.data());
-    memWork[3].shmHeader = reinterpret_cast<MemoryBlockHeader*>(mem4x.data());
+    void *pMemDev, *pMemPy, *pMemNtf;
+    void *blocks[4];
+    QSharedMemory *shm[4];
+    QSharedMemory *shmPy;
+    if (m_arena)
+    {
+        // Note: arena blocks are never locked. Memory is always shared with script and
+        //       synchronized by sequence locks, other fields are single words
+        pMemDev   = m_arena->block(sMemDev);
+        pMemPy    = m_arena->block(sMemPy );
+        blocks[0] = m_arena->block(sMem0x );
+        blocks[1] = m_arena->block(sMem1x );
+        blocks[2] = m_arena->block(sMem3x );
+        blocks[3] = m_arena->block(sMem4x );
+        pMemNtf   = m_arena->block(sMemNtf);
+        for (int i = 0; i < 4; i++)
+            shm[i] = nullptr;
+        shmPy = nullptr;
+    }
+    else
+    {
+        int szMemDevStringTable = m_deviceName.size()+1;
+        int szMemDev = sizeof(DeviceBlock)+szMemDevStringTable;
+        initMem(memDev, szMemDev);
+        initMem(memPy, sizeof(PythonBlock));
+        initMem(mem0x, memoryBlockSize(m_device->count_0x_bytes()));
+        initMem(mem1x, memoryBlockSize(m_device->count_1x_bytes()));
+        initMem(mem3x, memoryBlockSize(m_device->count_3x_bytes()));
+        initMem(mem4x, memoryBlockSize(m_device->count_4x_bytes()));
+        initMem(memNtf, mbServerRunScriptNotify::blockSize());
+        pMemDev   = memDev.data();
+        pMemPy    = memPy .data();
+        blocks[0] = mem0x .data();
+        blocks[1] = mem1x .data();
+        blocks[2] = mem3x .data();
+        blocks[3] = mem4x .data();
+        pMemNtf   = memNtf.data();
+        shm[0] = &mem0x;
+        shm[1] = &mem1x;
+        shm[2] = &mem3x;
+        shm[3] = &mem4x;
+        shmPy = &memPy;
+    }
 
-    memWork[0].shmMem = reinterpret_cast<uint8_t*>(mem0x.data())+sizeof(MemoryBlockHeader);
-    memWork[1].shmMem = reinterpret_cast<uint8_t*>(mem1x.data())+sizeof(MemoryBlockHeader);
-    memWork[2].shmMem = reinterpret_cast<uint8_t*>(mem3x.data())+sizeof(MemoryBlockHeader);
-    memWork[3].shmMem = reinterpret_cast<uint8_t*>(mem4x.data())+sizeof(MemoryBlockHeader);
+    DeviceBlock *devMem = reinterpret_cast<DeviceBlock*>(pMemDev);
+    initDeviceBlock(devMem);
 
-    memWork[0].shmMask = reinterpret_cast<uint8_t*>(mem0x.data())+sizeof(MemoryBlockHeader)+m_device->count_0x_bytes();
-    memWork[1].shmMask = reinterpret_cast<uint8_t*>(mem1x.data())+sizeof(MemoryBlockHeader)+m_device->count_1x_bytes();
-    memWork[2].shmMask = reinterpret_cast<uint8_t*>(mem3x.data())+sizeof(MemoryBlockHeader)+m_device->count_3x_bytes();
-    memWork[3].shmMask = reinterpret_cast<uint8_t*>(mem4x.data())+sizeof(MemoryBlockHeader)+m_device->count_4x_bytes();
+    PythonBlock *pyMem = reinterpret_cast<PythonBlock*>(pMemPy);
+    memset(pyMem, 0, sizeof(PythonBlock));
 
-    memWork[0].changeCounter = memWork[0].shmHeader->changeCounter;
-    memWork[1].changeCounter = memWork[1].shmHeader->changeCounter;
-    memWork[2].changeCounter = memWork[2].shmHeader->changeCounter;
-    memWork[3].changeCounter = memWork[3].shmHeader->changeCounter;
+    MemWork memWork[4];
+    initMemWork(memWork, blocks, shm);
 
-    // Initialize memory
-    for (int i = 0; i < 4; i++)
+    // Note: memory that is already attached to external storage (memory-mapped image) can't be moved
+    //       (such devices are never placed into arena, see 'canUseArena')
+    bool sharedMemory = (m_scriptSharedMemory || m_arena) && canShareMemory(memWork);
+    if (m_arena && !sharedMemory)
     {
-        memWork[i].devMemChangeCounter = memWork[i].devMemBlock->changeCounter();
-        QSharedMemory &shm = *memWork[i].shm;
-        shm.lock();
-        memWork[i].devMemBlock->memGet(0, memWork[i].shmMem, memWork[i].devMemBlock->sizeBytes());
-        shm.unlock();
+        mbServer::LogError("Python", QString("Memory of device '%1' can't be placed into shared memory arena").arg(deviceName()));
+        return;
     }
-
-    qDebug() << "Control: key =" << memDev.key() << " nativeKey =" << memDev.nativeKey();
-
-    devMem->flags |= 1;
+    // Note: script process may have no atomic compare-and-swap for writer lock of memory block,
+    //       so shared memory is only offered to it and memory is copied until script accepts it
+    //       (arena has no copy mode, script that can't share its memory fails there)
+    bool sharedMemoryOffer = sharedMemory && !m_arena;
+    if (sharedMemoryOffer)
+        sharedMemory = false;
+    initMemory(memWork, sharedMemory);
+
+    if (!m_arena)
+        qDebug() << "Control: key =" << memDev.key() << " nativeKey =" << memDev.nativeKey();
+
+    devMem->flags |= DeviceFlag_Run;
+    if (sharedMemory)
+        devMem->flags |= DeviceFlag_SharedMemory;
+    else if (sharedMemoryOffer)
+        devMem->flags |= DeviceFlag_SharedMemoryOffer;
     //devMem->flags = 0;
     m_ctrlRun = true;
 
-    QString scriptFileName = QString("script_%1.py").arg(m_device->name());
     QFile scriptfile;
-    bool res;
-    if (m_scriptUseOptimization)
-        res = fileManager->getFile(scriptFileName, scriptfile, QIODevice::ReadOnly);
-    else
-        res = fileManager->createTemporaryFile(scriptFileName, scriptfile, QIODevice::WriteOnly);
-    if (!res)
-    {
-        mbServer::LogError("Python", QString("Can't create file '%1' to start Python script process").arg(scriptFileName));
-        return;
-    }
-    if (scriptfile.openMode() & QIODevice::WriteOnly)
+    if (!m_hosted)
     {
-        QString scriptInit  = getScriptInit ();
-        QString scriptLoop  = getScriptLoop ();
-        QString scriptFinal = getScriptFinal();
+        QString scriptFileName = QString("script_%1.py").arg(m_device->name());
+        bool res;
+        if (m_scriptUseOptimization)
+            res = fileManager->getFile(scriptFileName, scriptfile, QIODevice::ReadOnly);
+        else
+            res = fileManager->createTemporaryFile(scriptFileName, scriptfile, QIODevice::WriteOnly);
+        if (!res)
+        {
+            mbServer::LogError("Python", QString("Can't create file '%1' to start Python script process").arg(scriptFileName));
+            releaseMemory(memWork, sharedMemory);
+            return;
+        }
+        if (scriptfile.openMode() & QIODevice::WriteOnly)
+        {
+            QString scriptInit  = getScriptInit ();
+            QString scriptLoop  = getScriptLoop ();
+            QString scriptFinal = getScriptFinal();
 
-        QFile qrcfile(":/server/python/programhead.py");
-        qrcfile.open(QIODevice::ReadOnly | QIODevice::Text);
+            QFile qrcfile(":/server/python/programhead.py");
+            qrcfile.open(QIODevice::ReadOnly | QIODevice::Text);
 
-        // Copy program header
-        while (!qrcfile.atEnd())
-        {
-            QByteArray bLine = qrcfile.readLine();
-            scriptfile.write(bLine);
+            // Copy program header
+            while (!qrcfile.atEnd())
+            {
+                QByteArray bLine = qrcfile.readLine();
+                scriptfile.write(bLine);
+            }
+            qrcfile.close();
+
+            // Write Init, Loop and Final script
+            scriptfile.write(scriptInit .toUtf8());
+            scriptfile.write(scriptLoop .toUtf8());
+            scriptfile.write(scriptFinal.toUtf8());
+            scriptfile.close();
+            scriptfile.open(QIODevice::ReadOnly); // Note: to prevent file deletion
         }
-        qrcfile.close();
-
-        // Write Init, Loop and Final script
-        scriptfile.write(scriptInit .toUtf8());
-        scriptfile.write(scriptLoop .toUtf8());
-        scriptfile.write(scriptFinal.toUtf8());
-        scriptfile.close();
-        scriptfile.open(QIODevice::ReadOnly); // Note: to prevent file deletion
     }
 
-    QString pyscript = QFileInfo(scriptfile).absoluteFilePath();
-    QString pyfile = m_pyInterpreter;
-    QString importPath = getImportPath();
-    QStringList args;
-    args << "-u"
-         << pyscript
-         << "--project"    << mbServer::global()->project()->absoluteFilePath()
-         << "--importpath" << importPath
-         << "--memid"      << prefix
-         << "--period"     << QString::number(m_scriptLoopPeriod);
+    // Note: in shared mode script sees changes immediately, otherwise only after memory is copied
+    mbServerRunScriptNotify notify(pMemNtf, sharedMemory);
+    m_device->setChangeNotifier(&notify);
 
     mb::Timestamp_t tm;
     const mb::Timestamp_t timeoutStartStop = 1000;
 
     QProcess py;
     m_py = &py;
-    //py.setProcessChannelMode(QProcess::ForwardedChannels);
-
-    py.setProcessChannelMode(QProcess::MergedChannels);
-    connect(m_py, &QProcess::readyReadStandardOutput, this, &mbServerRunScriptThread::readPyStdOut);
-    mbServer::LogDebug("Python", QString("Try start process '%1' with args '%2'").arg(pyfile, args.join(' ')));
-    py.start(pyfile, args);
-
-    // Wait for start
-    tm = mb::currentTimestamp();
-    while (m_ctrlRun && (py.state() != QProcess::Running) && (mb::currentTimestamp()-tm < timeoutStartStop))
+    if (m_hosted)
     {
-        eloop.processEvents();
-        mb::msleep(1);
+        // Script is executed by worker process that waits until memory is ready (see 'mbServerRunScriptWorker')
+        m_ready.storeRelease(1);
     }
-
-    if (py.state() != QProcess::Running)
+    else
     {
-        mbServer::LogError("Python", QString("Can't start process '%1'").arg(py.program()));
-        m_ctrlRun = false;
+        QString pyscript = QFileInfo(scriptfile).absoluteFilePath();
+        QString pyfile = m_pyInterpreter;
+        QString importPath = getImportPath();
+        QStringList args;
+        args << "-u"
+             << pyscript
+             << "--project"    << mbServer::global()->project()->absoluteFilePath()
+             << "--importpath" << importPath
+             << "--memid"      << m_memId
+             << "--period"     << QString::number(m_scriptLoopPeriod);
+        if (m_arena)
+            args << "--arena" << m_arena->key();
+
+        //py.setProcessChannelMode(QProcess::ForwardedChannels);
+
+        py.setProcessChannelMode(QProcess::MergedChannels);
+        connect(m_py, &QProcess::readyReadStandardOutput, this, &mbServerRunScriptThread::readPyStdOut);
+        mbServer::LogDebug("Python", QString("Try start process '%1' with args '%2'").arg(pyfile, args.join(' ')));
+        py.start(pyfile, args);
+
+        // Wait for start
+        tm = mb::currentTimestamp();
+        while (m_ctrlRun && (py.state() != QProcess::Running) && (mb::currentTimestamp()-tm < timeoutStartStop))
+        {
+            eloop.processEvents();
+            mb::msleep(1);
+        }
+
+        if (py.state() != QProcess::Running)
+        {
+            mbServer::LogError("Python", QString("Can't start process '%1'").arg(py.program()));
+            m_ctrlRun = false;
+        }
     }
 
     // Main Loop
+    PythonBlock pyStat;
+    mb::Timestamp_t tmStat = mb::currentTimestamp();
     while (m_ctrlRun)
     {
         eloop.processEvents();
-        for (int i = 0; i < 4; i++)
+        if (sharedMemoryOffer)
+            sharedMemoryOffer = !checkSharedMemoryAnswer(memWork, devMem, pyMem, shmPy, &notify, &sharedMemory);
+        QVector<NotifyRecord> changes;
+        if (!sharedMemory)
+            changes = notify.takePending(); // taken before copy so every change is already in copied memory
+        syncMemory(memWork, sharedMemory);
+        notify.publish(changes);
+        devMem->cycle++;
+        tm = mb::currentTimestamp();
+        if (tm - tmStat >= StatisticPeriod)
         {
-            QSharedMemory &shm = *memWork[i].shm;
-            MemoryBlockHeader *head = memWork[i].shmHeader;
-            shm.lock();
-            if (memWork[i].changeCounter != head->changeCounter)
-            {
-                //qDebug() << "New Header:" << head->changeCounter << ". Offset:" << head->changeByteOffset << ". Count: " << head->changeByteCount;
-                uint32_t byteOffset = head->changeByteOffset;
-                memWork[i].devMemBlock->memSetMask(byteOffset, memWork[i].shmMem+byteOffset, memWork[i].shmMask+byteOffset, head->changeByteCount);
-                memset(memWork[i].shmMask+byteOffset, 0, head->changeByteCount);
-                head->changeByteOffset = 0xFFFFFFFF;
-                head->changeByteCount = 0;
-                memWork[i].changeCounter = head->changeCounter;
-            }
-            if (memWork[i].devMemChangeCounter != memWork[i].devMemBlock->changeCounter())
-            {
-                memWork[i].devMemChangeCounter = memWork[i].devMemBlock->changeCounter();
-                memWork[i].devMemBlock->memGet(0, memWork[i].shmMem, memWork[i].devMemBlock->sizeBytes());
-            }
-            shm.unlock();
+            tmStat = tm;
+            if (shmPy)
+                shmPy->lock();
+            pyStat = *pyMem;
+            if (shmPy)
+                shmPy->unlock();
+            publishStatistic(pyStat, true);
         }
-        devMem->cycle++;
         mb::msleep(1);
     }
 
     // Finish process
-    devMem->flags &= (~1);
-    if (py.state() != QProcess::NotRunning)
+    devMem->flags &= (~DeviceFlag_Run);
+    notify.wake();
+    if (m_hosted)
+    {
+        // Wait for 'Final'-script of the device, its changes must get into device memory.
+        // Note: script that was not started by worker (or whose worker is finished) is not waited for
+        tm = mb::currentTimestamp();
+        while (!(pyMem->flags & PythonFlag_Finished) && isHostedRunning() && (mb::currentTimestamp()-tm < timeoutStartStop*2))
+        {
+            syncMemory(memWork, sharedMemory);
+            mb::msleep(1);
+        }
+        syncMemory(memWork, sharedMemory);
+        m_ready.storeRelease(0);
+    }
+    else if (py.state() != QProcess::NotRunning)
     {
         tm = mb::currentTimestamp();
         Modbus::msleep(1);
@@ -314,15 +322,272 @@ void mbServerRunScriptThread::run()
             py.kill();
         }
     }
+    if (shmPy)
+        shmPy->lock();
+    pyStat = *pyMem;
+    if (shmPy)
+        shmPy->unlock();
+    publishStatistic(pyStat, false);
+    m_device->setChangeNotifier(nullptr);
+    releaseMemory(memWork, sharedMemory); // Note: before shared segments are destroyed
     eloop.processEvents();
 
 }
 
+void mbServerRunScriptThread::initDeviceBlock(DeviceBlock *devMem)
+{
+    devMem->count0x = m_device->count_0x();
+    devMem->count1x = m_device->count_1x();
+    devMem->count3x = m_device->count_3x();
+    devMem->count4x = m_device->count_4x();
+    devMem->exceptionStatusRef = m_device->exceptionStatusAddressInt();
+    devMem->byteOrder = m_device->byteOrder();
+    devMem->registerOrder = m_device->registerOrder();
+    devMem->stoDeviceName = 0;
+    devMem->stringTableSize = m_deviceName.size()+1;
+    uint8_t *ptrDevMemStringTable = reinterpret_cast<uint8_t*>(&devMem[1]);
+    memcpy(ptrDevMemStringTable, m_deviceName.data(), m_deviceName.size());
+    ptrDevMemStringTable[m_deviceName.size()] = 0;
+}
+
+void mbServerRunScriptThread::initMemWork(MemWork *memWork, void *const blocks[], QSharedMemory *const shm[])
+{
+    memWork[0].devMemBlock = &m_device->memBlockRef_0x();
+    memWork[1].devMemBlock = &m_device->memBlockRef_1x();
+    memWork[2].devMemBlock = &m_device->memBlockRef_3x();
+    memWork[3].devMemBlock = &m_device->memBlockRef_4x();
+
+    for (int i = 0; i < 4; i++)
+    {
+        uint8_t *block = reinterpret_cast<uint8_t*>(blocks[i]);
+        memWork[i].shm = shm[i];
+        memWork[i].shmHeader = reinterpret_cast<MemoryBlockHeader*>(block);
+        memWork[i].shmMem = block+sizeof(MemoryBlockHeader);
+        memWork[i].shmMask = block+sizeof(MemoryBlockHeader)+memWork[i].devMemBlock->sizeBytes();
+        memWork[i].shmPages = memWork[i].shmMask+memWork[i].devMemBlock->sizeBytes();
+        memWork[i].changeCounter = memWork[i].shmHeader->changeCounter;
+    }
+}
+
+bool mbServerRunScriptThread::checkSharedMemoryAnswer(MemWork *memWork, DeviceBlock *devMem, const PythonBlock *pyMem, QSharedMemory *shmPy, mbServerRunScriptNotify *notify, bool *sharedMemory)
+{
+    if (shmPy)
+        shmPy->lock();
+    uint32_t pyFlags = pyMem->flags;
+    if (shmPy)
+        shmPy->unlock();
+    if (!(pyFlags & (PythonFlag_SharedMemory | PythonFlag_CopyMemory)))
+        return false;
+    uint32_t flags = devMem->flags & ~DeviceFlag_SharedMemoryOffer;
+    if (pyFlags & PythonFlag_SharedMemory)
+    {
+        // Note: script waits for the answer and doesn't use memory yet, so it can be switched,
+        //       changes that were not published yet are already in memory script starts with
+        initMemory(memWork, true);
+        notify->setImmediate(true);
+        notify->takePending();
+        *sharedMemory = true;
+        flags |= DeviceFlag_SharedMemory;
+    }
+    else
+        mbServer::LogDebug("Python", QString("Script of device '%1' has no atomic compare-and-swap, memory is copied").arg(deviceName()));
+    devMem->flags = flags;
+    return true;
+}
+
+bool mbServerRunScriptThread::canShareMemory(const MemWork *memWork) const
+{
+#if defined(Q_PROCESSOR_X86)
+    for (int i = 0; i < 4; i++)
+    {
+        if (memWork[i].devMemBlock->isAttached())
+            return false;
+    }
+    return true;
+#else
+    // Note: script side of sequence lock relies on ordered stores that is guaranteed by x86/x64 only
+    Q_UNUSED(memWork)
+    return false;
+#endif
+}
+
+void mbServerRunScriptThread::initMemory(MemWork *memWork, bool sharedMemory)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        memWork[i].devMemChangeCounter = memWork[i].devMemBlock->changeCounter();
+        if (memWork[i].shm)
+            memWork[i].shm->lock();
+        uint32_t sz = static_cast<uint32_t>(memWork[i].devMemBlock->sizeBytes());
+        memWork[i].shmHeader->rangeCount = 0;
+        memWork[i].shmHeader->pageOverflow = 0;
+        memset(memWork[i].shmMask, 0, sz);
+        memset(memWork[i].shmPages, 0, memoryDirtyPagesBytes(sz));
+        if (sharedMemory)
+        {
+            memWork[i].shmHeader->changeCounter = 0;
+            memWork[i].shmHeader->sequence = 0;
+            memWork[i].shmHeader->writeLock = 0;
+            memWork[i].changeCounter = 0;
+            memWork[i].devMemBlock->attachMemory(memWork[i].shmMem, true);
+            memWork[i].devMemBlock->setSequenceLock(&memWork[i].shmHeader->sequence, &memWork[i].shmHeader->changeCounter, &memWork[i].shmHeader->writeLock);
+        }
+        else
+            memWork[i].devMemBlock->memGet(0, memWork[i].shmMem, memWork[i].devMemBlock->sizeBytes());
+        if (memWork[i].shm)
+            memWork[i].shm->unlock();
+    }
+}
+
+void mbServerRunScriptThread::syncMemory(MemWork *memWork, bool sharedMemory)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        if (sharedMemory)
+        {
+            // Script writes device memory directly, so only notify about its changes
+            uint32_t c = memWork[i].shmHeader->changeCounter;
+            if (!(c & 1) && (memWork[i].changeCounter != c))
+            {
+                memWork[i].changeCounter = c;
+                memWork[i].devMemBlock->notifyChanged();
+            }
+            continue;
+        }
+        MemoryBlockHeader *head = memWork[i].shmHeader;
+        if (memWork[i].shm)
+            memWork[i].shm->lock();
+        if (memWork[i].changeCounter != head->changeCounter)
+        {
+            if (head->pageOverflow)
+            {
+                // Note: consecutive dirty pages are applied by single call
+                uint32_t sz = static_cast<uint32_t>(memWork[i].devMemBlock->sizeBytes());
+                uint32_t pages = (sz+MemoryDirtyPageSize-1)/MemoryDirtyPageSize;
+                uint32_t first = 0;
+                uint32_t count = 0;
+                for (uint32_t p = 0; p < pages; p++)
+                {
+                    if (memWork[i].shmPages[p/8] & (1 << (p%8)))
+                    {
+                        if (count == 0)
+                            first = p;
+                        count++;
+                    }
+                    else if (count)
+                    {
+                        applyChanges(&memWork[i], first*MemoryDirtyPageSize, count*MemoryDirtyPageSize);
+                        count = 0;
+                    }
+                }
+                if (count)
+                    applyChanges(&memWork[i], first*MemoryDirtyPageSize, count*MemoryDirtyPageSize);
+                memset(memWork[i].shmPages, 0, memoryDirtyPagesBytes(sz));
+                head->pageOverflow = 0;
+            }
+            else
+            {
+                uint32_t c = qMin<uint32_t>(head->rangeCount, MemoryDirtyRangeCount);
+                for (uint32_t r = 0; r < c; r++)
+                    applyChanges(&memWork[i], head->ranges[r].byteOffset, head->ranges[r].byteCount);
+            }
+            head->rangeCount = 0;
+            memWork[i].changeCounter = head->changeCounter;
+        }
+        if (memWork[i].devMemChangeCounter != memWork[i].devMemBlock->changeCounter())
+        {
+            memWork[i].devMemChangeCounter = memWork[i].devMemBlock->changeCounter();
+            memWork[i].devMemBlock->memGet(0, memWork[i].shmMem, memWork[i].devMemBlock->sizeBytes());
+        }
+        if (memWork[i].shm)
+            memWork[i].shm->unlock();
+    }
+}
+
+void mbServerRunScriptThread::releaseMemory(MemWork *memWork, bool sharedMemory)
+{
+    if (sharedMemory)
+    {
+        // return memory to device before shared block is destroyed
+        for (int i = 0; i < 4; i++)
+            memWork[i].devMemBlock->detachMemory();
+    }
+}
+
+void mbServerRunScriptThread::applyChanges(MemWork *memWork, uint32_t byteOffset, uint32_t byteCount)
+{
+    uint32_t sz = static_cast<uint32_t>(memWork->devMemBlock->sizeBytes());
+    if (byteOffset >= sz)
+        return;
+    if (byteCount > sz - byteOffset)
+        byteCount = sz - byteOffset;
+    memWork->devMemBlock->memSetMask(byteOffset, memWork->shmMem+byteOffset, memWork->shmMask+byteOffset, byteCount);
+    memset(memWork->shmMask+byteOffset, 0, byteCount);
+}
+
+void mbServerRunScriptThread::updateLoopTime(PythonBlock *pyMem, uint32_t us, bool overrun)
+{
+    // Note: same calculation is made by Python side (see '_MemoryPythonBlock.setlooptime')
+    pyMem->loopTimeLast = us;
+    if (pyMem->pycycle == 0)
+        pyMem->loopTimeAvg = us;
+    else
+        pyMem->loopTimeAvg = static_cast<uint32_t>(static_cast<int64_t>(pyMem->loopTimeAvg) + (static_cast<int64_t>(us) - pyMem->loopTimeAvg) / 16);
+    if (us > pyMem->loopTimeMax)
+        pyMem->loopTimeMax = us;
+    if (overrun)
+        pyMem->loopOverruns++;
+}
+
+void mbServerRunScriptThread::publishStatistic(const PythonBlock &py, bool isRunning)
+{
+    mbServerScriptStatistic stat;
+    stat.isRunning = isRunning;
+    stat.period    = static_cast<quint32>(m_scriptLoopPeriod);
+    stat.cycles    = py.pycycle;
+    stat.timeLast  = py.loopTimeLast;
+    stat.timeAvg   = py.loopTimeAvg;
+    stat.timeMax   = py.loopTimeMax;
+    stat.overruns  = py.loopOverruns;
+    stat.timestamp = QDateTime::currentDateTime();
+    m_device->setScriptStatistic(stat);
+}
+
 void mbServerRunScriptThread::readPyStdOut()
 {
     mbServer::OutputMessage(QString::fromUtf8(m_py->readAllStandardOutput()));
 }
 
+QString mbServerRunScriptThread::processMemoryId()
+{
+    return QString("ModbusTools.Server.%1").arg(getProcessIdString());
+}
+
+bool mbServerRunScriptThread::canUseArena() const
+{
+    // Note: memory that is attached to external storage (memory-mapped image) can't be moved into arena,
+    //       arena memory is always shared with device, so it's used on x86/x64 only (see 'canShareMemory')
+#if defined(Q_PROCESSOR_X86)
+    return !m_device->memBlockRef_0x().isAttached() &&
+           !m_device->memBlockRef_1x().isAttached() &&
+           !m_device->memBlockRef_3x().isAttached() &&
+           !m_device->memBlockRef_4x().isAttached();
+#else
+    return false;
+#endif
+}
+
+void mbServerRunScriptThread::reserveArena(mbServerRunScriptArena *arena) const
+{
+    arena->addBlock(m_memId+QStringLiteral(".device"), sizeof(DeviceBlock)+m_deviceName.size()+1);
+    arena->addBlock(m_memId+QStringLiteral(".python"), sizeof(PythonBlock));
+    arena->addBlock(m_memId+QStringLiteral(".mem0x" ), memoryBlockSize(m_device->count_0x_bytes()));
+    arena->addBlock(m_memId+QStringLiteral(".mem1x" ), memoryBlockSize(m_device->count_1x_bytes()));
+    arena->addBlock(m_memId+QStringLiteral(".mem3x" ), memoryBlockSize(m_device->count_3x_bytes()));
+    arena->addBlock(m_memId+QStringLiteral(".mem4x" ), memoryBlockSize(m_device->count_4x_bytes()));
+    arena->addBlock(m_memId+QStringLiteral(".notify"), static_cast<uint32_t>(mbServerRunScriptNotify::blockSize()));
+}
+
 QString mbServerRunScriptThread::getImportPath()
 {
     QStringList pathList;
@@ -361,20 +626,40 @@ QString mbServerRunScriptThread::getScriptLoop()
     res += "#############################################\n"
            "############## USER CODE: LOOP ##############\n"
            "#############################################\n\n";
-    res += "_mb_time_start = 0.0\n";
+    // Note: loop is scheduled against absolute deadlines of monotonic clock, so periods don't drift
+    res += "from time import monotonic as _mb_monotonic\n";
+    res += "_mb_time_deadline = _mb_monotonic()\n";
     res += "while (mbdevice.getflags() & 1):\n";
-    res += "    if (time() - _mb_time_start) < _mb_time_period:\n";
-    res += "        sleep(0.001)\n";
+    res += "    _mb_time_wait = _mb_time_deadline - _mb_monotonic()\n";
+    res += "    if _mb_time_wait > 0:\n";
+    res += "        mbdevice._idle(_mb_time_wait)\n";
     res += "        continue\n";
-    res += "    _mb_time_start = time()\n";
+    res += "    _mb_time_start = _mb_monotonic()\n";
     QStringList lines = m_scriptLoop.split('\n', Qt::SkipEmptyParts);
     Q_FOREACH(const QString &line, lines)
         res += QStringLiteral("    ") + line + QChar('\n');
-    res += "    mbdevice._incpycycle()\n";
+    res += "    _mb_time_deadline = mbdevice._endloop(_mb_time_start, _mb_time_deadline, _mb_time_period)\n";
     res += QChar('\n');
     return res;
 }
 
+// Loop-script for the modes where it's executed as separate code object (embedded interpreter and worker process).
+// Body is wrapped into single pass 'for' so 'continue' finishes current cycle and 'break' stops the loop
+// like inside 'while' of 'getScriptLoop()'. Note: function is not used as wrapper because assignments
+// inside it would become local, while variables of loop-script must stay global between cycles
+QString mbServerRunScriptThread::getScriptLoopBody() const
+{
+    QString res("_mb_loop_break = True\n"
+                "for _mb_loop_once in (0,):\n"
+                "    pass\n");
+    QStringList lines = m_scriptLoop.split('\n');
+    Q_FOREACH(const QString &line, lines)
+        res += QStringLiteral("    ") + line + QChar('\n');
+    res += "else:\n"
+           "    _mb_loop_break = False\n";
+    return res;
+}
+
 QString mbServerRunScriptThread::getScriptFinal()
 {
     QString res("\n");
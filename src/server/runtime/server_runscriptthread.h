@@ -2,10 +2,92 @@
 #define SERVER_RUNSCRIPTTHREAD_H
 
 #include <QThread>
+#include <QAtomicInt>
 #include <mbcore.h>
 
+#include <project/server_device.h>
+
 class QProcess;
-class mbServerDevice;
+class QSharedMemory;
+
+class mbServerRunScriptArena;
+class mbServerRunScriptNotify;
+
+// Layout of shared memory blocks used by Python script (see 'mbserver.py')
+typedef struct
+{
+    uint32_t flags;
+    uint32_t cycle;
+    uint32_t count0x;
+    uint32_t count1x;
+    uint32_t count3x;
+    uint32_t count4x;
+    uint32_t exceptionStatusRef;
+    uint32_t byteOrder;
+    uint32_t registerOrder;
+    uint32_t stoDeviceName;
+    uint32_t stringTableSize;
+    //char stringTable[1];
+} DeviceBlock;
+
+enum DeviceBlockFlag
+{
+    DeviceFlag_Run               = 0x01,
+    DeviceFlag_SharedMemory      = 0x02, // device memory lives in shared segment, no copying (see 'MemoryBlockHeader')
+    DeviceFlag_SharedMemoryOffer = 0x04  // shared memory is offered, script answers by 'PythonFlag_SharedMemory'
+                                         // or 'PythonFlag_CopyMemory' (memory is copied until the answer)
+};
+
+typedef struct
+{
+    uint32_t pycycle;
+    uint32_t flags;
+    uint32_t loopTimeLast; // microseconds
+    uint32_t loopTimeAvg;  // microseconds, exponential moving average
+    uint32_t loopTimeMax;  // microseconds
+    uint32_t loopOverruns; // count of 'Loop'-scripts that were finished after next deadline
+} PythonBlock;
+
+enum PythonBlockFlag
+{
+    PythonFlag_Finished     = 0x01, // 'Final'-script of device was executed by worker process
+    PythonFlag_SharedMemory = 0x02, // script accepts offered shared memory (has atomic compare-and-swap for 'writeLock')
+    PythonFlag_CopyMemory   = 0x04  // script declines offered shared memory, memory is copied
+};
+
+enum
+{
+    MemoryDirtyRangeCount = 16, // count of dirty ranges in 'MemoryBlockHeader'
+    MemoryDirtyPageSize   = 256 // count of memory bytes covered by one bit of dirty-page bitmap
+};
+
+typedef struct
+{
+    uint32_t byteOffset;
+    uint32_t byteCount;
+} MemoryDirtyRange;
+
+// Memory block is 'MemoryBlockHeader', memory bytes, mask bytes and dirty-page bitmap (see 'memoryBlockSize').
+// Script appends every written range into 'ranges' (adjacent ranges are merged). When 'ranges' is full
+// all ranges are moved into dirty-page bitmap and 'pageOverflow' is set, so server applies only touched data.
+// When 'DeviceFlag_SharedMemory' is set 'changeCounter' is used as sequence lock of Python side
+// (odd while script writes memory) and 'sequence' as sequence lock of server side.
+// Both sides write memory only while holding 'writeLock' (0 - free, otherwise process id of the owner,
+// taken by compare-and-swap), so read-modify-write of one side can't overwrite concurrent change of the other one.
+// Lock is taken over only when its owner process is not alive. Script side of sequence lock uses plain stores,
+// so shared mode is used on x86/x64 only where such stores are ordered
+typedef struct
+{
+    uint32_t changeCounter;
+    uint32_t rangeCount;
+    uint32_t pageOverflow;
+    uint32_t sequence;
+    uint32_t writeLock;
+    MemoryDirtyRange ranges[MemoryDirtyRangeCount];
+} MemoryBlockHeader;
+
+inline uint32_t memoryDirtyPagesBytes(uint32_t bytes) { return ((bytes+MemoryDirtyPageSize-1)/MemoryDirtyPageSize+7)/8; }
+inline uint32_t memoryBlockSize(uint32_t bytes) { return sizeof(MemoryBlockHeader)+bytes*2+memoryDirtyPagesBytes(bytes); }
 
 class mbServerRunScriptThread : public QThread
 {
@@ -14,7 +96,32 @@ public:
     explicit mbServerRunScriptThread(mbServerDevice *device, const MBSETTINGS &scripts, QObject *parent = nullptr);
 
 public:
-    inline void stop() { m_ctrlRun = false; }
+    virtual void stop() { m_ctrlRun = false; }
+
+public: // hosted mode: script is executed by shared worker process (see 'mbServerRunScriptWorker')
+    inline bool isHosted() const { return m_hosted; }
+    inline void setHosted(bool hosted) { m_hosted = hosted; }
+    inline bool isReady() const { return m_ready.loadAcquire() != 0; }
+    // Set by worker while its process hosts the script, so 'Final'-script is waited for only then
+    inline bool isHostedRunning() const { return m_hostedRunning.loadAcquire() != 0; }
+    inline void setHostedRunning(bool running) { m_hostedRunning.storeRelease(running); }
+
+public: // arena mode: blocks of device are placed into single shared memory segment (see 'mbServerRunScriptArena')
+    inline mbServerRunScriptArena *arena() const { return m_arena; }
+    inline void setArena(mbServerRunScriptArena *arena) { m_arena = arena; }
+    bool canUseArena() const;
+    void reserveArena(mbServerRunScriptArena *arena) const;
+
+public:
+    static QString processMemoryId();
+    inline QString deviceName() const { return QString::fromUtf8(m_deviceName); }
+    inline const QString &memoryId() const { return m_memId; }
+    inline int scriptLoopPeriod() const { return m_scriptLoopPeriod; }
+    inline const QString &scriptInit() const { return m_scriptInit; }
+    inline const QString &scriptLoop() const { return m_scriptLoop; }
+    inline const QString &scriptFinal() const { return m_scriptFinal; }
+    QString getScriptLoopBody() const;
+    QString getImportPath();
 
 protected:
     void run() override;
@@ -22,25 +129,57 @@ protected:
 private Q_SLOTS:
     void readPyStdOut();
 
-private:
-    QString getImportPath();
+protected:
+    struct MemWork
+    {
+        mbServerDevice::MemoryBlock *devMemBlock;
+        uint devMemChangeCounter;
+        QSharedMemory *shm; // null if memory block is not shared with other process (no locking needed)
+        MemoryBlockHeader *shmHeader;
+        uint8_t *shmMem;
+        uint8_t *shmMask;
+        uint8_t *shmPages; // dirty-page bitmap
+        uint32_t changeCounter;
+    };
+
+protected:
     QString getScriptInit();
     QString getScriptLoop();
     QString getScriptFinal();
+    void initDeviceBlock(DeviceBlock *devMem);
+    void initMemWork(MemWork *memWork, void *const blocks[], QSharedMemory *const shm[]);
+    bool canShareMemory(const MemWork *memWork) const;
+    // Returns true when script answered to offered shared memory (memory is switched into shared mode if accepted)
+    bool checkSharedMemoryAnswer(MemWork *memWork, DeviceBlock *devMem, const PythonBlock *pyMem, QSharedMemory *shmPy, mbServerRunScriptNotify *notify, bool *sharedMemory);
+    void initMemory(MemWork *memWork, bool sharedMemory);
+    void syncMemory(MemWork *memWork, bool sharedMemory);
+    void releaseMemory(MemWork *memWork, bool sharedMemory);
+    void applyChanges(MemWork *memWork, uint32_t byteOffset, uint32_t byteCount);
+    static void updateLoopTime(PythonBlock *pyMem, uint32_t us, bool overrun);
+    void publishStatistic(const PythonBlock &py, bool isRunning);
 
-private:
+protected:
+    enum { StatisticPeriod = 1000 }; // period of script statistic publishing, milliseconds
+
+protected:
     bool m_ctrlRun;
 
-private:
+protected:
     mbServerDevice *m_device;
     QStringList m_settingImportPath;
     QByteArray m_deviceName;
     QString m_pyInterpreter;
     bool m_scriptUseOptimization;
+    bool m_scriptSharedMemory;
     int m_scriptLoopPeriod;
     QString m_scriptInit ;
     QString m_scriptLoop ;
     QString m_scriptFinal;
+    QString m_memId;
+    bool m_hosted;
+    QAtomicInt m_ready;
+    QAtomicInt m_hostedRunning;
+    mbServerRunScriptArena *m_arena;
     QProcess *m_py;
 };
 
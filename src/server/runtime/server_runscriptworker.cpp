@@ -0,0 +1,211 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "server_runscriptworker.h"
+
+#include <QProcess>
+#include <QEventLoop>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <server.h>
+#include <core_filemanager.h>
+#include <project/server_project.h>
+
+#include "server_runscriptthread.h"
+#include "server_runscriptarena.h"
+
+mbServerRunScriptWorker::mbServerRunScriptWorker(int index, const QList<mbServerRunScriptThread*> &devices, QObject *parent) : QThread{parent},
+    m_index(index),
+    m_devices(devices)
+{
+    m_ctrlRun = true;
+    m_pyInterpreter = mbServer::global()->scriptDefaultExecutable();
+    m_py = nullptr;
+    moveToThread(this);
+}
+
+void mbServerRunScriptWorker::run()
+{
+    QEventLoop eloop;
+    mbCoreFileManager *fileManager = mbServer::global()->fileManager();
+
+    mb::Timestamp_t tm;
+    const mb::Timestamp_t timeoutStartStop = 1000;
+
+    m_ctrlRun = true;
+    // Wait until device threads create memory of devices
+    tm = mb::currentTimestamp();
+    while (m_ctrlRun && !isDevicesReady() && (mb::currentTimestamp()-tm < timeoutStartStop))
+        mb::msleep(1);
+    if (!m_ctrlRun)
+        return;
+    if (!isDevicesReady())
+        mbServer::LogWarning("Python", QString("Memory of some devices of worker process %1 is not ready after %2 ms").arg(m_index).arg(timeoutStartStop));
+    if (m_devices.isEmpty())
+        return;
+
+    QString scriptFileName = QString("script_worker_%1.py").arg(m_index);
+    QFile scriptfile;
+    if (!fileManager->createTemporaryFile(scriptFileName, scriptfile, QIODevice::WriteOnly))
+    {
+        mbServer::LogError("Python", QString("Can't create file '%1' to start Python worker process").arg(scriptFileName));
+        return;
+    }
+    QFile qrcfile(":/server/python/scriptworker.py");
+    qrcfile.open(QIODevice::ReadOnly);
+    scriptfile.write(qrcfile.readAll());
+    qrcfile.close();
+    scriptfile.close();
+    scriptfile.open(QIODevice::ReadOnly); // Note: to prevent file deletion
+
+    QString manifestFileName = QString("script_worker_%1.json").arg(m_index);
+    QFile manifestfile;
+    if (!fileManager->createTemporaryFile(manifestFileName, manifestfile, QIODevice::WriteOnly) || !writeManifest(manifestfile))
+    {
+        mbServer::LogError("Python", QString("Can't create file '%1' to start Python worker process").arg(manifestFileName));
+        return;
+    }
+    manifestfile.close();
+    manifestfile.open(QIODevice::ReadOnly); // Note: to prevent file deletion
+
+    QString pyfile = m_pyInterpreter;
+    QStringList args;
+    args << "-u"
+         << QFileInfo(scriptfile).absoluteFilePath()
+         << "--project"    << mbServer::global()->project()->absoluteFilePath()
+         << "--importpath" << m_devices.first()->getImportPath()
+         << "--manifest"   << QFileInfo(manifestfile).absoluteFilePath();
+
+    QProcess py;
+    m_py = &py;
+    py.setProcessChannelMode(QProcess::MergedChannels);
+    connect(m_py, &QProcess::readyReadStandardOutput, this, &mbServerRunScriptWorker::readPyStdOut);
+    mbServer::LogDebug("Python", QString("Try start worker process '%1' with args '%2'").arg(pyfile, args.join(' ')));
+    py.start(pyfile, args);
+
+    // Wait for start
+    tm = mb::currentTimestamp();
+    while (m_ctrlRun && (py.state() != QProcess::Running) && (mb::currentTimestamp()-tm < timeoutStartStop))
+    {
+        eloop.processEvents();
+        mb::msleep(1);
+    }
+
+    if (py.state() != QProcess::Running)
+    {
+        mbServer::LogError("Python", QString("Can't start worker process '%1'").arg(py.program()));
+        m_ctrlRun = false;
+    }
+    else
+        setHostedRunning(true);
+
+    // Main Loop
+    while (m_ctrlRun)
+    {
+        eloop.processEvents();
+        if (py.state() == QProcess::NotRunning)
+        {
+            // Note: process exits normally when scripts of all its devices are finished
+            if (py.exitStatus() == QProcess::CrashExit)
+                mbServer::LogError("Python", QString("Worker process '%1' is crashed").arg(py.program()));
+            else
+                mbServer::LogDebug("Python", QString("Worker process '%1' is finished").arg(py.program()));
+            break;
+        }
+        mb::msleep(10);
+    }
+
+    // Finish process: it exits when 'Final'-scripts of all devices are executed
+    if (py.state() != QProcess::NotRunning)
+    {
+        tm = mb::currentTimestamp();
+        while ((py.state() != QProcess::NotRunning) && (mb::currentTimestamp()-tm < timeoutStartStop*2))
+        {
+            eloop.processEvents();
+            mb::msleep(1);
+        }
+        if (py.state() != QProcess::NotRunning)
+        {
+            mbServer::LogError("Python", QString("Can't stop worker process '%1'. Killing it").arg(py.program()));
+            py.kill();
+            py.waitForFinished(timeoutStartStop);
+        }
+    }
+    setHostedRunning(false);
+    eloop.processEvents();
+    m_py = nullptr;
+}
+
+void mbServerRunScriptWorker::readPyStdOut()
+{
+    mbServer::OutputMessage(QString::fromUtf8(m_py->readAllStandardOutput()));
+}
+
+bool mbServerRunScriptWorker::isDevicesReady() const
+{
+    Q_FOREACH (mbServerRunScriptThread *t, m_devices)
+    {
+        if (!t->isReady())
+            return false;
+    }
+    return true;
+}
+
+void mbServerRunScriptWorker::setHostedRunning(bool running)
+{
+    Q_FOREACH (mbServerRunScriptThread *t, m_hostedDevices)
+        t->setHostedRunning(running);
+}
+
+bool mbServerRunScriptWorker::writeManifest(QFile &file)
+{
+    QJsonArray devices;
+    m_hostedDevices.clear();
+    QString arena;
+    Q_FOREACH (mbServerRunScriptThread *t, m_devices)
+    {
+        if (t->arena())
+            arena = t->arena()->key();
+        if (!t->isReady())
+        {
+            mbServer::LogError("Python", QString("Memory of device '%1' is not ready. Script is skipped").arg(t->deviceName()));
+            continue;
+        }
+        QJsonObject d;
+        d[QStringLiteral("name"  )] = t->deviceName();
+        d[QStringLiteral("memid" )] = t->memoryId();
+        d[QStringLiteral("period")] = t->scriptLoopPeriod();
+        d[QStringLiteral("init"  )] = t->scriptInit();
+        d[QStringLiteral("loop"  )] = t->getScriptLoopBody();
+        d[QStringLiteral("final" )] = t->scriptFinal();
+        devices.append(d);
+        m_hostedDevices.append(t);
+    }
+    QJsonObject root;
+    root[QStringLiteral("arena"  )] = arena;
+    root[QStringLiteral("devices")] = devices;
+    return file.write(QJsonDocument(root).toJson()) >= 0;
+}
@@ -0,0 +1,67 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef SERVER_RUNSCRIPTWORKER_H
+#define SERVER_RUNSCRIPTWORKER_H
+
+#include <QThread>
+#include <mbcore.h>
+
+class QProcess;
+class QFile;
+class mbServerRunScriptThread;
+
+// Controls single Python worker process that executes scripts of several devices.
+// Memory of every device is still synchronized by its own 'mbServerRunScriptThread' in hosted mode.
+class mbServerRunScriptWorker : public QThread
+{
+    Q_OBJECT
+public:
+    explicit mbServerRunScriptWorker(int index, const QList<mbServerRunScriptThread*> &devices, QObject *parent = nullptr);
+
+public:
+    inline int index() const { return m_index; }
+    inline void stop() { m_ctrlRun = false; }
+
+protected:
+    void run() override;
+
+private Q_SLOTS:
+    void readPyStdOut();
+
+private:
+    bool isDevicesReady() const;
+    bool writeManifest(QFile &file);
+    void setHostedRunning(bool running);
+
+private:
+    bool m_ctrlRun;
+
+private:
+    int m_index;
+    QList<mbServerRunScriptThread*> m_devices;
+    QList<mbServerRunScriptThread*> m_hostedDevices; // devices whose scripts are written into manifest
+    QString m_pyInterpreter;
+    QProcess *m_py;
+};
+
+#endif // SERVER_RUNSCRIPTWORKER_H
@@ -22,6 +22,7 @@
 */
 #include "server_runsimaction.h"
 
+#include <server.h>
 #include <project/server_device.h>
 
 mbServerRunSimAction::mbServerRunSimAction(const MBSETTINGS &settings)
@@ -29,9 +30,12 @@ mbServerRunSimAction::mbServerRunSimAction(const MBSETTINGS &settings)
     const mbServerSimAction::Strings &sAction = mbServerSimAction::Strings::instance();
     m_device  = reinterpret_cast<mbServerDevice*>(settings.value(sAction.device).value<void*>());
     m_address = mb::toAddress(settings.value(sAction.address).toInt());
+    m_block   = memoryBlock(m_device, m_address.type());
+    m_bitOffset = bitOffset(m_address);
     m_period  = settings.value(sAction.period).toInt();
     m_byteOrder = mb::getByteOrder(m_device, mb::enumDataOrderValue(settings.value(sAction.byteOrder), mb::LessSignifiedFirst));
     m_registerOrder = mb::getRegisterOrder(m_device, mb::toRegisterOrder(settings.value(sAction.registerOrder), mb::R0R1R2R3));
+    m_swapSize = 0;
 }
 
 mbServerRunSimAction::~mbServerRunSimAction()
@@ -49,30 +53,86 @@ void mbServerRunSimAction::setValue(const QVariant &value)
     m_device->setValue(address(), dataType(), value);
 }
 
-void mbServerRunSimAction::trySwap(void *d, int size)
+void mbServerRunSimAction::initSwap(int size)
 {
-    // TODO: resolve this conditions in compiling stage
-    if ((size > 1) && (m_byteOrder == mb::MostSignifiedFirst))
-        mb::changeByteOrder(d, size);
+    m_swapSize = resolveSwap(size, m_byteOrder, m_registerOrder, m_swapIndex);
+}
+
+void mbServerRunSimAction::swapToMemory(void *values, int count) const
+{
+    swapToMemory(m_swapIndex, m_swapSize, values, count);
+}
+
+void mbServerRunSimAction::swapFromMemory(void *values, int count) const
+{
+    swapFromMemory(m_swapIndex, m_swapSize, values, count);
+}
+
+int mbServerRunSimAction::resolveSwap(int size, mb::DataOrder byteOrder, mb::RegisterOrder registerOrder, quint8 *swapIndex)
+{
+    quint8 index[MaxSwapSize];
+    if ((size < 2) || (size > MaxSwapSize))
+        return 0;
+    for (int i = 0; i < size; i++)
+        index[i] = static_cast<quint8>(i);
+    // Note: swap is applied to byte indexes, so result is permutation of bytes
+    if (byteOrder == mb::MostSignifiedFirst)
+        mb::changeByteOrder(index, size);
     switch (size)
     {
     case 4:
-        if (mb::toDataOrder(m_registerOrder) == mb::MostSignifiedFirst)
-            mb::swapRegisters32(d);
+        if (mb::toDataOrder(registerOrder) == mb::MostSignifiedFirst)
+            mb::swapRegisters32(index);
         break;
     case 8:
-        mb::swapRegisters64(d, m_registerOrder);
+        mb::swapRegisters64(index, registerOrder);
         break;
     }
+    for (int i = 0; i < size; i++)
+    {
+        if (index[i] != i)
+        {
+            memcpy(swapIndex, index, static_cast<size_t>(size));
+            return size;
+        }
+    }
+    return 0;
 }
 
-int mbServerRunSimAction::init(qint64 time)
+void mbServerRunSimAction::swapToMemory(const quint8 *swapIndex, int swapSize, void *values, int count)
+{
+    if (!swapSize)
+        return;
+    quint8 tmp[MaxSwapSize];
+    quint8 *p = reinterpret_cast<quint8*>(values);
+    for (int i = 0; i < count; i++, p += swapSize)
+    {
+        memcpy(tmp, p, static_cast<size_t>(swapSize));
+        for (int j = 0; j < swapSize; j++)
+            p[j] = tmp[swapIndex[j]];
+    }
+}
+
+void mbServerRunSimAction::swapFromMemory(const quint8 *swapIndex, int swapSize, void *values, int count)
+{
+    if (!swapSize)
+        return;
+    quint8 tmp[MaxSwapSize];
+    quint8 *p = reinterpret_cast<quint8*>(values);
+    for (int i = 0; i < count; i++, p += swapSize)
+    {
+        memcpy(tmp, p, static_cast<size_t>(swapSize));
+        for (int j = 0; j < swapSize; j++)
+            p[swapIndex[j]] = tmp[j];
+    }
+}
+
+int mbServerRunSimAction::init(qint64 /*time*/)
 {
-    m_last = time;
     return 0;
 }
 
-int mbServerRunSimAction::exec(qint64 /*time*/)
+int mbServerRunSimAction::exec(qint64 /*time*/, Batch &/*batch*/)
 {
     return 0;
 }
@@ -144,6 +204,16 @@ mbServerRunSimAction *createRunActionCopy(const MBSETTINGS &settings)
     return new mbServerRunSimActionCopy(settings);
 }
 
+mbServerRunSimAction *createRunActionExpression(const MBSETTINGS &settings)
+{
+    return new mbServerRunSimActionExpression(settings);
+}
+
+mbServerRunSimAction *createRunActionPlayback(const MBSETTINGS &settings)
+{
+    return new mbServerRunSimActionPlayback(settings);
+}
+
 mbServerRunSimActionCopy::mbServerRunSimActionCopy(const MBSETTINGS &settings) : mbServerRunSimAction(settings)
 {
     const mbServerSimAction::Strings &s = mbServerSimAction::Strings::instance();
@@ -153,78 +223,237 @@ mbServerRunSimActionCopy::mbServerRunSimActionCopy(const MBSETTINGS &settings) :
     switch (m_dataType)
     {
     case mb::Bit:
-        m_srcCount = count;
-        m_dstCount = count;
-        m_buffer.resize((count+7)/8);
-        switch (sourceAddress.type())
-        {
-        case Modbus::Memory_0x: m_methodRead = &mbServerDevice::read_0x    ; m_src = sourceAddress.offset()   ; break;
-        case Modbus::Memory_1x: m_methodRead = &mbServerDevice::read_1x    ; m_src = sourceAddress.offset()   ; break;
-        case Modbus::Memory_3x: m_methodRead = &mbServerDevice::read_3x_bit; m_src = sourceAddress.offset()*16; break;
-        default               : m_methodRead = &mbServerDevice::read_4x_bit; m_src = sourceAddress.offset()*16; break;
-        }
-
-        switch (m_address.type())
-        {
-        case Modbus::Memory_0x: m_methodWrite = &mbServerDevice::write_0x    ; m_dst = m_address.offset()   ; break;
-        case Modbus::Memory_1x: m_methodWrite = &mbServerDevice::write_1x    ; m_dst = m_address.offset()   ; break;
-        case Modbus::Memory_3x: m_methodWrite = &mbServerDevice::write_3x_bit; m_dst = m_address.offset()*16; break;
-        default               : m_methodWrite = &mbServerDevice::write_4x_bit; m_dst = m_address.offset()*16; break;
-        }
+        m_bitCount = count;
         break;
     case mb::Int8:
     case mb::UInt8:
-        m_srcCount = count * 8;
-        m_dstCount = count * 8;
-        m_buffer.resize(count);
-        switch (sourceAddress.type())
-        {
-        case Modbus::Memory_0x: m_methodRead = &mbServerDevice::read_0x    ; m_src = sourceAddress.offset()   ; break;
-        case Modbus::Memory_1x: m_methodRead = &mbServerDevice::read_1x    ; m_src = sourceAddress.offset()   ; break;
-        case Modbus::Memory_3x: m_methodRead = &mbServerDevice::read_3x_bit; m_src = sourceAddress.offset()*16; break;
-        default               : m_methodRead = &mbServerDevice::read_4x_bit; m_src = sourceAddress.offset()*16; break;
-        }
-
-        switch (m_address.type())
-        {
-        case Modbus::Memory_0x: m_methodWrite = &mbServerDevice::write_0x    ; m_dst = m_address.offset()   ; break;
-        case Modbus::Memory_1x: m_methodWrite = &mbServerDevice::write_1x    ; m_dst = m_address.offset()   ; break;
-        case Modbus::Memory_3x: m_methodWrite = &mbServerDevice::write_3x_bit; m_dst = m_address.offset()*16; break;
-        default               : m_methodWrite = &mbServerDevice::write_4x_bit; m_dst = m_address.offset()*16; break;
-        }
+        m_bitCount = count * MB_BYTE_SZ_BITES;
         break;
     default:
+        m_bitCount = mb::sizeOfDataType(m_dataType) * count * MB_BYTE_SZ_BITES;
+        break;
+    }
+    m_buffer.resize((m_bitCount+MB_BYTE_SZ_BITES-1)/MB_BYTE_SZ_BITES);
+    m_srcBlock = memoryBlock(m_device, sourceAddress.type());
+    m_src = bitOffset(sourceAddress);
+}
+
+int mbServerRunSimActionCopy::exec(qint64 /*time*/, Batch &batch)
+{
+    // Note: source block can't be read by its own methods when it's the block locked by 'batch'
+    Modbus::StatusCode r;
+    if (m_srcBlock == m_block)
+        r = batch.readBits(m_src, m_bitCount, m_buffer.data());
+    else
+        r = m_srcBlock->readBits(m_src, m_bitCount, m_buffer.data());
+    if (!Modbus::StatusIsGood(r))
+        return -1;
+    batch.writeBits(m_bitOffset, m_bitCount, m_buffer.data());
+    return 0;
+}
+
+static double rawToDouble(mb::DataType dataType, const void *raw)
+{
+    switch (dataType)
+    {
+    case mb::Bit     : return (*reinterpret_cast<const quint8 *>(raw) & 1);
+    case mb::Int8    : return *reinterpret_cast<const qint8  *>(raw);
+    case mb::UInt8   : return *reinterpret_cast<const quint8 *>(raw);
+    case mb::Int16   : return *reinterpret_cast<const qint16 *>(raw);
+    case mb::UInt16  : return *reinterpret_cast<const quint16*>(raw);
+    case mb::Int32   : return *reinterpret_cast<const qint32 *>(raw);
+    case mb::UInt32  : return *reinterpret_cast<const quint32*>(raw);
+    case mb::Int64   : return static_cast<double>(*reinterpret_cast<const qint64 *>(raw));
+    case mb::UInt64  : return static_cast<double>(*reinterpret_cast<const quint64*>(raw));
+    case mb::Float32 : return *reinterpret_cast<const float  *>(raw);
+    case mb::Double64: return *reinterpret_cast<const double *>(raw);
+    default:
+        return 0.0;
+    }
+}
+
+
+static void doubleToRaw(mb::DataType dataType, double v, void *raw)
+{
+    switch (dataType)
+    {
+    case mb::Bit     : *reinterpret_cast<quint8 *>(raw) = (v == v) && (v != 0.0); break;
+    case mb::Int8    : *reinterpret_cast<qint8  *>(raw) = clampCast<qint8  >(v); break;
+    case mb::UInt8   : *reinterpret_cast<quint8 *>(raw) = clampCast<quint8 >(v); break;
+    case mb::Int16   : *reinterpret_cast<qint16 *>(raw) = clampCast<qint16 >(v); break;
+    case mb::UInt16  : *reinterpret_cast<quint16*>(raw) = clampCast<quint16>(v); break;
+    case mb::Int32   : *reinterpret_cast<qint32 *>(raw) = clampCast<qint32 >(v); break;
+    case mb::UInt32  : *reinterpret_cast<quint32*>(raw) = clampCast<quint32>(v); break;
+    case mb::Int64   : *reinterpret_cast<qint64 *>(raw) = clampCast<qint64 >(v); break;
+    case mb::UInt64  : *reinterpret_cast<quint64*>(raw) = clampCast<quint64>(v); break;
+    case mb::Float32 : *reinterpret_cast<float  *>(raw) = clampCast<float>(v); break;
+    case mb::Double64: *reinterpret_cast<double *>(raw) = v; break;
+    default:
+        break;
+    }
+}
+
+static uint dataTypeBitCount(mb::DataType dataType)
+{
+    if (dataType == mb::Bit)
+        return 1;
+    return mb::sizeOfDataType(dataType) * MB_BYTE_SZ_BITES;
+}
+
+mbServerRunSimActionExpression::mbServerRunSimActionExpression(const MBSETTINGS &settings) : mbServerRunSimAction(settings)
+{
+    const mbServerSimAction::Strings &s = mbServerSimAction::Strings::instance();
+    m_dataType = mb::enumDataTypeValue(settings.value(s.dataType));
+    m_evaluated = false;
+    initSwap(static_cast<int>(mb::sizeOfDataType(m_dataType)));
+
+    QString source = settings.value(s.expression).toString();
+    m_valid = m_expression.compile(source, m_dataType);
+    if (!m_valid)
     {
-        uint sz = mb::sizeOfDataType(m_dataType) * count;
-        m_src = sourceAddress.offset();
-        m_dst = m_address.offset();
-        m_buffer.resize(sz);
-        switch (sourceAddress.type())
+        mbServer::LogError(QStringLiteral("Simulation"), QString("Expression '%1' of action '%2' is not compiled: %3")
+                                                         .arg(source, mb::toString(m_address), m_expression.errorString()));
+        return;
+    }
+    Q_FOREACH (const mbServerRunSimExpression::Reference &r, m_expression.references())
+    {
+        Input in;
+        in.block = memoryBlock(m_device, r.address.type());
+        in.bitOffset = bitOffset(r.address);
+        in.bitCount = dataTypeBitCount(r.dataType);
+        in.dataType = r.dataType;
+        in.swapSize = resolveSwap(static_cast<int>(mb::sizeOfDataType(r.dataType)), m_byteOrder, m_registerOrder, in.swapIndex);
+        m_inputs.append(in);
+    }
+    m_raw.fill('\0', m_inputs.count()*MaxSwapSize);
+    m_rawLast.fill('\0', m_inputs.count()*MaxSwapSize);
+    m_values.resize(m_inputs.count());
+}
+
+int mbServerRunSimActionExpression::exec(qint64 /*time*/, Batch &batch)
+{
+    if (!m_valid)
+        return -1;
+    char *raw = m_raw.data();
+    for (int i = 0; i < m_inputs.count(); i++)
+    {
+        const Input &in = m_inputs.at(i);
+        // Note: block locked by 'batch' can't be read by its own methods
+        Modbus::StatusCode r;
+        if (in.block == m_block)
+            r = batch.readBits(in.bitOffset, in.bitCount, raw+i*MaxSwapSize);
+        else
+            r = in.block->readBits(in.bitOffset, in.bitCount, raw+i*MaxSwapSize);
+        if (!Modbus::StatusIsGood(r))
+            return -1;
+    }
+    if (m_evaluated && (memcmp(raw, m_rawLast.constData(), static_cast<size_t>(m_raw.size())) == 0))
+        return 0; // inputs are not changed since last evaluation
+    memcpy(m_rawLast.data(), raw, static_cast<size_t>(m_raw.size()));
+
+    for (int i = 0; i < m_inputs.count(); i++)
+    {
+        const Input &in = m_inputs.at(i);
+        quint8 v[MaxSwapSize];
+        memcpy(v, raw+i*MaxSwapSize, MaxSwapSize);
+        swapFromMemory(in.swapIndex, in.swapSize, v, 1);
+        m_values[i] = rawToDouble(in.dataType, v);
+    }
+    quint8 out[MaxSwapSize] = {};
+    doubleToRaw(m_dataType, m_expression.evaluate(m_values.constData()), out);
+    swapToMemory(out, 1);
+    batch.writeBits(m_bitOffset, dataTypeBitCount(m_dataType), out);
+    m_evaluated = true;
+    return 0;
+}
+
+mbServerRunSimActionPlayback::mbServerRunSimActionPlayback(const MBSETTINGS &settings) : mbServerRunSimAction(settings)
+{
+    const mbServerSimAction::Strings &s = mbServerSimAction::Strings::instance();
+    m_dataType = mb::enumDataTypeValue(settings.value(s.dataType));
+    m_fileName = settings.value(s.playbackFile).toString();
+    m_speed = settings.value(s.playbackSpeed, 1.0).toDouble();
+    if (m_speed <= 0.0)
+        m_speed = 1.0;
+    m_loop = settings.value(s.playbackLoop, true).toBool();
+    m_interpolation = settings.value(s.playbackInterpolation).toBool();
+    m_size = settings.value(s.playbackSize, 1).toInt();
+    if (m_size < 1)
+        m_size = 1;
+    m_channels = 0;
+    m_start = 0;
+    m_index = 0;
+    initSwap(static_cast<int>(mb::sizeOfDataType(m_dataType)));
+}
+
+int mbServerRunSimActionPlayback::init(qint64 time)
+{
+    // Note: trace is opened (and converted from CSV if needed) in sim task thread, not in GUI thread
+    if (!m_trace.open(m_fileName))
+    {
+        mbServer::LogError(QStringLiteral("Simulation"), QString("Playback of action '%1' is not started: %2")
+                                                         .arg(mb::toString(m_address), m_trace.errorString()));
+        return -1;
+    }
+    m_channels = qMin(m_size, m_trace.channelCount());
+    m_values.resize(m_channels);
+    m_buffer.fill('\0', m_channels*MaxSwapSize);
+    m_start = time;
+    m_index = 0;
+    return 0;
+}
+
+int mbServerRunSimActionPlayback::exec(qint64 time, Batch &batch)
+{
+    if (!m_trace.isOpen())
+        return -1;
+    qint64 duration = m_trace.lastTimestamp() - m_trace.firstTimestamp();
+    qint64 t = static_cast<qint64>(static_cast<double>(time - m_start) * m_speed);
+    if (m_loop)
+        t = (duration > 0) ? (t % duration) : 0;
+    else if (t > duration)
+        t = duration; // the last record is held when playback is finished
+    t += m_trace.firstTimestamp();
+
+    m_index = m_trace.find(t, m_index);
+    qint64 t0 = m_trace.timestamp(m_index);
+    const double *v = m_trace.values(m_index);
+    if (!v)
+        return -1;
+    memcpy(m_values.data(), v, sizeof(double)*static_cast<size_t>(m_channels));
+    if (m_interpolation && (m_index+1 < m_trace.recordCount()))
+    {
+        qint64 t1 = m_trace.timestamp(m_index+1);
+        const double *v1 = m_trace.values(m_index+1);
+        if (v1 && (t1 > t0) && (t > t0))
         {
-        case Modbus::Memory_0x: m_methodRead = &mbServerDevice::read_0x; m_srcCount = sz*8; break;
-        case Modbus::Memory_1x: m_methodRead = &mbServerDevice::read_1x; m_srcCount = sz*8; break;
-        case Modbus::Memory_3x: m_methodRead = &mbServerDevice::read_3x; m_srcCount = sz/2; break;
-        default               : m_methodRead = &mbServerDevice::read_4x; m_srcCount = sz/2; break;
+            double k = static_cast<double>(t - t0) / static_cast<double>(t1 - t0);
+            for (int i = 0; i < m_channels; i++)
+                m_values[i] += (v1[i] - m_values[i]) * k;
         }
+    }
 
-        switch (m_address.type())
+    const uint bitCount = dataTypeBitCount(m_dataType);
+    if (m_dataType == mb::Bit)
+    {
+        for (int i = 0; i < m_channels; i++)
         {
-        case Modbus::Memory_0x: m_methodWrite = &mbServerDevice::write_0x; m_dstCount = sz*8; break;
-        case Modbus::Memory_1x: m_methodWrite = &mbServerDevice::write_1x; m_dstCount = sz*8; break;
-        case Modbus::Memory_3x: m_methodWrite = &mbServerDevice::write_3x; m_dstCount = sz/2; break;
-        default               : m_methodWrite = &mbServerDevice::write_4x; m_dstCount = sz/2; break;
+            quint8 b = (m_values.at(i) != 0.0);
+            batch.writeBits(m_bitOffset+static_cast<uint>(i), 1, &b);
         }
+        return 0;
     }
-        break;
-    }
+    const int size = static_cast<int>(mb::sizeOfDataType(m_dataType));
+    char *out = m_buffer.data();
+    for (int i = 0; i < m_channels; i++)
+        doubleToRaw(m_dataType, m_values.at(i), out+i*size);
+    swapToMemory(out, m_channels);
+    batch.writeBits(m_bitOffset, bitCount*static_cast<uint>(m_channels), out);
+    return 0;
 }
 
-int mbServerRunSimActionCopy::exec(qint64 time)
+int mbServerRunSimActionPlayback::final(qint64 /*time*/)
 {
-    if (((time-this->m_last) >= this->m_period))
-    {
-        (m_device->*m_methodRead )(m_src, m_srcCount, m_buffer.data(), nullptr);
-        (m_device->*m_methodWrite)(m_dst, m_dstCount, m_buffer.data(), nullptr);
-    }
+    m_trace.close();
     return 0;
 }
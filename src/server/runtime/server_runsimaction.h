@@ -23,16 +23,63 @@
 #ifndef SERVER_RUNSIMACTION_H
 #define SERVER_RUNSIMACTION_H
 
+#include <type_traits>
+#include <limits>
+
 #include <QtMath>
 #include <QVariant>
+#include <QVector>
 
 #include <mbcore.h>
+#include <project/server_device.h>
 #include <project/server_simaction.h>
 
-class mbServerDevice;
+#include "server_runsimexpression.h"
+#include "server_runsimtrace.h"
+
+// Converts 'v' to type 'T' saturating it to range of 'T' (NaN is converted to 0),
+// because out of range floating to integer conversion is undefined behavior
+template <typename T>
+inline T clampCast(double v)
+{
+    if (v != v)
+        return 0;
+    if (v <= static_cast<double>(std::numeric_limits<T>::min()))
+        return std::numeric_limits<T>::min();
+    // Note: max of 64-bit type is rounded up when converted to double,
+    //       so '>=' is used to keep result in range
+    if (v >= static_cast<double>(std::numeric_limits<T>::max()))
+        return std::numeric_limits<T>::max();
+    return static_cast<T>(v);
+}
+
+template <>
+inline bool clampCast<bool>(double v)
+{
+    return static_cast<bool>(v);
+}
+
+template <>
+inline float clampCast<float>(double v)
+{
+    if (v > static_cast<double>(std::numeric_limits<float>::max()) && v != std::numeric_limits<double>::infinity())
+        return std::numeric_limits<float>::max();
+    if (v < static_cast<double>(std::numeric_limits<float>::lowest()) && v != -std::numeric_limits<double>::infinity())
+        return std::numeric_limits<float>::lowest();
+    return static_cast<float>(v);
+}
+
+template <>
+inline double clampCast<double>(double v)
+{
+    return v;
+}
 
 class mbServerRunSimAction
 {
+public:
+    typedef mbServerDevice::MemoryBlock::Batch Batch;
+
 public:
     mbServerRunSimAction(const MBSETTINGS &settings);
     virtual ~mbServerRunSimAction();
@@ -42,30 +89,95 @@ public:
     inline mb::Address address() const { return m_address; }
     virtual mb::DataType dataType() const = 0;
     inline int period() const { return m_period; }
+    inline mbServerDevice::MemoryBlock *memoryBlock() const { return m_block; }
+    inline uint bitOffset() const { return m_bitOffset; }
     QVariant value() const;
     void setValue(const QVariant &value);
-    void trySwap(void *d, int size);
+
+public:
+    static mbServerDevice::MemoryBlock *memoryBlock(mbServerDevice *device, Modbus::MemoryType memoryType);
+    static uint bitOffset(mb::Address address);
+    // Returns size of swap permutation 'swapIndex' for value of 'size' bytes or 0 if value isn't swapped
+    static int resolveSwap(int size, mb::DataOrder byteOrder, mb::RegisterOrder registerOrder, quint8 *swapIndex);
+    static void swapToMemory(const quint8 *swapIndex, int swapSize, void *values, int count);
+    static void swapFromMemory(const quint8 *swapIndex, int swapSize, void *values, int count);
 
 public:
     virtual int init(qint64 time);
-    virtual int exec(qint64 time);
+    // Note: 'exec' is called by task scheduler when action is due,
+    // 'batch' holds write lock of 'memoryBlock()' for all due actions of that block
+    virtual int exec(qint64 time, Batch &batch);
     virtual int final(qint64 time);
 
 protected:
+    // Byte and register order of value with 'size' bytes is resolved once,
+    // so 'swapToMemory'/'swapFromMemory' is a plain byte permutation (or nothing)
+    void initSwap(int size);
+    void swapToMemory(void *values, int count) const;
+    void swapFromMemory(void *values, int count) const;
+
+protected:
+    enum { MaxSwapSize = 8 };
+
     mbServerDevice *m_device;
+    mbServerDevice::MemoryBlock *m_block;
     mb::Address m_address;
+    uint m_bitOffset;
     int m_period;
-    qint64 m_last;
     mb::DataOrder m_byteOrder;
     mb::RegisterOrder m_registerOrder;
+    int m_swapSize;         // size of the value if swap is needed, 0 otherwise
+    quint8 m_swapIndex[MaxSwapSize]; // memory byte 'i' of the value is native byte 'm_swapIndex[i]'
 };
 
+// Base for actions that drive array of 'size' consecutive values of type 'T' (single value if 'size' is 1)
 template <typename T>
 class mbServerRunSimActionT : public mbServerRunSimAction
 {
 public:
-    mbServerRunSimActionT(const MBSETTINGS &settings) : mbServerRunSimAction(settings) {}
+    mbServerRunSimActionT(const MBSETTINGS &settings, const QString &sizeKey) : mbServerRunSimAction(settings)
+    {
+        int size = settings.value(sizeKey, 1).toInt();
+        m_values.resize(size > 0 ? size : 1);
+        initSwap(sizeof(T));
+    }
     mb::DataType dataType() const override { return mb::dataTypeFromT<T>(); }
+
+protected:
+    enum { BitCount = std::is_same<T, bool>::value ? 1 : sizeof(T)*MB_BYTE_SZ_BITES };
+
+    Modbus::StatusCode readValues(const Batch &batch)
+    {
+        Modbus::StatusCode r;
+        if (std::is_same<T, bool>::value) // bool array is packed into bits
+        {
+            for (int i = 0; i < m_values.count(); i++)
+            {
+                r = batch.readBits(this->m_bitOffset+static_cast<uint>(i), 1, &m_values[i]);
+                if (!Modbus::StatusIsGood(r))
+                    return r;
+            }
+            return Modbus::Status_Good;
+        }
+        r = batch.readBits(this->m_bitOffset, static_cast<uint>(m_values.count())*BitCount, m_values.data());
+        this->swapFromMemory(m_values.data(), m_values.count());
+        return r;
+    }
+
+    Modbus::StatusCode writeValues(Batch &batch)
+    {
+        if (std::is_same<T, bool>::value)
+        {
+            for (int i = 0; i < m_values.count(); i++)
+                batch.writeBits(this->m_bitOffset+static_cast<uint>(i), 1, &m_values[i]);
+            return Modbus::Status_Good;
+        }
+        this->swapToMemory(m_values.data(), m_values.count());
+        return batch.writeBits(this->m_bitOffset, static_cast<uint>(m_values.count())*BitCount, m_values.data());
+    }
+
+protected:
+    QVector<T> m_values;
 };
 
 
@@ -73,7 +185,7 @@ template <typename T>
 class mbServerRunSimActionIncrement : public mbServerRunSimActionT<T>
 {
 public:
-    mbServerRunSimActionIncrement(const MBSETTINGS &settings) : mbServerRunSimActionT<T>(settings)
+    mbServerRunSimActionIncrement(const MBSETTINGS &settings) : mbServerRunSimActionT<T>(settings, mbServerSimAction::Strings::instance().incrementSize)
     {
         m_increment = settings.value(mbServerSimAction::Strings::instance().incrementValue).value<T>();
         m_min = settings.value(mbServerSimAction::Strings::instance().incrementMin).value<T>();
@@ -81,20 +193,18 @@ public:
     }
 
 public:
-    int exec(qint64 time) override
+    int exec(qint64 /*time*/, mbServerRunSimAction::Batch &batch) override
     {
-        if (time-this->m_last >= this->m_period)
+        if (!Modbus::StatusIsGood(this->readValues(batch)))
+            return -1;
+        T *v = this->m_values.data();
+        const int c = this->m_values.count();
+        for (int i = 0; i < c; i++)
         {
-            QVariant v = this->value();
-            T t = v.value<T>();
-            mbServerRunSimAction::trySwap(&t, sizeof(t));
-            t += m_increment;
-            if ((t < m_min) || (t > m_max))
-                t = m_min;
-            mbServerRunSimAction::trySwap(&t, sizeof(t));
-            this->setValue(t);
-            this->m_last = time;
+            T t = v[i] + m_increment;
+            v[i] = ((t < m_min) || (t > m_max)) ? m_min : t;
         }
+        this->writeValues(batch);
         return 0;
     }
 
@@ -108,7 +218,7 @@ template <typename T>
 class mbServerRunSimActionSine : public mbServerRunSimActionT<T>
 {
 public:
-    mbServerRunSimActionSine(const MBSETTINGS &settings) : mbServerRunSimActionT<T>(settings)
+    mbServerRunSimActionSine(const MBSETTINGS &settings) : mbServerRunSimActionT<T>(settings, mbServerSimAction::Strings::instance().sineSize)
     {
         const mbServerSimAction::Strings &s = mbServerSimAction::Strings::instance();
         m_sinePeriod = settings.value(s.sinePeriod).toDouble();
@@ -117,19 +227,28 @@ public:
         m_phaseShift    = settings.value(s.sinePhaseShift   ).toLongLong();
         m_amplitude     = settings.value(s.sineAmplitude    ).toDouble();
         m_verticalShift = settings.value(s.sineVerticalShift).toDouble();
+        // element 'i' is shifted by 'i*elementPhaseShift', so its angle is rotated by constant step
+        qreal step = -static_cast<qreal>(settings.value(s.sineElementPhaseShift).toLongLong())/m_sinePeriod*2*M_PI;
+        m_stepSin = qSin(step);
+        m_stepCos = qCos(step);
     }
 
 public:
-    int exec(qint64 time) override
+    int exec(qint64 time, mbServerRunSimAction::Batch &batch) override
     {
-        if (((time-this->m_last) >= this->m_period))
+        qreal x = static_cast<qreal>(time-m_phaseShift)/m_sinePeriod*2*M_PI;
+        qreal sn = qSin(x);
+        qreal cs = qCos(x);
+        T *v = this->m_values.data();
+        const int c = this->m_values.count();
+        for (int i = 0; i < c; i++)
         {
-            qreal x = static_cast<qreal>(time-m_phaseShift)/m_sinePeriod;
-            T v = static_cast<T>(m_amplitude*qSin(x*2*M_PI)+m_verticalShift);
-            mbServerRunSimAction::trySwap(&v, sizeof(v));
-            this->setValue(v);
-            this->m_last = time;
+            v[i] = clampCast<T>(m_amplitude*sn+m_verticalShift);
+            qreal t = sn*m_stepCos + cs*m_stepSin;
+            cs = cs*m_stepCos - sn*m_stepSin;
+            sn = t;
         }
+        this->writeValues(batch);
         return 0;
     }
 
@@ -138,13 +257,15 @@ private:
     qint64 m_phaseShift;
     qreal m_amplitude;
     qreal m_verticalShift;
+    qreal m_stepSin;
+    qreal m_stepCos;
 };
 
 template <typename T>
 class mbServerRunSimActionRandom : public mbServerRunSimActionT<T>
 {
 public:
-    mbServerRunSimActionRandom(const MBSETTINGS &settings) : mbServerRunSimActionT<T>(settings)
+    mbServerRunSimActionRandom(const MBSETTINGS &settings) : mbServerRunSimActionT<T>(settings, mbServerSimAction::Strings::instance().randomSize)
     {
         const mbServerSimAction::Strings &s = mbServerSimAction::Strings::instance();
         m_min   = settings.value(s.randomMin).toDouble();
@@ -152,16 +273,16 @@ public:
     }
 
 public:
-    int exec(qint64 time) override
+    int exec(qint64 /*time*/, mbServerRunSimAction::Batch &batch) override
     {
-        if (((time-this->m_last) >= this->m_period))
+        T *v = this->m_values.data();
+        const int c = this->m_values.count();
+        for (int i = 0; i < c; i++)
         {
             qreal x = static_cast<qreal>(RAND_MAX-qrand())/static_cast<qreal>(RAND_MAX); // koef is [0;1]
-            T v = static_cast<T>(x*m_range+m_min);
-            mbServerRunSimAction::trySwap(&v, sizeof(v));
-            this->setValue(v);
-            this->m_last = time;
+            v[i] = clampCast<T>(x*m_range+m_min);
         }
+        this->writeValues(batch);
         return 0;
     }
 
@@ -170,6 +291,39 @@ private:
     qreal m_range;
 };
 
+// Value is calculated by compiled expression over device registers,
+// expression is evaluated again only when any of its input values is changed
+class mbServerRunSimActionExpression : public mbServerRunSimAction
+{
+public:
+    mbServerRunSimActionExpression(const MBSETTINGS &settings);
+    mb::DataType dataType() const override { return m_dataType; }
+
+public:
+    int exec(qint64 time, Batch &batch) override;
+
+private:
+    struct Input
+    {
+        mbServerDevice::MemoryBlock *block;
+        uint bitOffset;
+        uint bitCount;
+        mb::DataType dataType;
+        int swapSize;
+        quint8 swapIndex[MaxSwapSize];
+    };
+
+private:
+    mb::DataType m_dataType;
+    mbServerRunSimExpression m_expression;
+    bool m_valid;
+    bool m_evaluated;
+    QVector<Input> m_inputs;
+    QByteArray m_raw;     // raw input values read by current 'exec', 'MaxSwapSize' bytes per input
+    QByteArray m_rawLast; // raw input values of the last evaluation
+    QVector<double> m_values;
+};
+
 class mbServerRunSimActionCopy : public mbServerRunSimAction
 {
 public:
@@ -177,24 +331,49 @@ public:
     mb::DataType dataType() const override { return m_dataType; }
 
 public:
-    int exec(qint64 time) override;
+    int exec(qint64 time, Batch &batch) override;
 
 private:
-    typedef Modbus::StatusCode (mbServerDevice::*MethodRead )(uint bitOffset, uint bitCount, void* bites, uint *fact) const;
-    typedef Modbus::StatusCode (mbServerDevice::*MethodWrite)(uint bitOffset, uint bitCount, const void* bites, uint *fact);
-    MethodRead  m_methodRead;
-    MethodWrite m_methodWrite;
     mb::DataType m_dataType;
-    uint m_dst;
+    mbServerDevice::MemoryBlock *m_srcBlock;
     uint m_src;
-    uint m_dstCount;
-    uint m_srcCount;
+    uint m_bitCount;
     QByteArray m_buffer;
 };
 
+// Recorded trace is streamed into 'size' consecutive values (one value per trace channel),
+// trace time is scaled by 'speed' and can be looped and linearly interpolated between records
+class mbServerRunSimActionPlayback : public mbServerRunSimAction
+{
+public:
+    mbServerRunSimActionPlayback(const MBSETTINGS &settings);
+    mb::DataType dataType() const override { return m_dataType; }
+
+public:
+    int init(qint64 time) override;
+    int exec(qint64 time, Batch &batch) override;
+    int final(qint64 time) override;
+
+private:
+    mb::DataType m_dataType;
+    QString m_fileName;
+    double m_speed;
+    bool m_loop;
+    bool m_interpolation;
+    int m_size;
+    mbServerRunSimTrace m_trace;
+    int m_channels;         // count of written channels
+    qint64 m_start;         // time of playback start
+    qint64 m_index;         // current trace record
+    QVector<double> m_values;
+    QByteArray m_buffer;    // values to be written into memory, 'MaxSwapSize' bytes per value
+};
+
 mbServerRunSimAction *createRunActionIncrement(mb::DataType dataType, const MBSETTINGS &settings);
 mbServerRunSimAction *createRunActionSine     (mb::DataType dataType, const MBSETTINGS &settings);
 mbServerRunSimAction *createRunActionRandom   (mb::DataType dataType, const MBSETTINGS &settings);
 mbServerRunSimAction *createRunActionCopy     (const MBSETTINGS &settings);
+mbServerRunSimAction *createRunActionExpression(const MBSETTINGS &settings);
+mbServerRunSimAction *createRunActionPlayback (const MBSETTINGS &settings);
 
 #endif // SERVER_RUNSIMACTION_H
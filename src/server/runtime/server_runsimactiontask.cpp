@@ -23,13 +23,25 @@
 #include "server_runsimactiontask.h"
 
 #include <QDateTime>
+#include <QHash>
+#include <QSet>
 
 #include "server_runsimaction.h"
 
+#include <project/server_project.h>
 #include <project/server_simaction.h>
 
 mbServerRunSimActionTask::mbServerRunSimActionTask(QObject *parent) : mbCoreTask(parent)
 {
+    m_timeBase = 0;
+    m_tick = 0;
+    m_project = nullptr;
+    m_worker = 0;
+    m_lastPublish = 0;
+    m_busy = 0;
+    m_execs = 0;
+    m_loops = 0;
+    m_loopMax = 0;
 }
 
 mbServerRunSimActionTask::~mbServerRunSimActionTask()
@@ -39,6 +51,8 @@ mbServerRunSimActionTask::~mbServerRunSimActionTask()
 
 void mbServerRunSimActionTask::setActions(const QList<mbServerSimAction *> &actions)
 {
+    QHash<mbServerDevice::MemoryBlock*, int> groups;
+    QSet<mbServerDevice*> devices;
     Q_FOREACH(mbServerSimAction *i, actions)
     {
         if (!i->device())
@@ -60,32 +74,163 @@ void mbServerRunSimActionTask::setActions(const QList<mbServerSimAction *> &acti
         case mbServerSimAction::Copy:
             item = createRunActionCopy(s);
             break;
+        case mbServerSimAction::Expression:
+            item = createRunActionExpression(s);
+            break;
+        case mbServerSimAction::Playback:
+            item = createRunActionPlayback(s);
+            break;
         }
         if (item)
+        {
             m_actions.append(item);
+            int group = groups.value(item->memoryBlock(), -1);
+            if (group < 0)
+            {
+                group = m_groups.count();
+                Group g;
+                g.block = item->memoryBlock();
+                m_groups.append(g);
+                groups.insert(g.block, group);
+            }
+            Item it;
+            it.action = item;
+            it.group = group;
+            it.due = 0;
+            m_items.append(it);
+            devices.insert(item->device());
+        }
     }
+    m_stat.devices = static_cast<quint32>(devices.count());
+    m_stat.actions = static_cast<quint32>(m_items.count());
+}
+
+void mbServerRunSimActionTask::setWorker(mbServerProject *project, int worker)
+{
+    m_project = project;
+    m_worker = worker;
 }
 
 int mbServerRunSimActionTask::init()
 {
-    qint64 time = QDateTime::currentMSecsSinceEpoch();
+    m_timer.start();
+    m_timeBase = QDateTime::currentMSecsSinceEpoch();
+    m_tick = 0;
+    m_lastPublish = 0;
+    m_busy = 0;
+    m_execs = 0;
+    m_loops = 0;
+    m_loopMax = 0;
+    m_stat.overruns = 0;
+    m_wheel.fill(QVector<int>(), WheelSize);
+    for (int i = 0; i < m_items.count(); i++)
+    {
+        m_items[i].due = 0;
+        schedule(i, 0);
+    }
     Q_FOREACH(mbServerRunSimAction *i, m_actions)
-        i->init(time);
+        i->init(m_timeBase);
     return 0;
 }
 
 int mbServerRunSimActionTask::loop()
 {
-    qint64 time = QDateTime::currentMSecsSinceEpoch();
-    Q_FOREACH(mbServerRunSimAction *i, m_actions)
-        i->exec(time);
-    return 0;
+    qint64 now = m_timer.elapsed();
+    // Note: if task was late more than whole wheel turn every slot is visited only once
+    qint64 first = qMax(m_tick+1, now-WheelSize+1);
+    for (qint64 t = first; t <= now; t++)
+    {
+        QVector<int> &slot = m_wheel[static_cast<int>(t % WheelSize)];
+        for (int i = 0; i < slot.count(); )
+        {
+            int index = slot.at(i);
+            const Item &item = m_items.at(index);
+            if (item.due > now) // item is due on one of the next wheel turns
+            {
+                i++;
+                continue;
+            }
+            Group &g = m_groups[item.group];
+            if (g.due.isEmpty())
+                m_dueGroups.append(item.group);
+            g.due.append(index);
+            slot[i] = slot.last();
+            slot.removeLast();
+        }
+    }
+    m_tick = now;
+
+    qint64 time = m_timeBase + now;
+    qint64 begin = m_dueGroups.count() ? m_timer.nsecsElapsed() : 0;
+    for (int gi = 0; gi < m_dueGroups.count(); gi++)
+    {
+        Group &g = m_groups[m_dueGroups.at(gi)];
+        {
+            mbServerRunSimAction::Batch batch(g.block);
+            for (int i = 0; i < g.due.count(); i++)
+                m_items.at(g.due.at(i)).action->exec(time, batch);
+        }
+        m_execs += static_cast<quint32>(g.due.count());
+        for (int i = 0; i < g.due.count(); i++)
+            schedule(g.due.at(i), now);
+        g.due.clear();
+    }
+    if (m_dueGroups.count())
+    {
+        qint64 elapsed = m_timer.nsecsElapsed() - begin;
+        m_busy += elapsed;
+        m_loops++;
+        if (elapsed > m_loopMax)
+            m_loopMax = elapsed;
+        m_dueGroups.clear();
+    }
+    if (now - m_lastPublish >= PublishPeriod)
+        publishStatistic(now);
+
+    for (int i = 1; i < MaxSleep; i++)
+    {
+        if (!m_wheel.at(static_cast<int>((now+i) % WheelSize)).isEmpty())
+            return i;
+    }
+    return MaxSleep;
 }
 
 int mbServerRunSimActionTask::final()
 {
-    qint64 time = QDateTime::currentMSecsSinceEpoch();
+    qint64 time = m_timeBase + m_timer.elapsed();
     Q_FOREACH(mbServerRunSimAction *i, m_actions)
         i->final(time);
     return 0;
 }
+
+void mbServerRunSimActionTask::schedule(int index, qint64 now)
+{
+    Item &item = m_items[index];
+    int period = item.action->period();
+    if (period < 1)
+        period = 1;
+    item.due += period;
+    if (item.due <= now) // missed periods are skipped, not replayed
+    {
+        item.due = now + period;
+        m_stat.overruns++;
+    }
+    m_wheel[static_cast<int>(item.due % WheelSize)].append(index);
+}
+
+void mbServerRunSimActionTask::publishStatistic(qint64 now)
+{
+    qint64 period = now - m_lastPublish; // milliseconds
+    m_stat.execs = static_cast<quint32>(m_execs * 1000 / period);
+    m_stat.load = static_cast<quint32>(qMin<qint64>(100, m_busy / (period * 10000)));
+    m_stat.timeAvg = m_loops ? static_cast<quint32>(m_busy / m_loops / 1000) : 0;
+    m_stat.timeMax = static_cast<quint32>(m_loopMax / 1000);
+    m_stat.timestamp = QDateTime::currentDateTime();
+    if (m_project)
+        m_project->setSimStatistic(m_worker, m_stat);
+    m_lastPublish = now;
+    m_busy = 0;
+    m_execs = 0;
+    m_loops = 0;
+    m_loopMax = 0;
+}
@@ -23,8 +23,15 @@
 #ifndef SERVER_RUNSIMACTIONTASK_H
 #define SERVER_RUNSIMACTIONTASK_H
 
+#include <QElapsedTimer>
+#include <QVector>
+
 #include <mbcore_task.h>
 
+#include <project/server_device.h>
+#include <project/server_simstatistic.h>
+
+class mbServerProject;
 class mbServerSimAction;
 class mbServerRunSimAction;
 
@@ -36,6 +43,8 @@ public:
 
 public:
     void setActions(const QList<mbServerSimAction*> &actions);
+    // Load statistic of the task is published into 'project' as statistic of 'worker'
+    void setWorker(mbServerProject *project, int worker);
 
 public: // task interface
     virtual int init() override;
@@ -43,9 +52,50 @@ public: // task interface
     virtual int final() override;
 
 private:
+    void schedule(int index, qint64 now);
+    void publishStatistic(qint64 now);
+
+private:
+    enum
+    {
+        WheelSize = 1024, // count of timer wheel slots, every slot is 1 millisecond
+        MaxSleep  = 100,  // max sleep time (milliseconds) returned by 'loop()'
+        PublishPeriod = 1000 // statistic publish period (milliseconds)
+    };
+
+    struct Item
+    {
+        mbServerRunSimAction *action;
+        int group;
+        qint64 due; // milliseconds since task start
+    };
+
+    // Actions that write to the same memory block of the same device
+    struct Group
+    {
+        mbServerDevice::MemoryBlock *block;
+        QVector<int> due;
+    };
+
     typedef QList<mbServerRunSimAction*> Actions_t;
 
     Actions_t m_actions;
+    QVector<Item> m_items;
+    QVector<Group> m_groups;
+    QVector<int> m_dueGroups;
+    QVector<QVector<int> > m_wheel; // slot 'i' holds indexes of items with '(due % WheelSize) == i'
+    QElapsedTimer m_timer;
+    qint64 m_timeBase;
+    qint64 m_tick;
+
+    mbServerProject *m_project;
+    int m_worker;
+    mbServerSimStatistic m_stat;
+    qint64 m_lastPublish;
+    qint64 m_busy;      // nanoseconds spent on actions since last publish
+    quint32 m_execs;    // count of executed actions since last publish
+    quint32 m_loops;    // count of loops with due actions since last publish
+    qint64 m_loopMax;   // nanoseconds
 };
 
 #endif // SERVER_RUNSIMACTIONTASK_H
@@ -0,0 +1,435 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "server_runsimexpression.h"
+
+#include <QtMath>
+
+mbServerRunSimExpression::mbServerRunSimExpression()
+{
+    m_pos = 0;
+    m_defaultDataType = mb::UInt16;
+    m_depth = 0;
+    m_maxDepth = 0;
+}
+
+bool mbServerRunSimExpression::compile(const QString &source, mb::DataType defaultDataType)
+{
+    m_source = source;
+    m_pos = 0;
+    m_defaultDataType = defaultDataType;
+    m_errorString.clear();
+    m_references.clear();
+    m_code.clear();
+    m_depth = 0;
+    m_maxDepth = 0;
+    skipSpaces();
+    if (m_pos >= m_source.length())
+        return setError(QStringLiteral("Expression is empty"));
+    if (!parseTernary())
+        return false;
+    skipSpaces();
+    if (m_pos < m_source.length())
+        return setError(QString("Unexpected symbol '%1'").arg(m_source.at(m_pos)));
+    m_stack.resize(m_maxDepth);
+    return true;
+}
+
+double mbServerRunSimExpression::evaluate(const double *inputs) const
+{
+    double *s = m_stack.data();
+    int top = -1;
+    const Instruction *c = m_code.constData();
+    const Instruction *end = c + m_code.count();
+    for (; c != end; ++c)
+    {
+        switch (c->op)
+        {
+        case Op_Const       : s[++top] = c->value; break;
+        case Op_Input       : s[++top] = inputs[c->index]; break;
+        case Op_Neg         : s[top] = -s[top]; break;
+        case Op_Not         : s[top] = (s[top] == 0.0); break;
+        case Op_Add         : --top; s[top] = s[top] + s[top+1]; break;
+        case Op_Sub         : --top; s[top] = s[top] - s[top+1]; break;
+        case Op_Mul         : --top; s[top] = s[top] * s[top+1]; break;
+        case Op_Div         : --top; s[top] = (s[top+1] != 0.0) ? s[top] / s[top+1] : 0.0; break;
+        case Op_Mod         : --top; s[top] = (s[top+1] != 0.0) ? std::fmod(s[top], s[top+1]) : 0.0; break;
+        case Op_Less        : --top; s[top] = (s[top] <  s[top+1]); break;
+        case Op_LessEqual   : --top; s[top] = (s[top] <= s[top+1]); break;
+        case Op_Greater     : --top; s[top] = (s[top] >  s[top+1]); break;
+        case Op_GreaterEqual: --top; s[top] = (s[top] >= s[top+1]); break;
+        case Op_Equal       : --top; s[top] = (s[top] == s[top+1]); break;
+        case Op_NotEqual    : --top; s[top] = (s[top] != s[top+1]); break;
+        case Op_And         : --top; s[top] = ((s[top] != 0.0) && (s[top+1] != 0.0)); break;
+        case Op_Or          : --top; s[top] = ((s[top] != 0.0) || (s[top+1] != 0.0)); break;
+        case Op_Select      : top -= 2; s[top] = (s[top] != 0.0) ? s[top+1] : s[top+2]; break;
+        case Op_Abs         : s[top] = qAbs(s[top]); break;
+        case Op_Sqrt        : s[top] = (s[top] > 0.0) ? qSqrt(s[top]) : 0.0; break;
+        case Op_Sin         : s[top] = qSin(s[top]); break;
+        case Op_Cos         : s[top] = qCos(s[top]); break;
+        case Op_Round       : s[top] = std::round(s[top]); break;
+        case Op_Floor       : s[top] = std::floor(s[top]); break;
+        case Op_Ceil        : s[top] = std::ceil(s[top]); break;
+        case Op_Min         : --top; s[top] = qMin(s[top], s[top+1]); break;
+        case Op_Max         : --top; s[top] = qMax(s[top], s[top+1]); break;
+        }
+    }
+    return (top >= 0) ? s[top] : 0.0;
+}
+
+bool mbServerRunSimExpression::parseTernary()
+{
+    if (!parseOr())
+        return false;
+    if (match("?"))
+    {
+        if (!parseTernary())
+            return false;
+        if (!match(":"))
+            return setError(QStringLiteral("Expected ':'"));
+        if (!parseTernary())
+            return false;
+        emitCode(Op_Select);
+    }
+    return true;
+}
+
+bool mbServerRunSimExpression::parseOr()
+{
+    if (!parseAnd())
+        return false;
+    while (match("||"))
+    {
+        if (!parseAnd())
+            return false;
+        emitCode(Op_Or);
+    }
+    return true;
+}
+
+bool mbServerRunSimExpression::parseAnd()
+{
+    if (!parseEquality())
+        return false;
+    while (match("&&"))
+    {
+        if (!parseEquality())
+            return false;
+        emitCode(Op_And);
+    }
+    return true;
+}
+
+bool mbServerRunSimExpression::parseEquality()
+{
+    if (!parseRelational())
+        return false;
+    for (;;)
+    {
+        OpCode op;
+        if (match("=="))
+            op = Op_Equal;
+        else if (match("!="))
+            op = Op_NotEqual;
+        else
+            return true;
+        if (!parseRelational())
+            return false;
+        emitCode(op);
+    }
+}
+
+bool mbServerRunSimExpression::parseRelational()
+{
+    if (!parseAdditive())
+        return false;
+    for (;;)
+    {
+        OpCode op;
+        if (match("<="))
+            op = Op_LessEqual;
+        else if (match(">="))
+            op = Op_GreaterEqual;
+        else if (match("<"))
+            op = Op_Less;
+        else if (match(">"))
+            op = Op_Greater;
+        else
+            return true;
+        if (!parseAdditive())
+            return false;
+        emitCode(op);
+    }
+}
+
+bool mbServerRunSimExpression::parseAdditive()
+{
+    if (!parseMultiplicative())
+        return false;
+    for (;;)
+    {
+        OpCode op;
+        if (match("+"))
+            op = Op_Add;
+        else if (match("-"))
+            op = Op_Sub;
+        else
+            return true;
+        if (!parseMultiplicative())
+            return false;
+        emitCode(op);
+    }
+}
+
+bool mbServerRunSimExpression::parseMultiplicative()
+{
+    if (!parseUnary())
+        return false;
+    for (;;)
+    {
+        OpCode op;
+        if (match("*"))
+            op = Op_Mul;
+        else if (match("/"))
+            op = Op_Div;
+        else if (match("%"))
+            op = Op_Mod;
+        else
+            return true;
+        if (!parseUnary())
+            return false;
+        emitCode(op);
+    }
+}
+
+bool mbServerRunSimExpression::parseUnary()
+{
+    if (match("-"))
+    {
+        if (!parseUnary())
+            return false;
+        emitCode(Op_Neg);
+        return true;
+    }
+    if (match("+"))
+        return parseUnary();
+    // Note: '!=' can't be here because operand is expected
+    if (match("!"))
+    {
+        if (!parseUnary())
+            return false;
+        emitCode(Op_Not);
+        return true;
+    }
+    return parsePrimary();
+}
+
+bool mbServerRunSimExpression::parsePrimary()
+{
+    skipSpaces();
+    if (m_pos >= m_source.length())
+        return setError(QStringLiteral("Unexpected end of expression"));
+    QChar c = m_source.at(m_pos);
+    if (c == QLatin1Char('('))
+    {
+        m_pos++;
+        if (!parseTernary())
+            return false;
+        if (!match(")"))
+            return setError(QStringLiteral("Expected ')'"));
+        return true;
+    }
+    if (c == QLatin1Char('['))
+        return parseReference();
+    if (c.isLetter())
+        return parseFunction();
+    if (c.isDigit() || (c == QLatin1Char('.')))
+    {
+        int begin = m_pos;
+        while ((m_pos < m_source.length()) && (m_source.at(m_pos).isDigit() || (m_source.at(m_pos) == QLatin1Char('.'))))
+            m_pos++;
+        if ((m_pos < m_source.length()) && (m_source.at(m_pos).toLower() == QLatin1Char('e')))
+        {
+            int exp = m_pos++;
+            if ((m_pos < m_source.length()) && ((m_source.at(m_pos) == QLatin1Char('+')) || (m_source.at(m_pos) == QLatin1Char('-'))))
+                m_pos++;
+            if ((m_pos < m_source.length()) && m_source.at(m_pos).isDigit())
+            {
+                while ((m_pos < m_source.length()) && m_source.at(m_pos).isDigit())
+                    m_pos++;
+            }
+            else
+                m_pos = exp;
+        }
+        bool ok;
+        double v = m_source.midRef(begin, m_pos-begin).toDouble(&ok);
+        if (!ok)
+            return setError(QString("Bad number '%1'").arg(m_source.mid(begin, m_pos-begin)));
+        emitCode(Op_Const, 0, v);
+        return true;
+    }
+    return setError(QString("Unexpected symbol '%1'").arg(c));
+}
+
+bool mbServerRunSimExpression::parseReference()
+{
+    int begin = ++m_pos; // skip '['
+    int end = m_source.indexOf(QLatin1Char(']'), begin);
+    if (end < 0)
+        return setError(QStringLiteral("Expected ']'"));
+    QString ref = m_source.mid(begin, end-begin);
+    m_pos = end+1;
+
+    Reference r;
+    r.dataType = m_defaultDataType;
+    int sep = ref.indexOf(QLatin1Char(':'));
+    if (sep >= 0)
+    {
+        bool ok;
+        r.dataType = mb::enumDataTypeValue(ref.mid(sep+1).trimmed(), &ok);
+        if (!ok)
+            return setError(QString("Bad data type in reference '%1'").arg(ref));
+        ref = ref.left(sep);
+    }
+    r.address = mb::toAddress(ref.trimmed());
+    if (!r.address.isValid())
+        return setError(QString("Bad address in reference '%1'").arg(ref));
+
+    int index;
+    for (index = 0; index < m_references.count(); index++)
+    {
+        const Reference &e = m_references.at(index);
+        if ((mb::toInt(e.address) == mb::toInt(r.address)) && (e.dataType == r.dataType))
+            break;
+    }
+    if (index == m_references.count())
+        m_references.append(r);
+    emitCode(Op_Input, index);
+    return true;
+}
+
+bool mbServerRunSimExpression::parseFunction()
+{
+    struct Function
+    {
+        const char *name;
+        OpCode op;
+        int args;
+    };
+    static const Function functions[] =
+    {
+        { "abs"  , Op_Abs  , 1 },
+        { "sqrt" , Op_Sqrt , 1 },
+        { "sin"  , Op_Sin  , 1 },
+        { "cos"  , Op_Cos  , 1 },
+        { "round", Op_Round, 1 },
+        { "floor", Op_Floor, 1 },
+        { "ceil" , Op_Ceil , 1 },
+        { "min"  , Op_Min  , 2 },
+        { "max"  , Op_Max  , 2 }
+    };
+
+    int begin = m_pos;
+    while ((m_pos < m_source.length()) && m_source.at(m_pos).isLetterOrNumber())
+        m_pos++;
+    QString name = m_source.mid(begin, m_pos-begin);
+    const Function *f = nullptr;
+    for (size_t i = 0; i < sizeof(functions)/sizeof(functions[0]); i++)
+    {
+        if (name == QLatin1String(functions[i].name))
+        {
+            f = &functions[i];
+            break;
+        }
+    }
+    if (!f)
+        return setError(QString("Unknown function '%1'").arg(name));
+    if (!match("("))
+        return setError(QString("Expected '(' after '%1'").arg(name));
+    for (int i = 0; i < f->args; i++)
+    {
+        if (i && !match(","))
+            return setError(QString("Expected ',' in '%1'").arg(name));
+        if (!parseTernary())
+            return false;
+    }
+    if (!match(")"))
+        return setError(QString("Expected ')' after arguments of '%1'").arg(name));
+    emitCode(f->op);
+    return true;
+}
+
+void mbServerRunSimExpression::skipSpaces()
+{
+    while ((m_pos < m_source.length()) && m_source.at(m_pos).isSpace())
+        m_pos++;
+}
+
+bool mbServerRunSimExpression::match(const char *token)
+{
+    skipSpaces();
+    int len = static_cast<int>(qstrlen(token));
+    if (m_source.midRef(m_pos, len) != QLatin1String(token))
+        return false;
+    m_pos += len;
+    return true;
+}
+
+bool mbServerRunSimExpression::setError(const QString &text)
+{
+    m_errorString = QString("%1 (position %2)").arg(text).arg(m_pos+1);
+    return false;
+}
+
+void mbServerRunSimExpression::emitCode(OpCode op, int index, double value)
+{
+    Instruction i;
+    i.op = op;
+    i.index = index;
+    i.value = value;
+    m_code.append(i);
+    switch (op)
+    {
+    case Op_Const:
+    case Op_Input:
+        m_depth++;
+        if (m_depth > m_maxDepth)
+            m_maxDepth = m_depth;
+        break;
+    case Op_Neg:
+    case Op_Not:
+    case Op_Abs:
+    case Op_Sqrt:
+    case Op_Sin:
+    case Op_Cos:
+    case Op_Round:
+    case Op_Floor:
+    case Op_Ceil:
+        break;
+    case Op_Select:
+        m_depth -= 2;
+        break;
+    default:
+        m_depth--;
+        break;
+    }
+}
@@ -0,0 +1,129 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef SERVER_RUNSIMEXPRESSION_H
+#define SERVER_RUNSIMEXPRESSION_H
+
+#include <QString>
+#include <QVector>
+
+#include <mbcore.h>
+
+/*
+   Compiled arithmetic/logic expression of 'Expression' simulation action.
+   Source is parsed once and compiled into compact stack bytecode that is evaluated in 'double'.
+
+   Syntax:
+   * numbers: '12', '0.5', '1e3'
+   * register references: '[400010]' (value of action data type) or '[400010:Float32]' (explicit type)
+   * operators (by priority, lowest first): '?:', '||', '&&', '==' '!=', '<' '<=' '>' '>=', '+' '-', '*' '/' '%',
+     unary '-' '+' '!'
+   * functions: 'abs(x)', 'sqrt(x)', 'sin(x)', 'cos(x)', 'round(x)', 'floor(x)', 'ceil(x)', 'min(x,y)', 'max(x,y)'
+*/
+class mbServerRunSimExpression
+{
+public:
+    struct Reference
+    {
+        mb::Address address;
+        mb::DataType dataType;
+    };
+
+public:
+    mbServerRunSimExpression();
+
+public:
+    bool compile(const QString &source, mb::DataType defaultDataType);
+    inline const QString &errorString() const { return m_errorString; }
+    // Note: references are unique, 'inputs' of 'evaluate' has value for every reference in the same order
+    inline const QVector<Reference> &references() const { return m_references; }
+    double evaluate(const double *inputs) const;
+
+private:
+    enum OpCode
+    {
+        Op_Const,
+        Op_Input,
+        Op_Neg,
+        Op_Not,
+        Op_Add,
+        Op_Sub,
+        Op_Mul,
+        Op_Div,
+        Op_Mod,
+        Op_Less,
+        Op_LessEqual,
+        Op_Greater,
+        Op_GreaterEqual,
+        Op_Equal,
+        Op_NotEqual,
+        Op_And,
+        Op_Or,
+        Op_Select,
+        Op_Abs,
+        Op_Sqrt,
+        Op_Sin,
+        Op_Cos,
+        Op_Round,
+        Op_Floor,
+        Op_Ceil,
+        Op_Min,
+        Op_Max
+    };
+
+    struct Instruction
+    {
+        OpCode op;
+        int index;
+        double value;
+    };
+
+private: // recursive descent parser, every level emits code of its subexpression
+    bool parseTernary();
+    bool parseOr();
+    bool parseAnd();
+    bool parseEquality();
+    bool parseRelational();
+    bool parseAdditive();
+    bool parseMultiplicative();
+    bool parseUnary();
+    bool parsePrimary();
+    bool parseReference();
+    bool parseFunction();
+    void skipSpaces();
+    bool match(const char *token);
+    bool setError(const QString &text);
+    void emitCode(OpCode op, int index = 0, double value = 0);
+
+private:
+    QString m_source;
+    int m_pos;
+    mb::DataType m_defaultDataType;
+    QString m_errorString;
+    QVector<Reference> m_references;
+    QVector<Instruction> m_code;
+    int m_depth;
+    int m_maxDepth;
+    mutable QVector<double> m_stack;
+};
+
+#endif // SERVER_RUNSIMEXPRESSION_H
@@ -0,0 +1,351 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "server_runsimtrace.h"
+
+#include <algorithm>
+
+#include <QFileInfo>
+
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+mbServerRunSimTrace::mbServerRunSimTrace()
+{
+    m_channelCount = 0;
+    m_recordSize = 0;
+    m_recordCount = 0;
+    m_windowRecords = 1;
+    m_firstTimestamp = 0;
+    m_lastTimestamp = 0;
+    m_current.number = -1;
+    m_current.data = nullptr;
+    m_current.count = 0;
+    m_next = m_current;
+}
+
+mbServerRunSimTrace::~mbServerRunSimTrace()
+{
+    close();
+}
+
+bool mbServerRunSimTrace::open(const QString &fileName)
+{
+    close();
+    m_errorString.clear();
+    QString traceFile = fileName;
+    QFileInfo fi(fileName);
+    if (fi.suffix().compare(QStringLiteral("csv"), Qt::CaseInsensitive) == 0)
+    {
+        traceFile = fileName + QStringLiteral(".mbtrace");
+        QFileInfo ti(traceFile);
+        if (!ti.exists() || (ti.lastModified() < fi.lastModified()))
+        {
+            if (!convertCsv(fileName, traceFile, &m_errorString))
+                return false;
+        }
+    }
+
+    m_file.setFileName(traceFile);
+    if (!m_file.open(QIODevice::ReadOnly))
+        return setError(QString("Can't open trace file '%1': %2").arg(traceFile, m_file.errorString()));
+    Header h;
+    if ((m_file.read(reinterpret_cast<char*>(&h), sizeof(h)) != static_cast<qint64>(sizeof(h))) ||
+        (memcmp(h.magic, "MBTR", sizeof(h.magic)) != 0))
+        return setError(QString("File '%1' is not a trace file").arg(traceFile));
+    if (h.version != Version)
+        return setError(QString("Trace file '%1' has unsupported version %2").arg(traceFile).arg(h.version));
+    if (h.channelCount == 0)
+        return setError(QString("Trace file '%1' has no channels").arg(traceFile));
+
+    m_channelCount = static_cast<int>(h.channelCount);
+    m_recordSize = static_cast<qint64>(sizeof(qint64) + sizeof(double)*h.channelCount);
+    qint64 recordCount = (m_file.size() - static_cast<qint64>(sizeof(Header))) / m_recordSize;
+    if (recordCount <= 0)
+        return setError(QString("Trace file '%1' has no records").arg(traceFile));
+    m_windowRecords = qMax<qint64>(1, WindowSize / m_recordSize);
+
+    // Note: only the first timestamp of every window is read here, records themselves are never loaded
+    qint64 windows = (recordCount + m_windowRecords - 1) / m_windowRecords;
+    m_windowTimestamps.resize(static_cast<int>(windows));
+    for (qint64 w = 0; w < windows; w++)
+    {
+        qint64 ts;
+        if (!m_file.seek(static_cast<qint64>(sizeof(Header)) + w*m_windowRecords*m_recordSize) ||
+            (m_file.read(reinterpret_cast<char*>(&ts), sizeof(ts)) != static_cast<qint64>(sizeof(ts))))
+            return setError(QString("Can't read trace file '%1': %2").arg(traceFile, m_file.errorString()));
+        m_windowTimestamps[static_cast<int>(w)] = ts;
+    }
+    qint64 ts;
+    if (!m_file.seek(static_cast<qint64>(sizeof(Header)) + (recordCount-1)*m_recordSize) ||
+        (m_file.read(reinterpret_cast<char*>(&ts), sizeof(ts)) != static_cast<qint64>(sizeof(ts))))
+        return setError(QString("Can't read trace file '%1': %2").arg(traceFile, m_file.errorString()));
+    m_firstTimestamp = m_windowTimestamps.first();
+    m_lastTimestamp = ts;
+    m_recordCount = recordCount;
+    if (!setCurrentWindow(0))
+    {
+        m_recordCount = 0;
+        return false;
+    }
+    return true;
+}
+
+void mbServerRunSimTrace::close()
+{
+    unmapWindow(m_current);
+    unmapWindow(m_next);
+    if (m_file.isOpen())
+        m_file.close();
+    m_windowTimestamps.clear();
+    m_channelCount = 0;
+    m_recordSize = 0;
+    m_recordCount = 0;
+}
+
+qint64 mbServerRunSimTrace::find(qint64 time, qint64 hint)
+{
+    if (!isOpen())
+        return 0;
+    qint64 index = qBound<qint64>(0, hint, m_recordCount-1);
+    qint64 number = index / m_windowRecords;
+    const int windows = m_windowTimestamps.count();
+    if ((time < timestamp(index)) ||
+        ((number+1 < windows) && (m_windowTimestamps.at(static_cast<int>(number+1)) <= time)))
+    {
+        // 'time' is out of 'hint' window (jump or loop): window is found by its first timestamp
+        QVector<qint64>::const_iterator it = std::upper_bound(m_windowTimestamps.constBegin(), m_windowTimestamps.constEnd(), time);
+        number = (it == m_windowTimestamps.constBegin()) ? 0 : (it - m_windowTimestamps.constBegin() - 1);
+        index = number * m_windowRecords;
+    }
+    if (!setCurrentWindow(number))
+        return index;
+    qint64 last = qMin(m_recordCount, (number+1)*m_windowRecords) - 1;
+    // sequential playback: next record is not due yet
+    if ((index == last) || (timestamp(index+1) > time))
+        return index;
+    // binary search of the last record with timestamp <= 'time' within the window
+    qint64 lo = index+1;
+    qint64 hi = last;
+    while (lo < hi)
+    {
+        qint64 mid = lo + (hi-lo+1)/2;
+        if (timestamp(mid) <= time)
+            lo = mid;
+        else
+            hi = mid-1;
+    }
+    return lo;
+}
+
+qint64 mbServerRunSimTrace::timestamp(qint64 index)
+{
+    const uchar *r = record(index);
+    if (!r)
+        return 0;
+    qint64 ts;
+    memcpy(&ts, r, sizeof(ts));
+    return ts;
+}
+
+const double *mbServerRunSimTrace::values(qint64 index)
+{
+    const uchar *r = record(index);
+    if (!r)
+        return nullptr;
+    return reinterpret_cast<const double*>(r + sizeof(qint64));
+}
+
+const uchar *mbServerRunSimTrace::record(qint64 index)
+{
+    if ((index < 0) || (index >= m_recordCount))
+        return nullptr;
+    qint64 number = index / m_windowRecords;
+    const Window *w;
+    if (number == m_current.number)
+        w = &m_current;
+    else if (number == m_next.number)
+        w = &m_next;
+    else
+    {
+        if (!setCurrentWindow(number))
+            return nullptr;
+        w = &m_current;
+    }
+    return w->data + (index - number*m_windowRecords)*m_recordSize;
+}
+
+bool mbServerRunSimTrace::setCurrentWindow(qint64 number)
+{
+    if (number == m_current.number)
+        return true;
+    unmapWindow(m_current);
+    if (number == m_next.number)
+    {
+        m_current = m_next;
+        m_next.number = -1;
+        m_next.data = nullptr;
+    }
+    else
+    {
+        unmapWindow(m_next);
+        if (!mapWindow(m_current, number))
+            return false;
+        prefetch(m_current);
+    }
+    // next window is mapped in advance so reading pages is started before playback reaches it
+    if ((number+1 < m_windowTimestamps.count()) && mapWindow(m_next, number+1))
+        prefetch(m_next);
+    return true;
+}
+
+bool mbServerRunSimTrace::mapWindow(Window &w, qint64 number)
+{
+    qint64 first = number * m_windowRecords;
+    qint64 count = qMin(m_windowRecords, m_recordCount - first);
+    uchar *data = m_file.map(static_cast<qint64>(sizeof(Header)) + first*m_recordSize, count*m_recordSize);
+    if (!data)
+        return setError(QString("Can't map trace file '%1': %2").arg(m_file.fileName(), m_file.errorString()));
+    w.number = number;
+    w.data = data;
+    w.count = count;
+    return true;
+}
+
+void mbServerRunSimTrace::unmapWindow(Window &w)
+{
+    if (w.data)
+        m_file.unmap(w.data);
+    w.number = -1;
+    w.data = nullptr;
+    w.count = 0;
+}
+
+void mbServerRunSimTrace::prefetch(const Window &w)
+{
+#ifdef Q_OS_UNIX
+    // Note: kernel reads pages asynchronously, so sim task thread is not blocked by disk I/O
+    const quintptr page = static_cast<quintptr>(sysconf(_SC_PAGESIZE));
+    quintptr p = reinterpret_cast<quintptr>(w.data);
+    quintptr begin = p & ~(page-1);
+    madvise(reinterpret_cast<void*>(begin), static_cast<size_t>(p - begin + static_cast<quintptr>(w.count*m_recordSize)), MADV_WILLNEED);
+#else
+    Q_UNUSED(w)
+#endif
+}
+
+bool mbServerRunSimTrace::setError(const QString &text)
+{
+    m_errorString = text;
+    return false;
+}
+
+bool mbServerRunSimTrace::convertCsv(const QString &csvFile, const QString &traceFile, QString *errorString)
+{
+    QFile in(csvFile);
+    if (!in.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        *errorString = QString("Can't open CSV trace file '%1': %2").arg(csvFile, in.errorString());
+        return false;
+    }
+    // Note: trace is written into temporary file, so half converted trace is never used
+    QString tempFile = traceFile + QStringLiteral(".tmp");
+    QFile out(tempFile);
+    if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        *errorString = QString("Can't create trace file '%1': %2").arg(tempFile, out.errorString());
+        return false;
+    }
+    Header h;
+    memcpy(h.magic, "MBTR", sizeof(h.magic));
+    h.version = Version;
+    h.channelCount = 0;
+    h.reserved = 0;
+    out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+
+    const int BufferSize = 1024*1024;
+    QByteArray buffer;
+    buffer.reserve(BufferSize);
+    QVector<double> values;
+    int channels = 0;
+    qint64 records = 0;
+    qint64 lastTimestamp = 0;
+    while (!in.atEnd())
+    {
+        QByteArray line = in.readLine().trimmed();
+        if (line.isEmpty())
+            continue;
+        QList<QByteArray> items;
+        if (line.contains(';')) // ';' separated CSV can use decimal comma
+            items = line.replace(',', '.').split(';');
+        else
+            items = line.split(',');
+        if ((items.count() < 2) || (channels && (items.count()-1 != channels)))
+            continue;
+        bool ok;
+        qint64 ts = qRound64(items.at(0).trimmed().toDouble(&ok));
+        if (!ok || (records && (ts < lastTimestamp))) // timestamps can't decrease
+            continue;
+        values.resize(items.count()-1);
+        for (int i = 1; ok && (i < items.count()); i++)
+            values[i-1] = items.at(i).trimmed().toDouble(&ok);
+        if (!ok)
+            continue;
+        channels = values.count();
+        buffer.append(reinterpret_cast<const char*>(&ts), sizeof(ts));
+        buffer.append(reinterpret_cast<const char*>(values.constData()), static_cast<int>(sizeof(double))*channels);
+        lastTimestamp = ts;
+        records++;
+        if (buffer.size() >= BufferSize)
+        {
+            out.write(buffer);
+            buffer.clear();
+        }
+    }
+    out.write(buffer);
+    if (records == 0)
+    {
+        out.remove();
+        *errorString = QString("CSV trace file '%1' has no records").arg(csvFile);
+        return false;
+    }
+    h.channelCount = static_cast<quint32>(channels);
+    out.seek(0);
+    out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+    if (out.error() != QFileDevice::NoError)
+    {
+        *errorString = QString("Can't write trace file '%1': %2").arg(tempFile, out.errorString());
+        out.remove();
+        return false;
+    }
+    out.close();
+    QFile::remove(traceFile);
+    if (!QFile::rename(tempFile, traceFile))
+    {
+        *errorString = QString("Can't rename '%1' into '%2'").arg(tempFile, traceFile);
+        QFile::remove(tempFile);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,113 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef SERVER_RUNSIMTRACE_H
+#define SERVER_RUNSIMTRACE_H
+
+#include <QFile>
+#include <QVector>
+
+/*
+   Recorded multi-channel trace of 'Playback' simulation action.
+   Trace file is accessed through memory mapped windows, so memory use doesn't depend on trace length.
+
+   Binary trace file format (native byte order):
+   * header: 'MBTR' magic, quint32 version, quint32 channel count, quint32 reserved
+   * records: qint64 timestamp (milliseconds, non decreasing) followed by 'double' value of every channel
+
+   CSV trace (file with '.csv' suffix) is converted once into binary '<file>.mbtrace' beside it
+   (converted again only when CSV file is newer). First CSV column is timestamp in milliseconds,
+   other columns are channel values, lines that are not numbers (e.g. header) are skipped.
+*/
+class mbServerRunSimTrace
+{
+public:
+    mbServerRunSimTrace();
+    ~mbServerRunSimTrace();
+
+public:
+    bool open(const QString &fileName);
+    void close();
+    inline bool isOpen() const { return m_recordCount > 0; }
+    inline const QString &errorString() const { return m_errorString; }
+    inline int channelCount() const { return m_channelCount; }
+    inline qint64 recordCount() const { return m_recordCount; }
+    inline qint64 firstTimestamp() const { return m_firstTimestamp; }
+    inline qint64 lastTimestamp() const { return m_lastTimestamp; }
+
+public:
+    // Returns index of the last record with timestamp less or equal 'time' (0 if there is no such record).
+    // Search begins from 'hint' index, so sequential playback doesn't touch anything but the current window.
+    qint64 find(qint64 time, qint64 hint);
+    qint64 timestamp(qint64 index);
+    // Returns pointer to 'channelCount()' values of record 'index'.
+    // Note: pointer is valid until next call of any non-const method
+    const double *values(qint64 index);
+
+public:
+    static bool convertCsv(const QString &csvFile, const QString &traceFile, QString *errorString);
+
+private:
+    struct Header
+    {
+        char magic[4];
+        quint32 version;
+        quint32 channelCount;
+        quint32 reserved;
+    };
+
+    struct Window
+    {
+        qint64 number; // -1 if not mapped
+        uchar *data;
+        qint64 count;  // count of records in window
+    };
+
+    enum
+    {
+        Version = 1,
+        WindowSize = 4*1024*1024 // approximate size of single mapped window in bytes
+    };
+
+private:
+    const uchar *record(qint64 index);
+    bool setCurrentWindow(qint64 number);
+    bool mapWindow(Window &w, qint64 number);
+    void unmapWindow(Window &w);
+    void prefetch(const Window &w);
+    bool setError(const QString &text);
+
+private:
+    QFile m_file;
+    QString m_errorString;
+    int m_channelCount;
+    qint64 m_recordSize;
+    qint64 m_recordCount;
+    qint64 m_windowRecords;
+    qint64 m_firstTimestamp;
+    qint64 m_lastTimestamp;
+    QVector<qint64> m_windowTimestamps; // timestamp of the first record of every window
+    Window m_current;
+    Window m_next;                      // window after current one, mapped and prefetched in advance
+};
+
+#endif // SERVER_RUNSIMTRACE_H
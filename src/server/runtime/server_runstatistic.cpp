@@ -0,0 +1,269 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "server_runstatistic.h"
+
+mbServerRunStatistic::Defaults::Defaults() :
+    publishPeriod(1000)
+{
+}
+
+const mbServerRunStatistic::Defaults &mbServerRunStatistic::Defaults::instance()
+{
+    static const Defaults d;
+    return d;
+}
+
+mbServerRunStatistic::mbServerRunStatistic()
+{
+    m_type = Modbus::TCP;
+    m_publishPeriod = Defaults::instance().publishPeriod;
+    m_last = nullptr;
+    m_timer.start();
+    m_lastPublish = 0;
+}
+
+mbServerRunStatistic::~mbServerRunStatistic()
+{
+    Q_FOREACH (Connection *c, m_connections)
+    {
+        for (int i = 0; i < 256; i++)
+            delete c->units[i];
+        delete c;
+    }
+}
+
+void mbServerRunStatistic::rx(const Modbus::Char *source, const uint8_t *buff, uint16_t size)
+{
+    Connection *c = connection(source);
+    c->total.bytesIn += size;
+    m_total.bytesIn += size;
+    quint8 unit, func, exc;
+    if (!parseFrame(buff, size, &unit, &func, &exc))
+        return;
+    Counters *u = c->units[unit];
+    if (!u)
+    {
+        u = new Counters();
+        c->units[unit] = u;
+    }
+    func &= 0x7F;
+    u->requests++;
+    u->bytesIn += size;
+    u->functions[func]++;
+    c->total.requests++;
+    c->total.functions[func]++;
+    m_total.requests++;
+    m_total.functions[func]++;
+    c->isPending = true;
+    c->rxTime = m_timer.nsecsElapsed();
+}
+
+void mbServerRunStatistic::tx(const Modbus::Char *source, const uint8_t *buff, uint16_t size)
+{
+    Connection *c = connection(source);
+    c->total.bytesOut += size;
+    m_total.bytesOut += size;
+    quint8 unit, func, exc;
+    if (!parseFrame(buff, size, &unit, &func, &exc))
+        return;
+    Counters *u = c->units[unit];
+    if (!u)
+    {
+        u = new Counters();
+        c->units[unit] = u;
+    }
+    u->responses++;
+    u->bytesOut += size;
+    c->total.responses++;
+    m_total.responses++;
+    if (func & 0x80)
+    {
+        int i = (exc < mbServerPortStatistic::ExceptionCount) ? exc : 0;
+        u->exceptions[i]++;
+        c->total.exceptions[i]++;
+        m_total.exceptions[i]++;
+    }
+    if (c->isPending)
+    {
+        quint64 us = static_cast<quint64>(m_timer.nsecsElapsed() - c->rxTime) / 1000;
+        countTime(*u, us);
+        countTime(c->total, us);
+        countTime(m_total, us);
+        c->isPending = false;
+    }
+}
+
+void mbServerRunStatistic::connectionOpened(const Modbus::Char *source)
+{
+    Connection *c = connection(source);
+    c->isOpen = true;
+    c->isPending = false;
+}
+
+void mbServerRunStatistic::connectionClosed(const Modbus::Char *source)
+{
+    Connection *c = connection(source);
+    c->isOpen = false;
+    c->isPending = false;
+}
+
+bool mbServerRunStatistic::isPublishTime()
+{
+    qint64 now = m_timer.elapsed();
+    if ((now - m_lastPublish) < m_publishPeriod)
+        return false;
+    m_lastPublish = now;
+    return true;
+}
+
+mbServerPortStatistic mbServerRunStatistic::snapshot()
+{
+    mbServerPortStatistic s;
+    s.total = m_total;
+    s.timestamp = QDateTime::currentDateTime();
+    Q_FOREACH (const Connection *c, m_connections)
+    {
+        mbServerPortStatistic::Connection sc;
+        sc.name = c->name;
+        sc.isOpen = c->isOpen;
+        sc.total = c->total;
+        for (int i = 0; i < 256; i++)
+        {
+            if (c->units[i])
+                sc.units.insert(static_cast<quint8>(i), *c->units[i]);
+        }
+        s.connections.append(sc);
+    }
+    removeClosed();
+    return s;
+}
+
+mbServerRunStatistic::Connection *mbServerRunStatistic::connection(const Modbus::Char *source)
+{
+    // Note: frames of one connection usually come in series, so compare with the last one
+    //       first to avoid hashing and memory allocation for every frame
+    if (m_last && (m_lastSource == source))
+        return m_last;
+    QByteArray key(source);
+    Connection *c = m_hash.value(key);
+    if (!c)
+    {
+        c = new Connection;
+        c->name = QString::fromUtf8(key);
+        c->isOpen = true;
+        c->isPending = false;
+        c->rxTime = 0;
+        memset(c->units, 0, sizeof(c->units));
+        m_hash.insert(key, c);
+        m_connections.append(c);
+    }
+    m_lastSource = key;
+    m_last = c;
+    return c;
+}
+
+void mbServerRunStatistic::removeClosed()
+{
+    for (int i = m_connections.count()-1; i >= 0; i--)
+    {
+        Connection *c = m_connections.at(i);
+        if (c->isOpen)
+            continue;
+        m_hash.remove(c->name.toUtf8());
+        m_connections.removeAt(i);
+        if (m_last == c)
+        {
+            m_last = nullptr;
+            m_lastSource.clear();
+        }
+        for (int j = 0; j < 256; j++)
+            delete c->units[j];
+        delete c;
+    }
+}
+
+static inline int hexDigit(uint8_t c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+static inline bool hexByte(const uint8_t *buff, quint8 *v)
+{
+    int hi = hexDigit(buff[0]);
+    int lo = hexDigit(buff[1]);
+    if (hi < 0 || lo < 0)
+        return false;
+    *v = static_cast<quint8>((hi << 4) | lo);
+    return true;
+}
+
+bool mbServerRunStatistic::parseFrame(const uint8_t *buff, uint16_t size, quint8 *unit, quint8 *func, quint8 *exc) const
+{
+    *exc = 0;
+    switch (m_type)
+    {
+    case Modbus::ASC:
+    {
+        // ':' + unit + function + data + LRC + CR/LF (all as hex chars)
+        int i = (size > 0 && buff[0] == ':') ? 1 : 0;
+        if (size < i + 4)
+            return false;
+        if (!hexByte(buff+i, unit) || !hexByte(buff+i+2, func))
+            return false;
+        if (size >= i + 6)
+            hexByte(buff+i+4, exc);
+        return true;
+    }
+    case Modbus::RTU:
+        // unit + function + data + CRC
+        if (size < 2)
+            return false;
+        *unit = buff[0];
+        *func = buff[1];
+        if (size > 2)
+            *exc = buff[2];
+        return true;
+    default:
+        // MBAP-header (7 bytes, unit is the last byte) + function + data
+        if (size < 8)
+            return false;
+        *unit = buff[6];
+        *func = buff[7];
+        if (size > 8)
+            *exc = buff[8];
+        return true;
+    }
+}
+
+void mbServerRunStatistic::countTime(Counters &c, quint64 us)
+{
+    if (c.timeCount == 0 || us < c.timeMin)
+        c.timeMin = us;
+    if (us > c.timeMax)
+        c.timeMax = us;
+    c.timeSum += us;
+    c.timeCount++;
+}
@@ -0,0 +1,102 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef SERVER_RUNSTATISTIC_H
+#define SERVER_RUNSTATISTIC_H
+
+#include <QHash>
+#include <QElapsedTimer>
+
+#include <ModbusQt.h>
+
+#include <project/server_portstatistic.h>
+
+/*
+   Collects per-connection and per-unit statistic of the server port.
+   Object is owned and updated by the port thread only, so no locks are used.
+   Snapshot is made with 'snapshot()' when 'isPublishTime()' returns true.
+   Closed connections are reported by one snapshot and then removed,
+   their counters stay accumulated in port total.
+*/
+class mbServerRunStatistic
+{
+public:
+    struct Defaults
+    {
+        const int publishPeriod; // milliseconds
+
+        Defaults();
+        static const Defaults &instance();
+    };
+
+public:
+    mbServerRunStatistic();
+    ~mbServerRunStatistic();
+
+public:
+    inline Modbus::ProtocolType type() const { return m_type; }
+    inline void setType(Modbus::ProtocolType type) { m_type = type; }
+    inline int publishPeriod() const { return m_publishPeriod; }
+    inline void setPublishPeriod(int period) { m_publishPeriod = period; }
+
+public:
+    void rx(const Modbus::Char *source, const uint8_t *buff, uint16_t size);
+    void tx(const Modbus::Char *source, const uint8_t *buff, uint16_t size);
+    void connectionOpened(const Modbus::Char *source);
+    void connectionClosed(const Modbus::Char *source);
+
+public:
+    bool isPublishTime();
+    mbServerPortStatistic snapshot();
+
+private:
+    typedef mbServerPortStatistic::Counters Counters;
+
+    struct Connection
+    {
+        QString name;
+        bool isOpen;
+        bool isPending;  // request is received, response is not sent yet
+        qint64 rxTime;   // nanoseconds
+        Counters total;
+        Counters *units[256];
+    };
+
+private:
+    Connection *connection(const Modbus::Char *source);
+    void removeClosed();
+    bool parseFrame(const uint8_t *buff, uint16_t size, quint8 *unit, quint8 *func, quint8 *exc) const;
+    static void countTime(Counters &c, quint64 us);
+
+private:
+    Modbus::ProtocolType m_type;
+    int m_publishPeriod;
+    QHash<QByteArray, Connection*> m_hash;
+    QList<Connection*> m_connections;
+    QByteArray m_lastSource;
+    Connection *m_last;
+    Counters m_total;
+    QElapsedTimer m_timer;
+    qint64 m_lastPublish;
+};
+
+#endif // SERVER_RUNSTATISTIC_H
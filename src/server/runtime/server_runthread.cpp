@@ -38,6 +38,7 @@ mbServerRunThread::mbServerRunThread(mbServerPort *serverPort, mbServerRunDevice
 {
     m_serverPort = serverPort;
     m_ctrlRun = true;
+    m_open = 0;
     m_device = device;
     m_settings = serverPort->settings();
 }
@@ -57,8 +58,10 @@ void mbServerRunThread::run()
     {
         loop.processEvents();
         port.run();
+        m_open.storeRelease(port.isOpen());
         Modbus::msleep(1);
     }
     port.close();
+    m_open.storeRelease(0);
     mbServer::LogInfo(port.name(), QStringLiteral("Stop"));
 }
@@ -24,6 +24,7 @@
 #define SERVER_RUNTHREAD_H
 
 #include <QThread>
+#include <QAtomicInt>
 
 #include <ModbusQt.h>
 
@@ -38,12 +39,15 @@ public:
 
 public:
     inline void stop() { m_ctrlRun = false; }
+    // Returns true when port is open (e.g. TCP port is listening for connections)
+    inline bool isOpen() const { return m_open.loadAcquire() != 0; }
 
 protected:
     void run() override;
 
 private:
     bool m_ctrlRun;
+    QAtomicInt m_open;
 
 private:
     mbServerPort *m_serverPort;
@@ -22,7 +22,10 @@
 */
 #include "server_runtime.h"
 
+#include <algorithm>
+
 #include <QCoreApplication>
+#include <QThread>
 
 #include <core_filemanager.h>
 
@@ -32,6 +35,7 @@
 #include <project/server_port.h>
 #include <project/server_deviceref.h>
 #include <project/server_scriptmodule.h>
+#include <project/server_simaction.h>
 
 #include <runtime/core_runtaskthread.h>
 
@@ -44,20 +48,21 @@
 #include "server_runsimactiontask.h"
 
 #include "server_runscriptthread.h"
+#include "server_runscriptembedded.h"
+#include "server_runscriptworker.h"
+#include "server_runscriptarena.h"
 
 mbServerRuntime::mbServerRuntime(QObject *parent)
     : mbCoreRuntime{parent}
 {
+    m_scriptArena = nullptr;
 }
 
 void mbServerRuntime::createComponents()
 {
     mbCoreRuntime::createComponents();
 
-    mbServerRunSimActionTask *simActionTask = new mbServerRunSimActionTask;
-    simActionTask->setActions(project()->simActions());
-    mbCoreRunTaskThread *simActionThread = new mbCoreRunTaskThread(simActionTask);
-    m_taskThreads.append(simActionThread);
+    createSimWorkers();
 
     Q_FOREACH (mbServerPort *port, project()->ports())
         createRunThread(port);
@@ -84,6 +89,8 @@ void mbServerRuntime::createComponents()
         }
         Q_FOREACH (mbServerDevice *dev, project()->devices())
             createScriptThread(dev);
+        createScriptArena();
+        createScriptWorkers();
     }
 }
 
@@ -95,6 +102,9 @@ void mbServerRuntime::startComponents()
 
     Q_FOREACH (mbServerRunScriptThread *t, m_scriptThreads)
         t->start();
+
+    Q_FOREACH (mbServerRunScriptWorker *t, m_scriptWorkers)
+        t->start();
 }
 
 void mbServerRuntime::beginStopComponents()
@@ -105,6 +115,9 @@ void mbServerRuntime::beginStopComponents()
 
     Q_FOREACH (mbServerRunScriptThread *t, m_scriptThreads)
         t->stop();
+
+    Q_FOREACH (mbServerRunScriptWorker *t, m_scriptWorkers)
+        t->stop();
 }
 
 bool mbServerRuntime::tryStopComponents()
@@ -123,6 +136,12 @@ bool mbServerRuntime::tryStopComponents()
         if (t->isRunning())
             return false;
     }
+
+    Q_FOREACH (mbServerRunScriptWorker *t, m_scriptWorkers)
+    {
+        if (t->isRunning())
+            return false;
+    }
     return true;
 }
 
@@ -133,8 +152,15 @@ void mbServerRuntime::clearComponents()
     qDeleteAll(m_threads);
     m_threads.clear();
 
+    // Note: workers refer to script threads
+    qDeleteAll(m_scriptWorkers);
+    m_scriptWorkers.clear();
+
     qDeleteAll(m_scriptThreads);
     m_scriptThreads.clear();
+
+    delete m_scriptArena;
+    m_scriptArena = nullptr;
 }
 
 mbServerRunThread *mbServerRuntime::createRunThread(mbServerPort *port)
@@ -183,7 +209,11 @@ mbServerRunScriptThread *mbServerRuntime::createScriptThread(mbServerDevice *dev
         }
         if (scripts.count())
         {
-            mbServerRunScriptThread *t = new mbServerRunScriptThread(device, scripts);
+            mbServerRunScriptThread *t;
+            if (mbServer::global()->scriptEmbedded() && mbServerRunScriptEmbedded::isAvailable())
+                t = new mbServerRunScriptEmbedded(device, scripts);
+            else
+                t = new mbServerRunScriptThread(device, scripts);
             m_scriptThreads.insert(device, t);
             return t;
         }
@@ -191,3 +221,112 @@ mbServerRunScriptThread *mbServerRuntime::createScriptThread(mbServerDevice *dev
     return nullptr;
 }
 
+void mbServerRuntime::createScriptArena()
+{
+    if (!mbServer::global()->scriptSharedArena() || (mbServer::global()->scriptEmbedded() && mbServerRunScriptEmbedded::isAvailable()))
+        return;
+    mbServerRunScriptArena *arena = new mbServerRunScriptArena(mbServerRunScriptThread::processMemoryId()+QStringLiteral(".arena"));
+    QList<mbServerRunScriptThread*> threads;
+    Q_FOREACH (mbServerRunScriptThread *t, m_scriptThreads)
+    {
+        // Note: devices with memory-mapped image keep their own shared memory segments
+        if (t->canUseArena())
+        {
+            t->reserveArena(arena);
+            threads.append(t);
+        }
+    }
+    if (threads.isEmpty())
+    {
+        delete arena;
+        return;
+    }
+    if (!arena->create())
+    {
+        mbServer::LogError("Python", QString("Can't create shared memory arena '%1': %2").arg(arena->key(), arena->errorString()));
+        delete arena;
+        return;
+    }
+    Q_FOREACH (mbServerRunScriptThread *t, threads)
+        t->setArena(arena);
+    m_scriptArena = arena;
+}
+
+void mbServerRuntime::createScriptWorkers()
+{
+    int count = mbServer::global()->scriptWorkerCount();
+    if ((count <= 0) || (mbServer::global()->scriptEmbedded() && mbServerRunScriptEmbedded::isAvailable()))
+        return;
+    QList<mbServerRunScriptThread*> threads;
+    Q_FOREACH (mbServerDevice *dev, project()->devices())
+    {
+        if (mbServerRunScriptThread *t = m_scriptThreads.value(dev))
+            threads.append(t);
+    }
+    if (threads.isEmpty())
+        return;
+    count = qMin(count, threads.count());
+    QVector<QList<mbServerRunScriptThread*> > groups(count);
+    for (int i = 0; i < threads.count(); i++)
+    {
+        threads.at(i)->setHosted(true);
+        groups[i % count].append(threads.at(i));
+    }
+    for (int i = 0; i < count; i++)
+        m_scriptWorkers.append(new mbServerRunScriptWorker(i, groups.at(i)));
+}
+
+// Devices are sorted by estimated load, the heaviest first
+struct mbServerSimDeviceLoadGreater
+{
+    bool operator()(const QPair<double, mbServerDevice*> &a, const QPair<double, mbServerDevice*> &b) const { return a.first > b.first; }
+};
+
+void mbServerRuntime::createSimWorkers()
+{
+    // Note: all actions of the device are executed by the same worker,
+    // so memory of the device is never written by two workers at once
+    QList<mbServerDevice*> devices;
+    QHash<mbServerDevice*, QList<mbServerSimAction*> > actions;
+    QHash<mbServerDevice*, double> loads;
+    Q_FOREACH (mbServerSimAction *a, project()->simActions())
+    {
+        mbServerDevice *dev = a->device();
+        if (!dev)
+            continue;
+        if (!actions.contains(dev))
+            devices.append(dev);
+        actions[dev].append(a);
+        // estimated load is count of written values per millisecond
+        loads[dev] += static_cast<double>(a->arraySize()) / qMax(a->period(), 1);
+    }
+
+    int count = mbServer::global()->simWorkerCount();
+    if (count <= 0)
+        count = QThread::idealThreadCount();
+    count = qBound(1, count, qMax(devices.count(), 1));
+
+    QVector<QPair<double, mbServerDevice*> > sorted;
+    Q_FOREACH (mbServerDevice *dev, devices)
+        sorted.append(qMakePair(loads.value(dev), dev));
+    std::stable_sort(sorted.begin(), sorted.end(), mbServerSimDeviceLoadGreater());
+
+    // every next device goes to the least loaded worker
+    QVector<QList<mbServerSimAction*> > groups(count);
+    QVector<double> workerLoads(count, 0.0);
+    for (int i = 0; i < sorted.count(); i++)
+    {
+        int w = static_cast<int>(std::min_element(workerLoads.constBegin(), workerLoads.constEnd()) - workerLoads.constBegin());
+        groups[w].append(actions.value(sorted.at(i).second));
+        workerLoads[w] += sorted.at(i).first;
+    }
+
+    project()->resetSimStatistic(count);
+    for (int i = 0; i < count; i++)
+    {
+        mbServerRunSimActionTask *task = new mbServerRunSimActionTask;
+        task->setActions(groups.at(i));
+        task->setWorker(project(), i);
+        m_taskThreads.append(new mbCoreRunTaskThread(task));
+    }
+}
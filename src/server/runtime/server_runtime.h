@@ -32,6 +32,8 @@ class mbServerPort;
 class mbServerDevice;
 class mbServerRunThread;
 class mbServerRunScriptThread;
+class mbServerRunScriptWorker;
+class mbServerRunScriptArena;
 
 class mbServerRuntime : public mbCoreRuntime
 {
@@ -56,6 +58,9 @@ private:
 private:
     mbServerRunThread *createRunThread(mbServerPort *port);
     mbServerRunScriptThread *createScriptThread(mbServerDevice *device);
+    void createScriptArena();
+    void createScriptWorkers();
+    void createSimWorkers();
 
 private: // threads
     typedef QHash<mbServerPort*, mbServerRunThread*> Threads_t;
@@ -63,6 +68,11 @@ private: // threads
 
     typedef QHash<mbServerDevice*, mbServerRunScriptThread*> ScriptThreads_t;
     ScriptThreads_t m_scriptThreads;
+
+    typedef QList<mbServerRunScriptWorker*> ScriptWorkers_t;
+    ScriptWorkers_t m_scriptWorkers;
+
+    mbServerRunScriptArena *m_scriptArena;
 };
 
 #endif // SERVER_RUNTIME_H